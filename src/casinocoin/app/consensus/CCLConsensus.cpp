@@ -544,6 +544,12 @@ CCLConsensus::doAccept(
             }
         }
 
+        // Read ahead the state the new open ledger will use, before
+        // taking the master lock
+        auto const locals = localTxs_.getTxSet();
+        auto prefetched = app_.openLedger().prefetch(
+            *sharedLCL.ledger_, locals, retriableTxs);
+
         // Build new open ledger
         auto lock = make_lock(app_.getMasterMutex(), std::defer_lock);
         auto sl = make_lock(ledgerMaster_.peekMutex(), std::defer_lock);
@@ -559,7 +565,7 @@ CCLConsensus::doAccept(
             app_,
             *rules,
             sharedLCL.ledger_,
-            localTxs_.getTxSet(),
+            locals,
             anyDisputes,
             retriableTxs,
             tapNONE,
@@ -567,7 +573,8 @@ CCLConsensus::doAccept(
             [&](OpenView& view, beast::Journal j) {
                 // Stuff the ledger with transactions from the queue.
                 return app_.getTxQ().accept(app_, view);
-            });
+            },
+            std::move(prefetched));
 
         // Signal a potential fee change to subscribers after the open ledger
         // is created
@@ -691,6 +698,7 @@ applyTransactions(
     auto& set = *(cSet.map_);
     CanonicalTXSet retriableTxs(set.getHash().as_uint256());
 
+    std::vector<std::shared_ptr<STTx const>> txns;
     for (auto const& item : set)
     {
         if (!txFilter(item.key()))
@@ -701,7 +709,7 @@ applyTransactions(
         JLOG(j.debug()) << "Processing candidate transaction: " << item.key();
         try
         {
-            retriableTxs.insert(
+            txns.push_back(
                 std::make_shared<STTx const>(SerialIter{item.slice()}));
         }
         catch (std::exception const&)
@@ -709,6 +717,7 @@ applyTransactions(
             JLOG(j.warn()) << "Txn " << item.key() << " throws";
         }
     }
+    retriableTxs.insert(txns);
 
     bool certainRetry = true;
     // Attempt to apply all of the retriable transactions
@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_LEDGER_BOOKINDEX_H_INCLUDED
+#define CASINOCOIN_APP_LEDGER_BOOKINDEX_H_INCLUDED
+
+#include <casinocoin/ledger/ReadView.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/beast/utility/Journal.h>
+#include <casinocoin/protocol/Book.h>
+#include <casinocoin/protocol/STAmount.h>
+#include <casinocoin/protocol/STLedgerEntry.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace casinocoin {
+
+/** The offers of every order book, kept across ledgers.
+
+    Reading a book from the ledger means walking its quality
+    directories page by page, reading every offer and the balance of
+    every offer owner. The index holds, for each book, its offers in
+    the order that walk visits them together with the funds of their
+    owners, and is brought up to date with each new validated ledger
+    from the offers, account roots and trust lines its metadata shows
+    were changed.
+
+    The index for a ledger is an immutable Snapshot, so book queries
+    can read it without locking while the next one is built. Only
+    the books touched by a ledger are copied when it is applied.
+*/
+class BookIndex
+{
+public:
+    struct Offer
+    {
+        std::shared_ptr<SLE const> sle;
+        // The quality directory and page the offer is listed in
+        uint256 directory;
+        std::uint64_t page;
+        // The position of the offer within its page, relative to the
+        // other offers of the page
+        std::uint64_t order;
+        // What the owner holds of the issue the offer sells, as
+        // reported by accountHolds and never negative
+        STAmount ownerFunds;
+    };
+
+    /** The offers of a book, best quality first. */
+    using Offers = std::vector<Offer>;
+
+    class Snapshot
+    {
+    public:
+        /** The sequence of the ledger this is the index of. */
+        LedgerIndex
+        seq () const
+        {
+            return seq_;
+        }
+
+        /** The hash of the ledger this is the index of. */
+        uint256 const&
+        hash () const
+        {
+            return hash_;
+        }
+
+        /** The offers of a book, or nullptr if it has none. */
+        std::shared_ptr<Offers const>
+        offers (Book const& book) const;
+
+        /** The number of books with offers. */
+        std::size_t
+        books () const
+        {
+            return books_.size ();
+        }
+
+    private:
+        friend class BookIndex;
+
+        LedgerIndex seq_ = 0;
+        uint256 hash_;
+        Fees fees_;
+        // Keyed by the base of the book's quality directories
+        hash_map<uint256, std::shared_ptr<Offers const>> books_;
+        // The order given to the next offer added to a page
+        std::uint64_t nextOrder_ = 0;
+    };
+
+    /** Returns the ledger with a given hash, if it is available. */
+    using GetLedger = std::function<
+        std::shared_ptr<ReadView const> (uint256 const&)>;
+
+    explicit
+    BookIndex (beast::Journal j);
+
+    /** The index of the last ledger it was updated to, if any. */
+    std::shared_ptr<Snapshot const>
+    current () const;
+
+    /** Bring the index up to date with a closed ledger.
+
+        If the index is of an earlier ledger, the ledgers between the
+        two are fetched with getLedger and their metadata applied in
+        turn. Otherwise the index is built again from the state of the
+        ledger. Open ledgers are ignored.
+
+        @return The index of the ledger, or nullptr if there is none.
+    */
+    std::shared_ptr<Snapshot const>
+    update (std::shared_ptr<ReadView const> const& ledger,
+        GetLedger const& getLedger);
+
+private:
+    std::shared_ptr<Snapshot const>
+    build (ReadView const& ledger) const;
+
+    std::shared_ptr<Snapshot const>
+    apply (Snapshot const& prev, ReadView const& ledger) const;
+
+    STAmount
+    ownerFunds (ReadView const& ledger, SLE const& offer) const;
+
+    // How far back to look for the ledger the index is of
+    static std::size_t const maxGap = 32;
+
+    beast::Journal j_;
+
+    // Serializes updates
+    std::mutex updateMutex_;
+    // Only accessed with the atomic shared_ptr functions
+    std::shared_ptr<Snapshot const> current_;
+};
+
+} // casinocoin
+
+#endif
@@ -457,6 +457,12 @@ Ledger::read (Keylet const& k) const
     return std::move(sle);
 }
 
+std::size_t
+Ledger::prefetch (std::vector<uint256> const& keys) const
+{
+    return stateMap_->prefetch(keys);
+}
+
 //------------------------------------------------------------------------------
 
 auto
@@ -182,6 +182,9 @@ public:
     std::shared_ptr<SLE const>
     read (Keylet const& k) const override;
 
+    std::size_t
+    prefetch (std::vector<uint256> const& keys) const override;
+
     std::unique_ptr<sles_type::iter_base>
     slesBegin() const override;
 
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_LEDGER_LEDGERREPLAYER_H_INCLUDED
+#define CASINOCOIN_APP_LEDGER_LEDGERREPLAYER_H_INCLUDED
+
+#include <casinocoin/app/ledger/Ledger.h>
+#include <casinocoin/beast/utility/Journal.h>
+#include <casinocoin/json/json_value.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace casinocoin {
+
+class Application;
+
+/** Re-applies stored ledgers to measure the cost of applying them.
+
+    Each ledger in a range is loaded from the local databases, and its
+    transactions are applied again, in their original order, to a new
+    ledger built on its parent, as consensus does when it closes a
+    ledger. The ledger built is then compared with the stored one:
+    every transaction must give the same result and the hashes of the
+    ledger, its state and its transactions must match. When the state
+    does not, the first entries which differ are reported.
+
+    Loading, applying and closing each ledger are timed. While the
+    replay runs the ApplyProfiler is enabled, so the cost of each stage
+    of applying a transaction is broken down by transaction type.
+
+    Nothing is written to the databases, so the same range can be
+    replayed again to compare builds.
+*/
+class LedgerReplayer
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** The outcome of replaying one ledger. */
+    struct Result
+    {
+        std::uint32_t seq = 0;
+        std::size_t transactions = 0;
+        // Transactions whose result differed from the stored one
+        std::size_t mismatched = 0;
+        bool matched = false;
+        std::chrono::microseconds load {0};
+        std::chrono::microseconds apply {0};
+        std::chrono::microseconds close {0};
+        // Of the ledger built, for a ledger which did not match
+        uint256 hash;
+        uint256 accountHash;
+        uint256 txHash;
+        // The first state entries which differ from the stored ledger
+        std::vector<uint256> differences;
+
+        Json::Value
+        getJson () const;
+    };
+
+    LedgerReplayer (Application& app, beast::Journal j);
+
+    /** Replay one ledger on top of its parent.
+
+        @return The result, or boost::none if either could not be loaded.
+    */
+    boost::optional<Result>
+    replay (std::shared_ptr<Ledger const> const& parent,
+        std::shared_ptr<Ledger const> const& ledger);
+
+    /** Replay the ledgers with sequence numbers in [first, last].
+
+        @return A report holding the result of each ledger, totals and
+                the apply profile.
+    */
+    Json::Value
+    replay (std::uint32_t first, std::uint32_t last);
+
+private:
+    Application& app_;
+    beast::Journal j_;
+};
+
+} // casinocoin
+
+#endif
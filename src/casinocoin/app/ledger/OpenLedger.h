@@ -23,11 +23,13 @@
 #include <casinocoin/app/ledger/Ledger.h>
 #include <casinocoin/ledger/CachedSLEs.h>
 #include <casinocoin/ledger/OpenView.h>
+#include <casinocoin/ledger/TxRecorder.h>
 #include <casinocoin/app/misc/CanonicalTXSet.h>
 #include <casinocoin/basics/Log.h>
 #include <casinocoin/basics/UnorderedContainers.h>
 #include <casinocoin/core/Config.h>
 #include <casinocoin/beast/utility/Journal.h>
+#include <atomic>
 #include <cassert>
 #include <mutex>
 
@@ -54,6 +56,16 @@ private:
     std::mutex mutable modify_mutex_;
     std::mutex mutable current_mutex_;
     std::shared_ptr<OpenView const> current_;
+    // The closed ledger current_ is built on, and the footprints
+    // of the transactions applied to it
+    std::shared_ptr<Ledger const> ledger_;
+    TxRecorder footprints_;
+    std::atomic<std::uint32_t> prefetchKeys_ {0};
+    std::atomic<std::uint32_t> prefetchReads_ {0};
+    std::atomic<std::uint32_t> misses_ {0};
+    std::atomic<std::uint32_t> rebuildTime_ {0};
+    std::atomic<std::uint32_t> carried_ {0};
+    std::atomic<std::uint32_t> reapplied_ {0};
 
 public:
     /** Signature for modification functions.
@@ -121,10 +133,13 @@ public:
         If `f` returns `true`, the changes made in the
         OpenView will be published to the open ledger.
 
+        @param prefetched The keys returned by prefetch for the
+                          transactions `f` applies, if any
         @return `true` if the open view was changed
     */
     bool
-    modify (modify_type const& f);
+    modify (modify_type const& f,
+        std::vector<uint256> prefetched = {});
 
     /** Accept a new ledger.
 
@@ -139,7 +154,10 @@ public:
             depending on the value of `retriesFirst`.
 
             The transactions in the current open view
-            are applied to the new open view.
+            are applied to the new open view. A transaction
+            whose footprint the closed ledger did not change
+            is carried over with its recorded results instead
+            of being applied again.
 
             The list of local transactions are applied
             to the new open view.
@@ -158,6 +176,8 @@ public:
 
         @param rules The rules for the open ledger
         @param ledger A new closed ledger
+        @param prefetched The keys returned by prefetch for this
+                          ledger and these transactions, if any
     */
     void
     accept (Application& app, Rules const& rules,
@@ -165,7 +185,68 @@ public:
             OrderedTxs const& locals, bool retriesFirst,
                 OrderedTxs& retries, ApplyFlags flags,
                     std::string const& suffix = "",
-                        modify_type const& f = {});
+                        modify_type const& f = {},
+                            std::vector<uint256> prefetched = {});
+
+    /** Read ahead the state a batch of transactions will use.
+
+        The tree nodes leading to the entries the transactions are
+        likely to touch are loaded from the node store with batched
+        asynchronous reads, so that applying the transactions later
+        does not wait on disk. This should be called without holding
+        the master lock.
+
+        Thread safety:
+            Can be called concurrently from any thread.
+
+        @param ledger The closed ledger the open ledger is built on
+        @return The keys read ahead, sorted
+    */
+    std::vector<uint256>
+    prefetch (Ledger const& ledger,
+        std::vector<std::shared_ptr<STTx const>> const& txs);
+
+    /** Read ahead the state accept() will use.
+
+        This reads ahead for the retries, the transactions in the
+        current open view and the local transactions. Call it before
+        taking the master lock and pass the result to accept.
+
+        @param ledger The new closed ledger
+        @return The keys read ahead, sorted
+    */
+    std::vector<uint256>
+    prefetch (Ledger const& ledger,
+        OrderedTxs const& locals, OrderedTxs const& retries);
+
+    struct PrefetchStats
+    {
+        /** Keys read ahead */
+        std::uint32_t keys;
+        /** Keys which needed a node store read */
+        std::uint32_t reads;
+        /** Distinct keys a batch read which its prefetch had not
+            read ahead. Each is a read which may have waited on the
+            node store.
+        */
+        std::uint32_t misses;
+    };
+
+    PrefetchStats
+    prefetchStats () const;
+
+    struct RebuildStats
+    {
+        /** Microseconds the last accept took */
+        std::uint32_t time;
+        /** Transactions carried over with their results */
+        std::uint32_t carried;
+        /** Transactions applied again */
+        std::uint32_t reapplied;
+    };
+
+    RebuildStats
+    rebuildStats () const;
 
     /** Algorithm for applying transactions.
 
@@ -192,6 +273,28 @@ private:
     create (Rules const& rules,
         std::shared_ptr<Ledger const> const& ledger);
 
+    bool
+    carry (Application& app, OpenView& view,
+        TxRecorder& recorder, Ledger const& ledger,
+            OrderedTxs& retries, ApplyFlags flags);
+
+    static
+    void
+    applyBatch (Application& app, OpenView& view,
+        std::vector<std::shared_ptr<STTx const>> const& txs,
+            OrderedTxs& retries, ApplyFlags flags,
+                beast::Journal j);
+
+    static
+    void
+    applyRetries (Application& app, OpenView& view,
+        OrderedTxs& retries, ApplyFlags flags,
+            beast::Journal j);
+
+    static
+    Result
+    classify (std::pair<TER, bool> const& result);
+
     static
     Result
     apply_one (Application& app, OpenView& view,
@@ -209,6 +312,7 @@ OpenLedger::apply (Application& app, OpenView& view,
         OrderedTxs& retries, ApplyFlags flags,
             beast::Journal j)
 {
+    std::vector<std::shared_ptr<STTx const>> batch;
     for (auto iter = txs.begin();
         iter != txs.end(); ++iter)
     {
@@ -219,10 +323,7 @@ OpenLedger::apply (Application& app, OpenView& view,
             auto const tx = *iter;
             if (check.txExists(tx->getTransactionID()))
                 continue;
-            auto const result = apply_one(app, view,
-                tx, true, flags, j);
-            if (result == Result::retry)
-                retries.insert(tx);
+            batch.push_back(tx);
         }
         catch(std::exception const&)
         {
@@ -230,43 +331,23 @@ OpenLedger::apply (Application& app, OpenView& view,
                 "Caught exception";
         }
     }
-    bool retry = true;
-    for (int pass = 0;
-        pass < LEDGER_TOTAL_PASSES;
-            ++pass)
-    {
-        int changes = 0;
-        auto iter = retries.begin();
-        while (iter != retries.end())
-        {
-            switch (apply_one(app, view,
-                iter->second, retry, flags,
-                    j))
-            {
-            case Result::success:
-                ++changes;
-            case Result::failure:
-                iter = retries.erase (iter);
-                break;
-            case Result::retry:
-                ++iter;
-            }
-        }
-        // A non-retry pass made no changes
-        if (! changes && ! retry)
-            return;
-        // Stop retriable passes
-        if (! changes || (pass >= LEDGER_RETRY_PASSES))
-            retry = false;
-    }
-
-    // If there are any transactions left, we must have
-    // tried them in at least one final pass
-    assert (retries.empty() || ! retry);
+    applyBatch(app, view, batch, retries, flags, j);
+    applyRetries(app, view, retries, flags, j);
 }
 
 //------------------------------------------------------------------------------
 
+/** Add the keys of the state entries a transaction is likely to read.
+
+    These are the account roots and owner directories of the accounts
+    involved, the trust lines for the issues it moves and the order
+    books it may cross.
+*/
+void
+likelyKeys (STTx const& tx, std::vector<uint256>& keys);
+
+//------------------------------------------------------------------------------
+
 // For debug logging
 
 std::string
@@ -26,11 +26,17 @@
 #include <BeastConfig.h>
 #include <casinocoin/app/ledger/OrderBookDB.h>
 #include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/basics/Log.h>
 #include <casinocoin/core/Config.h>
 #include <casinocoin/core/JobQueue.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <casinocoin/ledger/View.h>
 #include <casinocoin/protocol/Indexes.h>
+#include <casinocoin/protocol/STArray.h>
+#include <casinocoin/shamap/SHAMapMissingNode.h>
+#include <algorithm>
 
 namespace casinocoin {
 
@@ -42,56 +48,260 @@ OrderBookDB::OrderBookDB (Application& app, Stoppable& parent)
 {
 }
 
+// The ranges of keys a scan is split into
+static int const scanRanges = 4;
+
+struct OrderBookDB::Scan
+{
+    struct Range
+    {
+        // The last key scanned
+        uint256 after;
+        bool done = false;
+        std::vector<Book> books;
+    };
+
+    explicit
+    Scan (std::shared_ptr<ReadView const> const& l)
+        : ledger (l)
+        , ranges (scanRanges)
+    {
+        for (int i = 1; i < scanRanges; ++i)
+        {
+            ranges[i].after = statePartitionStart (i, scanRanges);
+            --ranges[i].after;
+        }
+    }
+
+    std::shared_ptr<ReadView const> ledger;
+    std::vector<Range> ranges;
+};
+
+// The book of a quality directory. Fields which are zero, as they are
+// for CSC, are left out of the metadata of a created directory.
+static
+Book
+bookOf (STObject const& dir)
+{
+    auto const field = [&dir](SField const& f)
+    {
+        return dir.isFieldPresent (f) ? dir.getFieldH160 (f) : uint160 ();
+    };
+
+    Book book;
+    book.in.currency.copyFrom (field (sfTakerPaysCurrency));
+    book.in.account.copyFrom (field (sfTakerPaysIssuer));
+    book.out.currency.copyFrom (field (sfTakerGetsCurrency));
+    book.out.account.copyFrom (field (sfTakerGetsIssuer));
+    return book;
+}
+
+// Whether an entry is the first page of a book's quality directory
+static
+bool
+isQualityRoot (STObject const& dir, uint256 const& key)
+{
+    return dir.isFieldPresent (sfExchangeRate) &&
+        dir.isFieldPresent (sfRootIndex) &&
+        dir.getFieldH256 (sfRootIndex) == key;
+}
+
 void OrderBookDB::invalidate ()
 {
     std::lock_guard <std::recursive_mutex> sl (mLock);
     mSeq = 0;
 }
 
+std::uint32_t OrderBookDB::getLedgerSeq ()
+{
+    std::lock_guard <std::recursive_mutex> sl (mLock);
+    return mSeq;
+}
+
 void OrderBookDB::setup(
     std::shared_ptr<ReadView const> const& ledger)
 {
+    if (app_.config().PATH_SEARCH_MAX == 0)
+    {
+        // nothing to do
+        return;
+    }
+
     {
         std::lock_guard <std::recursive_mutex> sl (mLock);
         auto seq = ledger->info().seq;
 
-        // Do a full update every 256 ledgers
+        // The ledgers after the one being updated to are applied by
+        // the next call once the update is done
+        if (mUpdating)
+            return;
+
         if (mSeq != 0)
         {
             if (seq == mSeq)
                 return;
-            if ((seq > mSeq) && ((seq - mSeq) < 256))
-                return;
             if ((seq < mSeq) && ((mSeq - seq) < 16))
                 return;
         }
 
-        JLOG (j_.debug())
-            << "Advancing from " << mSeq << " to " << seq;
-
-        mSeq = seq;
+        mUpdating = true;
     }
 
-    if (app_.config().PATH_SEARCH_MAX == 0)
-    {
-        // nothing to do
-    }
-    else if (app_.config().standalone())
-        update(ledger);
+    // Even applying a few ledgers reads their metadata, so it is kept
+    // off the thread publishing them
+    if (app_.config().standalone())
+        catchUp(ledger);
     else
         app_.getJobQueue().addJob(
             jtUPDATE_PF, "OrderBookDB::update",
-            [this, ledger] (Job&) { update(ledger); });
+            [this, ledger] (Job&) { catchUp(ledger); });
 }
 
-void OrderBookDB::update(
+void OrderBookDB::catchUp (
     std::shared_ptr<ReadView const> const& ledger)
 {
-    hash_set< uint256 > seen;
-    OrderBookDB::IssueToOrderBook destMap;
-    OrderBookDB::IssueToOrderBook sourceMap;
-    hash_set< Issue > CSCBooks;
+    // However this ends, the next setup can start an update again
+    struct Done
+    {
+        OrderBookDB& db;
+
+        ~Done ()
+        {
+            std::lock_guard <std::recursive_mutex> sl (db.mLock);
+            db.mUpdating = false;
+        }
+    } const done {*this};
+
+    if (applyLedgers (ledger))
+        return;
+
+    auto target = ledger;
+    {
+        std::lock_guard <std::recursive_mutex> sl (mLock);
+
+        // Finish an interrupted scan if its ledger isn't too old to
+        // catch up from
+        if (mScan && mScan->ledger->info().seq <= ledger->info().seq &&
+            ledger->info().seq - mScan->ledger->info().seq <= maxGap)
+        {
+            target = mScan->ledger;
+        }
+    }
+
+    JLOG (j_.debug())
+        << "Scanning ledger " << target->info().seq << " for books";
+
+    update(target);
+}
+
+bool OrderBookDB::applyLedgers (
+    std::shared_ptr<ReadView const> const& ledger)
+{
+    std::uint32_t seq;
+    uint256 hash;
+    {
+        std::lock_guard <std::recursive_mutex> sl (mLock);
+        seq = mSeq;
+        hash = mHash;
+    }
+
+    if (seq == 0)
+        return false;
+
+    auto const chain = ledgerChainSince (hash, seq, ledger,
+        [this](uint256 const& parent) -> std::shared_ptr<ReadView const>
+        {
+            return app_.getLedgerMaster ().getLedgerByHash (parent);
+        }, maxGap);
+    if (chain.empty ())
+        return false;
+
+    for (auto const& next : chain)
+    {
+        auto const& view = *next;
+
+        // The books which gained or lost a quality directory
+        hash_map <uint256, Book> touched;
+        for (auto const& item : view.txs)
+        {
+            if (! item.second)
+                return false;
+
+            for (auto const& node :
+                item.second->getFieldArray (sfAffectedNodes))
+            {
+                if (node.getFieldU16 (sfLedgerEntryType) != ltDIR_NODE)
+                    continue;
+
+                bool const created = node.getFName () == sfCreatedNode;
+                if (! created && node.getFName () != sfDeletedNode)
+                    continue;
+
+                auto const& fields = created ? sfNewFields : sfFinalFields;
+                if (! node.isFieldPresent (fields))
+                    return false;
 
+                auto const& dir = node.getFieldObject (fields);
+                if (! isQualityRoot (dir, node.getFieldH256 (sfLedgerIndex)))
+                    continue;
+
+                auto const book = bookOf (dir);
+                touched.emplace (getBookBase (book), book);
+            }
+        }
+
+        std::lock_guard <std::recursive_mutex> sl (mLock);
+
+        // A book is there for as long as any of its quality
+        // directories are
+        for (auto const& book : touched)
+        {
+            if (view.succ (book.first, getQualityNext (book.first)))
+                rawAddBook (book.second);
+            else
+                rawRemoveBook (book.second);
+            mUnconfirmed.erase (book.first);
+        }
+
+        // Books from the open ledger are dropped if validated ledgers
+        // still don't show them after a while
+        std::size_t dropped = 0;
+        for (auto iter = mUnconfirmed.begin (); iter != mUnconfirmed.end ();)
+        {
+            if (view.succ (iter->first, getQualityNext (iter->first)))
+            {
+                iter = mUnconfirmed.erase (iter);
+            }
+            else if (view.info().seq >= iter->second.second + confirmLedgers)
+            {
+                rawRemoveBook (iter->second.first);
+                iter = mUnconfirmed.erase (iter);
+                ++dropped;
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+
+        mSeq = view.info().seq;
+        mHash = view.info().hash;
+
+        if (! touched.empty () || dropped != 0)
+        {
+            JLOG (j_.debug())
+                << "Ledger " << mSeq << " changed "
+                << touched.size () << " books, dropped "
+                << dropped << " unconfirmed";
+        }
+    }
+
+    return true;
+}
+
+void OrderBookDB::update(
+    std::shared_ptr<ReadView const> const& ledger)
+{
     JLOG (j_.debug()) << "OrderBookDB::update>";
 
     if (app_.config().PATH_SEARCH_MAX == 0)
@@ -100,49 +310,107 @@ void OrderBookDB::update(
         return;
     }
 
-    // walk through the entire ledger looking for orderbook entries
-    int books = 0;
+    // Pick up where an interrupted scan of this ledger stopped
+    std::shared_ptr<Scan> scan;
+    {
+        std::lock_guard <std::recursive_mutex> sl (mLock);
+        if (mScan && mScan->ledger == ledger)
+            scan = mScan;
+        mScan.reset ();
+    }
+    if (! scan)
+        scan = std::make_shared<Scan> (ledger);
 
-    try
+    // Walk through a range of the ledger looking for orderbook entries,
+    // noting how far it got
+    auto const scanRange = [&scan, &ledger](int i)
     {
-        for(auto& sle : ledger->sles)
+        auto& range = scan->ranges[i];
+        if (range.done)
+            return;
+
+        bool const last = (i + 1 == scanRanges);
+        auto const limit = last ? uint256 () :
+            statePartitionStart (i + 1, scanRanges);
+
+        try
         {
-            if (sle->getType () == ltDIR_NODE &&
-                sle->isFieldPresent (sfExchangeRate) &&
-                sle->getFieldH256 (sfRootIndex) == sle->key())
+            // Only directory nodes need to be deserialized
+            forEachStateLeaf (*ledger, range.after,
+                [&](StateLeaf const& leaf)
             {
-                Book book;
-                book.in.currency.copyFrom(sle->getFieldH160(
-                    sfTakerPaysCurrency));
-                book.in.account.copyFrom(sle->getFieldH160 (
-                    sfTakerPaysIssuer));
-                book.out.account.copyFrom(sle->getFieldH160(
-                    sfTakerGetsIssuer));
-                book.out.currency.copyFrom (sle->getFieldH160(
-                    sfTakerGetsCurrency));
-
-                uint256 index = getBookBase (book);
-                if (seen.insert (index).second)
+                if (! last && leaf.key () >= limit)
+                    return false;
+
+                if (leaf.type () == ltDIR_NODE)
                 {
-                    auto orderBook = std::make_shared<OrderBook> (index, book);
-                    sourceMap[book.in].push_back (orderBook);
-                    destMap[book.out].push_back (orderBook);
-                    if (isCSC(book.out))
-                        CSCBooks.insert(book.in);
-                    ++books;
+                    auto const& sle = leaf.sle ();
+                    if (isQualityRoot (*sle, sle->key ()))
+                        range.books.push_back (bookOf (*sle));
                 }
-            }
+
+                range.after = leaf.key ();
+                return true;
+            });
+            range.done = true;
+        }
+        catch (const SHAMapMissingNode&)
+        {
         }
+    };
+
+    // The ranges of a closed ledger are scanned in parallel
+    if (dynamic_cast<Ledger const*> (ledger.get ()))
+    {
+        app_.getWorkerPool ().forEach (scanRanges,
+            [&](std::size_t i)
+            {
+                scanRange (i);
+            });
+    }
+    else
+    {
+        for (int i = 0; i < scanRanges; ++i)
+            scanRange (i);
     }
-    catch (const SHAMapMissingNode&)
+
+    auto const remaining = std::count_if (
+        scan->ranges.begin (), scan->ranges.end (),
+        [](Scan::Range const& range) { return ! range.done; });
+    if (remaining != 0)
     {
         JLOG (j_.info())
-            << "OrderBookDB::update encountered a missing node";
+            << "OrderBookDB::update encountered a missing node, "
+            << remaining << " of " << scanRanges << " ranges left";
         std::lock_guard <std::recursive_mutex> sl (mLock);
+        mScan = std::move (scan);
         mSeq = 0;
         return;
     }
 
+    hash_set< uint256 > seen;
+    OrderBookDB::IssueToOrderBook destMap;
+    OrderBookDB::IssueToOrderBook sourceMap;
+    hash_set< Issue > CSCBooks;
+
+    int books = 0;
+    for (auto const& range : scan->ranges)
+    {
+        for (auto const& book : range.books)
+        {
+            uint256 index = getBookBase (book);
+            if (seen.insert (index).second)
+            {
+                auto orderBook = std::make_shared<OrderBook> (index, book);
+                sourceMap[book.in].push_back (orderBook);
+                destMap[book.out].push_back (orderBook);
+                if (isCSC(book.out))
+                    CSCBooks.insert(book.in);
+                ++books;
+            }
+        }
+    }
+
     JLOG (j_.debug())
         << "OrderBookDB::update< " << books << " books found";
     {
@@ -151,14 +419,24 @@ void OrderBookDB::update(
         mCSCBooks.swap(CSCBooks);
         mSourceMap.swap(sourceMap);
         mDestMap.swap(destMap);
+        mUnconfirmed.clear();
+
+        mSeq = ledger->info().seq;
+        mHash = ledger->info().hash;
     }
     app_.getLedgerMaster().newOrderBookDB();
 }
 
 void OrderBookDB::addOrderBook(Book const& book)
 {
-    bool toCSC = isCSC (book.out);
     std::lock_guard <std::recursive_mutex> sl (mLock);
+    if (rawAddBook (book))
+        mUnconfirmed.emplace (getBookBase (book), std::make_pair (book, mSeq));
+}
+
+bool OrderBookDB::rawAddBook(Book const& book)
+{
+    bool toCSC = isCSC (book.out);
 
     if (toCSC)
     {
@@ -167,7 +445,7 @@ void OrderBookDB::addOrderBook(Book const& book)
         for (auto ob: mSourceMap[book.in])
         {
             if (isCSC (ob->getCurrencyOut ())) // also to CSC
-                return;
+                return false;
         }
     }
     else
@@ -177,7 +455,7 @@ void OrderBookDB::addOrderBook(Book const& book)
             if (ob->getCurrencyIn() == book.in.currency &&
                 ob->getIssuerIn() == book.in.account)
             {
-                return;
+                return false;
             }
         }
     }
@@ -188,6 +466,31 @@ void OrderBookDB::addOrderBook(Book const& book)
     mDestMap[book.out].push_back (orderBook);
     if (toCSC)
         mCSCBooks.insert(book.in);
+    return true;
+}
+
+void OrderBookDB::rawRemoveBook(Book const& book)
+{
+    auto const remove = [&book](IssueToOrderBook& map, Issue const& issue)
+    {
+        auto it = map.find (issue);
+        if (it == map.end ())
+            return;
+
+        auto& books = it->second;
+        books.erase (std::remove_if (books.begin (), books.end (),
+            [&book](OrderBook::ref ob) { return ob->book () == book; }),
+                books.end ());
+        if (books.empty ())
+            map.erase (it);
+    };
+
+    remove (mSourceMap, book.in);
+    remove (mDestMap, book.out);
+
+    // There is only one book from an issue to CSC
+    if (isCSC (book.out))
+        mCSCBooks.erase (book.in);
 }
 
 // return list of all orderbooks that want this issuerID and currencyID
@@ -40,10 +40,33 @@ class OrderBookDB
 public:
     OrderBookDB (Application& app, Stoppable& parent);
 
+    /** Bring the books up to date with a ledger.
+
+        The books are kept up to date from the directories the
+        metadata of each ledger shows were created or deleted. The
+        state of a ledger is only scanned when there are no books yet,
+        or the ledgers since the ones they are of aren't available.
+        Unless standalone, the update runs on a job.
+    */
     void setup (std::shared_ptr<ReadView const> const& ledger);
+
+    /** Find the books by scanning the state of a ledger.
+
+        A scan interrupted by a missing node is resumed from where it
+        stopped the next time the same ledger is scanned.
+    */
     void update (std::shared_ptr<ReadView const> const& ledger);
+
     void invalidate ();
 
+    /** The sequence of the ledger the books are of, or 0 if none. */
+    std::uint32_t getLedgerSeq ();
+
+    /** Add a book an offer in the open ledger created.
+
+        The book is dropped again unless a validated ledger shows it
+        within a few ledgers, since the offer may never be validated.
+    */
     void addOrderBook(Book const&);
 
     /** @return a list of all orderbooks that want this issuerID and currencyID.
@@ -67,7 +90,23 @@ public:
     using IssueToOrderBook = hash_map <Issue, OrderBook::List>;
 
 private:
-    void rawAddBook(Book const&);
+    struct Scan;
+
+    // Apply the ledgers up to ledger, or scan it if they can't be
+    void catchUp (std::shared_ptr<ReadView const> const& ledger);
+
+    // Apply the ledgers since the one the books are of, up to ledger
+    bool applyLedgers (std::shared_ptr<ReadView const> const& ledger);
+
+    // Must be called with mLock held
+    bool rawAddBook(Book const&);
+    void rawRemoveBook(Book const&);
+
+    // How far back to look for the ledger the books are of
+    static std::uint32_t const maxGap = 256;
+
+    // How many ledgers a book added from the open ledger has to show up
+    static std::uint32_t const confirmLedgers = 4;
 
     Application& app_;
 
@@ -87,6 +126,15 @@ private:
     BookToListenersMap mListeners;
 
     std::uint32_t mSeq;
+    uint256 mHash;
+
+    // The books added from the open ledger that no validated ledger has
+    // shown yet, by book base, with the sequence of the books when added
+    hash_map <uint256, std::pair<Book, std::uint32_t>> mUnconfirmed;
+
+    // Whether an update is under way, and what an interrupted scan found
+    bool mUpdating = false;
+    std::shared_ptr<Scan> mScan;
 
     beast::Journal j_;
 };
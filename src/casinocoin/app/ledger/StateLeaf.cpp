@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
+#include <casinocoin/app/ledger/Ledger.h>
+#include <casinocoin/core/WorkerPool.h>
+
+namespace casinocoin {
+
+LedgerEntryType
+StateLeaf::type () const
+{
+    // Fields are serialized in canonical order, so an entry always
+    // starts with sfLedgerEntryType: a one byte field id followed by
+    // the 16-bit type.
+    auto const fieldID = static_cast<std::uint8_t> (
+        (sfLedgerEntryType.fieldType << 4) | sfLedgerEntryType.fieldValue);
+
+    if (data_.size () >= 3 && data_[0] == fieldID)
+        return static_cast<LedgerEntryType> ((data_[1] << 8) | data_[2]);
+
+    return sle ()->getType ();
+}
+
+std::shared_ptr<SLE const> const&
+StateLeaf::sle () const
+{
+    if (! sle_)
+    {
+        SerialIter sit (data_);
+        sle_ = std::make_shared<SLE const> (sit, key_);
+    }
+    return sle_;
+}
+
+//------------------------------------------------------------------------------
+
+bool
+forEachStateLeaf (ReadView const& view, uint256 const& after,
+    std::function<bool (StateLeaf const&)> const& f)
+{
+    if (auto const ledger = dynamic_cast<Ledger const*> (&view))
+    {
+        auto const& map = ledger->stateMap ();
+        auto const end = map.end ();
+        for (auto iter = map.upper_bound (after); iter != end; ++iter)
+        {
+            if (! f (StateLeaf (iter->key (), iter->slice ())))
+                return false;
+        }
+        return true;
+    }
+
+    auto const end = view.sles.end ();
+    for (auto iter = view.sles.upper_bound (after); iter != end; ++iter)
+    {
+        Serializer s;
+        (*iter)->add (s);
+        if (! f (StateLeaf (*iter, s.slice ())))
+            return false;
+    }
+    return true;
+}
+
+uint256
+statePartitionStart (int partition, int partitions)
+{
+    std::uint64_t const top =
+        (static_cast<std::uint64_t> (partition) << 32) / partitions;
+    uint256 key;
+    auto p = key.begin ();
+    p[0] = static_cast<std::uint8_t> (top >> 24);
+    p[1] = static_cast<std::uint8_t> (top >> 16);
+    p[2] = static_cast<std::uint8_t> (top >> 8);
+    p[3] = static_cast<std::uint8_t> (top);
+    return key;
+}
+
+void
+forEachStateLeaf (Ledger const& ledger, WorkerPool& workers, int partitions,
+    std::function<void (int, StateLeaf const&)> const& f)
+{
+    partitions = std::max (1, std::min (partitions, 256));
+
+    auto const first = [partitions](int i)
+    {
+        return statePartitionStart (i, partitions);
+    };
+
+    auto const& map = ledger.stateMap ();
+
+    auto const scan = [&](int i)
+    {
+        auto const end = map.end ();
+        auto iter = map.begin ();
+        if (i != 0)
+        {
+            auto start = first (i);
+            iter = map.upper_bound (--start);
+        }
+
+        bool const last = (i + 1 == partitions);
+        auto const limit = last ? uint256 () : first (i + 1);
+        for (; iter != end; ++iter)
+        {
+            if (! last && iter->key () >= limit)
+                break;
+            f (i, StateLeaf (iter->key (), iter->slice ()));
+        }
+    };
+
+    workers.forEach (partitions,
+        [&](std::size_t i)
+        {
+            scan (static_cast<int> (i));
+        });
+}
+
+} // casinocoin
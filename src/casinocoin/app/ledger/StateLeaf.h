@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_LEDGER_STATELEAF_H_INCLUDED
+#define CASINOCOIN_APP_LEDGER_STATELEAF_H_INCLUDED
+
+#include <casinocoin/ledger/ReadView.h>
+#include <casinocoin/protocol/LedgerFormats.h>
+#include <casinocoin/protocol/STLedgerEntry.h>
+#include <casinocoin/protocol/Serializer.h>
+#include <casinocoin/basics/Slice.h>
+#include <functional>
+#include <memory>
+
+namespace casinocoin {
+
+class Ledger;
+class WorkerPool;
+
+/** A ledger entry in its serialized form.
+
+    The entry is only deserialized when sle() is called, so a scan
+    that looks at the keys, types or raw bytes of the state map does
+    not pay for building an STLedgerEntry per leaf.
+
+    A StateLeaf refers to data owned by the view it came from and is
+    only valid during the callback it is passed to.
+*/
+class StateLeaf
+{
+private:
+    uint256 const& key_;
+    Slice data_;
+    mutable std::shared_ptr<SLE const> sle_;
+
+public:
+    StateLeaf (uint256 const& key, Slice data)
+        : key_ (key)
+        , data_ (data)
+    {
+    }
+
+    StateLeaf (std::shared_ptr<SLE const> sle, Slice data)
+        : key_ (sle->key ())
+        , data_ (data)
+        , sle_ (std::move (sle))
+    {
+    }
+
+    StateLeaf (StateLeaf const&) = delete;
+    StateLeaf& operator= (StateLeaf const&) = delete;
+
+    uint256 const&
+    key () const
+    {
+        return key_;
+    }
+
+    /** The canonical serialization of the entry. */
+    Slice
+    slice () const
+    {
+        return data_;
+    }
+
+    /** The type of the entry, read without deserializing it. */
+    LedgerEntryType
+    type () const;
+
+    /** The deserialized entry, built on first use. */
+    std::shared_ptr<SLE const> const&
+    sle () const;
+};
+
+/** Visit the state entries of a view in key order.
+
+    Entries are visited starting after `after`, so the key of the last
+    entry seen can be used to resume a scan. For a closed ledger the
+    leaves of the state map are visited without deserializing them;
+    other views fall back to their sles range.
+
+    @param f Called for each entry, returns false to stop.
+    @return false if the callback stopped the scan.
+*/
+bool
+forEachStateLeaf (ReadView const& view, uint256 const& after,
+    std::function<bool (StateLeaf const&)> const& f);
+
+/** The first key of a partition of the key space.
+
+    The key space is split into `partitions` ranges of equal width on
+    the top 32 bits of the key. Partition 0 starts at the zero key.
+*/
+uint256
+statePartitionStart (int partition, int partitions);
+
+/** Visit all the state entries of a ledger using several threads.
+
+    The key space is split into `partitions` ranges of equal width,
+    each scanned in key order on a thread of `workers`. The callback receives
+    the index of the partition, which increases with the keys, and may
+    be called concurrently for different partitions. Exceptions thrown
+    by a scan are rethrown to the caller.
+*/
+void
+forEachStateLeaf (Ledger const& ledger, WorkerPool& workers, int partitions,
+    std::function<void (int, StateLeaf const&)> const& f);
+
+} // casinocoin
+
+#endif
@@ -0,0 +1,380 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/ledger/BookIndex.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
+#include <casinocoin/basics/Log.h>
+#include <casinocoin/ledger/View.h>
+#include <casinocoin/protocol/Indexes.h>
+#include <casinocoin/protocol/STArray.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace casinocoin {
+
+// The base of the book a quality directory belongs to
+static
+uint256
+bookBase (uint256 directory)
+{
+    std::fill (directory.end () - 8, directory.end (), 0);
+    return directory;
+}
+
+// The order a walk of the book's directories visits offers in
+static
+bool
+walkOrder (BookIndex::Offer const& lhs, BookIndex::Offer const& rhs)
+{
+    if (lhs.directory != rhs.directory)
+        return lhs.directory < rhs.directory;
+    if (lhs.page != rhs.page)
+        return lhs.page < rhs.page;
+    return lhs.order < rhs.order;
+}
+
+std::shared_ptr<BookIndex::Offers const>
+BookIndex::Snapshot::offers (Book const& book) const
+{
+    auto const iter = books_.find (getBookBase (book));
+    if (iter == books_.end ())
+        return nullptr;
+    return iter->second;
+}
+
+//------------------------------------------------------------------------------
+
+BookIndex::BookIndex (beast::Journal j)
+    : j_ (j)
+{
+}
+
+std::shared_ptr<BookIndex::Snapshot const>
+BookIndex::current () const
+{
+    return std::atomic_load (&current_);
+}
+
+std::shared_ptr<BookIndex::Snapshot const>
+BookIndex::update (std::shared_ptr<ReadView const> const& ledger,
+    GetLedger const& getLedger)
+{
+    if (! ledger || ledger->open ())
+        return current ();
+
+    std::lock_guard<std::mutex> lock (updateMutex_);
+
+    auto const prev = current ();
+    if (prev && prev->hash () == ledger->info ().hash)
+        return prev;
+
+    auto next = prev;
+    if (next)
+    {
+        auto const chain = ledgerChainSince (prev->hash (), prev->seq (),
+            ledger, getLedger, maxGap);
+        if (chain.empty ())
+            next = nullptr;
+        for (auto iter = chain.begin (); next && iter != chain.end (); ++iter)
+            next = apply (*next, **iter);
+    }
+
+    if (! next)
+        next = build (*ledger);
+
+    std::atomic_store (&current_, next);
+    return next;
+}
+
+STAmount
+BookIndex::ownerFunds (ReadView const& ledger, SLE const& offer) const
+{
+    auto const& gets = offer.getFieldAmount (sfTakerGets);
+    auto funds = accountHolds (ledger, offer.getAccountID (sfAccount),
+        gets.getCurrency (), gets.getIssuer (), fhZERO_IF_FROZEN, j_);
+    if (funds < zero)
+        funds.clear ();
+    return funds;
+}
+
+std::shared_ptr<BookIndex::Snapshot const>
+BookIndex::build (ReadView const& ledger) const
+{
+    auto const start = std::chrono::steady_clock::now ();
+
+    std::vector<std::shared_ptr<SLE const>> sles;
+    forEachStateLeaf (ledger, uint256 (),
+        [&sles](StateLeaf const& leaf)
+        {
+            if (leaf.type () == ltOFFER)
+                sles.push_back (leaf.sle ());
+            return true;
+        });
+
+    // Directory pages and owner funds are shared by many offers
+    hash_map<uint256, std::shared_ptr<SLE const>> pages;
+    std::map<std::pair<AccountID, Issue>, STAmount> funds;
+
+    auto snapshot = std::make_shared<Snapshot> ();
+    snapshot->seq_ = ledger.seq ();
+    snapshot->hash_ = ledger.info ().hash;
+    snapshot->fees_ = ledger.fees ();
+
+    hash_map<uint256, std::shared_ptr<Offers>> books;
+    for (auto& sle : sles)
+    {
+        Offer offer;
+        offer.directory = sle->getFieldH256 (sfBookDirectory);
+        offer.page = sle->getFieldU64 (sfBookNode);
+
+        auto const pageKey = keylet::page (offer.directory, offer.page);
+        auto& page = pages[pageKey.key];
+        if (! page)
+            page = ledger.read (pageKey);
+        if (! page)
+        {
+            JLOG (j_.warn ()) << "Offer " << sle->key () <<
+                " is missing from its book directory";
+            continue;
+        }
+        auto const& indexes = page->getFieldV256 (sfIndexes);
+        offer.order = std::find (indexes.begin (), indexes.end (),
+            sle->key ()) - indexes.begin ();
+
+        auto const& gets = sle->getFieldAmount (sfTakerGets);
+        auto const owner = std::make_pair (
+            sle->getAccountID (sfAccount), gets.issue ());
+        auto iter = funds.find (owner);
+        if (iter == funds.end ())
+            iter = funds.emplace (owner, ownerFunds (ledger, *sle)).first;
+        offer.ownerFunds = iter->second;
+        offer.sle = std::move (sle);
+
+        auto& book = books[bookBase (offer.directory)];
+        if (! book)
+            book = std::make_shared<Offers> ();
+        book->push_back (std::move (offer));
+    }
+
+    for (auto& book : books)
+    {
+        std::sort (book.second->begin (), book.second->end (), walkOrder);
+        snapshot->books_.emplace (book.first, std::move (book.second));
+    }
+
+    // No page holds more entries than there are offers
+    snapshot->nextOrder_ = sles.size ();
+
+    JLOG (j_.info ()) << "Built book index of ledger " <<
+        ledger.seq () << ": " << sles.size () << " offers, " <<
+        snapshot->books_.size () << " books in " <<
+        std::chrono::duration_cast<std::chrono::milliseconds> (
+            std::chrono::steady_clock::now () - start).count () << "ms";
+    return snapshot;
+}
+
+std::shared_ptr<BookIndex::Snapshot const>
+BookIndex::apply (Snapshot const& prev, ReadView const& ledger) const
+{
+    // The reserve changes what every owner of CSC can offer
+    auto const& fees = ledger.fees ();
+    if (fees.reserve != prev.fees_.reserve ||
+            fees.increment != prev.fees_.increment)
+        return nullptr;
+
+    // Metadata in the order the transactions were applied
+    std::map<std::uint32_t, std::shared_ptr<STObject const>> metas;
+    for (auto const& item : ledger.txs)
+    {
+        if (! item.second)
+            return nullptr;
+        metas.emplace ((*item.second)[sfTransactionIndex], item.second);
+    }
+
+    auto next = std::make_shared<Snapshot> ();
+    next->seq_ = ledger.seq ();
+    next->hash_ = ledger.info ().hash;
+    next->fees_ = fees;
+    next->books_ = prev.books_;
+    next->nextOrder_ = prev.nextOrder_;
+
+    // Offers as they are in the ledger, nullptr if deleted, by book
+    hash_map<uint256, hash_map<uint256, std::shared_ptr<SLE const>>> offers;
+    // The order of offers added to a page, given in the order the
+    // transactions were applied
+    hash_map<uint256, std::uint64_t> orders;
+    // Owners whose holdings of an issue changed
+    hash_map<Issue, hash_set<AccountID>> owners;
+    // Issuers whose flags changed, which may freeze all their issues
+    hash_set<AccountID> issuers;
+
+    for (auto const& meta : metas)
+    {
+        for (auto const& node : meta.second->getFieldArray (sfAffectedNodes))
+        {
+            auto const type = node.getFieldU16 (sfLedgerEntryType);
+            if (type != ltOFFER && type != ltACCOUNT_ROOT &&
+                    type != ltCASINOCOIN_STATE)
+                continue;
+
+            bool const created = node.getFName () == sfCreatedNode;
+            auto const& fields = created ? sfNewFields : sfFinalFields;
+            if (! node.isFieldPresent (fields))
+                return nullptr;
+            auto const& obj = node.getFieldObject (fields);
+            auto const key = node.getFieldH256 (sfLedgerIndex);
+
+            if (type == ltOFFER)
+            {
+                if (! obj.isFieldPresent (sfBookDirectory))
+                    return nullptr;
+                offers[bookBase (obj.getFieldH256 (sfBookDirectory))][key] =
+                    ledger.read (keylet::offer (key));
+                if (created)
+                    orders[key] = next->nextOrder_++;
+            }
+            else if (type == ltACCOUNT_ROOT)
+            {
+                if (! obj.isFieldPresent (sfAccount))
+                    return nullptr;
+                auto const account = obj.getAccountID (sfAccount);
+                owners[cscIssue ()].insert (account);
+                if (node.isFieldPresent (sfPreviousFields) &&
+                        node.getFieldObject (sfPreviousFields).
+                            isFieldPresent (sfFlags))
+                    issuers.insert (account);
+            }
+            else
+            {
+                if (! obj.isFieldPresent (sfLowLimit) ||
+                        ! obj.isFieldPresent (sfHighLimit) ||
+                        ! obj.isFieldPresent (sfBalance))
+                    return nullptr;
+                auto const low = obj.getFieldAmount (sfLowLimit).getIssuer ();
+                auto const high = obj.getFieldAmount (sfHighLimit).getIssuer ();
+                auto const currency =
+                    obj.getFieldAmount (sfBalance).getCurrency ();
+                owners[Issue (currency, high)].insert (low);
+                owners[Issue (currency, low)].insert (high);
+            }
+        }
+    }
+
+    // The offers of a book, copied from the previous index when first
+    // changed
+    hash_map<uint256, std::shared_ptr<Offers>> edited;
+    auto const edit = [&](uint256 const& base) -> Offers&
+    {
+        auto& book = edited[base];
+        if (! book)
+        {
+            auto const iter = next->books_.find (base);
+            book = (iter == next->books_.end ()) ?
+                std::make_shared<Offers> () :
+                std::make_shared<Offers> (*iter->second);
+        }
+        return *book;
+    };
+
+    // Refresh the funds of owners whose holdings changed
+    if (! owners.empty () || ! issuers.empty ())
+    {
+        for (auto const& book : next->books_)
+        {
+            auto const& issue = book.second->front ().sle->
+                getFieldAmount (sfTakerGets).issue ();
+            bool const all = issuers.count (issue.account) != 0;
+            auto const changed = owners.find (issue);
+            if (! all && changed == owners.end ())
+                continue;
+
+            Offers* editing = nullptr;
+            for (std::size_t i = 0; i < book.second->size (); ++i)
+            {
+                auto const& sle = *(*book.second)[i].sle;
+                if (! all && ! changed->second.count (
+                        sle.getAccountID (sfAccount)))
+                    continue;
+                if (! editing)
+                    editing = &edit (book.first);
+                (*editing)[i].ownerFunds = ownerFunds (ledger, sle);
+            }
+        }
+    }
+
+    // Add, replace and remove the offers which changed
+    for (auto& book : offers)
+    {
+        auto& changed = book.second;
+        auto& entries = edit (book.first);
+
+        Offers kept;
+        kept.reserve (entries.size () + changed.size ());
+        for (auto& offer : entries)
+        {
+            auto const iter = changed.find (offer.sle->key ());
+            if (iter != changed.end ())
+            {
+                auto sle = std::move (iter->second);
+                changed.erase (iter);
+                if (! sle)
+                    continue;
+                offer.sle = std::move (sle);
+                offer.ownerFunds = ownerFunds (ledger, *offer.sle);
+            }
+            kept.push_back (std::move (offer));
+        }
+        entries.swap (kept);
+
+        for (auto& change : changed)
+        {
+            if (! change.second)
+                continue;
+
+            Offer offer;
+            offer.directory = change.second->getFieldH256 (sfBookDirectory);
+            offer.page = change.second->getFieldU64 (sfBookNode);
+            auto const order = orders.find (change.first);
+            offer.order = (order != orders.end ()) ?
+                order->second : next->nextOrder_++;
+            offer.ownerFunds = ownerFunds (ledger, *change.second);
+            offer.sle = std::move (change.second);
+            entries.push_back (std::move (offer));
+        }
+
+        std::sort (entries.begin (), entries.end (), walkOrder);
+    }
+
+    for (auto& book : edited)
+    {
+        if (book.second->empty ())
+            next->books_.erase (book.first);
+        else
+            next->books_[book.first] = std::move (book.second);
+    }
+
+    JLOG (j_.debug ()) << "Applied ledger " << ledger.seq () <<
+        " to book index: " << offers.size () << " books with offer changes, " <<
+        edited.size () << " books changed";
+    return next;
+}
+
+} // casinocoin
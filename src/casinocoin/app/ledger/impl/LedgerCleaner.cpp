@@ -28,6 +28,7 @@
 #include <casinocoin/app/ledger/InboundLedgers.h>
 #include <casinocoin/app/ledger/LedgerMaster.h>
 #include <casinocoin/app/misc/LoadFeeTrack.h>
+#include <casinocoin/core/WorkerPool.h>
 #include <casinocoin/protocol/JsonFields.h>
 #include <casinocoin/beast/core/CurrentThreadName.h>
 
@@ -81,6 +82,10 @@ class LedgerCleanerImp : public LedgerCleaner
     // Number of errors encountered since last success
     int failures_ = 0;
 
+    // The ledger whose nodes were last found to all be present. Only
+    // used by the cleaner thread.
+    std::shared_ptr<Ledger const> checked_;
+
     //--------------------------------------------------------------------------
 public:
     LedgerCleanerImp (
@@ -337,7 +342,7 @@ private:
             doTxns = true;
         }
 
-        if (doNodes && !nodeLedger->walkLedger(app_.journal ("Ledger")))
+        if (doNodes && !checkNodes (nodeLedger))
         {
             JLOG (j_.debug()) << "Ledger " << ledgerIndex << " is missing nodes";
             app_.getLedgerMaster().clearLedger (ledgerIndex);
@@ -355,6 +360,50 @@ private:
         return true;
     }
 
+    /** Check that all the nodes of a ledger are present.
+
+        Ledgers are checked from the newest down. When the ledger after
+        this one was checked last, only the state nodes which differ
+        from it are walked, as the shared ones were found then.
+
+        @return `true` if no node is missing.
+    */
+    bool checkNodes (std::shared_ptr<Ledger const> const& ledger)
+    {
+        bool complete = false;
+        if (checked_ &&
+            checked_->info().seq == ledger->info().seq + 1 &&
+            checked_->info().parentHash == ledger->info().hash &&
+            ledger->stateMap().getHash().as_uint256() ==
+                ledger->info().accountHash)
+        {
+            try
+            {
+                ledger->stateMap().visitDelta (checked_->stateMap(),
+                    [](uint256 const&, SHAMap::DeltaItem const&)
+                    {
+                        return true;
+                    }, &app_.getWorkerPool());
+
+                std::vector<SHAMapMissingNode> missing;
+                ledger->txMap().walkMap (missing, 1);
+                complete = missing.empty();
+            }
+            catch (SHAMapMissingNode const& e)
+            {
+                JLOG (j_.info()) << "Ledger " << ledger->info().seq <<
+                    ": " << e;
+            }
+        }
+        else
+        {
+            complete = ledger->walkLedger (app_.journal ("Ledger"));
+        }
+
+        checked_ = complete ? ledger : nullptr;
+        return complete;
+    }
+
     /** Returns the hash of the specified ledger.
         @param ledgerIndex The index of the desired ledger.
         @param referenceLedger [out] An optional known good subsequent ledger.
@@ -1724,6 +1724,7 @@ void LedgerMaster::doAdvance ()
                 {
                     ScopedUnlockType sul(m_mutex);
                     app_.getOPs().pubLedger(ledger);
+                    app_.getOrderBookDB().setup(ledger);
                 }
             }
 
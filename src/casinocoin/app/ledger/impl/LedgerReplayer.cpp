@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/ledger/LedgerReplayer.h>
+#include <casinocoin/app/main/Application.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/app/tx/apply.h>
+#include <casinocoin/basics/Log.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <casinocoin/ledger/OpenView.h>
+#include <casinocoin/protocol/Feature.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <map>
+
+namespace casinocoin {
+
+static std::chrono::microseconds
+elapsed (LedgerReplayer::clock_type::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds> (
+        LedgerReplayer::clock_type::now () - start);
+}
+
+Json::Value
+LedgerReplayer::Result::getJson () const
+{
+    Json::Value ret (Json::objectValue);
+    ret[jss::ledger_index] = seq;
+    ret[jss::transactions] = static_cast<Json::UInt> (transactions);
+    ret[jss::load_us] = static_cast<Json::UInt> (load.count ());
+    ret[jss::apply_us] = static_cast<Json::UInt> (apply.count ());
+    ret[jss::close_us] = static_cast<Json::UInt> (close.count ());
+    ret[jss::matched] = matched;
+    if (mismatched != 0)
+        ret[jss::mismatched] = static_cast<Json::UInt> (mismatched);
+    if (! matched)
+    {
+        ret[jss::ledger_hash] = to_string (hash);
+        ret[jss::account_hash] = to_string (accountHash);
+        ret[jss::transaction_hash] = to_string (txHash);
+        if (! differences.empty ())
+        {
+            auto& jv = (ret[jss::differences] = Json::arrayValue);
+            for (auto const& key : differences)
+                jv.append (to_string (key));
+        }
+    }
+    return ret;
+}
+
+// How many differing state entries to report for a ledger
+static std::size_t const maxDifferences = 32;
+
+LedgerReplayer::LedgerReplayer (Application& app, beast::Journal j)
+    : app_ (app)
+    , j_ (j)
+{
+}
+
+boost::optional<LedgerReplayer::Result>
+LedgerReplayer::replay (std::shared_ptr<Ledger const> const& parent,
+    std::shared_ptr<Ledger const> const& ledger)
+{
+    if (! parent || ! ledger ||
+            ledger->info ().parentHash != parent->info ().hash)
+        return boost::none;
+
+    Result result;
+    result.seq = ledger->info ().seq;
+
+    // The transactions in the order they were applied, with their results
+    auto start = clock_type::now ();
+    std::map<std::uint32_t, std::pair<
+        std::shared_ptr<STTx const>, TER>> txs;
+    for (auto const& item : ledger->txs)
+    {
+        auto const& meta = *item.second;
+        txs.emplace (meta[sfTransactionIndex], std::make_pair (item.first,
+            static_cast<TER> (meta[sfTransactionResult])));
+    }
+    result.transactions = txs.size ();
+    result.load = elapsed (start);
+
+    auto const& info = ledger->info ();
+
+    start = clock_type::now ();
+    auto built = std::make_shared<Ledger> (*parent, info.closeTime);
+    if (built->rules ().enabled (featureSHAMapV2) &&
+            ! built->stateMap ().is_v2 ())
+        built->make_v2 ();
+    {
+        OpenView accum (&*built);
+        for (auto const& tx : txs)
+        {
+            auto const ter = apply (app_, accum, *tx.second.first,
+                tapNO_CHECK_SIGN, j_).first;
+            if (ter != tx.second.second)
+            {
+                ++result.mismatched;
+                JLOG (j_.warn ()) << "Ledger " << info.seq << " transaction " <<
+                    tx.second.first->getTransactionID () << ": " <<
+                    transToken (ter) << " instead of " <<
+                    transToken (tx.second.second);
+            }
+        }
+        accum.apply (*built);
+    }
+    result.apply = elapsed (start);
+
+    start = clock_type::now ();
+    built->updateSkipList ();
+    built->setAccepted (info.closeTime, info.closeTimeResolution,
+        getCloseAgree (info), app_.config ());
+    result.close = elapsed (start);
+
+    result.hash = built->info ().hash;
+    result.accountHash = built->info ().accountHash;
+    result.txHash = built->info ().txHash;
+    result.matched = result.hash == info.hash &&
+        result.accountHash == info.accountHash &&
+            result.txHash == info.txHash;
+
+    if (! result.matched)
+    {
+        JLOG (j_.error ()) << "Ledger " << info.seq << " replayed as " <<
+            result.hash << " instead of " << info.hash;
+
+        if (result.accountHash != info.accountHash)
+        {
+            built->stateMap ().visitDelta (ledger->stateMap (),
+                [&](uint256 const& key, SHAMap::DeltaItem const&)
+                {
+                    result.differences.push_back (key);
+                    return result.differences.size () < maxDifferences;
+                }, &app_.getWorkerPool ());
+            if (! result.differences.empty ())
+                JLOG (j_.error ()) << "Ledger " << info.seq <<
+                    " state first differs at " << result.differences.front ();
+        }
+    }
+    return result;
+}
+
+Json::Value
+LedgerReplayer::replay (std::uint32_t first, std::uint32_t last)
+{
+    auto& profiler = app_.getApplyProfiler ();
+    bool const profiling = profiler.enabled ();
+    profiler.reset ();
+    profiler.enable (true);
+
+    Json::Value ret (Json::objectValue);
+    auto& ledgers = (ret[jss::ledgers] = Json::arrayValue);
+    std::size_t transactions = 0;
+    std::size_t failed = 0;
+    std::chrono::microseconds applyTime {0};
+
+    auto const load = [&](std::uint32_t seq)
+        -> std::shared_ptr<Ledger const>
+    {
+        try
+        {
+            return loadByIndex (seq, app_);
+        }
+        catch (SHAMapMissingNode const& e)
+        {
+            JLOG (j_.error ()) << "Ledger " << seq << ": " << e.what ();
+            return nullptr;
+        }
+    };
+
+    std::shared_ptr<Ledger const> parent =
+        (first > 1) ? load (first - 1) : nullptr;
+    for (auto seq = first; seq <= last; ++seq)
+    {
+        auto const start = clock_type::now ();
+        auto ledger = load (seq);
+        auto const loadTime = elapsed (start);
+
+        boost::optional<Result> result;
+        try
+        {
+            result = replay (parent, ledger);
+        }
+        catch (SHAMapMissingNode const& e)
+        {
+            JLOG (j_.error ()) << "Ledger " << seq << ": " << e.what ();
+        }
+
+        if (! result)
+        {
+            JLOG (j_.warn ()) << "Ledger " << seq << " can't be replayed";
+            ++failed;
+            Json::Value& jv = ledgers.append (Json::objectValue);
+            jv[jss::ledger_index] = seq;
+            jv[jss::matched] = false;
+        }
+        else
+        {
+            result->load += loadTime;
+            if (! result->matched)
+                ++failed;
+            transactions += result->transactions;
+            applyTime += result->apply;
+            ledgers.append (result->getJson ());
+
+            JLOG (j_.info ()) << "Ledger " << seq << ": " <<
+                result->transactions << " transactions applied in " <<
+                result->apply.count () << "us";
+        }
+
+        parent = std::move (ledger);
+    }
+
+    ret[jss::transactions] = static_cast<Json::UInt> (transactions);
+    ret[jss::apply_us] = static_cast<Json::UInt> (applyTime.count ());
+    ret[jss::failed] = static_cast<Json::UInt> (failed);
+    ret[jss::profile] = profiler.getJson ();
+
+    profiler.enable (profiling);
+    return ret;
+}
+
+} // casinocoin
@@ -134,12 +134,15 @@ public:
 
         // Get the set of local transactions as a canonical
         // set (so they apply in a valid order)
+        std::vector<std::shared_ptr<STTx const>> txns;
         {
             std::lock_guard <std::mutex> lock (m_lock);
 
+            txns.reserve (m_txns.size ());
             for (auto const& it : m_txns)
-                tset.insert (it.getTX());
+                txns.push_back (it.getTX());
         }
+        tset.insert (txns);
 
         return tset;
     }
@@ -30,7 +30,10 @@
 #include <casinocoin/app/tx/apply.h>
 #include <casinocoin/ledger/CachedView.h>
 #include <casinocoin/protocol/Feature.h>
+#include <casinocoin/protocol/Indexes.h>
 #include <boost/range/adaptor/transformed.hpp>
+#include <algorithm>
+#include <chrono>
 
 namespace casinocoin {
 
@@ -41,6 +44,7 @@ OpenLedger::OpenLedger(std::shared_ptr<
     : j_ (journal)
     , cache_ (cache)
     , current_ (create(ledger->rules(), ledger))
+    , ledger_ (ledger)
 {
 }
 
@@ -62,15 +66,22 @@ OpenLedger::current() const
 }
 
 bool
-OpenLedger::modify (modify_type const& f)
+OpenLedger::modify (modify_type const& f,
+    std::vector<uint256> prefetched)
 {
     std::lock_guard<
         std::mutex> lock1(modify_mutex_);
     auto next = std::make_shared<
         OpenView>(*current_);
+    TxRecorder recorder;
+    recorder.expect(std::move(prefetched));
+    next->record(&recorder);
     auto const changed = f(*next, j_);
+    misses_ += recorder.unexpected();
+    next->record(nullptr);
     if (changed)
     {
+        footprints_.append(std::move(recorder));
         std::lock_guard<
             std::mutex> lock2(
                 current_mutex_);
@@ -85,11 +96,16 @@ OpenLedger::accept(Application& app, Rules const& rules,
         OrderedTxs const& locals, bool retriesFirst,
             OrderedTxs& retries, ApplyFlags flags,
                 std::string const& suffix,
-                    modify_type const& f)
+                    modify_type const& f,
+                        std::vector<uint256> prefetched)
 {
     JLOG(j_.trace()) <<
         "accept ledger " << ledger->seq() << " " << suffix;
+    auto const start = std::chrono::steady_clock::now();
+    TxRecorder recorder;
+    recorder.expect(std::move(prefetched));
     auto next = create(rules, ledger);
+    next->record(&recorder);
     if (retriesFirst)
     {
         // Handle disputed tx, outside lock
@@ -104,8 +120,11 @@ OpenLedger::accept(Application& app, Rules const& rules,
     // would get lost.
     std::lock_guard<
         std::mutex> lock1(modify_mutex_);
-    // Apply tx from the current open view
-    if (! current_->txs.empty())
+    // Apply tx from the current open view, carrying
+    // over what the closed ledger didn't change
+    if (! current_->txs.empty() &&
+        ! carry(app, *next, recorder, *ledger,
+            retries, flags))
         apply (app, *next, *ledger,
             boost::adaptors::transform(
                 current_->txs,
@@ -123,12 +142,66 @@ OpenLedger::accept(Application& app, Rules const& rules,
     for (auto const& item : locals)
         app.getTxQ().apply(app, *next,
             item.second, flags, j_);
+    misses_ += recorder.unexpected();
+    next->record(nullptr);
+    recorder.finish();
+    footprints_ = std::move(recorder);
+    ledger_ = ledger;
+    rebuildTime_ = std::chrono::duration_cast<
+        std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
     // Switch to the new open view
     std::lock_guard<
         std::mutex> lock2(current_mutex_);
     current_ = std::move(next);
 }
 
+std::vector<uint256>
+OpenLedger::prefetch (Ledger const& ledger,
+    std::vector<std::shared_ptr<STTx const>> const& txs)
+{
+    std::vector<uint256> keys;
+    for (auto const& tx : txs)
+        likelyKeys(*tx, keys);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    auto const reads = ledger.stateMap().prefetch(keys);
+    prefetchKeys_ += keys.size();
+    prefetchReads_ += reads;
+
+    JLOG(j_.trace()) <<
+        "prefetch " << txs.size() << " tx, " << keys.size() <<
+            " keys, " << reads << " reads";
+    return keys;
+}
+
+std::vector<uint256>
+OpenLedger::prefetch (Ledger const& ledger,
+    OrderedTxs const& locals, OrderedTxs const& retries)
+{
+    std::vector<std::shared_ptr<STTx const>> txs;
+    for (auto const& item : retries)
+        txs.push_back(item.second);
+    for (auto const& item : current()->txs)
+        txs.push_back(item.first);
+    for (auto const& item : locals)
+        txs.push_back(item.second);
+    return prefetch(ledger, txs);
+}
+
+auto
+OpenLedger::prefetchStats () const -> PrefetchStats
+{
+    return { prefetchKeys_, prefetchReads_, misses_ };
+}
+
+auto
+OpenLedger::rebuildStats () const -> RebuildStats
+{
+    return { rebuildTime_, carried_, reapplied_ };
+}
+
 //------------------------------------------------------------------------------
 
 std::shared_ptr<OpenView>
@@ -149,8 +222,13 @@ OpenLedger::apply_one (Application& app, OpenView& view,
 {
     if (retry)
         flags = flags | tapRETRY;
-    auto const result = casinocoin::apply(
-        app, view, *tx, flags, j);
+    return classify(casinocoin::apply(
+        app, view, *tx, flags, j));
+}
+
+auto
+OpenLedger::classify (std::pair<TER, bool> const& result) -> Result
+{
     if (result.second)
         return Result::success;
     if (isTefFailure (result.first) ||
@@ -160,6 +238,227 @@ OpenLedger::apply_one (Application& app, OpenView& view,
     return Result::retry;
 }
 
+// Past this many changed keys, applying everything again is cheaper
+// than walking the difference between the ledgers
+static std::size_t const maxCarryDelta = 65536;
+
+// Whether the result of a transaction depends only on the state
+// it reads, and not on the time or sequence of the ledger
+static
+bool
+carryable (STTx const& tx, LedgerIndex seq)
+{
+    switch (tx.getTxnType())
+    {
+    case ttPAYMENT:
+    case ttACCOUNT_SET:
+    case ttREGULAR_KEY_SET:
+    case ttSIGNER_LIST_SET:
+    case ttTRUST_SET:
+    case ttOFFER_CANCEL:
+        break;
+    default:
+        return false;
+    }
+    return ! tx.isFieldPresent(sfLastLedgerSequence) ||
+        tx.getFieldU32(sfLastLedgerSequence) >= seq;
+}
+
+bool
+OpenLedger::carry (Application& app, OpenView& view,
+    TxRecorder& recorder, Ledger const& ledger,
+        OrderedTxs& retries, ApplyFlags flags)
+{
+    // The state the transactions read must be all that differs
+    if (! footprints_.complete() ||
+        footprints_.footprints().size() != current_->txCount() ||
+        ledger_->stateMap().is_v2() != ledger.stateMap().is_v2() ||
+        ! (view.rules() == current_->rules()) ||
+        ledger_->fees().base != ledger.fees().base ||
+        ledger_->fees().units != ledger.fees().units ||
+        ledger_->fees().reserve != ledger.fees().reserve ||
+        ledger_->fees().increment != ledger.fees().increment ||
+        ledger_->ledgerConfig().lastUpdateIndex !=
+            ledger.ledgerConfig().lastUpdateIndex)
+        return false;
+
+    // Keys whose state in the new view may differ from what the
+    // transactions saw, starting with those the ledger changed
+    hash_set<uint256> dirty;
+    if (! ledger_->stateMap().visitDelta(ledger.stateMap(),
+        [&](uint256 const& key, SHAMap::DeltaItem const&)
+        {
+            dirty.insert(key);
+            return dirty.size() < maxCarryDelta;
+        }))
+    {
+        JLOG(j_.debug()) <<
+            "carry: ledger " << ledger.seq() << " changed too much";
+        return false;
+    }
+
+    // Retries applied first changed the view already
+    recorder.finish();
+    for (auto const& fp : recorder.footprints())
+        fp->addWrites(dirty);
+
+    // Walk the transactions in the order they were applied. Each
+    // one carried over leaves exactly the state it left before, so
+    // only the keys written by transactions applied differently
+    // need to be added.
+    std::uint32_t carried = 0;
+    std::uint32_t reapplied = 0;
+    for (auto const& fp : footprints_.footprints())
+    {
+        try
+        {
+            if (ledger.txExists(fp->id))
+            {
+                fp->addWrites(dirty);
+                continue;
+            }
+
+            auto const tx = std::make_shared<STTx const>(
+                SerialIter{ fp->txn->slice() });
+            if (! fp->ranged && ! fp->touches(dirty) &&
+                ! view.txExists(fp->id) &&
+                    carryable(*tx, view.seq()))
+            {
+                recorder.replay(view, fp);
+                ++carried;
+                continue;
+            }
+
+            fp->addWrites(dirty);
+            ++reapplied;
+            if (apply_one(app, view, tx, true, flags, j_) ==
+                    Result::retry)
+                retries.insert(tx);
+            auto const last = recorder.last();
+            if (last && last->id == fp->id)
+                last->addWrites(dirty);
+        }
+        catch(std::exception const&)
+        {
+            JLOG(j_.error()) <<
+                "Caught exception";
+        }
+    }
+    applyRetries(app, view, retries, flags, j_);
+
+    carried_ += carried;
+    reapplied_ += reapplied;
+    JLOG(j_.debug()) <<
+        "carry: " << carried << " carried, " << reapplied <<
+            " applied again, " << dirty.size() << " keys changed";
+    return true;
+}
+
+void
+OpenLedger::applyBatch (Application& app, OpenView& view,
+    std::vector<std::shared_ptr<STTx const>> const& txs,
+        OrderedTxs& retries, ApplyFlags flags,
+            beast::Journal j)
+{
+    auto const results = applyParallel(app, view, txs,
+        flags | tapRETRY, app.config().APPLY_THREADS, j);
+    for (std::size_t i = 0; i < txs.size(); ++i)
+    {
+        if (classify(results[i]) == Result::retry)
+            retries.insert(txs[i]);
+    }
+}
+
+void
+OpenLedger::applyRetries (Application& app, OpenView& view,
+    OrderedTxs& retries, ApplyFlags flags,
+        beast::Journal j)
+{
+    bool retry = true;
+    for (int pass = 0;
+        pass < LEDGER_TOTAL_PASSES;
+            ++pass)
+    {
+        int changes = 0;
+        auto iter = retries.begin();
+        while (iter != retries.end())
+        {
+            switch (apply_one(app, view,
+                iter->second, retry, flags,
+                    j))
+            {
+            case Result::success:
+                ++changes;
+            case Result::failure:
+                iter = retries.erase (iter);
+                break;
+            case Result::retry:
+                ++iter;
+            }
+        }
+        // A non-retry pass made no changes
+        if (! changes && ! retry)
+            return;
+        // Stop retriable passes
+        if (! changes || (pass >= LEDGER_RETRY_PASSES))
+            retry = false;
+    }
+
+    // If there are any transactions left, we must have
+    // tried them in at least one final pass
+    assert (retries.empty() || ! retry);
+}
+
+//------------------------------------------------------------------------------
+
+void
+likelyKeys (STTx const& tx, std::vector<uint256>& keys)
+{
+    auto const account = tx.getAccountID(sfAccount);
+    keys.push_back(keylet::account(account).key);
+    keys.push_back(keylet::ownerDir(account).key);
+
+    boost::optional<AccountID> destination;
+    if (tx.isFieldPresent(sfDestination))
+    {
+        destination = tx.getAccountID(sfDestination);
+        keys.push_back(keylet::account(*destination).key);
+    }
+
+    // The issuer and the lines of both parties for an issue
+    auto const lines = [&](Issue const& issue)
+    {
+        if (isCSC(issue.currency))
+            return;
+        keys.push_back(keylet::account(issue.account).key);
+        if (account != issue.account)
+            keys.push_back(keylet::line(account, issue).key);
+        if (destination && *destination != issue.account)
+            keys.push_back(keylet::line(*destination, issue).key);
+    };
+
+    for (auto const field : { &sfAmount, &sfSendMax, &sfLimitAmount })
+    {
+        if (tx.isFieldPresent(*field))
+            lines(tx.getFieldAmount(*field).issue());
+    }
+
+    if (tx.isFieldPresent(sfTakerPays) && tx.isFieldPresent(sfTakerGets))
+    {
+        auto const pays = tx.getFieldAmount(sfTakerPays).issue();
+        auto const gets = tx.getFieldAmount(sfTakerGets).issue();
+        lines(pays);
+        lines(gets);
+        // The book the offer crosses and the one it is placed in
+        keys.push_back(keylet::book(Book(gets, pays)).key);
+        keys.push_back(keylet::book(Book(pays, gets)).key);
+    }
+
+    if (tx.isFieldPresent(sfOfferSequence))
+        keys.push_back(keylet::offer(account,
+            tx.getFieldU32(sfOfferSequence)).key);
+}
+
 //------------------------------------------------------------------------------
 
 std::string
@@ -51,6 +51,8 @@
 #include <casinocoin/app/misc/NetworkOPs.h>
 #include <casinocoin/app/misc/SHAMapStore.h>
 #include <casinocoin/app/misc/TxQ.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/app/misc/SigVerifier.h>
 #include <casinocoin/app/misc/ValidatorSite.h>
 #include <casinocoin/app/misc/configuration/VotableConfiguration.h>
 #include <casinocoin/app/misc/BlacklistUpdater.h>
@@ -60,6 +62,7 @@
 #include <casinocoin/basics/Sustain.h>
 #include <casinocoin/json/json_reader.h>
 #include <casinocoin/core/DeadlineTimer.h>
+#include <casinocoin/core/WorkerPool.h>
 #include <casinocoin/nodestore/DummyScheduler.h>
 #include <casinocoin/overlay/Cluster.h>
 #include <casinocoin/overlay/make_Overlay.h>
@@ -67,6 +70,7 @@
 #include <casinocoin/resource/Fees.h>
 #include <casinocoin/beast/asio/io_latency_probe.h>
 #include <casinocoin/beast/core/LexicalCast.h>
+#include <chrono>
 #include <fstream>
 
 namespace casinocoin {
@@ -286,6 +290,7 @@ public:
     NodeCache m_tempNodeCache;
     std::unique_ptr <CollectorManager> m_collectorManager;
     CachedSLEs cachedSLEs_;
+    WorkerPool workerPool_;
     std::pair<PublicKey, SecretKey> nodeIdentity_;
 
     std::unique_ptr <Resource::Manager> m_resourceManager;
@@ -322,6 +327,8 @@ public:
     std::unique_ptr <LoadManager> m_loadManager;
     std::unique_ptr <VotableConfiguration> m_votableConfig;
     std::unique_ptr <TxQ> txQ_;
+    std::unique_ptr <ApplyProfiler> applyProfiler_;
+    std::unique_ptr <SigVerifier> sigVerifier_;
     DeadlineTimer m_sweepTimer;
     DeadlineTimer m_entropyTimer;
     bool startTimers_;
@@ -455,6 +462,9 @@ public:
     CachedSLEs&
     cachedSLEs() override { return cachedSLEs_; }
 
+    WorkerPool&
+    getWorkerPool() override { return workerPool_; }
+
     AmendmentTable&
     getAmendmentTable() override { return *m_amendmentTable; }
 
@@ -509,6 +519,12 @@ public:
 
     TxQ& getTxQ() override;
 
+    ApplyProfiler&
+    getApplyProfiler () override { return *applyProfiler_; }
+
+    SigVerifier&
+    getSigVerifier () override { return *sigVerifier_; }
+
     DatabaseCon& getTxnDB () override;
     DatabaseCon& getLedgerDB () override;
     DatabaseCon& getWalletDB () override;
@@ -555,6 +571,14 @@ private:
     bool updateTables ();
     void startGenesisLedger ();
 
+    boost::filesystem::path fullBelowFile () const
+    {
+        auto const dbPath = config_->legacy ("database_path");
+        if (dbPath.empty ())
+            return {};
+        return boost::filesystem::path (dbPath) / "full_below.bin";
+    }
+
     std::shared_ptr<Ledger>
     getLastFullLedger();
 
@@ -607,6 +631,8 @@ ApplicationImp::ApplicationImp(std::unique_ptr<Config> config, std::unique_ptr<L
 
     , cachedSLEs_ (std::chrono::minutes(1), stopwatch())
 
+    , workerPool_ (0)
+
     , m_resourceManager (Resource::make_Manager (
         m_collectorManager->collector(), logs_->journal("Resource")))
 
@@ -704,6 +730,13 @@ ApplicationImp::ApplicationImp(std::unique_ptr<Config> config, std::unique_ptr<L
 
     , txQ_(make_TxQ(setup_TxQ(*config_), logs_->journal("TxQ")))
 
+    , applyProfiler_ (std::make_unique<ApplyProfiler> (
+        m_collectorManager->group ("apply")))
+
+    , sigVerifier_ (std::make_unique<SigVerifier> (
+        setup_SigVerifier (*config_), *m_jobQueue, workerPool_,
+            logs_->journal ("SigVerifier")))
+
     , m_sweepTimer (this)
 
     , m_entropyTimer (this)
@@ -997,6 +1030,36 @@ bool ApplicationImp::setup()
     family().treecache().setTargetSize (config_->getSize (siTreeCacheSize));
     family().treecache().setTargetAge (config_->getSize (siTreeCacheAge));
 
+    if (!config_->standalone() && !fullBelowFile().empty())
+    {
+        // Trust subtrees found complete before the last shutdown once
+        // each one is confirmed to still be wholly in the node store.
+        // The check walks the node store, so it runs in the background
+        // and sync treats the keys as unknown until then.
+        if (loadFullBelow (family().fullbelow(), fullBelowFile(),
+            [this](uint256 const& key)
+            {
+                return subtreeInStore (family().fullbelow(),
+                    *m_nodeStore, key, m_journal);
+            }, m_journal) != 0)
+        {
+            m_jobQueue->addJob (jtSWEEP, "fullBelowVerify",
+                [this] (Job& job)
+                {
+                    auto const start = std::chrono::steady_clock::now ();
+                    auto const pending = family().fullbelow().pendingSize ();
+                    auto const restored = family().fullbelow().verifyPending (
+                        job.getCancelCallback ());
+                    JLOG (m_journal.info()) <<
+                        "Verified " << restored << " of " << pending <<
+                        " full below keys in " <<
+                        std::chrono::duration_cast<std::chrono::milliseconds> (
+                            std::chrono::steady_clock::now () - start).count () <<
+                        "ms";
+                });
+        }
+    }
+
     //----------------------------------------------------------------------
     //
     // Server
@@ -1728,6 +1791,9 @@ void ApplicationImp::onStop()
     mValidations->flush ();
     m_crnReports->flush ();
 
+    if (!config_->standalone() && !fullBelowFile().empty())
+        saveFullBelow (family().fullbelow(), fullBelowFile(), m_journal);
+
     // stop the relaynode refresh cycle
     crnListUpdater_->stop ();
     // stop the validator site refresh cycle
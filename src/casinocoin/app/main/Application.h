@@ -46,6 +46,9 @@ namespace NodeStore { class Database; }
 // VFALCO TODO Fix forward declares required for header dependency loops
 class VotableConfiguration;
 class AmendmentTable;
+class ApplyProfiler;
+class SigVerifier;
+class WorkerPool;
 class CachedSLEs;
 class CollectorManager;
 class Family;
@@ -144,6 +147,9 @@ public:
     virtual LoadManager&            getLoadManager () = 0;
     virtual Overlay&                overlay () = 0;
     virtual TxQ&                    getTxQ() = 0;
+    virtual ApplyProfiler&          getApplyProfiler() = 0;
+    virtual SigVerifier&            getSigVerifier() = 0;
+    virtual WorkerPool&             getWorkerPool() = 0;
     virtual ValidatorList&          validators () = 0;
     virtual ValidatorSite&          validatorSites () = 0;
     virtual CRNList&                relaynodes () = 0;
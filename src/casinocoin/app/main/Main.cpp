@@ -26,6 +26,7 @@
 #include <BeastConfig.h>
 #include <casinocoin/basics/Log.h>
 #include <casinocoin/protocol/digest.h>
+#include <casinocoin/app/ledger/LedgerReplayer.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/basics/CheckLibraryVersions.h>
 #include <casinocoin/basics/contract.h>
@@ -41,8 +42,10 @@
 #include <casinocoin/resource/Fees.h>
 #include <casinocoin/rpc/RPCHandler.h>
 #include <casinocoin/protocol/BuildInfo.h>
+#include <casinocoin/protocol/JsonFields.h>
 #include <casinocoin/beast/clock/basic_seconds_clock.h>
 #include <casinocoin/beast/core/CurrentThreadName.h>
+#include <casinocoin/beast/core/LexicalCast.h>
 #include <casinocoin/beast/core/Time.h>
 #include <casinocoin/beast/utility/Debug.h>
 #include <beast/unit_test/dstream.hpp>
@@ -51,6 +54,7 @@
 #include <beast/unit_test/reporter.hpp>
 #include <test/quiet_reporter.h>
 #include <google/protobuf/stubs/common.h>
+#include <boost/optional.hpp>
 #include <boost/program_options.hpp>
 #include <cstdlib>
 #include <iostream>
@@ -250,6 +254,7 @@ int run (int argc, char** argv)
     ("load", "Load the current ledger from the local DB.")
     ("valid", "Consider the initial ledger a valid network ledger.")
     ("replay","Replay a ledger close.")
+    ("replay_range", po::value<std::string> (), "Re-apply the stored ledgers <first>-<last> offline and report their timings.")
     ("ledger", po::value<std::string> (), "Load the specified ledger and start from .")
     ("ledgerfile", po::value<std::string> (), "Load the specified ledger file.")
     ("start", "Start from a fresh Ledger.")
@@ -309,6 +314,24 @@ int run (int argc, char** argv)
             bool (vm.count ("unittest-log")));
     }
 
+    // Replaying a range of ledgers runs standalone and then exits
+    boost::optional<std::pair<std::uint32_t, std::uint32_t>> replayRange;
+    if (vm.count ("replay_range"))
+    {
+        auto const range = vm["replay_range"].as<std::string> ();
+        auto const dash = range.find ('-');
+        std::uint32_t first, last;
+        if (dash == std::string::npos ||
+            ! beast::lexicalCastChecked (first, range.substr (0, dash)) ||
+            ! beast::lexicalCastChecked (last, range.substr (dash + 1)) ||
+            first < 2 || last < first)
+        {
+            std::cerr << "Invalid replay_range = " << range << std::endl;
+            return -1;
+        }
+        replayRange.emplace (first, last);
+    }
+
     auto config = std::make_unique<Config>();
 
     auto configFile = vm.count ("conf") ?
@@ -316,7 +339,8 @@ int run (int argc, char** argv)
 
     // config file, quiet flag.
     config->setup (configFile, bool (vm.count ("quiet")),
-        bool(vm.count("silent")), bool(vm.count("standalone")));
+        bool(vm.count("silent")),
+        bool(vm.count("standalone")) || replayRange);
 
     {
         // Stir any previously saved entropy into the pool:
@@ -476,6 +500,20 @@ int run (int argc, char** argv)
             return -1;
         }
 
+        if (replayRange)
+        {
+            app->doStart(false /*don't start timers*/);
+
+            auto const report = LedgerReplayer (*app,
+                app->journal ("LedgerReplayer")).replay (
+                    replayRange->first, replayRange->second);
+            std::cout << report.toStyledString ();
+
+            app->signalStop ();
+            app->run ();
+            return (report[jss::failed].asUInt () == 0) ? 0 : 1;
+        }
+
         // Start the server
         app->doStart(true /*start timers*/);
 
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_MISC_BATCHTUNER_H_INCLUDED
+#define CASINOCOIN_APP_MISC_BATCHTUNER_H_INCLUDED
+
+#include <casinocoin/basics/Histogram.h>
+#include <casinocoin/json/json_value.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace casinocoin {
+
+class Config;
+
+/** Sizes the batches NetworkOPs applies to the open ledger.
+
+    The tuner keeps a running estimate of the cost of applying one
+    transaction, from the batches it is told about, and aims to keep
+    the time from submission to the open ledger under a target at the
+    99th percentile:
+
+    - A batch takes no more transactions than can be applied in half
+      the target, so one batch never holds the master lock for long
+      and a transaction waits for at most the batch running when it
+      arrives and its own.
+
+    - Relayed transactions are refused while the queue already holds
+      more work than fits in the target. The bound is scaled down
+      while the observed latency is over the target, and back up
+      while it is well under.
+
+    Batch sizes, queue wait times and latencies are kept in power of
+    two histograms.
+*/
+class BatchTuner
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    struct Setup
+    {
+        std::chrono::milliseconds targetLatency {250};
+        std::size_t minBatch = 8;
+        std::size_t maxBatch = 5000;
+    };
+
+    explicit
+    BatchTuner (Setup const& setup);
+
+    /** The number of pending transactions the next batch should take. */
+    std::size_t
+    batchSize (std::size_t pending) const;
+
+    /** Whether a relayed transaction should join a queue of `pending`. */
+    bool
+    admit (std::size_t pending);
+
+    /** Record a batch.
+
+        Only the time from `applying` to `end` counts towards the cost
+        of a transaction. Preparing the batch and waiting for the
+        master lock count towards latency only.
+
+        @param submitted When each transaction in the batch was submitted.
+        @param start When the batch was taken from the queue.
+        @param applying When the batch started being applied.
+        @param end When the batch was in the open ledger.
+    */
+    void
+    record (std::vector<clock_type::time_point> const& submitted,
+        clock_type::time_point start, clock_type::time_point applying,
+            clock_type::time_point end);
+
+    /** Estimated cost of applying one transaction, in microseconds. */
+    double
+    cost () const;
+
+    /** 99th percentile latency of recent transactions. */
+    std::chrono::microseconds
+    latency () const;
+
+    Json::Value
+    getJson () const;
+
+private:
+    // Latencies kept for the percentile
+    static std::size_t const window = 1024;
+
+    Setup const setup_;
+
+    std::mutex mutable mutex_;
+    double cost_ = 0;
+    double scale_ = 1;
+    std::uint64_t p99_ = 0;
+    std::uint64_t dropped_ = 0;
+    std::vector<std::uint64_t> recent_;
+    std::size_t next_ = 0;
+    Histogram sizes_;
+    Histogram waits_;
+    Histogram latencies_;
+};
+
+BatchTuner::Setup
+setup_BatchTuner (Config const& config);
+
+} // casinocoin
+
+#endif
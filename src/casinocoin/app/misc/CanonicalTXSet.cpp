@@ -25,58 +25,73 @@
 
 #include <BeastConfig.h>
 #include <casinocoin/app/misc/CanonicalTXSet.h>
-#include <boost/range/adaptor/transformed.hpp>
+#include <algorithm>
+#include <iterator>
 
 namespace casinocoin {
 
-bool CanonicalTXSet::Key::operator< (Key const& rhs) const
+std::uint64_t CanonicalTXSet::Key::prefix (uint256 const& account)
 {
-    if (mAccount < rhs.mAccount) return true;
+    std::uint64_t ret = 0;
+    for (auto iter = account.begin (); iter != account.begin () + 8; ++iter)
+        ret = (ret << 8) | *iter;
+    return ret;
+}
 
-    if (mAccount > rhs.mAccount) return false;
+bool CanonicalTXSet::Key::operator< (Key const& rhs) const
+{
+    // The prefixes of the accounts almost always decide, otherwise
+    // compare each field once
+    if (mPrefix != rhs.mPrefix)
+        return mPrefix < rhs.mPrefix;
 
-    if (mSeq < rhs.mSeq) return true;
+    if (auto const c = compare (mAccount, rhs.mAccount))
+        return c < 0;
 
-    if (mSeq > rhs.mSeq) return false;
+    if (mSeq != rhs.mSeq)
+        return mSeq < rhs.mSeq;
 
     return mTXid < rhs.mTXid;
 }
 
 bool CanonicalTXSet::Key::operator> (Key const& rhs) const
 {
-    if (mAccount > rhs.mAccount) return true;
-
-    if (mAccount < rhs.mAccount) return false;
+    if (mPrefix != rhs.mPrefix)
+        return mPrefix > rhs.mPrefix;
 
-    if (mSeq > rhs.mSeq) return true;
+    if (auto const c = compare (mAccount, rhs.mAccount))
+        return c > 0;
 
-    if (mSeq < rhs.mSeq) return false;
+    if (mSeq != rhs.mSeq)
+        return mSeq > rhs.mSeq;
 
     return mTXid > rhs.mTXid;
 }
 
 bool CanonicalTXSet::Key::operator<= (Key const& rhs) const
 {
-    if (mAccount < rhs.mAccount) return true;
+    if (mPrefix != rhs.mPrefix)
+        return mPrefix < rhs.mPrefix;
 
-    if (mAccount > rhs.mAccount) return false;
+    if (auto const c = compare (mAccount, rhs.mAccount))
+        return c < 0;
 
-    if (mSeq < rhs.mSeq) return true;
-
-    if (mSeq > rhs.mSeq) return false;
+    if (mSeq != rhs.mSeq)
+        return mSeq < rhs.mSeq;
 
     return mTXid <= rhs.mTXid;
 }
 
-bool CanonicalTXSet::Key::operator>= (Key const& rhs)const
+bool CanonicalTXSet::Key::operator>= (Key const& rhs) const
 {
-    if (mAccount > rhs.mAccount) return true;
-
-    if (mAccount < rhs.mAccount) return false;
+    if (mPrefix != rhs.mPrefix)
+        return mPrefix > rhs.mPrefix;
 
-    if (mSeq > rhs.mSeq) return true;
+    if (auto const c = compare (mAccount, rhs.mAccount))
+        return c > 0;
 
-    if (mSeq < rhs.mSeq) return false;
+    if (mSeq != rhs.mSeq)
+        return mSeq > rhs.mSeq;
 
     return mTXid >= rhs.mTXid;
 }
@@ -92,40 +107,116 @@ uint256 CanonicalTXSet::accountKey (AccountID const& account)
     return ret;
 }
 
+CanonicalTXSet::Key CanonicalTXSet::makeKey (STTx const& txn)
+{
+    return Key (
+        accountKey (txn.getAccountID(sfAccount)),
+        txn.getSequence (),
+        txn.getTransactionID ());
+}
+
+void CanonicalTXSet::settle () const
+{
+    if (mSorted == mEntries.size ())
+        return;
+
+    auto const less = [](value_type const& a, value_type const& b)
+    {
+        return a.first < b.first;
+    };
+    auto const middle = mEntries.begin () + mSorted;
+    std::stable_sort (middle, mEntries.end (), less);
+    std::inplace_merge (mEntries.begin (), middle, mEntries.end (), less);
+
+    // The merge is stable, so of equal keys the entry inserted first
+    // is kept, unless it was erased and a later one brings it back
+    auto out = mEntries.begin ();
+    for (auto iter = mEntries.begin (); iter != mEntries.end (); ++iter)
+    {
+        if (out != mEntries.begin () && std::prev (out)->first == iter->first)
+        {
+            // Only sorted entries can be erased, so this one is live
+            auto& kept = std::prev (out)->second;
+            if (! kept)
+            {
+                kept = std::move (iter->second);
+                --mErased;
+            }
+            continue;
+        }
+        if (out != iter)
+            *out = std::move (*iter);
+        ++out;
+    }
+    mEntries.erase (out, mEntries.end ());
+    mSorted = mEntries.size ();
+}
+
+void CanonicalTXSet::compact ()
+{
+    if (mErased == 0)
+        return;
+
+    settle ();
+    mEntries.erase (
+        std::remove_if (mEntries.begin (), mEntries.end (),
+            [](value_type const& v)
+            {
+                return ! v.second;
+            }),
+        mEntries.end ());
+    mSorted = mEntries.size ();
+    mErased = 0;
+}
+
 void CanonicalTXSet::insert (std::shared_ptr<STTx const> const& txn)
 {
-    mMap.insert (
-        std::make_pair (
-            Key (
-                accountKey (txn->getAccountID(sfAccount)),
-                txn->getSequence (),
-                txn->getTransactionID ()),
-            txn));
+    // Drop the erased entries once they are the majority
+    if (mErased * 2 > mEntries.size ())
+        compact ();
+
+    mEntries.emplace_back (makeKey (*txn), txn);
+}
+
+void CanonicalTXSet::insert (
+    std::vector<std::shared_ptr<STTx const>> const& txns)
+{
+    compact ();
+
+    mEntries.reserve (mEntries.size () + txns.size ());
+    for (auto const& txn : txns)
+        mEntries.emplace_back (makeKey (*txn), txn);
 }
 
 std::vector<std::shared_ptr<STTx const>>
 CanonicalTXSet::prune(AccountID const& account,
     std::uint32_t const seq)
 {
+    settle ();
+
     auto effectiveAccount = accountKey (account);
 
     Key keyLow(effectiveAccount, seq, zero);
     Key keyHigh(effectiveAccount, seq+1, zero);
 
-    auto range = boost::make_iterator_range(
-        mMap.lower_bound(keyLow),
-            mMap.lower_bound(keyHigh));
-    auto txRange = boost::adaptors::transform(
-        range,
-    [](auto const& p)
+    auto const less = [](value_type const& v, Key const& k)
     {
-        return p.second;
-    });
-
-    std::vector<std::shared_ptr<STTx const>> result(
-        txRange.begin(), txRange.end());
-
-    mMap.erase(range.begin(), range.end());
+        return v.first < k;
+    };
+    auto iter = std::lower_bound(
+        mEntries.begin(), mEntries.end(), keyLow, less);
+    auto const last = std::lower_bound(
+        iter, mEntries.end(), keyHigh, less);
+
+    std::vector<std::shared_ptr<STTx const>> result;
+    for (; iter != last; ++iter)
+    {
+        if (iter->second)
+        {
+            result.push_back(std::move(iter->second));
+            ++mErased;
+        }
+    }
 
     return result;
 }
@@ -134,7 +225,8 @@ CanonicalTXSet::iterator CanonicalTXSet::erase (iterator const& it)
 {
     iterator tmp = it;
     ++tmp;
-    mMap.erase (it);
+    it->second.reset ();
+    ++mErased;
     return tmp;
 }
 
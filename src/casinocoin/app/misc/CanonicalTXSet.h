@@ -28,6 +28,9 @@
 
 #include <casinocoin/protocol/CasinocoinLedgerHash.h>
 #include <casinocoin/protocol/STTx.h>
+#include <boost/iterator/filter_iterator.hpp>
+#include <memory>
+#include <vector>
 
 namespace casinocoin {
 
@@ -37,6 +40,13 @@ namespace casinocoin {
 
     - Puts transactions from the same account in sequence order
 
+    Entries are kept in a vector. Inserted transactions are appended,
+    and sorted into place together the next time the set is walked or
+    measured, so filling a set one transaction at a time costs no more
+    than inserting them all at once. Erasing an entry only marks it,
+    so the retry passes of consensus walk the same memory without
+    shuffling it; the marked entries are dropped by a later insert.
+    Inserting invalidates iterators.
 */
 // VFALCO TODO rename to SortedTxSet
 class CanonicalTXSet
@@ -49,6 +59,7 @@ private:
             : mAccount (account)
             , mTXid (id)
             , mSeq (seq)
+            , mPrefix (prefix (account))
         {
         }
 
@@ -72,17 +83,43 @@ private:
         }
 
     private:
+        // The leading bytes of the account, in the same order
+        static std::uint64_t prefix (uint256 const& account);
+
         uint256 mAccount;
         uint256 mTXid;
         std::uint32_t mSeq;
+        std::uint64_t mPrefix;
+    };
+
+    using value_type = std::pair <Key, std::shared_ptr<STTx const>>;
+    using storage_type = std::vector <value_type>;
+
+    // Erased entries have no transaction
+    struct Live
+    {
+        bool operator() (value_type const& v) const
+        {
+            return v.second != nullptr;
+        }
     };
 
     // Calculate the salted key for the given account
     uint256 accountKey (AccountID const& account);
 
+    Key makeKey (STTx const& txn);
+
+    // Sort the entries appended since the last call into place
+    void settle () const;
+
+    // Drop the erased entries
+    void compact ();
+
 public:
-    using iterator = std::map <Key, std::shared_ptr<STTx const>>::iterator;
-    using const_iterator = std::map <Key, std::shared_ptr<STTx const>>::const_iterator;
+    using iterator = boost::filter_iterator <
+        Live, storage_type::iterator>;
+    using const_iterator = boost::filter_iterator <
+        Live, storage_type::const_iterator>;
 
 public:
     explicit CanonicalTXSet (LedgerHash const& saltHash)
@@ -92,6 +129,9 @@ public:
 
     void insert (std::shared_ptr<STTx const> const& txn);
 
+    /** Insert many transactions. */
+    void insert (std::vector<std::shared_ptr<STTx const>> const& txns);
+
     std::vector<std::shared_ptr<STTx const>>
     prune(AccountID const& account, std::uint32_t const seq);
 
@@ -100,41 +140,52 @@ public:
     {
         mSetHash = saltHash;
 
-        mMap.clear ();
+        mEntries.clear ();
+        mSorted = 0;
+        mErased = 0;
     }
 
     iterator erase (iterator const& it);
 
     iterator begin ()
     {
-        return mMap.begin ();
+        settle ();
+        return iterator (mEntries.begin (), mEntries.end ());
     }
     iterator end ()
     {
-        return mMap.end ();
+        settle ();
+        return iterator (mEntries.end (), mEntries.end ());
     }
     const_iterator begin ()  const
     {
-        return mMap.begin ();
+        settle ();
+        return const_iterator (mEntries.begin (), mEntries.end ());
     }
     const_iterator end () const
     {
-        return mMap.end ();
+        settle ();
+        return const_iterator (mEntries.end (), mEntries.end ());
     }
     size_t size () const
     {
-        return mMap.size ();
+        settle ();
+        return mEntries.size () - mErased;
     }
     bool empty () const
     {
-        return mMap.empty ();
+        return size () == 0;
     }
 
 private:
     // Used to salt the accounts so people can't mine for low account numbers
     uint256 mSetHash;
 
-    std::map <Key, std::shared_ptr<STTx const>> mMap;
+    // Sorted by key up to mSorted, including the erased entries,
+    // then the entries inserted since in insertion order
+    mutable storage_type mEntries;
+    mutable std::size_t mSorted = 0;
+    mutable std::size_t mErased = 0;
 };
 
 } // casinocoin
@@ -84,6 +84,15 @@ int HashRouter::getFlags (uint256 const& key)
     return emplace(key).first.getFlags ();
 }
 
+void HashRouter::erase (uint256 const& key)
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+
+    auto const iter = suppressionMap_.find (key);
+    if (iter != suppressionMap_.end ())
+        suppressionMap_.erase (iter);
+}
+
 bool HashRouter::setFlags (uint256 const& key, int flags)
 {
     assert (flags != 0);
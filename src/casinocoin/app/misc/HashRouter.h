@@ -156,6 +156,12 @@ public:
 
     int getFlags (uint256 const& key);
 
+    /** Forget a hash, along with its flags and peers.
+
+        The next time the hash is seen it is treated as new.
+    */
+    void erase (uint256 const& key);
+
     /** Determines whether the hashed item should be relayed.
 
         Effects:
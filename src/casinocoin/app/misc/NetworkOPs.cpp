@@ -37,6 +37,7 @@
 #include <casinocoin/app/ledger/OrderBookDB.h>
 #include <casinocoin/app/ledger/TransactionMaster.h>
 #include <casinocoin/app/main/LoadManager.h>
+#include <casinocoin/app/misc/BatchTuner.h>
 #include <casinocoin/app/misc/CRN.h>
 #include <casinocoin/app/misc/CRNReports.h>
 #include <casinocoin/app/misc/CRNList.h>
@@ -88,6 +89,7 @@ class NetworkOPsImp final
         FailHard failType;
         bool applied;
         TER result;
+        BatchTuner::clock_type::time_point submitted;
 
         TransactionStatus (
                 std::shared_ptr<Transaction> t,
@@ -98,6 +100,7 @@ class NetworkOPsImp final
             , admin (a)
             , local (l)
             , failType (f)
+            , submitted (BatchTuner::clock_type::now ())
         {}
     };
 
@@ -167,6 +170,8 @@ public:
         , m_job_queue (job_queue)
         , m_standalone (standalone)
         , m_network_quorum (start_valid ? 0 : network_quorum)
+        , batchTuner_ (setup_BatchTuner (app_.config ()))
+        , bookIndex_ (app_.journal ("BookIndex"))
         , accounting_ ()
     {
     }
@@ -250,6 +255,12 @@ public:
                       Json::Value const& jvMarker, Json::Value& jvResult)
             override;
 
+    std::shared_ptr<BookIndex::Snapshot const>
+    getBookIndex () const override
+    {
+        return bookIndex_.current ();
+    }
+
     // Ledger proposal/close functions.
     void processTrustedProposal (
         CCLCxPeerPos::pointer proposal,
@@ -348,6 +359,11 @@ public:
         return m_localTX->size ();
     }
 
+    Json::Value getTransactionBatchJson () override
+    {
+        return batchTuner_.getJson ();
+    }
+
     //Helper function to generate SQL query to get transactions.
     std::string transactionsSQL (
         std::string selection, AccountID const& account,
@@ -471,6 +487,8 @@ private:
     void processHeartbeatTimer ();
     void processClusterTimer ();
 
+    void updateBookIndex (std::shared_ptr<ReadView const> const& ledger);
+
     void setMode (OperatingMode);
 
     Json::Value transJson (
@@ -506,6 +524,7 @@ private:
     std::recursive_mutex mSubLock;
 
     std::atomic<OperatingMode> mMode;
+    std::atomic <bool> mReachedFull {false};
 
     std::atomic <bool> mNeedNetworkLedger;
     bool m_amendmentBlocked;
@@ -549,6 +568,15 @@ private:
     std::mutex mMutex;
     DispatchState mDispatchState = DispatchState::none;
     std::vector <TransactionStatus> mTransactions;
+    BatchTuner batchTuner_;
+
+    // The books of the last published ledger
+    BookIndex bookIndex_;
+    // The latest published ledger the book index hasn't caught up with,
+    // and whether a job is bringing it up to date
+    std::mutex bookIndexMutex_;
+    std::shared_ptr<ReadView const> bookIndexLedger_;
+    bool bookIndexUpdating_ = false;
 
     StateAccounting accounting_;
 };
@@ -888,6 +916,20 @@ void NetworkOPsImp::doTransactionAsync (std::shared_ptr<Transaction> transaction
     if (transaction->getApplying())
         return;
 
+    // Keep the queue short enough to meet the latency target. Relayed
+    // transactions can be dropped, as the network still has them.
+    if (! batchTuner_.admit (mTransactions.size()))
+    {
+        JLOG(m_journal.debug()) << "Transaction batch queue is full, " <<
+            "dropping " << transaction->getID();
+
+        // Forget having seen it, so the next copy relayed to us is
+        // processed rather than suppressed
+        transaction->setResult (telCAN_NOT_QUEUE);
+        app_.getHashRouter().erase (transaction->getID());
+        return;
+    }
+
     mTransactions.push_back (TransactionStatus (transaction, bUnlimited, false,
         failType));
     transaction->setApplying();
@@ -958,41 +1000,104 @@ void NetworkOPsImp::apply (std::unique_lock<std::mutex>& batchLock)
 {
     std::vector<TransactionStatus> submit_held;
     std::vector<TransactionStatus> transactions;
-    mTransactions.swap (transactions);
+    auto const size = batchTuner_.batchSize (mTransactions.size());
+    if (size == mTransactions.size())
+    {
+        mTransactions.swap (transactions);
+    }
+    else
+    {
+        // Take the oldest, the rest are left for the next batch
+        auto const last = mTransactions.begin() + size;
+        transactions.assign (std::make_move_iterator (mTransactions.begin()),
+            std::make_move_iterator (last));
+        mTransactions.erase (mTransactions.begin(), last);
+    }
     assert (! transactions.empty());
+    auto const start = BatchTuner::clock_type::now();
 
     assert (mDispatchState != DispatchState::running);
     mDispatchState = DispatchState::running;
 
     batchLock.unlock();
 
+    // Load the state the transactions will read before taking the
+    // master lock, so applying them doesn't wait on the node store
+    std::vector<uint256> prefetched;
+    if (auto const closed = m_ledgerMaster.getClosedLedger())
+    {
+        std::vector<std::shared_ptr<STTx const>> txs;
+        txs.reserve (transactions.size());
+        for (auto const& e : transactions)
+            txs.push_back (e.transaction->getSTransaction());
+        prefetched = app_.openLedger().prefetch (*closed, txs);
+    }
+
     {
         auto lock = make_lock(app_.getMasterMutex());
         bool changed = false;
+        BatchTuner::clock_type::time_point applying;
         {
             std::lock_guard <std::recursive_mutex> lock (
                 m_ledgerMaster.peekMutex());
 
+            // Only applying counts towards the cost of a transaction,
+            // not the prefetch or waiting for the locks
+            applying = BatchTuner::clock_type::now();
             app_.openLedger().modify(
                 [&](OpenView& view, beast::Journal j)
             {
+                std::vector<std::shared_ptr<STTx const>> txs;
+                std::vector<ApplyFlags> flags;
+                txs.reserve (transactions.size());
+                flags.reserve (transactions.size());
                 for (TransactionStatus& e : transactions)
                 {
+                    txs.push_back (e.transaction->getSTransaction());
                     // we check before addingto the batch
-                    ApplyFlags flags = tapNO_CHECK_SIGN;
-                    if (e.admin)
-                        flags = flags | tapUNLIMITED;
-
-                    auto const result = app_.getTxQ().apply(
-                        app_, view, e.transaction->getSTransaction(),
-                        flags, j);
-                    e.result = result.first;
-                    e.applied = result.second;
-                    changed = changed || result.second;
+                    flags.push_back (e.admin ?
+                        tapNO_CHECK_SIGN | tapUNLIMITED : tapNO_CHECK_SIGN);
+                }
+
+                // Transactions the queue would apply straight away
+                // are applied speculatively on several threads
+                auto& txQ = app_.getTxQ();
+                auto const results = applyParallel (
+                    app_.getWorkerPool(), view, txs,
+                    app_.config().APPLY_THREADS,
+                    [&](OpenView& to, std::size_t i)
+                    {
+                        return TxQ::applyDirect (
+                            app_, to, *txs[i], flags[i], j);
+                    },
+                    [&](OpenView const& to, std::size_t i)
+                    {
+                        return txQ.isDirect (app_, to, *txs[i], j);
+                    },
+                    [&](OpenView& to, std::size_t i)
+                    {
+                        return txQ.apply (
+                            app_, to, txs[i], flags[i], j);
+                    }, j);
+
+                for (std::size_t i = 0; i < transactions.size(); ++i)
+                {
+                    auto& e = transactions[i];
+                    e.result = results[i].first;
+                    e.applied = results[i].second;
+                    changed = changed || results[i].second;
                 }
                 return changed;
-            });
+            }, std::move (prefetched));
         }
+
+        std::vector<BatchTuner::clock_type::time_point> submitted;
+        submitted.reserve (transactions.size());
+        for (TransactionStatus const& e : transactions)
+            submitted.push_back (e.submitted);
+        batchTuner_.record (submitted, start, applying,
+            BatchTuner::clock_type::now());
+
         if (changed)
             reportFeeChange();
 
@@ -1884,6 +1989,19 @@ void NetworkOPsImp::setMode (OperatingMode om)
 
 
     JLOG(m_journal.info()) << "STATE->" << strOperatingMode ();
+
+    // How long a restart takes to sync, including any state
+    // tree verification it could not skip
+    if (om == omFULL && !mReachedFull.exchange (true))
+    {
+        auto const& fullBelow = app_.family().fullbelow();
+        JLOG(m_journal.info()) << "Synced " <<
+            UptimeTimer::getInstance ().getElapsedSeconds () <<
+            "s after startup, " << fullBelow.restoredSize () <<
+            " full below keys restored, " << fullBelow.pendingSize () <<
+            " pending";
+    }
+
     pubServer ();
 }
 
@@ -2514,6 +2632,55 @@ void NetworkOPsImp::pubLedger (
         JLOG(m_journal.trace()) << "pubAccepted: " << vt.second->getJson ();
         pubValidatedTransaction (lpAccepted, *vt.second);
     }
+
+    updateBookIndex (lpAccepted);
+}
+
+void NetworkOPsImp::updateBookIndex (
+    std::shared_ptr<ReadView const> const& ledger)
+{
+    {
+        std::lock_guard <std::mutex> lock (bookIndexMutex_);
+        bookIndexLedger_ = ledger;
+        if (bookIndexUpdating_)
+            return;
+        bookIndexUpdating_ = true;
+    }
+
+    // One job at a time catches up with the latest ledger published,
+    // so the index never goes back and ledgers published while it works
+    // are applied together
+    auto const work = [this]
+    {
+        for (;;)
+        {
+            std::shared_ptr<ReadView const> next;
+            {
+                std::lock_guard <std::mutex> lock (bookIndexMutex_);
+                next = std::move (bookIndexLedger_);
+                if (! next)
+                {
+                    bookIndexUpdating_ = false;
+                    return;
+                }
+            }
+            bookIndex_.update (next,
+                [this](uint256 const& hash) -> std::shared_ptr<ReadView const>
+                {
+                    return m_ledgerMaster.getLedgerByHash (hash);
+                });
+        }
+    };
+
+    if (app_.config().standalone())
+        work ();
+    else if (! m_job_queue.addCountedJob (
+        jtUPDATE_PF, "BookIndex::update", jobCounter_,
+        [work] (Job&) { work (); }))
+    {
+        std::lock_guard <std::mutex> lock (bookIndexMutex_);
+        bookIndexUpdating_ = false;
+    }
 }
 
 void NetworkOPsImp::reportFeeChange ()
@@ -3039,6 +3206,133 @@ void NetworkOPsImp::getBookPage (
         isGlobalFrozen(view, book.out.account) ||
             isGlobalFrozen(view, book.in.account);
 
+    auto const rate = transferRate(view, book.out.account);
+    auto viewJ = app_.journal ("View");
+
+    // Adds an offer to the page. The funds of its owner are read from
+    // the ledger unless the book index has them.
+    auto const addOffer = [&](std::shared_ptr<SLE const> const& sleOffer,
+        STAmount const& saDirRate, STAmount const* indexedFunds)
+    {
+        auto const uOfferOwnerID =
+                sleOffer->getAccountID (sfAccount);
+        auto const& saTakerGets =
+                sleOffer->getFieldAmount (sfTakerGets);
+        auto const& saTakerPays =
+                sleOffer->getFieldAmount (sfTakerPays);
+        STAmount saOwnerFunds;
+        bool firstOwnerOffer (true);
+
+        if (book.out.account == uOfferOwnerID)
+        {
+            // If an offer is selling issuer's own IOUs, it is fully
+            // funded.
+            saOwnerFunds    = saTakerGets;
+        }
+        else if (bGlobalFreeze)
+        {
+            // If either asset is globally frozen, consider all offers
+            // that aren't ours to be totally unfunded
+            saOwnerFunds.clear (book.out);
+        }
+        else
+        {
+            auto umBalanceEntry  = umBalance.find (uOfferOwnerID);
+            if (umBalanceEntry != umBalance.end ())
+            {
+                // Found in running balance table.
+
+                saOwnerFunds    = umBalanceEntry->second;
+                firstOwnerOffer = false;
+            }
+            else
+            {
+                // Did not find balance in table.
+
+                saOwnerFunds = indexedFunds ? *indexedFunds :
+                    accountHolds (view, uOfferOwnerID, book.out.currency,
+                        book.out.account, fhZERO_IF_FROZEN, viewJ);
+
+                if (saOwnerFunds < zero)
+                {
+                    // Treat negative funds as zero.
+
+                    saOwnerFunds.clear ();
+                }
+            }
+        }
+
+        Json::Value jvOffer = sleOffer->getJson (0);
+
+        STAmount saTakerGetsFunded;
+        STAmount saOwnerFundsLimit = saOwnerFunds;
+        Rate offerRate = parityRate;
+
+        if (rate != parityRate
+            // Have a tranfer fee.
+            && uTakerID != book.out.account
+            // Not taking offers of own IOUs.
+            && book.out.account != uOfferOwnerID)
+            // Offer owner not issuing ownfunds
+        {
+            // Need to charge a transfer fee to offer owner.
+            offerRate = rate;
+            saOwnerFundsLimit = divide (
+                saOwnerFunds, offerRate);
+        }
+
+        if (saOwnerFundsLimit >= saTakerGets)
+        {
+            // Sufficient funds no shenanigans.
+            saTakerGetsFunded   = saTakerGets;
+        }
+        else
+        {
+            // Only provide, if not fully funded.
+
+            saTakerGetsFunded = saOwnerFundsLimit;
+
+            saTakerGetsFunded.setJson (jvOffer[jss::taker_gets_funded]);
+            std::min (
+                saTakerPays, multiply (
+                    saTakerGetsFunded, saDirRate, saTakerPays.issue ())).setJson
+                    (jvOffer[jss::taker_pays_funded]);
+        }
+
+        STAmount saOwnerPays = (parityRate == offerRate)
+            ? saTakerGetsFunded
+            : std::min (
+                saOwnerFunds,
+                multiply (saTakerGetsFunded, offerRate));
+
+        umBalance[uOfferOwnerID]    = saOwnerFunds - saOwnerPays;
+
+        // Include all offers funded and unfunded
+        Json::Value& jvOf = jvOffers.append (jvOffer);
+        jvOf[jss::quality] = saDirRate.getText ();
+
+        if (firstOwnerOffer)
+            jvOf[jss::owner_funds] = saOwnerFunds.getText ();
+    };
+
+    // The ledger the book index is of is served from the index
+    auto const index = getBookIndex ();
+    if (index && ! view.open () && index->hash () == view.info ().hash)
+    {
+        JLOG(m_journal.trace()) << "getBookPage: from index";
+        if (auto const offers = index->offers (book))
+        {
+            for (std::size_t i = 0; i < offers->size () && iLimit-- > 0; ++i)
+            {
+                auto const& offer = (*offers)[i];
+                addOffer (offer.sle,
+                    amountFromQuality (getQuality (offer.directory)),
+                        &offer.ownerFunds);
+            }
+        }
+        return;
+    }
+
     bool            bDone           = false;
     bool            bDirectAdvance  = true;
 
@@ -3047,9 +3341,6 @@ void NetworkOPsImp::getBookPage (
     unsigned int    uBookEntry;
     STAmount        saDirRate;
 
-    auto const rate = transferRate(view, book.out.account);
-    auto viewJ = app_.journal ("View");
-
     while (! bDone && iLimit-- > 0)
     {
         if (bDirectAdvance)
@@ -3090,105 +3381,7 @@ void NetworkOPsImp::getBookPage (
 
             if (sleOffer)
             {
-                auto const uOfferOwnerID =
-                        sleOffer->getAccountID (sfAccount);
-                auto const& saTakerGets =
-                        sleOffer->getFieldAmount (sfTakerGets);
-                auto const& saTakerPays =
-                        sleOffer->getFieldAmount (sfTakerPays);
-                STAmount saOwnerFunds;
-                bool firstOwnerOffer (true);
-
-                if (book.out.account == uOfferOwnerID)
-                {
-                    // If an offer is selling issuer's own IOUs, it is fully
-                    // funded.
-                    saOwnerFunds    = saTakerGets;
-                }
-                else if (bGlobalFreeze)
-                {
-                    // If either asset is globally frozen, consider all offers
-                    // that aren't ours to be totally unfunded
-                    saOwnerFunds.clear (book.out);
-                }
-                else
-                {
-                    auto umBalanceEntry  = umBalance.find (uOfferOwnerID);
-                    if (umBalanceEntry != umBalance.end ())
-                    {
-                        // Found in running balance table.
-
-                        saOwnerFunds    = umBalanceEntry->second;
-                        firstOwnerOffer = false;
-                    }
-                    else
-                    {
-                        // Did not find balance in table.
-
-                        saOwnerFunds = accountHolds (view,
-                            uOfferOwnerID, book.out.currency,
-                                book.out.account, fhZERO_IF_FROZEN, viewJ);
-
-                        if (saOwnerFunds < zero)
-                        {
-                            // Treat negative funds as zero.
-
-                            saOwnerFunds.clear ();
-                        }
-                    }
-                }
-
-                Json::Value jvOffer = sleOffer->getJson (0);
-
-                STAmount saTakerGetsFunded;
-                STAmount saOwnerFundsLimit = saOwnerFunds;
-                Rate offerRate = parityRate;
-
-                if (rate != parityRate
-                    // Have a tranfer fee.
-                    && uTakerID != book.out.account
-                    // Not taking offers of own IOUs.
-                    && book.out.account != uOfferOwnerID)
-                    // Offer owner not issuing ownfunds
-                {
-                    // Need to charge a transfer fee to offer owner.
-                    offerRate = rate;
-                    saOwnerFundsLimit = divide (
-                        saOwnerFunds, offerRate);
-                }
-
-                if (saOwnerFundsLimit >= saTakerGets)
-                {
-                    // Sufficient funds no shenanigans.
-                    saTakerGetsFunded   = saTakerGets;
-                }
-                else
-                {
-                    // Only provide, if not fully funded.
-
-                    saTakerGetsFunded = saOwnerFundsLimit;
-
-                    saTakerGetsFunded.setJson (jvOffer[jss::taker_gets_funded]);
-                    std::min (
-                        saTakerPays, multiply (
-                            saTakerGetsFunded, saDirRate, saTakerPays.issue ())).setJson
-                            (jvOffer[jss::taker_pays_funded]);
-                }
-
-                STAmount saOwnerPays = (parityRate == offerRate)
-                    ? saTakerGetsFunded
-                    : std::min (
-                        saOwnerFunds,
-                        multiply (saTakerGetsFunded, offerRate));
-
-                umBalance[uOfferOwnerID]    = saOwnerFunds - saOwnerPays;
-
-                // Include all offers funded and unfunded
-                Json::Value& jvOf = jvOffers.append (jvOffer);
-                jvOf[jss::quality] = saDirRate.getText ();
-
-                if (firstOwnerOffer)
-                    jvOf[jss::owner_funds] = saOwnerFunds.getText ();
+                addOffer (sleOffer, saDirRate, nullptr);
             }
             else
             {
@@ -27,6 +27,7 @@
 #define CASINOCOIN_APP_MISC_NETWORKOPS_H_INCLUDED
 
 #include <casinocoin/core/JobQueue.h>
+#include <casinocoin/app/ledger/BookIndex.h>
 #include <casinocoin/protocol/STValidation.h>
 #include <casinocoin/protocol/STPerformanceReport.h>
 #include <casinocoin/app/ledger/Ledger.h>
@@ -214,6 +215,13 @@ public:
         Json::Value const& jvMarker,
         Json::Value& jvResult) = 0;
 
+    /** The offers of every book as of the last published ledger the
+        index has been brought up to date with. That happens on a job
+        after the ledger is published, so it may lag behind.
+    */
+    virtual std::shared_ptr<BookIndex::Snapshot const>
+    getBookIndex () const = 0;
+
     //--------------------------------------------------------------------------
 
     // ledger proposal/close functions
@@ -268,6 +276,9 @@ public:
     virtual void updateLocalTx (ReadView const& newValidLedger) = 0;
     virtual std::size_t getLocalTxCount () = 0;
 
+    /** Batch sizes, wait times and latency of applied transactions. */
+    virtual Json::Value getTransactionBatchJson () = 0;
+
     // client information retrieval functions
     using AccountTx  = std::pair<std::shared_ptr<Transaction>, TxMeta::pointer>;
     using AccountTxs = std::vector<AccountTx>;
@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_MISC_SIGVERIFIER_H_INCLUDED
+#define CASINOCOIN_APP_MISC_SIGVERIFIER_H_INCLUDED
+
+#include <casinocoin/basics/base_uint.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/beast/utility/Journal.h>
+#include <casinocoin/protocol/STTx.h>
+#include <boost/optional.hpp>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace casinocoin {
+
+class Config;
+class JobQueue;
+class WorkerPool;
+
+/** Remembers which transactions have good signatures.
+
+    Verdicts are keyed by transaction ID, which covers the signatures
+    as well as the signed fields, so a forged signature can never pick
+    up the verdict of a genuine one. Unlike the HashRouter flags,
+    entries stay until they are pushed out by newer ones. The cache is
+    split into shards by the first byte of the ID, each with its own
+    lock and evicting its oldest entry when full.
+*/
+class SigCache
+{
+public:
+    explicit
+    SigCache (std::size_t size);
+
+    /** The verdict for a transaction, if it is known. */
+    boost::optional<bool>
+    find (uint256 const& id) const;
+
+    void
+    insert (uint256 const& id, bool valid);
+
+    std::size_t
+    size () const;
+
+    void
+    clear ();
+
+private:
+    static std::size_t const shardCount = 16;
+
+    struct Shard
+    {
+        std::mutex mutable mutex;
+        hash_map<uint256, bool> verdicts;
+        // Keys in the order they were added
+        std::deque<uint256> order;
+    };
+
+    Shard&
+    shard (uint256 const& id) const
+    {
+        return shards_[*id.begin () % shardCount];
+    }
+
+    std::size_t const capacity_;
+    std::array<Shard, shardCount> mutable shards_;
+};
+
+//------------------------------------------------------------------------------
+
+/** Checks the signatures of incoming transactions in batches.
+
+    Transactions passed to verify() are collected until a job on the
+    job queue picks them up, so the batches grow with the load: a lone
+    transaction is checked straight away, while a burst is checked
+    together. A batch is split into chunks which are spread over the
+    threads of a WorkerPool. Each signature gets the verdict checkSign
+    would give it, whatever batch it is in. Verdicts are kept in a
+    SigCache.
+*/
+class SigVerifier
+{
+public:
+    struct Setup
+    {
+        // Worker threads per batch, or 0 to choose from the hardware
+        std::size_t threads = 0;
+        // Verdicts remembered by the cache
+        std::size_t cacheSize = 65536;
+        // Most transactions checked by one job
+        std::size_t maxBatch = 1024;
+    };
+
+    /** Called with the verdict and, for a bad signature, a reason. */
+    using handler_type =
+        std::function<void (bool valid, std::string const& reason)>;
+
+    SigVerifier (Setup const& setup, JobQueue& jobQueue,
+        WorkerPool& workers, beast::Journal j);
+
+    /** Check the signature of a transaction in the background.
+
+        The handler is called on a job queue thread once the batch
+        the transaction joined has been checked, or before returning
+        if the verdict is already cached.
+    */
+    void
+    verify (std::shared_ptr<STTx const> const& tx,
+        bool allowMultiSign, handler_type handler);
+
+    /** Check the signatures of several transactions now.
+
+        Uses the cache and the worker threads, and gives the same
+        results as calling STTx::checkSign on each transaction.
+    */
+    std::vector<std::pair<bool, std::string>>
+    check (std::vector<std::shared_ptr<STTx const>> const& txs,
+        bool allowMultiSign);
+
+    SigCache&
+    cache ()
+    {
+        return cache_;
+    }
+
+    /** Number of signatures checked, not counting cache hits. */
+    std::uint64_t
+    checked () const
+    {
+        return checked_.load ();
+    }
+
+private:
+    struct Pending
+    {
+        std::shared_ptr<STTx const> tx;
+        bool allowMultiSign;
+        handler_type handler;
+    };
+
+    void
+    flush ();
+
+    Setup const setup_;
+    JobQueue& jobQueue_;
+    WorkerPool& workers_;
+    beast::Journal j_;
+    SigCache cache_;
+    std::atomic<std::uint64_t> checked_ {0};
+
+    std::mutex mutex_;
+    std::vector<Pending> pending_;
+    // Whether a job to check pending_ has been queued
+    bool scheduled_ = false;
+};
+
+SigVerifier::Setup
+setup_SigVerifier (Config const& config);
+
+} // casinocoin
+
+#endif
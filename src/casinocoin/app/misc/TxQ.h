@@ -29,9 +29,12 @@
 #include <casinocoin/app/tx/applySteps.h>
 #include <casinocoin/ledger/OpenView.h>
 #include <casinocoin/ledger/ApplyView.h>
+#include <casinocoin/protocol/CasinocoinLedgerHash.h>
 #include <casinocoin/protocol/TER.h>
 #include <casinocoin/protocol/STTx.h>
+#include <casinocoin/basics/UnorderedContainers.h>
 #include <boost/intrusive/set.hpp>
+#include <chrono>
 
 namespace casinocoin {
 
@@ -80,6 +83,13 @@ public:
             bikeshedding for now.
         */
         std::uint64_t zeroBaseFeeTransactionFeeLevel = 256000;
+        /* Longest time accept() may spend moving queued transactions
+            into the open ledger while the caller holds the master
+            lock. The rest of the queue is applied by a follow up job.
+            Zero means no limit.
+        */
+        std::chrono::milliseconds maximumAcceptTime =
+            std::chrono::milliseconds(500);
         bool standAlone = false;
     };
 
@@ -130,11 +140,41 @@ public:
         std::shared_ptr<STTx const> const& tx,
             ApplyFlags flags, beast::Journal j);
 
+    /**
+        Returns `true` if `apply` would put the transaction straight
+        into the view as it stands, without involving the queue. It
+        then does exactly what `applyDirect` does.
+    */
+    bool
+    isDirect(Application& app, OpenView const& view,
+        STTx const& tx, beast::Journal j);
+
+    /**
+        Apply a transaction to the open ledger the way `apply` does
+        when the queue is not involved. Does not use the queue, so
+        it can be called concurrently on different views.
+
+        @return A pair with the TER and a bool indicating
+                whether or not the transaction was applied.
+    */
+    static
+    std::pair<TER, bool>
+    applyDirect(Application& app, OpenView& view,
+        STTx const& tx, ApplyFlags flags, beast::Journal j);
+
     /**
         Fill the new open ledger with transactions from the queue.
         As we apply more transactions to the ledger, the required
         fee will increase.
 
+        If this takes longer than `Setup::maximumAcceptTime`, it
+        stops early and schedules a job which carries on applying
+        the queue to the open ledger. Applied and dropped
+        transactions leave the queue, and those which failed and
+        stayed are not tried again on the same open ledger, so each
+        pass resumes with the highest fee level transactions that
+        have not been tried yet.
+
         @return Whether any txs were added to the view.
     */
     bool
@@ -396,7 +436,8 @@ private:
         < MaybeTx, FeeHook,
         boost::intrusive::compare <GreaterFee> >;
 
-    using AccountMap = std::map <AccountID, TxQAccount>;
+    // Accounts are only ever looked up by ID, never walked in order
+    using AccountMap = hash_map <AccountID, TxQAccount>;
 
     Setup const setup_;
     beast::Journal j_;
@@ -407,6 +448,14 @@ private:
     FeeMultiSet byFee_;
     AccountMap byAccount_;
     boost::optional<size_t> maxSize_;
+    // Set while a job to finish an interrupted accept() is pending
+    bool acceptPending_ = false;
+    // The transactions accept() tried and left in the queue, and the
+    // parent of the open ledger it tried them on. A resumed accept
+    // on the same open ledger skips them, so they aren't retried
+    // and charged a retry again.
+    LedgerHash acceptParent_;
+    hash_set<TxID> acceptTried_;
 
     // Most queue operations are done under the master lock,
     // but use this mutex for the RPC "fee" command, which isn't.
@@ -421,6 +470,10 @@ private:
         AccountMap::iterator,
             boost::optional<FeeMultiSet::iterator>);
 
+    // Carry on with an accept() that ran out of time
+    void
+    resumeAccept(Application& app);
+
     // Erase and return the next entry in byFee_ (lower fee level)
     FeeMultiSet::iterator_type erase(FeeMultiSet::const_iterator_type);
     // Erase and return the next entry for the account (if fee level
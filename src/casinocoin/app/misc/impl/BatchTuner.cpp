@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/misc/BatchTuner.h>
+#include <casinocoin/core/Config.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <algorithm>
+
+namespace casinocoin {
+
+BatchTuner::BatchTuner (Setup const& setup)
+    : setup_ (setup)
+{
+    recent_.reserve (window);
+}
+
+std::size_t
+BatchTuner::batchSize (std::size_t pending) const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    // Until a batch has been measured, take everything
+    auto n = setup_.maxBatch;
+    if (cost_ > 0)
+    {
+        auto const budget = std::chrono::duration_cast<
+            std::chrono::microseconds> (setup_.targetLatency).count () / 2;
+        n = static_cast<std::size_t> (budget / cost_);
+    }
+    n = std::max (setup_.minBatch, std::min (n, setup_.maxBatch));
+    return std::min (n, pending);
+}
+
+bool
+BatchTuner::admit (std::size_t pending)
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (cost_ <= 0)
+        return true;
+
+    auto const target = std::chrono::duration_cast<
+        std::chrono::microseconds> (setup_.targetLatency).count ();
+    if ((pending + 1) * cost_ <= target * scale_)
+        return true;
+
+    ++dropped_;
+    return false;
+}
+
+void
+BatchTuner::record (std::vector<clock_type::time_point> const& submitted,
+    clock_type::time_point start, clock_type::time_point applying,
+        clock_type::time_point end)
+{
+    using namespace std::chrono;
+    if (submitted.empty ())
+        return;
+
+    auto const micros = [](clock_type::duration d)
+    {
+        return static_cast<std::uint64_t> (std::max<std::int64_t> (0,
+            duration_cast<microseconds> (d).count ()));
+    };
+
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    auto const cost = double (micros (end - applying)) / submitted.size ();
+    cost_ = (cost_ > 0) ? (cost_ * 3 + cost) / 4 : cost;
+
+    sizes_.add (submitted.size ());
+    for (auto const& t : submitted)
+    {
+        waits_.add (micros (start - t));
+        auto const latency = micros (end - t);
+        latencies_.add (latency);
+        if (recent_.size () < window)
+            recent_.push_back (latency);
+        else
+            recent_[next_] = latency;
+        next_ = (next_ + 1) % window;
+    }
+
+    auto sorted = recent_;
+    auto const nth = sorted.begin () + (sorted.size () * 99) / 100;
+    std::nth_element (sorted.begin (), nth, sorted.end ());
+    p99_ = *nth;
+
+    // Admit less work while over the target, and more again once
+    // there is room to spare
+    auto const target = duration_cast<microseconds> (
+        setup_.targetLatency).count ();
+    if (p99_ > static_cast<std::uint64_t> (target))
+        scale_ = std::max (0.1, scale_ * 0.8);
+    else if (p99_ < static_cast<std::uint64_t> (target / 2))
+        scale_ = std::min (1.0, scale_ * 1.25);
+}
+
+double
+BatchTuner::cost () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return cost_;
+}
+
+std::chrono::microseconds
+BatchTuner::latency () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return std::chrono::microseconds (p99_);
+}
+
+Json::Value
+BatchTuner::getJson () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    Json::Value ret (Json::objectValue);
+    ret[jss::target_latency_ms] = static_cast<Json::UInt> (
+        setup_.targetLatency.count ());
+    ret[jss::p99_us] = std::to_string (p99_);
+    ret[jss::tx_cost_us] = static_cast<Json::UInt> (cost_);
+    ret[jss::admit_scale] = scale_;
+    ret[jss::dropped] = std::to_string (dropped_);
+    ret[jss::batch_size] = sizes_.getJson ();
+    ret[jss::wait_us] = waits_.getJson ();
+    ret[jss::latency_us] = latencies_.getJson ();
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+
+BatchTuner::Setup
+setup_BatchTuner (Config const& config)
+{
+    BatchTuner::Setup setup;
+    auto const& section = config.section ("transaction_batch");
+    std::uint32_t target;
+    if (set (target, "target_latency", section))
+        setup.targetLatency = std::chrono::milliseconds (target);
+    set (setup.minBatch, "min_batch", section);
+    set (setup.maxBatch, "max_batch", section);
+    setup.minBatch = std::max<std::size_t> (1, setup.minBatch);
+    setup.maxBatch = std::max (setup.minBatch, setup.maxBatch);
+    return setup;
+}
+
+} // casinocoin
@@ -0,0 +1,258 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/misc/SigVerifier.h>
+#include <casinocoin/basics/Log.h>
+#include <casinocoin/core/Config.h>
+#include <casinocoin/core/JobQueue.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <algorithm>
+#include <thread>
+
+namespace casinocoin {
+
+SigCache::SigCache (std::size_t size)
+    : capacity_ (std::max<std::size_t> (1, size / shardCount))
+{
+}
+
+boost::optional<bool>
+SigCache::find (uint256 const& id) const
+{
+    auto& s = shard (id);
+    std::lock_guard<std::mutex> lock (s.mutex);
+    auto const iter = s.verdicts.find (id);
+    if (iter == s.verdicts.end ())
+        return boost::none;
+    return iter->second;
+}
+
+void
+SigCache::insert (uint256 const& id, bool valid)
+{
+    auto& s = shard (id);
+    std::lock_guard<std::mutex> lock (s.mutex);
+    auto const result = s.verdicts.emplace (id, valid);
+    if (! result.second)
+    {
+        result.first->second = valid;
+        return;
+    }
+    s.order.push_back (id);
+    if (s.order.size () > capacity_)
+    {
+        s.verdicts.erase (s.order.front ());
+        s.order.pop_front ();
+    }
+}
+
+std::size_t
+SigCache::size () const
+{
+    std::size_t n = 0;
+    for (auto& s : shards_)
+    {
+        std::lock_guard<std::mutex> lock (s.mutex);
+        n += s.verdicts.size ();
+    }
+    return n;
+}
+
+void
+SigCache::clear ()
+{
+    for (auto& s : shards_)
+    {
+        std::lock_guard<std::mutex> lock (s.mutex);
+        s.verdicts.clear ();
+        s.order.clear ();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+// Transactions checked together by one worker
+static std::size_t const chunkSize = 64;
+
+SigVerifier::SigVerifier (Setup const& setup, JobQueue& jobQueue,
+        WorkerPool& workers, beast::Journal j)
+    : setup_ (setup)
+    , jobQueue_ (jobQueue)
+    , workers_ (workers)
+    , j_ (j)
+    , cache_ (setup.cacheSize)
+{
+}
+
+void
+SigVerifier::verify (std::shared_ptr<STTx const> const& tx,
+    bool allowMultiSign, handler_type handler)
+{
+    if (allowMultiSign)
+    {
+        if (auto const valid = cache_.find (tx->getTransactionID ()))
+        {
+            handler (*valid, *valid ? "" : "Invalid signature.");
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock (mutex_);
+    pending_.push_back ({ tx, allowMultiSign, std::move (handler) });
+    if (! scheduled_)
+    {
+        scheduled_ = true;
+        jobQueue_.addJob (jtTRANSACTION, "SigVerifier",
+            [this](Job&)
+            {
+                flush ();
+            });
+    }
+}
+
+void
+SigVerifier::flush ()
+{
+    std::vector<Pending> batch;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        if (pending_.size () <= setup_.maxBatch)
+        {
+            batch.swap (pending_);
+        }
+        else
+        {
+            auto const last = pending_.begin () + setup_.maxBatch;
+            batch.assign (std::make_move_iterator (pending_.begin ()),
+                std::make_move_iterator (last));
+            pending_.erase (pending_.begin (), last);
+        }
+    }
+
+    // Transactions checked without multi-signing enabled are rare,
+    // so they are checked as a batch of their own
+    auto const split = std::stable_partition (batch.begin (), batch.end (),
+        [](Pending const& p)
+        {
+            return p.allowMultiSign;
+        });
+
+    auto const run = [&](std::vector<Pending>::iterator first,
+        std::vector<Pending>::iterator last, bool allowMultiSign)
+    {
+        if (first == last)
+            return;
+        std::vector<std::shared_ptr<STTx const>> txs;
+        txs.reserve (std::distance (first, last));
+        for (auto iter = first; iter != last; ++iter)
+            txs.push_back (iter->tx);
+        auto const results = check (txs, allowMultiSign);
+        for (std::size_t i = 0; i < results.size (); ++i)
+            first[i].handler (results[i].first, results[i].second);
+    };
+    run (batch.begin (), split, true);
+    run (split, batch.end (), false);
+
+    JLOG (j_.debug ()) <<
+        "Checked the signatures of " << batch.size () << " transactions";
+
+    // Let other jobs in before checking what arrived meanwhile
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (pending_.empty ())
+    {
+        scheduled_ = false;
+        return;
+    }
+    jobQueue_.addJob (jtTRANSACTION, "SigVerifier",
+        [this](Job&)
+        {
+            flush ();
+        });
+}
+
+std::vector<std::pair<bool, std::string>>
+SigVerifier::check (std::vector<std::shared_ptr<STTx const>> const& txs,
+    bool allowMultiSign)
+{
+    std::vector<std::pair<bool, std::string>> results (txs.size ());
+
+    // Verdicts found without multi-signing could be wrong for
+    // multi-signed transactions once it is enabled, so only
+    // the usual case is cached
+    std::vector<std::size_t> todo;
+    todo.reserve (txs.size ());
+    for (std::size_t i = 0; i < txs.size (); ++i)
+    {
+        if (allowMultiSign)
+        {
+            if (auto const valid = cache_.find (txs[i]->getTransactionID ()))
+            {
+                results[i] = { *valid, *valid ? "" : "Invalid signature." };
+                continue;
+            }
+        }
+        todo.push_back (i);
+    }
+
+    auto const chunks = (todo.size () + chunkSize - 1) / chunkSize;
+    auto threads = setup_.threads;
+    if (threads == 0)
+        threads = std::min (4u,
+            std::max (1u, std::thread::hardware_concurrency ()));
+
+    workers_.forEach (chunks, [&](std::size_t c)
+        {
+            auto const first = c * chunkSize;
+            auto const last = std::min (first + chunkSize, todo.size ());
+
+            std::vector<std::shared_ptr<STTx const>> chunk;
+            chunk.reserve (last - first);
+            for (auto i = first; i < last; ++i)
+                chunk.push_back (txs[todo[i]]);
+
+            auto const checked = checkSigns (chunk, allowMultiSign);
+            for (auto i = first; i < last; ++i)
+            {
+                results[todo[i]] = checked[i - first];
+                if (allowMultiSign)
+                    cache_.insert (txs[todo[i]]->getTransactionID (),
+                        checked[i - first].first);
+            }
+        }, threads);
+
+    checked_ += todo.size ();
+    return results;
+}
+
+//------------------------------------------------------------------------------
+
+SigVerifier::Setup
+setup_SigVerifier (Config const& config)
+{
+    SigVerifier::Setup setup;
+    auto const& section = config.section ("signature_verification");
+    set (setup.threads, "threads", section);
+    set (setup.cacheSize, "cache_size", section);
+    set (setup.maxBatch, "max_batch", section);
+    setup.maxBatch = std::max<std::size_t> (1, setup.maxBatch);
+    return setup;
+}
+
+} // casinocoin
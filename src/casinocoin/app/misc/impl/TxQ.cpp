@@ -24,14 +24,18 @@
 //==============================================================================
 
 #include <casinocoin/app/misc/TxQ.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
 #include <casinocoin/app/ledger/OpenLedger.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/app/misc/LoadFeeTrack.h>
+#include <casinocoin/app/misc/NetworkOPs.h>
 #include <casinocoin/app/tx/apply.h>
 #include <casinocoin/protocol/st.h>
 #include <casinocoin/protocol/Feature.h>
 #include <casinocoin/protocol/JsonFields.h>
+#include <casinocoin/basics/make_lock.h>
 #include <casinocoin/basics/mulDiv.h>
+#include <casinocoin/core/JobQueue.h>
 #include <boost/algorithm/clamp.hpp>
 #include <limits>
 #include <numeric>
@@ -1086,6 +1090,44 @@ TxQ::apply(Application& app, OpenView& view,
     return { terQUEUED, false };
 }
 
+bool
+TxQ::isDirect(Application& app, OpenView const& view,
+    STTx const& tx, beast::Journal j)
+{
+    if (!view.rules().enabled(featureFeeEscalation))
+        return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Anything queued for the account may be replaced,
+    // cleared or held back by this transaction
+    if (byAccount_.find(tx[sfAccount]) != byAccount_.end())
+        return false;
+
+    auto const baseFee = calculateBaseFee(app, view, tx, j);
+    auto const feeLevelPaid = getFeeLevelPaid(tx,
+        baseLevel, baseFee, setup_);
+    return feeLevelPaid >= FeeMetrics::scaleFeeLevel(
+        j_, feeMetrics_.getSnapshot(), view);
+}
+
+std::pair<TER, bool>
+TxQ::applyDirect(Application& app, OpenView& view,
+    STTx const& tx, ApplyFlags flags, beast::Journal j)
+{
+    if (!view.rules().enabled(featureFeeEscalation))
+        return casinocoin::apply(app, view, tx, flags, j);
+
+    auto const pfresult = preflight(app, view.rules(),
+        tx, flags, j);
+    if (pfresult.ter != tesSUCCESS)
+        return{ pfresult.ter, false };
+    auto const pcresult = preclaim(pfresult, app, view);
+    if (!pcresult.likelyToClaimFee)
+        return{ pcresult.ter, false };
+    return doApply(pcresult, app, view);
+}
+
 /*
     0. Is `featureFeeEscalation` enabled?
         Yes: Continue to next step.
@@ -1176,6 +1218,12 @@ TxQ::processClosedLedger(Application& app,
                         and continue iterating.
     2. Return indicator of whether the open ledger was modified.
 
+    If step 1 runs for longer than `Setup::maximumAcceptTime`, stop
+    early and queue a job that calls `accept` again on the open ledger,
+    so the master lock isn't held for the whole queue at once. Txs
+    left in the queue after being tried are skipped by later calls on
+    the same open ledger.
+
     "Appropriate candidate" is defined as the tx that has the
         highest fee level of:
         * the tx for the current account with the next sequence.
@@ -1204,8 +1252,46 @@ TxQ::accept(Application& app,
 
     auto const metricSnapshot = feeMetrics_.getSnapshot();
 
+    // Forget what was tried on an earlier open ledger
+    if (view.info().parentHash != acceptParent_)
+    {
+        acceptParent_ = view.info().parentHash;
+        acceptTried_.clear();
+    }
+
+    using clock_type = std::chrono::steady_clock;
+    auto const start = clock_type::now();
+
     for (auto candidateIter = byFee_.begin(); candidateIter != byFee_.end();)
     {
+        if (setup_.maximumAcceptTime.count() > 0 &&
+            clock_type::now() - start > setup_.maximumAcceptTime)
+        {
+            JLOG(j_.info()) << "Out of time moving queued transactions " <<
+                "into the open ledger, " << byFee_.size() <<
+                " left in the queue.";
+            if (!acceptPending_)
+            {
+                acceptPending_ = true;
+                app.getJobQueue().addJob(jtBATCH, "TxQ::accept",
+                    [this, &app](Job&)
+                    {
+                        resumeAccept(app);
+                    });
+            }
+            break;
+        }
+
+        if (acceptTried_.count(candidateIter->txID))
+        {
+            // Tried earlier on this open ledger, by an accept that
+            // ran out of time.
+            JLOG(j_.trace()) << "Skipping queued transaction " <<
+                candidateIter->txID << " already tried.";
+            candidateIter++;
+            continue;
+        }
+
         auto& account = byAccount_.at(candidateIter->account);
         if (candidateIter->sequence >
             account.transactions.begin()->first)
@@ -1274,6 +1360,7 @@ TxQ::accept(Application& app,
                 else
                     --candidateIter->retriesRemaining;
                 candidateIter->lastResult = txnResult;
+                acceptTried_.insert(candidateIter->txID);
                 if (account.dropPenalty &&
                     account.transactions.size() > 1 && isFull<95>())
                 {
@@ -1309,6 +1396,31 @@ TxQ::accept(Application& app,
     return ledgerChanged;
 }
 
+void
+TxQ::resumeAccept(Application& app)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        acceptPending_ = false;
+    }
+
+    bool changed = false;
+    {
+        auto lock = make_lock(app.getMasterMutex());
+        std::lock_guard <std::recursive_mutex> ledgerLock (
+            app.getLedgerMaster().peekMutex());
+
+        app.openLedger().modify(
+            [&](OpenView& view, beast::Journal j)
+            {
+                changed = accept(app, view);
+                return changed;
+            });
+    }
+    if (changed)
+        app.getOPs().reportFeeChange();
+}
+
 auto
 TxQ::getMetrics(OpenView const& view, std::uint32_t txCountPadding) const
     -> boost::optional<Metrics>
@@ -1493,6 +1605,9 @@ setup_TxQ(Config const& config)
         "minimum_last_ledger_buffer", section);
     set(setup.zeroBaseFeeTransactionFeeLevel,
         "zero_basefee_transaction_feelevel", section);
+    std::uint32_t acceptTime;
+    if (set(acceptTime, "maximum_accept_time", section))
+        setup.maximumAcceptTime = std::chrono::milliseconds(acceptTime);
 
     setup.standAlone = config.standalone();
     return setup;
@@ -39,6 +39,19 @@ hash_set<Currency> accountSourceCurrencies (
     if (includeCSC)
         currencies.insert (cscCurrency());
 
+    // The totals know which currencies the lines can send
+    if (auto const& totals = lrCache->getTotals ())
+    {
+        if (auto const lines = totals->account (account))
+        {
+            for (auto const& item : lines->currencies)
+                if (item.second.sendable != 0)
+                    currencies.insert (item.first);
+        }
+        currencies.erase (badCurrency());
+        return currencies;
+    }
+
     // List of casinocoin lines.
     auto& casinocoinLines = lrCache->getCasinocoinLines (account);
 
@@ -77,6 +90,19 @@ hash_set<Currency> accountDestCurrencies (
         currencies.insert (cscCurrency());
     // Even if account doesn't exist
 
+    // The totals know which currencies the lines can receive
+    if (auto const& totals = lrCache->getTotals ())
+    {
+        if (auto const lines = totals->account (account))
+        {
+            for (auto const& item : lines->currencies)
+                if (item.second.receivable != 0)
+                    currencies.insert (item.first);
+        }
+        currencies.erase (badCurrency());
+        return currencies;
+    }
+
     // List of casinocoin lines.
     auto& casinocoinLines = lrCache->getCasinocoinLines (account);
 
@@ -30,12 +30,26 @@
 namespace casinocoin {
 
 CasinocoinLineCache::CasinocoinLineCache(
-    std::shared_ptr <ReadView const> const& ledger)
+    std::shared_ptr <ReadView const> const& ledger,
+    std::shared_ptr <TrustLineGraph::Snapshot const> graph,
+    std::shared_ptr <TrustLineTotals::Snapshot const> totals)
 {
     // We want the caching that OpenView provides
     // And we need to own a shared_ptr to the input view
     // VFALCO TODO This should be a CachedLedger
     mLedger = std::make_shared<OpenView>(&*ledger, ledger);
+    mBaseLedger = ledger;
+
+    // Only a graph of this very ledger can stand in for its directories
+    if (graph && ! ledger->open () &&
+            graph->seq () == ledger->seq () &&
+            graph->hash () == ledger->info ().hash)
+        graph_ = std::move (graph);
+
+    if (totals && ! ledger->open () &&
+            totals->seq () == ledger->seq () &&
+            totals->hash () == ledger->info ().hash)
+        totals_ = std::move (totals);
 }
 
 std::vector<CasinocoinState::pointer> const&
@@ -49,8 +63,26 @@ CasinocoinLineCache::getCasinocoinLines (AccountID const& accountID)
         std::vector<CasinocoinState::pointer>());
 
     if (it.second)
-        it.first->second = getCasinocoinStateItems (
-            accountID, *mLedger);
+    {
+        if (graph_)
+        {
+            auto& items = it.first->second;
+            auto const lines = graph_->lines (accountID);
+            items.reserve (lines.size ());
+            for (auto const& line : lines)
+            {
+                auto const sle = mLedger->read (keylet::unchecked (line));
+                if (auto item = sle ? CasinocoinState::makeItem (
+                        accountID, sle) : nullptr)
+                    items.push_back (std::move (item));
+            }
+        }
+        else
+        {
+            it.first->second = getCasinocoinStateItems (
+                accountID, *mLedger);
+        }
+    }
 
     return it.first->second;
 }
@@ -28,6 +28,8 @@
 
 #include <casinocoin/app/ledger/Ledger.h>
 #include <casinocoin/app/paths/CasinocoinState.h>
+#include <casinocoin/app/paths/TrustLineGraph.h>
+#include <casinocoin/app/paths/TrustLineTotals.h>
 #include <casinocoin/basics/hardened_hash.h>
 #include <cstddef>
 #include <memory>
@@ -40,9 +42,17 @@ namespace casinocoin {
 class CasinocoinLineCache
 {
 public:
+    /** Create a cache of the trust lines in a ledger.
+
+        If a graph of the same ledger is given, the lines of an account
+        are looked up by key instead of walking its owner directory.
+        Totals of the same ledger are kept for getTotals.
+    */
     explicit
     CasinocoinLineCache (
-        std::shared_ptr <ReadView const> const& l);
+        std::shared_ptr <ReadView const> const& l,
+        std::shared_ptr <TrustLineGraph::Snapshot const> graph = nullptr,
+        std::shared_ptr <TrustLineTotals::Snapshot const> totals = nullptr);
 
     std::shared_ptr <ReadView const> const&
     getLedger () const
@@ -50,14 +60,31 @@ public:
         return mLedger;
     }
 
+    /** The ledger the cache was made with, rather than the view of it. */
+    std::shared_ptr <ReadView const> const&
+    getBaseLedger () const
+    {
+        return mBaseLedger;
+    }
+
     std::vector<CasinocoinState::pointer> const&
     getCasinocoinLines (AccountID const& accountID);
 
+    /** The trust line totals of the ledger, if the cache was given them. */
+    std::shared_ptr <TrustLineTotals::Snapshot const> const&
+    getTotals () const
+    {
+        return totals_;
+    }
+
 private:
     std::mutex mLock;
 
     casinocoin::hardened_hash<> hasher_;
     std::shared_ptr <ReadView const> mLedger;
+    std::shared_ptr <ReadView const> mBaseLedger;
+    std::shared_ptr <TrustLineGraph::Snapshot const> graph_;
+    std::shared_ptr <TrustLineTotals::Snapshot const> totals_;
 
     struct AccountKey
     {
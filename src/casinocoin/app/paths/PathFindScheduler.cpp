@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/paths/PathFindScheduler.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <algorithm>
+
+namespace casinocoin {
+
+void
+PathFindScheduler::order (std::vector<Entry>& entries)
+{
+    // The turn of each request: how many requests of the same client
+    // and class came before it
+    std::vector<std::size_t> turns (entries.size ());
+    {
+        hash_map<std::string, std::size_t> seen[2];
+        for (std::size_t i = 0; i < entries.size (); ++i)
+        {
+            auto const p = static_cast<int> (entries[i].priority);
+            turns[i] = seen[p][entries[i].client]++;
+        }
+    }
+
+    std::vector<std::size_t> index (entries.size ());
+    for (std::size_t i = 0; i < index.size (); ++i)
+        index[i] = i;
+
+    std::stable_sort (index.begin (), index.end (),
+        [&](std::size_t a, std::size_t b)
+        {
+            if (entries[a].priority != entries[b].priority)
+                return entries[a].priority < entries[b].priority;
+            return turns[a] < turns[b];
+        });
+
+    std::vector<Entry> ordered;
+    ordered.reserve (entries.size ());
+    for (auto const i : index)
+        ordered.push_back (std::move (entries[i]));
+    entries.swap (ordered);
+}
+
+PathFindScheduler::PathFindScheduler (std::chrono::milliseconds deadline)
+    : deadline_ (deadline)
+{
+}
+
+void
+PathFindScheduler::setDeadline (clock_type::duration deadline)
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    deadline_ = deadline;
+}
+
+PathFindScheduler::clock_type::time_point
+PathFindScheduler::deadline () const
+{
+    clock_type::duration deadline;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        deadline = deadline_;
+    }
+    if (deadline.count () <= 0)
+        return clock_type::time_point::max ();
+    return clock_type::now () + deadline;
+}
+
+void
+PathFindScheduler::queued (std::size_t n)
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    queued_ += n;
+}
+
+void
+PathFindScheduler::started (clock_type::time_point since)
+{
+    using namespace std::chrono;
+    auto const waited = duration_cast<microseconds> (
+        clock_type::now () - since).count ();
+
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (queued_ > 0)
+        --queued_;
+    ++running_;
+    waits_.add (static_cast<std::uint64_t> (std::max<std::int64_t> (0, waited)));
+}
+
+void
+PathFindScheduler::finished (clock_type::time_point start, bool partial)
+{
+    using namespace std::chrono;
+    auto const took = duration_cast<microseconds> (
+        clock_type::now () - start).count ();
+
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (running_ > 0)
+        --running_;
+    ++completed_;
+    if (partial)
+        ++partial_;
+    latencies_.add (static_cast<std::uint64_t> (std::max<std::int64_t> (0, took)));
+}
+
+void
+PathFindScheduler::skipped ()
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (queued_ > 0)
+        --queued_;
+}
+
+void
+PathFindScheduler::cancelled ()
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (queued_ > 0)
+        --queued_;
+    ++cancelled_;
+}
+
+Json::Value
+PathFindScheduler::getJson () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    Json::Value ret (Json::objectValue);
+    ret[jss::deadline_ms] = static_cast<Json::UInt> (
+        std::chrono::duration_cast<std::chrono::milliseconds> (
+            deadline_).count ());
+    ret[jss::queued] = static_cast<Json::UInt> (queued_);
+    ret[jss::running] = static_cast<Json::UInt> (running_);
+    ret[jss::completed] = std::to_string (completed_);
+    ret[jss::partial] = std::to_string (partial_);
+    ret[jss::cancelled] = std::to_string (cancelled_);
+    ret[jss::wait_us] = waits_.getJson ();
+    ret[jss::latency_us] = latencies_.getJson ();
+    return ret;
+}
+
+} // casinocoin
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_PATHS_PATHFINDSCHEDULER_H_INCLUDED
+#define CASINOCOIN_APP_PATHS_PATHFINDSCHEDULER_H_INCLUDED
+
+#include <casinocoin/app/paths/PathRequest.h>
+#include <casinocoin/basics/Histogram.h>
+#include <casinocoin/json/json_value.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace casinocoin {
+
+/** Decides the order path requests are updated in, and accounts for it.
+
+    Each pass over the path requests is scheduled as a whole:
+
+    - Requests from admin clients go before those of other clients.
+
+    - Within a class, clients take turns: every client's first request
+      goes before any client's second, so a client with many requests
+      can't hold the others back. A client's own requests keep the
+      order they had.
+
+    The requests are then updated on the worker pool, so a slow search
+    only holds up its own thread, and each update has a deadline after
+    which the source currencies not yet searched are left for the next
+    update, which searches them first. One-shot requests get no later
+    update, so theirs have no deadline.
+
+    The scheduler counts requests waiting and running, and keeps power
+    of two histograms of how long they waited and how long they took.
+*/
+class PathFindScheduler
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    enum class Priority
+    {
+        admin,
+        user
+    };
+
+    struct Entry
+    {
+        PathRequest::pointer request;
+        Priority priority;
+        std::string client;
+    };
+
+    /** Put a pass of requests in the order they should be served. */
+    static
+    void
+    order (std::vector<Entry>& entries);
+
+    /** The time allowed for one update, zero for no limit. */
+    explicit
+    PathFindScheduler (std::chrono::milliseconds deadline);
+
+    /** Change the time allowed for one update, zero for no limit. */
+    void
+    setDeadline (clock_type::duration deadline);
+
+    /** When an update started now should stop searching. */
+    clock_type::time_point
+    deadline () const;
+
+    /** Count `n` requests as waiting. */
+    void
+    queued (std::size_t n);
+
+    /** A waiting request starts, after waiting since `since`. */
+    void
+    started (clock_type::time_point since);
+
+    /** A running request finished, having started at `start`.
+
+        @param partial The deadline cut the update short.
+    */
+    void
+    finished (clock_type::time_point start, bool partial);
+
+    /** A waiting request turned out not to need an update, or was
+        left for the next pass.
+    */
+    void
+    skipped ();
+
+    /** A waiting request was dropped because the work was cancelled. */
+    void
+    cancelled ();
+
+    Json::Value
+    getJson () const;
+
+private:
+    std::mutex mutable mutex_;
+    clock_type::duration deadline_;
+    std::uint64_t queued_ = 0;
+    std::uint64_t running_ = 0;
+    std::uint64_t completed_ = 0;
+    std::uint64_t partial_ = 0;
+    std::uint64_t cancelled_ = 0;
+    Histogram waits_;
+    Histogram latencies_;
+};
+
+} // casinocoin
+
+#endif
@@ -0,0 +1,324 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/paths/PathLiquidityCache.h>
+#include <casinocoin/protocol/digest.h>
+#include <casinocoin/protocol/Serializer.h>
+#include <casinocoin/protocol/SField.h>
+#include <casinocoin/protocol/STLedgerEntry.h>
+#include <algorithm>
+#include <limits>
+
+namespace casinocoin {
+
+namespace {
+
+// Passes reads through to a view, noting what was read
+class RecordingView : public ReadView
+{
+private:
+    ReadView const& base_;
+
+public:
+    std::vector<uint256> mutable keys;
+    std::vector<std::tuple<uint256, boost::optional<uint256>,
+        boost::optional<uint256>>> mutable succs;
+    std::uint32_t mutable expiration =
+        std::numeric_limits<std::uint32_t>::max ();
+
+    explicit
+    RecordingView (ReadView const& base)
+        : base_ (base)
+    {
+    }
+
+    bool
+    exists (Keylet const& k) const override
+    {
+        keys.push_back (k.key);
+        return base_.exists (k);
+    }
+
+    std::shared_ptr<SLE const>
+    read (Keylet const& k) const override
+    {
+        keys.push_back (k.key);
+        auto sle = base_.read (k);
+
+        // An offer that already expired stays that way
+        if (sle && sle->getType () == ltOFFER &&
+                sle->isFieldPresent (sfExpiration))
+        {
+            auto const e = sle->getFieldU32 (sfExpiration);
+            if (e > base_.parentCloseTime ().time_since_epoch ().count ())
+                expiration = std::min (expiration, e);
+        }
+        return sle;
+    }
+
+    std::size_t
+    prefetch (std::vector<key_type> const& keys) const override
+    {
+        return base_.prefetch (keys);
+    }
+
+    boost::optional<key_type>
+    succ (key_type const& key, boost::optional<
+        key_type> const& last = boost::none) const override
+    {
+        auto found = base_.succ (key, last);
+        succs.emplace_back (key, last, found);
+        return found;
+    }
+
+    bool
+    open () const override
+    {
+        return base_.open ();
+    }
+
+    LedgerInfo const&
+    info () const override
+    {
+        return base_.info ();
+    }
+
+    Fees const&
+    fees () const override
+    {
+        return base_.fees ();
+    }
+
+    Rules const&
+    rules () const override
+    {
+        return base_.rules ();
+    }
+
+    LedgerConfig const&
+    ledgerConfig () const override
+    {
+        return base_.ledgerConfig ();
+    }
+
+    std::unique_ptr<sles_type::iter_base>
+    slesBegin () const override
+    {
+        return base_.slesBegin ();
+    }
+
+    std::unique_ptr<sles_type::iter_base>
+    slesEnd () const override
+    {
+        return base_.slesEnd ();
+    }
+
+    std::unique_ptr<sles_type::iter_base>
+    slesUpperBound (uint256 const& key) const override
+    {
+        return base_.slesUpperBound (key);
+    }
+
+    std::unique_ptr<txs_type::iter_base>
+    txsBegin () const override
+    {
+        return base_.txsBegin ();
+    }
+
+    std::unique_ptr<txs_type::iter_base>
+    txsEnd () const override
+    {
+        return base_.txsEnd ();
+    }
+
+    bool
+    txExists (key_type const& key) const override
+    {
+        return base_.txExists (key);
+    }
+
+    tx_type
+    txRead (key_type const& key) const override
+    {
+        return base_.txRead (key);
+    }
+};
+
+} // namespace
+
+void
+PathLiquidityCache::setLedger (std::shared_ptr<ReadView const> const& ledger)
+{
+    auto digests = std::dynamic_pointer_cast<
+        DigestAwareReadView const> (ledger);
+
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    if (! digests || digests->open ())
+    {
+        ledger_.reset ();
+        return;
+    }
+
+    if (ledger_ && ledger_->info ().hash == digests->info ().hash)
+        return;
+
+    // Drop what the last ledger had no use for
+    if (ledger_)
+    {
+        auto const seq = ledger_->seq ();
+        for (auto iter = entries_.begin (); iter != entries_.end ();)
+        {
+            if (iter->second->used != seq)
+                iter = entries_.erase (iter);
+            else
+                ++iter;
+        }
+    }
+
+    ledger_ = std::move (digests);
+}
+
+uint256
+PathLiquidityCache::makeKey (STPath const& path, AccountID const& srcAccount,
+    AccountID const& dstAccount, STAmount const& srcAmount,
+        STAmount const& dstAmount, STAmount const& minDstAmount)
+{
+    Serializer s (256);
+    s.add160 (srcAccount);
+    s.add160 (dstAccount);
+    srcAmount.add (s);
+    s.add160 (srcAmount.getIssuer ());
+    dstAmount.add (s);
+    s.add160 (dstAmount.getIssuer ());
+    minDstAmount.add (s);
+    for (auto const& element : path)
+    {
+        s.add8 (element.getNodeType ());
+        s.add160 (element.getAccountID ());
+        s.add160 (element.getCurrency ());
+        s.add160 (element.getIssuerID ());
+    }
+    return s.getSHA512Half ();
+}
+
+bool
+PathLiquidityCache::valid (Entry const& entry, ReadView const& view,
+    DigestAwareReadView const& ledger)
+{
+    auto const& fees = view.fees ();
+    if (fees.base != entry.fees.base ||
+            fees.units != entry.fees.units ||
+            fees.reserve != entry.fees.reserve ||
+            fees.increment != entry.fees.increment)
+        return false;
+
+    if (*entry.rules != view.rules ())
+        return false;
+
+    if (view.parentCloseTime ().time_since_epoch ().count () >=
+            entry.expiration)
+        return false;
+
+    for (auto const& digest : entry.digests)
+        if (ledger.digest (digest.first) != digest.second)
+            return false;
+
+    for (auto const& succ : entry.succs)
+        if (ledger.succ (succ.key, succ.last) != succ.found)
+            return false;
+
+    return true;
+}
+
+PathLiquidityCache::Result
+PathLiquidityCache::get (uint256 const& key, ReadView const& view,
+    Compute const& compute)
+{
+    std::shared_ptr<DigestAwareReadView const> ledger;
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        ledger = ledger_;
+        if (! ledger || view.info ().hash != ledger->info ().hash)
+            return compute (view);
+
+        auto const iter = entries_.find (key);
+        if (iter != entries_.end ())
+        {
+            entry = iter->second;
+            if (entry->ledger == ledger->info ().hash)
+            {
+                ++hits_;
+                return entry->result;
+            }
+        }
+    }
+
+    if (entry && valid (*entry, view, *ledger))
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        entry->ledger = ledger->info ().hash;
+        entry->used = ledger->seq ();
+        ++hits_;
+        return entry->result;
+    }
+
+    ++misses_;
+
+    RecordingView recorder (view);
+    auto const result = compute (recorder);
+    if (result.ter == tefEXCEPTION)
+        return result;
+
+    auto fresh = std::make_shared<Entry> ();
+    fresh->result = result;
+
+    auto& keys = recorder.keys;
+    std::sort (keys.begin (), keys.end ());
+    keys.erase (std::unique (keys.begin (), keys.end ()), keys.end ());
+    fresh->digests.reserve (keys.size ());
+    for (auto const& k : keys)
+        fresh->digests.emplace_back (k, ledger->digest (k));
+
+    fresh->succs.reserve (recorder.succs.size ());
+    for (auto const& succ : recorder.succs)
+        fresh->succs.push_back ({std::get<0> (succ),
+            std::get<1> (succ), std::get<2> (succ)});
+
+    fresh->fees = view.fees ();
+    fresh->rules.emplace (view.rules ());
+    fresh->expiration = recorder.expiration;
+    fresh->ledger = ledger->info ().hash;
+    fresh->used = ledger->seq ();
+
+    std::lock_guard<std::mutex> lock (mutex_);
+    entries_[key] = std::move (fresh);
+    return result;
+}
+
+std::size_t
+PathLiquidityCache::size () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return entries_.size ();
+}
+
+} // casinocoin
@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_PATHS_PATHLIQUIDITYCACHE_H_INCLUDED
+#define CASINOCOIN_APP_PATHS_PATHLIQUIDITYCACHE_H_INCLUDED
+
+#include <casinocoin/ledger/ReadView.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/protocol/STAmount.h>
+#include <casinocoin/protocol/STPathSet.h>
+#include <casinocoin/protocol/TER.h>
+#include <boost/optional.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace casinocoin {
+
+/** Liquidity checks of paths, kept from one ledger to the next.
+
+    A path find subscription ranks much the same candidate paths every
+    ledger, each with a full payment calculation. The calculation only
+    depends on the entries it reads, so the cache records the keys it
+    read, with their digests in the ledger, and what succ() returned.
+    When none of them changed in a later ledger, and neither did the
+    fees, the rules, or the expiry of an offer that was read, the
+    result is reused.
+
+    Only closed ledgers have digests: with an open ledger nothing is
+    looked up or stored. Lookups and stores may be concurrent.
+*/
+class PathLiquidityCache
+{
+public:
+    struct Result
+    {
+        TER ter;
+        STAmount amountOut;
+        std::uint64_t quality;
+    };
+
+    using Compute = std::function<Result (ReadView const&)>;
+
+    PathLiquidityCache () = default;
+    PathLiquidityCache (PathLiquidityCache const&) = delete;
+    PathLiquidityCache& operator= (PathLiquidityCache const&) = delete;
+
+    /** Start using the cache with another ledger.
+
+        @param ledger The closed ledger, not a view of it, so that the
+                      digests of its entries can be read.
+    */
+    void
+    setLedger (std::shared_ptr<ReadView const> const& ledger);
+
+    /** The key of a liquidity check. */
+    static uint256
+    makeKey (STPath const& path, AccountID const& srcAccount,
+        AccountID const& dstAccount, STAmount const& srcAmount,
+            STAmount const& dstAmount, STAmount const& minDstAmount);
+
+    /** Return the result of a check, running it if there's none to use.
+
+        @param view The view of the current ledger to check against.
+        @param compute Runs the check on the view it is passed.
+    */
+    Result
+    get (uint256 const& key, ReadView const& view, Compute const& compute);
+
+    std::size_t
+    size () const;
+
+    std::uint64_t
+    hits () const
+    {
+        return hits_;
+    }
+
+    std::uint64_t
+    misses () const
+    {
+        return misses_;
+    }
+
+private:
+    struct Entry
+    {
+        Result result;
+
+        // What the check read, and what it found
+        std::vector<std::pair<uint256, boost::optional<uint256>>> digests;
+        struct Succ
+        {
+            uint256 key;
+            boost::optional<uint256> last;
+            boost::optional<uint256> found;
+        };
+        std::vector<Succ> succs;
+
+        Fees fees;
+        boost::optional<Rules> rules;
+        // The earliest expiration of an offer that was read
+        std::uint32_t expiration;
+
+        // The last ledger the entry was found good for. Only changed
+        // with the mutex held, the rest never changes once stored.
+        uint256 ledger;
+        LedgerIndex used;
+    };
+
+    static bool
+    valid (Entry const& entry, ReadView const& view,
+        DigestAwareReadView const& ledger);
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<DigestAwareReadView const> ledger_;
+    hash_map<uint256, std::shared_ptr<Entry>> entries_;
+    std::atomic<std::uint64_t> hits_ {0};
+    std::atomic<std::uint64_t> misses_ {0};
+};
+
+} // casinocoin
+
+#endif
@@ -151,6 +151,16 @@ bool PathRequest::needsUpdate (bool newOnly, LedgerIndex index)
     return true;
 }
 
+bool PathRequest::isAdmin () const
+{
+    return consumer_.isUnlimited ();
+}
+
+std::string PathRequest::client () const
+{
+    return consumer_.to_string ();
+}
+
 bool PathRequest::hasCompletion ()
 {
     return bool (fCompletion);
@@ -461,29 +471,116 @@ Json::Value PathRequest::doStatus (Json::Value const&)
     return jvStatus;
 }
 
-std::unique_ptr<Pathfinder> const&
+std::unique_ptr<Pathfinder>
 PathRequest::getPathFinder(std::shared_ptr<CasinocoinLineCache> const& cache,
-    hash_map<Currency, std::unique_ptr<Pathfinder>>& currency_map,
-        Currency const& currency, STAmount const& dst_amount,
-            int const level)
+    Currency const& currency, STAmount const& dst_amount, int const level)
 {
-    auto i = currency_map.find(currency);
-    if (i != currency_map.end())
-        return i->second;
     auto pathfinder = std::make_unique<Pathfinder>(
         cache, *raSrcAccount, *raDstAccount, currency,
             boost::none, dst_amount, saSendMax, app_);
+    pathfinder->setLiquidityCache(&liquidity_);
     if (pathfinder->findPaths(level))
         pathfinder->computePathRanks(max_paths_);
     else
         pathfinder.reset();  // It's a bad request - clear it.
-    return currency_map[currency] = std::move(pathfinder);
+    return pathfinder;
+}
+
+void
+PathRequest::findPaths (std::shared_ptr<CasinocoinLineCache> const& cache,
+    Pathfinder* pathfinder, STAmount const& dst_amount, Search& search) const
+{
+    auto const& issue = search.issue;
+
+    JLOG(m_journal.debug())
+        << iIdentifier
+        << " Trying to find paths: "
+        << STAmount(issue, 1).getFullText();
+
+    if (! pathfinder)
+    {
+        assert(false);
+        JLOG(m_journal.debug()) << iIdentifier << " No paths found";
+        return;
+    }
+
+    STPath fullLiquidityPath;
+    auto ps = pathfinder->getBestPaths(max_paths_,
+        fullLiquidityPath, search.context, issue.account);
+
+    auto& sourceAccount = ! isCSC(issue.account)
+        ? issue.account
+        : isCSC(issue.currency)
+        ? cscAccount()
+        : *raSrcAccount;
+    STAmount saMaxAmount = saSendMax.value_or(
+        STAmount({issue.currency, sourceAccount}, 1u, 0, true));
+
+    JLOG(m_journal.debug()) << iIdentifier
+        << " Paths found, calling casinocoinCalc";
+
+    path::CasinocoinCalc::Input rcInput;
+    if (convert_all_)
+        rcInput.partialPaymentAllowed = true;
+    auto sandbox = std::make_unique<PaymentSandbox>
+        (&*cache->getLedger(), tapNONE);
+    auto rc = path::CasinocoinCalc::casinocoinCalculate(
+        *sandbox,
+        saMaxAmount,    // --> Amount to send is unlimited
+                        //     to get an estimate.
+        dst_amount,     // --> Amount to deliver.
+        *raDstAccount,  // --> Account to deliver to.
+        *raSrcAccount,  // --> Account sending from.
+        ps,             // --> Path set.
+        app_.logs(),
+        &rcInput);
+
+    if (! convert_all_ &&
+        ! fullLiquidityPath.empty() &&
+        (rc.result() == terNO_LINE || rc.result() == tecPATH_PARTIAL))
+    {
+        JLOG(m_journal.debug()) << iIdentifier
+            << " Trying with an extra path element";
+
+        ps.push_back(fullLiquidityPath);
+        sandbox = std::make_unique<PaymentSandbox>
+            (&*cache->getLedger(), tapNONE);
+        rc = path::CasinocoinCalc::casinocoinCalculate(
+            *sandbox,
+            saMaxAmount,    // --> Amount to send is unlimited
+                            //     to get an estimate.
+            dst_amount,     // --> Amount to deliver.
+            *raDstAccount,  // --> Account to deliver to.
+            *raSrcAccount,  // --> Account sending from.
+            ps,             // --> Path set.
+            app_.logs());
+
+        if (rc.result() != tesSUCCESS)
+        {
+            JLOG(m_journal.warn()) << iIdentifier
+                << " Failed with covering path "
+                << transHuman(rc.result());
+        }
+        else
+        {
+            JLOG(m_journal.debug()) << iIdentifier
+                << " Extra path element gives "
+                << transHuman(rc.result());
+        }
+    }
+
+    search.found = true;
+    search.ps = std::move(ps);
+    search.rc = std::move(rc);
 }
 
 bool
 PathRequest::findPaths (std::shared_ptr<CasinocoinLineCache> const& cache,
-    int const level, Json::Value& jvArray)
+    int const level, Json::Value& jvArray,
+        std::chrono::steady_clock::time_point deadline)
 {
+    partial_ = false;
+
     auto sourceCurrencies = sciSourceCurrencies;
     if (sourceCurrencies.empty ())
     {
@@ -504,95 +601,102 @@ PathRequest::findPaths (std::shared_ptr<CasinocoinLineCache> const& cache,
     auto const dst_amount = convert_all_ ?
         STAmount(saDstAmount.issue(), STAmount::cMaxValue, STAmount::cMaxOffset)
             : saDstAmount;
-    hash_map<Currency, std::unique_ptr<Pathfinder>> currency_map;
+
+    // Issues of the same currency share a Pathfinder, so the search for
+    // each currency runs as one task. Each task only reads the ledger
+    // and writes the results of its own issues, which are then used in
+    // the order of the issues, whatever order the tasks finished in.
+    liquidity_.setLedger(cache->getBaseLedger());
+
+    std::vector<Search> searches;
+    searches.reserve(sourceCurrencies.size());
+    std::vector<std::vector<std::size_t>> byCurrency;
+    hash_map<Currency, std::size_t> tasks;
     for (auto const& issue : sourceCurrencies)
     {
-        JLOG(m_journal.debug())
-            << iIdentifier
-            << " Trying to find paths: "
-            << STAmount(issue, 1).getFullText();
+        auto const task = tasks.emplace (
+            issue.currency, byCurrency.size()).first->second;
+        if (task == byCurrency.size())
+            byCurrency.emplace_back();
+        byCurrency[task].push_back(searches.size());
 
-        auto& pathfinder = getPathFinder(cache, currency_map,
-            issue.currency, dst_amount, level);
-        if (! pathfinder)
+        searches.emplace_back();
+        searches.back().issue = issue;
+        searches.back().context = mContext[issue];
+    }
+
+    // Currencies the last update didn't get to go first, in the order
+    // they were left in, so that each currency gets its turn
+    std::vector<std::size_t> order;
+    order.reserve(byCurrency.size());
+    std::vector<char> first(byCurrency.size(), 0);
+    for (auto const& currency : skipped_)
+    {
+        auto const it = tasks.find(currency);
+        if (it != tasks.end())
         {
-            assert(false);
-            JLOG(m_journal.debug()) << iIdentifier << " No paths found";
-            continue;
+            first[it->second] = 1;
+            order.push_back(it->second);
         }
+    }
+    for (std::size_t task = 0; task < byCurrency.size(); ++task)
+    {
+        if (! first[task])
+            order.push_back(task);
+    }
 
-        STPath fullLiquidityPath;
-        auto ps = pathfinder->getBestPaths(max_paths_,
-            fullLiquidityPath, mContext[issue], issue.account);
-        mContext[issue] = ps;
-
-        auto& sourceAccount = ! isCSC(issue.account)
-            ? issue.account
-            : isCSC(issue.currency)
-            ? cscAccount()
-            : *raSrcAccount;
-        STAmount saMaxAmount = saSendMax.value_or(
-            STAmount({issue.currency, sourceAccount}, 1u, 0, true));
-
-        JLOG(m_journal.debug()) << iIdentifier
-            << " Paths found, calling casinocoinCalc";
+    // Searches not started by the deadline wait for the next update,
+    // but every update searches at least one currency
+    std::atomic<std::size_t> started {0};
+    std::vector<char> ran(byCurrency.size(), 0);
+    mOwner.forEach(order.size(),
+        [&](std::size_t i)
+        {
+            if (started++ != 0 &&
+                std::chrono::steady_clock::now() >= deadline)
+                return;
+            auto const task = order[i];
+            ran[task] = 1;
+            auto const pathfinder = getPathFinder(cache,
+                searches[byCurrency[task].front()].issue.currency,
+                    dst_amount, level);
+            for (auto const j : byCurrency[task])
+                findPaths(cache, pathfinder.get(), dst_amount, searches[j]);
+        });
+
+    skipped_.clear();
+    std::size_t searched = 0;
+    for (auto const task : order)
+    {
+        if (ran[task])
+            searched += byCurrency[task].size();
+        else
+            skipped_.push_back(
+                searches[byCurrency[task].front()].issue.currency);
+    }
+    partial_ = ! skipped_.empty();
 
-        path::CasinocoinCalc::Input rcInput;
-        if (convert_all_)
-            rcInput.partialPaymentAllowed = true;
-        auto sandbox = std::make_unique<PaymentSandbox>
-            (&*cache->getLedger(), tapNONE);
-        auto rc = path::CasinocoinCalc::casinocoinCalculate(
-            *sandbox,
-            saMaxAmount,    // --> Amount to send is unlimited
-                            //     to get an estimate.
-            dst_amount,     // --> Amount to deliver.
-            *raDstAccount,  // --> Account to deliver to.
-            *raSrcAccount,  // --> Account sending from.
-            ps,             // --> Path set.
-            app_.logs(),
-            &rcInput);
+    for (auto& search : searches)
+    {
+        auto const& issue = search.issue;
+        if (! search.found)
+            continue;
 
-        if (! convert_all_ &&
-            ! fullLiquidityPath.empty() &&
-            (rc.result() == terNO_LINE || rc.result() == tecPATH_PARTIAL))
-        {
-            JLOG(m_journal.debug()) << iIdentifier
-                << " Trying with an extra path element";
-
-            ps.push_back(fullLiquidityPath);
-            sandbox = std::make_unique<PaymentSandbox>
-                (&*cache->getLedger(), tapNONE);
-            rc = path::CasinocoinCalc::casinocoinCalculate(
-                *sandbox,
-                saMaxAmount,    // --> Amount to send is unlimited
-                                //     to get an estimate.
-                dst_amount,     // --> Amount to deliver.
-                *raDstAccount,  // --> Account to deliver to.
-                *raSrcAccount,  // --> Account sending from.
-                ps,             // --> Path set.
-                app_.logs());
-
-            if (rc.result() != tesSUCCESS)
-            {
-                JLOG(m_journal.warn()) << iIdentifier
-                    << " Failed with covering path "
-                    << transHuman(rc.result());
-            }
-            else
-            {
-                JLOG(m_journal.debug()) << iIdentifier
-                    << " Extra path element gives "
-                    << transHuman(rc.result());
-            }
-        }
+        mContext[issue] = search.ps;
 
+        auto& rc = search.rc;
         if (rc.result () == tesSUCCESS)
         {
+            auto& sourceAccount = ! isCSC(issue.account)
+                ? issue.account
+                : isCSC(issue.currency)
+                ? cscAccount()
+                : *raSrcAccount;
+
             Json::Value jvEntry (Json::objectValue);
             rc.actualAmountIn.setIssuer (sourceAccount);
             jvEntry[jss::source_amount] = rc.actualAmountIn.getJson (0);
-            jvEntry[jss::paths_computed] = ps.getJson(0);
+            jvEntry[jss::paths_computed] = search.ps.getJson(0);
 
             if (convert_all_)
                 jvEntry[jss::destination_amount] = rc.actualAmountOut.getJson(0);
@@ -612,18 +716,24 @@ PathRequest::findPaths (std::shared_ptr<CasinocoinLineCache> const& cache,
         }
     }
 
-    /*  The resource fee is based on the number of source currencies used.
+    JLOG(m_journal.debug()) << iIdentifier << " Path liquidity cache: "
+        << liquidity_.hits() << " hits, " << liquidity_.misses()
+        << " misses, " << liquidity_.size() << " entries";
+
+    /*  The resource fee is based on the number of source currencies
+        searched, so an update cut short by its deadline costs less.
         The minimum cost is 50 and the maximum is 400. The cost increases
         after four source currencies, 50 - (4 * 4) = 34.
     */
-    int const size = sourceCurrencies.size();
+    int const size = searched;
     consumer_.charge({boost::algorithm::clamp(size * size + 34, 50, 400),
         "path update"});
     return true;
 }
 
 Json::Value PathRequest::doUpdate(
-    std::shared_ptr<CasinocoinLineCache> const& cache, bool fast)
+    std::shared_ptr<CasinocoinLineCache> const& cache, bool fast,
+    std::chrono::steady_clock::time_point deadline)
 {
     using namespace std::chrono;
     JLOG(m_journal.debug()) << iIdentifier
@@ -650,7 +760,6 @@ Json::Value PathRequest::doUpdate(
     newStatus[jss::source_account] = app_.accountIDCache().toBase58(*raSrcAccount);
     newStatus[jss::destination_account] = app_.accountIDCache().toBase58(*raDstAccount);
     newStatus[jss::destination_amount] = saDstAmount.getJson (0);
-    newStatus[jss::full_reply] = ! fast;
 
     if (jvId)
         newStatus[jss::id] = jvId;
@@ -692,7 +801,7 @@ Json::Value PathRequest::doUpdate(
         << " processing at level " << iLevel;
 
     Json::Value jvArray = Json::arrayValue;
-    if (findPaths(cache, iLevel, jvArray))
+    if (findPaths(cache, iLevel, jvArray, deadline))
     {
         bLastSuccess = jvArray.size() != 0;
         newStatus[jss::alternatives] = std::move (jvArray);
@@ -703,12 +812,17 @@ Json::Value PathRequest::doUpdate(
         newStatus = rpcError(rpcINTERNAL);
     }
 
+    // An update cut short by its deadline is not a full reply
+    bool const full = ! fast && ! partial_;
+    if (newStatus.isMember (jss::alternatives))
+        newStatus[jss::full_reply] = full;
+
     if (fast && quick_reply_ == steady_clock::time_point{})
     {
         quick_reply_ = steady_clock::now();
         mOwner.reportFast(duration_cast<milliseconds>(quick_reply_ - created_));
     }
-    else if (! fast && full_reply_ == steady_clock::time_point{})
+    else if (full && full_reply_ == steady_clock::time_point{})
     {
         full_reply_ = steady_clock::now();
         mOwner.reportFull(duration_cast<milliseconds>(full_reply_ - created_));
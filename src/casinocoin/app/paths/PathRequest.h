@@ -28,15 +28,19 @@
 
 #include <casinocoin/app/ledger/Ledger.h>
 #include <casinocoin/app/paths/Pathfinder.h>
+#include <casinocoin/app/paths/CasinocoinCalc.h>
+#include <casinocoin/app/paths/PathLiquidityCache.h>
 #include <casinocoin/app/paths/CasinocoinLineCache.h>
 #include <casinocoin/json/json_value.h>
 #include <casinocoin/net/InfoSub.h>
 #include <casinocoin/protocol/types.h>
 #include <boost/optional.hpp>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <set>
 #include <utility>
+#include <vector>
 
 namespace casinocoin {
 
@@ -91,6 +95,12 @@ public:
     bool needsUpdate (bool newOnly, LedgerIndex index);
     void updateComplete ();
 
+    // Whether the request comes from an admin client
+    bool isAdmin () const;
+
+    // Identifies the client the request comes from
+    std::string client () const;
+
     std::pair<bool, Json::Value> doCreate (
         std::shared_ptr<CasinocoinLineCache> const&,
         Json::Value const&);
@@ -99,8 +109,19 @@ public:
     Json::Value doStatus (Json::Value const&);
 
     // update jvStatus
+    // Source currencies not searched by the deadline are left for
+    // the next update, which searches them first
     Json::Value doUpdate (
-        std::shared_ptr<CasinocoinLineCache> const&, bool fast);
+        std::shared_ptr<CasinocoinLineCache> const&, bool fast,
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::time_point::max ());
+
+    // Whether the last update stopped at its deadline
+    bool partial () const
+    {
+        return partial_;
+    }
+
     InfoSub::pointer getSubscriber ();
     bool hasCompletion ();
 
@@ -110,16 +131,34 @@ private:
     bool isValid (std::shared_ptr<CasinocoinLineCache> const& crCache);
     void setValid ();
 
-    std::unique_ptr<Pathfinder> const&
+    std::unique_ptr<Pathfinder>
     getPathFinder(std::shared_ptr<CasinocoinLineCache> const&,
-        hash_map<Currency, std::unique_ptr<Pathfinder>>&, Currency const&,
-            STAmount const&, int const);
+        Currency const&, STAmount const&, int const);
+
+    // The paths from one source issue and what they can deliver
+    struct Search
+    {
+        Issue issue;
+        STPathSet context;          // Paths from the last update
+        bool found = false;
+        STPathSet ps;
+        path::CasinocoinCalc::Output rc;
+    };
+
+    /** Picks the best paths for an issue and checks them.
+        May run on any thread, concurrently with other searches.
+    */
+    void
+    findPaths (std::shared_ptr<CasinocoinLineCache> const&,
+        Pathfinder* pathfinder, STAmount const& dst_amount,
+            Search& search) const;
 
     /** Finds and sets a PathSet in the JSON argument.
         Returns false if the source currencies are inavlid.
     */
     bool
-    findPaths (std::shared_ptr<CasinocoinLineCache> const&, int const, Json::Value&);
+    findPaths (std::shared_ptr<CasinocoinLineCache> const&, int const,
+        Json::Value&, std::chrono::steady_clock::time_point deadline);
 
     int parseJson (Json::Value const&);
 
@@ -145,6 +184,8 @@ private:
 
     std::set<Issue> sciSourceCurrencies;
     std::map<Issue, STPathSet> mContext;
+    // Path liquidity kept across updates
+    PathLiquidityCache liquidity_;
 
     bool convert_all_;
 
@@ -154,6 +195,10 @@ private:
 
     int iLevel;
     bool bLastSuccess;
+    bool partial_ = false;
+    // Currencies the last update left unsearched, which the next
+    // update searches first
+    std::vector<Currency> skipped_;
 
     int iIdentifier;
 
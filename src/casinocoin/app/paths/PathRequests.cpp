@@ -29,9 +29,12 @@
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/basics/Log.h>
 #include <casinocoin/core/JobQueue.h>
+#include <casinocoin/core/WorkerPool.h>
 #include <casinocoin/protocol/JsonFields.h>
 #include <casinocoin/resource/Fees.h>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 
 namespace casinocoin {
 
@@ -43,6 +46,19 @@ PathRequests::getLineCache (
     std::shared_ptr <ReadView const> const& ledger,
     bool authoritative)
 {
+    // Bring the trust line graph and totals up to date before taking
+    // the lock, building them from scratch can take a while. Callers
+    // passing an authoritative ledger mustn't hold the lock either.
+    auto const getLedger =
+        [this](uint256 const& hash) -> std::shared_ptr<ReadView const>
+        {
+            return app_.getLedgerMaster ().getLedgerByHash (hash);
+        };
+    auto const graph = authoritative ?
+        graph_.update (ledger, getLedger) : graph_.current ();
+    auto const totals = authoritative ?
+        totals_.update (ledger, getLedger) : totals_.current ();
+
     ScopedLockType sl (mLock);
 
     std::uint32_t lineSeq = mLineCache ? mLineCache->getLedger()->seq() : 0;
@@ -53,7 +69,8 @@ PathRequests::getLineCache (
          (authoritative && ((lgrSeq + 8)  < lineSeq)) ||   // we jumped way back for some reason
          (lgrSeq > (lineSeq + 8)))                         // we jumped way forward for some reason
     {
-        mLineCache = std::make_shared<CasinocoinLineCache> (ledger);
+        mLineCache = std::make_shared<CasinocoinLineCache> (
+            ledger, graph, totals);
     }
     return mLineCache;
 }
@@ -72,85 +89,139 @@ void PathRequests::updateAll (std::shared_ptr <ReadView const> const& inLedger,
     {
         ScopedLockType sl (mLock);
         requests = requests_;
-        cache = getLineCache (inLedger, true);
     }
+    cache = getLineCache (inLedger, true);
 
     bool newRequests = app_.getLedgerMaster().isNewPathRequest();
-    bool mustBreak = false;
+    std::atomic<bool> mustBreak {false};
 
     JLOG (mJournal.trace()) <<
         "updateAll seq=" << cache->getLedger()->seq() <<
         ", " << requests.size() << " requests";
 
-    int processed = 0, removed = 0;
+    std::atomic<int> processed {0};
+    int removed = 0;
 
     do
     {
+        // Serve the live requests in the scheduler's order. The updates
+        // run on the worker pool, so a slow one only holds up its own
+        // thread.
+        std::vector<PathFindScheduler::Entry> entries;
+        entries.reserve (requests.size ());
         for (auto const& wr : requests)
         {
-            if (shouldCancel())
-                break;
+            if (auto request = wr.lock ())
+            {
+                auto const priority = request->isAdmin () ?
+                    PathFindScheduler::Priority::admin :
+                    PathFindScheduler::Priority::user;
+                entries.push_back ({request, priority, request->client ()});
+            }
+        }
+        PathFindScheduler::order (entries);
+
+        auto const queuedAt = PathFindScheduler::clock_type::now ();
+        scheduler_.queued (entries.size ());
+
+        // Requests to forget once the pass is over
+        std::mutex doneLock;
+        std::vector<PathRequest::pointer> done;
+
+        mustBreak = false;
+        auto const seq = cache->getLedger()->seq();
+        forEach (entries.size (), [&](std::size_t i)
+        {
+            if (shouldCancel ())
+            {
+                scheduler_.cancelled ();
+                return;
+            }
 
-            auto request = wr.lock ();
+            // We weren't handling new requests and then
+            // there was a new request
+            if (mustBreak)
+            {
+                scheduler_.skipped ();
+                return;
+            }
+
+            auto const& request = entries[i].request;
             bool remove = true;
+            bool updated = false;
 
-            if (request)
+            if (!request->needsUpdate (newRequests, seq))
+                remove = false;
+            else
             {
-                if (!request->needsUpdate (newRequests, cache->getLedger()->seq()))
-                    remove = false;
-                else
+                auto const start = PathFindScheduler::clock_type::now ();
+                if (auto ipSub = request->getSubscriber ())
                 {
-                    if (auto ipSub = request->getSubscriber ())
+                    if (!ipSub->getConsumer ().warn ())
                     {
-                        if (!ipSub->getConsumer ().warn ())
-                        {
-                            Json::Value update = request->doUpdate (cache, false);
-                            request->updateComplete ();
-                            update[jss::type] = "path_find";
-                            ipSub->send (update, false);
-                            remove = false;
-                            ++processed;
-                        }
-                    }
-                    else if (request->hasCompletion ())
-                    {
-                        // One-shot request with completion function
-                        request->doUpdate (cache, false);
-                        request->updateComplete();
-                        ++processed;
+                        scheduler_.started (queuedAt);
+                        Json::Value update = request->doUpdate (
+                            cache, false, scheduler_.deadline ());
+                        request->updateComplete ();
+                        update[jss::type] = "path_find";
+                        ipSub->send (update, false);
+                        remove = false;
+                        updated = true;
                     }
                 }
+                else if (request->hasCompletion ())
+                {
+                    // One-shot request with completion function. It gets
+                    // no later update, so it searches every currency.
+                    scheduler_.started (queuedAt);
+                    request->doUpdate (cache, false);
+                    request->updateComplete();
+                    updated = true;
+                }
+
+                if (updated)
+                {
+                    scheduler_.finished (start, request->partial ());
+                    ++processed;
+                }
             }
 
+            if (! updated)
+                scheduler_.skipped ();
+
             if (remove)
             {
-                ScopedLockType sl (mLock);
-
-                // Remove any dangling weak pointers or weak
-                // pointers that refer to this path request.
-                auto ret = std::remove_if (
-                    requests_.begin(), requests_.end(),
-                    [&removed,&request](auto const& wl)
-                    {
-                        auto r = wl.lock();
-
-                        if (r && r != request)
-                            return false;
-                        ++removed;
-                        return true;
-                    });
+                std::lock_guard<std::mutex> lock (doneLock);
+                done.push_back (request);
+            }
 
-                requests_.erase (ret, requests_.end());
+            if (!newRequests && !mustBreak &&
+                app_.getLedgerMaster().isNewPathRequest())
+            {
+                mustBreak = true;
             }
+        });
+
+        if (! done.empty () || entries.size () != requests.size ())
+        {
+            ScopedLockType sl (mLock);
 
-            mustBreak = !newRequests &&
-                app_.getLedgerMaster().isNewPathRequest();
+            // Remove any dangling weak pointers or weak
+            // pointers that refer to finished path requests.
+            auto ret = std::remove_if (
+                requests_.begin(), requests_.end(),
+                [&removed,&done](auto const& wl)
+                {
+                    auto r = wl.lock();
 
-            // We weren't handling new requests and then
-            // there was a new request
-            if (mustBreak)
-                break;
+                    if (r && std::find (done.begin(), done.end(), r) ==
+                            done.end())
+                        return false;
+                    ++removed;
+                    return true;
+                });
 
+            requests_.erase (ret, requests_.end());
         }
 
         if (mustBreak)
@@ -181,10 +252,17 @@ void PathRequests::updateAll (std::shared_ptr <ReadView const> const& inLedger,
     while (!shouldCancel ());
 
     JLOG (mJournal.debug()) <<
-        "updateAll complete: " << processed << " processed and " <<
+        "updateAll complete: " << processed.load () << " processed and " <<
         removed << " removed";
 }
 
+void PathRequests::forEach (std::size_t n,
+    std::function<void (std::size_t)> const& f)
+{
+    // By default, up to 4 threads if the hardware has them
+    app_.getWorkerPool ().forEach (n, f, threads_ != 0 ? threads_ : 4);
+}
+
 void PathRequests::insertPathRequest (
     PathRequest::pointer const& req)
 {
@@ -264,14 +342,23 @@ PathRequests::doLegacyPathRequest (
         std::shared_ptr<ReadView const> const& inLedger,
         Json::Value const& request)
 {
-    auto cache = std::make_shared<CasinocoinLineCache> (inLedger);
+    auto cache = std::make_shared<CasinocoinLineCache> (
+        inLedger, graph_.current (), totals_.current ());
 
     auto req = std::make_shared<PathRequest> (app_, []{},
         consumer, ++mLastIdentifier, *this, mJournal);
 
     auto result = req->doCreate (cache, request);
     if (result.first)
+    {
+        // Runs on the caller's thread, and without a deadline: there
+        // is no later update to search the rest of the currencies
+        auto const start = PathFindScheduler::clock_type::now ();
+        scheduler_.queued (1);
+        scheduler_.started (start);
         result.second = req->doUpdate (cache, false);
+        scheduler_.finished (start, req->partial ());
+    }
     return std::move (result.second);
 }
 
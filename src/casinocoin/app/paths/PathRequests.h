@@ -27,10 +27,16 @@
 #define CASINOCOIN_APP_PATHS_PATHREQUESTS_H_INCLUDED
 
 #include <casinocoin/app/main/Application.h>
+#include <casinocoin/app/paths/PathFindScheduler.h>
 #include <casinocoin/app/paths/PathRequest.h>
 #include <casinocoin/app/paths/CasinocoinLineCache.h>
+#include <casinocoin/app/paths/TrustLineGraph.h>
+#include <casinocoin/app/paths/TrustLineTotals.h>
+#include <casinocoin/core/Config.h>
 #include <casinocoin/core/Job.h>
+#include <algorithm>
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <vector>
 
@@ -43,6 +49,11 @@ public:
             beast::Journal journal, beast::insight::Collector::ptr const& collector)
         : app_ (app)
         , mJournal (journal)
+        , graph_ (journal)
+        , totals_ (journal)
+        , threads_ (std::max (0, app.config ().PATH_SEARCH_THREADS))
+        , scheduler_ (std::chrono::milliseconds (
+            app.config ().PATH_SEARCH_DEADLINE))
         , mLastIdentifier (0)
     {
         mFast = collector->make_event ("pathfind_fast");
@@ -79,6 +90,40 @@ public:
         std::shared_ptr<ReadView const> const& inLedger,
         Json::Value const& request);
 
+    /** What the trust lines of each account add up to, as of the
+        ledger paths were last found in.
+    */
+    std::shared_ptr<TrustLineTotals::Snapshot const> getLineTotals () const
+    {
+        return totals_.current ();
+    }
+
+    /** The most threads path finding uses at once, or 0 to choose
+        from the hardware.
+    */
+    std::size_t threads () const
+    {
+        return threads_;
+    }
+
+    /** Call f(i) for each i in [0, n) on the worker pool.
+
+        @see WorkerPool::forEach
+    */
+    void forEach (std::size_t n, std::function<void (std::size_t)> const& f);
+
+    /** Change the time allowed for one update, zero for no limit. */
+    void setDeadline (PathFindScheduler::clock_type::duration deadline)
+    {
+        scheduler_.setDeadline (deadline);
+    }
+
+    // Queue depth and latency of path request updates
+    Json::Value getJson () const
+    {
+        return scheduler_.getJson ();
+    }
+
     void reportFast (std::chrono::milliseconds ms)
     {
         mFast.notify (ms);
@@ -104,6 +149,18 @@ private:
     // Use a CasinocoinLineCache
     std::shared_ptr<CasinocoinLineCache>         mLineCache;
 
+    // The trust lines of each account, kept with the validated ledger
+    TrustLineGraph                   graph_;
+
+    // The totals of the trust lines of each account, kept alongside
+    TrustLineTotals                  totals_;
+
+    // Shared by the path searches of all requests
+    std::size_t const                threads_;
+
+    // Orders and times the updates of the requests
+    PathFindScheduler                scheduler_;
+
     std::atomic<int>                 mLastIdentifier;
 
     using ScopedLockType = std::lock_guard <std::recursive_mutex>;
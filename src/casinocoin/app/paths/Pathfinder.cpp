@@ -29,6 +29,8 @@
 #include <casinocoin/app/paths/Pathfinder.h>
 #include <casinocoin/app/paths/CasinocoinCalc.h>
 #include <casinocoin/app/paths/CasinocoinLineCache.h>
+#include <casinocoin/app/paths/PathLiquidityCache.h>
+#include <casinocoin/app/paths/PathRequests.h>
 #include <casinocoin/ledger/PaymentSandbox.h>
 #include <casinocoin/app/ledger/OrderBookDB.h>
 #include <casinocoin/basics/Log.h>
@@ -334,6 +336,36 @@ TER Pathfinder::getPathLiquidity (
                                    //      deliver to be worth keeping.
     STAmount& amountOut,           // OUT: The actual liquidity along the path.
     uint64_t& qualityOut) const    // OUT: The returned initial quality
+{
+    if (! mLiquidityCache)
+        return getPathLiquidity (*mLedger, path, minDstAmount,
+            amountOut, qualityOut);
+
+    auto const key = PathLiquidityCache::makeKey (path, mSrcAccount,
+        mDstAccount, mSrcAmount, mDstAmount, minDstAmount);
+    auto const result = mLiquidityCache->get (key, *mLedger,
+        [&](ReadView const& view)
+        {
+            PathLiquidityCache::Result r {tesSUCCESS, {}, 0};
+            r.ter = getPathLiquidity (view, path, minDstAmount,
+                r.amountOut, r.quality);
+            return r;
+        });
+
+    if (result.ter == tesSUCCESS)
+    {
+        amountOut = result.amountOut;
+        qualityOut = result.quality;
+    }
+    return result.ter;
+}
+
+TER Pathfinder::getPathLiquidity (
+    ReadView const& view,
+    STPath const& path,
+    STAmount const& minDstAmount,
+    STAmount& amountOut,
+    uint64_t& qualityOut) const
 {
     STPathSet pathSet;
     pathSet.push_back (path);
@@ -341,7 +373,7 @@ TER Pathfinder::getPathLiquidity (
     path::CasinocoinCalc::Input rcInput;
     rcInput.defaultPathsAllowed = false;
 
-    PaymentSandbox sandbox (&*mLedger, tapNONE);
+    PaymentSandbox sandbox (&view, tapNONE);
 
     try
     {
@@ -505,15 +537,31 @@ void Pathfinder::rankPaths (
         saMinDstAmount = smallestUsefulAmount(mDstAmount, maxPaths);
     }
 
+    // Each path is checked in a sandbox of its own, so the checks can
+    // run at the same time. They are gathered in order afterwards.
+    struct Probe
+    {
+        TER resultCode = tesSUCCESS;
+        STAmount liquidity;
+        uint64_t uQuality = 0;
+    };
+    std::vector<Probe> probes (paths.size ());
+    app_.getPathRequests ().forEach (paths.size (),
+        [&](std::size_t i)
+        {
+            if (! paths[i].empty())
+                probes[i].resultCode = getPathLiquidity (paths[i],
+                    saMinDstAmount, probes[i].liquidity, probes[i].uQuality);
+        });
+
     for (int i = 0; i < paths.size (); ++i)
     {
         auto const& currentPath = paths[i];
         if (! currentPath.empty())
         {
-            STAmount liquidity;
-            uint64_t uQuality;
-            auto const resultCode = getPathLiquidity (
-                currentPath, saMinDstAmount, liquidity, uQuality);
+            auto const& liquidity = probes[i].liquidity;
+            auto const uQuality = probes[i].uQuality;
+            auto const resultCode = probes[i].resultCode;
             if (resultCode != tesSUCCESS)
             {
                 JLOG (j_.debug()) <<
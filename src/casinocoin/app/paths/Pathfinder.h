@@ -28,6 +28,7 @@
 
 #include <casinocoin/app/ledger/Ledger.h>
 #include <casinocoin/app/paths/CasinocoinLineCache.h>
+#include <casinocoin/app/paths/PathLiquidityCache.h>
 #include <casinocoin/core/LoadEvent.h>
 #include <casinocoin/protocol/STAmount.h>
 #include <casinocoin/protocol/STPathSet.h>
@@ -61,6 +62,14 @@ public:
 
     bool findPaths (int searchLevel);
 
+    /** Reuse the liquidity of paths checked against earlier ledgers.
+        The cache must outlive the Pathfinder.
+    */
+    void setLiquidityCache (PathLiquidityCache* cache)
+    {
+        mLiquidityCache = cache;
+    }
+
     /** Compute the rankings of the paths. */
     void computePathRanks (int maxPaths);
 
@@ -161,6 +170,14 @@ private:
         STAmount& amountOut,           // OUT: The actual liquidity on the path.
         uint64_t& qualityOut) const;   // OUT: The returned initial quality
 
+    // Compute the liquidity for a path against a view.
+    TER getPathLiquidity (
+        ReadView const& view,
+        STPath const& path,
+        STAmount const& minDstAmount,
+        STAmount& amountOut,
+        uint64_t& qualityOut) const;
+
     // Does this path end on an account-to-account link whose last account has
     // set the "no casinocoin" flag on the link?
     bool isNoCasinocoinOut (STPath const& currentPath);
@@ -191,6 +208,7 @@ private:
     std::shared_ptr <ReadView const> mLedger;
     std::unique_ptr<LoadEvent> m_loadEvent;
     std::shared_ptr<CasinocoinLineCache> mRLCache;
+    PathLiquidityCache* mLiquidityCache = nullptr;
 
     STPathElement mSource;
     STPathSet mCompletePaths;
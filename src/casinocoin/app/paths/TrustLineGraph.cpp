@@ -0,0 +1,269 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/paths/TrustLineGraph.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
+#include <casinocoin/basics/Log.h>
+#include <casinocoin/ledger/View.h>
+#include <casinocoin/protocol/STArray.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace casinocoin {
+
+TrustLineGraph::Lines
+TrustLineGraph::Snapshot::lines (AccountID const& account) const
+{
+    auto const changed = changed_.find (account);
+    if (changed != changed_.end ())
+    {
+        auto const& keys = changed->second;
+        return Lines (keys.data (), keys.data () + keys.size ());
+    }
+
+    if (rows_)
+    {
+        auto const& accounts = rows_->accounts_;
+        auto const iter = std::lower_bound (
+            accounts.begin (), accounts.end (), account);
+        if (iter != accounts.end () && *iter == account)
+        {
+            auto const i = iter - accounts.begin ();
+            auto const keys = rows_->keys_.data ();
+            return Lines (keys + rows_->offsets_[i],
+                keys + rows_->offsets_[i + 1]);
+        }
+    }
+    return Lines (nullptr, nullptr);
+}
+
+std::size_t
+TrustLineGraph::Snapshot::accounts () const
+{
+    std::size_t n = rows_ ? rows_->accounts_.size () : 0;
+    for (auto const& changed : changed_)
+    {
+        bool const inRows = rows_ && std::binary_search (
+            rows_->accounts_.begin (), rows_->accounts_.end (),
+                changed.first);
+        if (inRows && changed.second.empty ())
+            --n;
+        else if (! inRows && ! changed.second.empty ())
+            ++n;
+    }
+    return n;
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr<TrustLineGraph::Snapshot::Rows const>
+TrustLineGraph::makeRows (std::vector<std::pair<AccountID, uint256>>& edges)
+{
+    std::sort (edges.begin (), edges.end ());
+    edges.erase (std::unique (edges.begin (), edges.end ()), edges.end ());
+
+    auto rows = std::make_shared<Snapshot::Rows> ();
+    rows->keys_.reserve (edges.size ());
+    for (auto const& edge : edges)
+    {
+        if (rows->accounts_.empty () || rows->accounts_.back () != edge.first)
+        {
+            rows->accounts_.push_back (edge.first);
+            rows->offsets_.push_back (rows->keys_.size ());
+        }
+        rows->keys_.push_back (edge.second);
+    }
+    rows->offsets_.push_back (rows->keys_.size ());
+    return rows;
+}
+
+TrustLineGraph::TrustLineGraph (beast::Journal j, std::size_t maxChanged)
+    : j_ (j)
+    , maxChanged_ (maxChanged)
+{
+}
+
+std::shared_ptr<TrustLineGraph::Snapshot const>
+TrustLineGraph::current () const
+{
+    return std::atomic_load (&current_);
+}
+
+std::shared_ptr<TrustLineGraph::Snapshot const>
+TrustLineGraph::update (std::shared_ptr<ReadView const> const& ledger,
+    GetLedger const& getLedger)
+{
+    if (! ledger || ledger->open ())
+        return current ();
+
+    std::lock_guard<std::mutex> lock (updateMutex_);
+
+    auto const prev = current ();
+    if (prev && prev->hash () == ledger->info ().hash)
+        return prev;
+
+    auto next = prev;
+    if (next)
+    {
+        auto const chain = ledgerChainSince (prev->hash (), prev->seq (),
+            ledger, getLedger, maxGap);
+        if (chain.empty ())
+            next = nullptr;
+        for (auto iter = chain.begin (); next && iter != chain.end (); ++iter)
+            next = apply (*next, **iter);
+    }
+
+    if (! next)
+        next = build (*ledger);
+
+    std::atomic_store (&current_, next);
+    return next;
+}
+
+std::shared_ptr<TrustLineGraph::Snapshot const>
+TrustLineGraph::build (ReadView const& ledger) const
+{
+    auto const start = std::chrono::steady_clock::now ();
+
+    std::vector<std::pair<AccountID, uint256>> edges;
+    forEachStateLeaf (ledger, uint256 (),
+        [&edges](StateLeaf const& leaf)
+        {
+            if (leaf.type () == ltCASINOCOIN_STATE)
+            {
+                auto const& sle = leaf.sle ();
+                edges.emplace_back (
+                    sle->getFieldAmount (sfLowLimit).getIssuer (), leaf.key ());
+                edges.emplace_back (
+                    sle->getFieldAmount (sfHighLimit).getIssuer (), leaf.key ());
+            }
+            return true;
+        });
+
+    auto snapshot = std::make_shared<Snapshot> ();
+    snapshot->seq_ = ledger.seq ();
+    snapshot->hash_ = ledger.info ().hash;
+    snapshot->rows_ = makeRows (edges);
+
+    JLOG (j_.info ()) << "Built trust line graph of ledger " <<
+        ledger.seq () << ": " << edges.size () / 2 << " lines, " <<
+        snapshot->rows_->accounts_.size () << " accounts in " <<
+        std::chrono::duration_cast<std::chrono::milliseconds> (
+            std::chrono::steady_clock::now () - start).count () << "ms";
+    return snapshot;
+}
+
+std::shared_ptr<TrustLineGraph::Snapshot const>
+TrustLineGraph::apply (Snapshot const& prev, ReadView const& ledger) const
+{
+    // Metadata in the order the transactions were applied
+    std::map<std::uint32_t, std::shared_ptr<STObject const>> metas;
+    for (auto const& item : ledger.txs)
+    {
+        if (! item.second)
+            return nullptr;
+        metas.emplace ((*item.second)[sfTransactionIndex], item.second);
+    }
+
+    auto next = std::make_shared<Snapshot> ();
+    next->seq_ = ledger.seq ();
+    next->hash_ = ledger.info ().hash;
+    next->rows_ = prev.rows_;
+    next->changed_ = prev.changed_;
+
+    // The lines of an account, taken out of the rows when it first changes
+    auto const edit = [&](AccountID const& account) -> std::vector<uint256>&
+    {
+        auto iter = next->changed_.find (account);
+        if (iter == next->changed_.end ())
+        {
+            auto const lines = prev.lines (account);
+            iter = next->changed_.emplace (account,
+                std::vector<uint256> (lines.begin (), lines.end ())).first;
+        }
+        return iter->second;
+    };
+
+    for (auto const& meta : metas)
+    {
+        for (auto const& node : meta.second->getFieldArray (sfAffectedNodes))
+        {
+            if (node.getFieldU16 (sfLedgerEntryType) != ltCASINOCOIN_STATE)
+                continue;
+
+            bool const created = node.getFName () == sfCreatedNode;
+            if (! created && node.getFName () != sfDeletedNode)
+                continue;
+
+            auto const& fields = created ? sfNewFields : sfFinalFields;
+            if (! node.isFieldPresent (fields))
+                return nullptr;
+            auto const& obj = node.getFieldObject (fields);
+            if (! obj.isFieldPresent (sfLowLimit) ||
+                    ! obj.isFieldPresent (sfHighLimit))
+                return nullptr;
+
+            auto const key = node.getFieldH256 (sfLedgerIndex);
+            for (auto const& limit : {&sfLowLimit, &sfHighLimit})
+            {
+                auto& keys = edit (obj.getFieldAmount (*limit).getIssuer ());
+                auto const pos = std::lower_bound (
+                    keys.begin (), keys.end (), key);
+                bool const found = pos != keys.end () && *pos == key;
+                if (created && ! found)
+                    keys.insert (pos, key);
+                else if (! created && found)
+                    keys.erase (pos);
+            }
+        }
+    }
+
+    // Fold the changes into new rows once there are enough of them
+    if (next->changed_.size () > maxChanged_)
+    {
+        std::vector<std::pair<AccountID, uint256>> edges;
+        if (next->rows_)
+        {
+            auto const& rows = *next->rows_;
+            edges.reserve (rows.keys_.size ());
+            for (std::size_t i = 0; i < rows.accounts_.size (); ++i)
+            {
+                if (next->changed_.count (rows.accounts_[i]))
+                    continue;
+                for (auto j = rows.offsets_[i]; j < rows.offsets_[i + 1]; ++j)
+                    edges.emplace_back (rows.accounts_[i], rows.keys_[j]);
+            }
+        }
+        for (auto const& changed : next->changed_)
+            for (auto const& key : changed.second)
+                edges.emplace_back (changed.first, key);
+
+        next->rows_ = makeRows (edges);
+        next->changed_.clear ();
+
+        JLOG (j_.debug ()) << "Compacted trust line graph at ledger " <<
+            ledger.seq ();
+    }
+
+    return next;
+}
+
+} // casinocoin
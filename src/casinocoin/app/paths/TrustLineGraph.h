@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_PATHS_TRUSTLINEGRAPH_H_INCLUDED
+#define CASINOCOIN_APP_PATHS_TRUSTLINEGRAPH_H_INCLUDED
+
+#include <casinocoin/ledger/ReadView.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/beast/utility/Journal.h>
+#include <casinocoin/protocol/UintTypes.h>
+#include <boost/range/iterator_range.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace casinocoin {
+
+/** Which trust lines each account has, kept across ledgers.
+
+    Pathfinding asks for the trust lines of the same accounts ledger
+    after ledger. Finding them means walking the owner directory of
+    the account, which also holds its offers and other entries. The
+    graph keeps the keys of the trust lines of every account, and is
+    brought up to date with each new closed ledger from the trust lines
+    its metadata shows were created or deleted. Changes to the balance
+    or limits of a line don't change the graph.
+
+    The graph for a ledger is an immutable Snapshot, so any number of
+    threads can read it without locking while the next one is built.
+    A snapshot holds the lines in a compressed sparse row layout,
+    with the accounts sorted, and the accounts whose lines changed
+    since that layout was built on the side. The changes are folded
+    into a new layout once there are enough of them.
+*/
+class TrustLineGraph
+{
+public:
+    using Lines = boost::iterator_range<uint256 const*>;
+
+    class Snapshot
+    {
+    public:
+        /** The sequence of the ledger this is the graph of. */
+        LedgerIndex
+        seq () const
+        {
+            return seq_;
+        }
+
+        /** The hash of the ledger this is the graph of. */
+        uint256 const&
+        hash () const
+        {
+            return hash_;
+        }
+
+        /** The keys of the trust lines of an account, in key order. */
+        Lines
+        lines (AccountID const& account) const;
+
+        /** The number of accounts with trust lines. */
+        std::size_t
+        accounts () const;
+
+    private:
+        friend class TrustLineGraph;
+
+        // The compressed sparse row layout: the lines of accounts_[i]
+        // are keys_[offsets_[i]] up to keys_[offsets_[i + 1]].
+        struct Rows
+        {
+            std::vector<AccountID> accounts_;
+            std::vector<std::uint32_t> offsets_;
+            std::vector<uint256> keys_;
+        };
+
+        LedgerIndex seq_ = 0;
+        uint256 hash_;
+        std::shared_ptr<Rows const> rows_;
+        // Accounts whose lines differ from rows_
+        hash_map<AccountID, std::vector<uint256>> changed_;
+    };
+
+    /** Returns the ledger with a given hash, if it is available. */
+    using GetLedger = std::function<
+        std::shared_ptr<ReadView const> (uint256 const&)>;
+
+    explicit
+    TrustLineGraph (beast::Journal j, std::size_t maxChanged = 4096);
+
+    /** The graph of the last ledger it was updated to, if any. */
+    std::shared_ptr<Snapshot const>
+    current () const;
+
+    /** Bring the graph up to date with a closed ledger.
+
+        If the graph is of an earlier ledger, the ledgers between the
+        two are fetched with getLedger and their metadata applied in
+        turn. Otherwise the graph is built again from the state of the
+        ledger. Open ledgers are ignored.
+
+        @return The graph of the ledger, or nullptr if there is none.
+    */
+    std::shared_ptr<Snapshot const>
+    update (std::shared_ptr<ReadView const> const& ledger,
+        GetLedger const& getLedger);
+
+private:
+    // Lay out (account, line) pairs as rows, sorting them first
+    static std::shared_ptr<Snapshot::Rows const>
+    makeRows (std::vector<std::pair<AccountID, uint256>>& edges);
+
+    std::shared_ptr<Snapshot const>
+    build (ReadView const& ledger) const;
+
+    std::shared_ptr<Snapshot const>
+    apply (Snapshot const& prev, ReadView const& ledger) const;
+
+    // How far back to look for the ledger the graph is of
+    static std::size_t const maxGap = 32;
+
+    beast::Journal j_;
+    std::size_t const maxChanged_;
+
+    // Serializes updates
+    std::mutex updateMutex_;
+    // Only accessed with the atomic shared_ptr functions
+    std::shared_ptr<Snapshot const> current_;
+};
+
+} // casinocoin
+
+#endif
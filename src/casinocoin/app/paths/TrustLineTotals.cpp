@@ -0,0 +1,442 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/paths/TrustLineTotals.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
+#include <casinocoin/basics/Log.h>
+#include <casinocoin/ledger/View.h>
+#include <casinocoin/protocol/Indexes.h>
+#include <casinocoin/protocol/STArray.h>
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+
+namespace casinocoin {
+
+namespace {
+
+// A trust line as one of the two accounts on it sees it
+struct LineSide
+{
+    AccountID account;
+    STAmount balance;
+    STAmount limit;
+    STAmount limitPeer;
+    bool frozen;
+};
+
+} // namespace
+
+// The low and the high side of a trust line. Fields are taken from
+// `previous` where it has them, to see the line as it was before the
+// change the metadata describes.
+static
+boost::optional<std::array<LineSide, 2>>
+sidesOf (STObject const& fields, STObject const* previous = nullptr)
+{
+    auto const from = [&](SField const& field) -> STObject const*
+    {
+        if (previous && previous->isFieldPresent (field))
+            return previous;
+        if (fields.isFieldPresent (field))
+            return &fields;
+        return nullptr;
+    };
+
+    auto const balance = from (sfBalance);
+    auto const low = from (sfLowLimit);
+    auto const high = from (sfHighLimit);
+    if (! balance || ! low || ! high)
+        return boost::none;
+
+    auto const flags = from (sfFlags);
+    std::uint32_t const f = flags ? flags->getFieldU32 (sfFlags) : 0;
+
+    auto const& lowLimit = low->getFieldAmount (sfLowLimit);
+    auto const& highLimit = high->getFieldAmount (sfHighLimit);
+    auto const& amount = balance->getFieldAmount (sfBalance);
+
+    std::array<LineSide, 2> sides;
+    sides[0] = {lowLimit.getIssuer (), amount, lowLimit, highLimit,
+        (f & lsfLowFreeze) != 0};
+    sides[1] = {highLimit.getIssuer (), -amount, highLimit, lowLimit,
+        (f & lsfHighFreeze) != 0};
+    return sides;
+}
+
+// Add a side of a line to the totals of its account, or take it out
+// again if `sign` is negative
+static
+void
+addSide (TrustLineTotals::Account& account, LineSide const& side,
+    uint256 const& key, int sign)
+{
+    auto const& currency = side.balance.getCurrency ();
+    auto& totals = account.currencies[currency];
+
+    totals.lines += sign;
+
+    // As accountSourceCurrencies and accountDestCurrencies see it
+    if (side.balance > zero || (side.limitPeer != zero &&
+            -side.balance < side.limitPeer))
+        totals.sendable += sign;
+    if (side.balance < side.limit)
+        totals.receivable += sign;
+
+    // As gateway_balances sees it
+    auto const signum = side.balance.signum ();
+    if (signum > 0 || (signum < 0 && side.frozen))
+    {
+        auto& unusual = account.unusual;
+        auto const pos = std::lower_bound (
+            unusual.begin (), unusual.end (), key);
+        bool const found = pos != unusual.end () && *pos == key;
+        if (sign > 0 && ! found)
+            unusual.insert (pos, key);
+        else if (sign < 0 && found)
+            unusual.erase (pos);
+    }
+    else if (signum < 0)
+    {
+        totals.obligations += sign;
+        if (sign > 0)
+            totals.owed -= side.balance;
+        else
+            totals.owed += side.balance;
+    }
+
+    if (totals.lines == 0)
+        account.currencies.erase (currency);
+}
+
+//------------------------------------------------------------------------------
+
+// 10^k for each k up to the digits of the largest amount, counted in
+// the smallest unit, with room left for the sum of many of them
+static
+std::vector<boost::multiprecision::cpp_int> const&
+powersOfTen ()
+{
+    static auto const powers = []
+    {
+        std::vector<boost::multiprecision::cpp_int> v;
+        boost::multiprecision::cpp_int power (1);
+        for (int k = STAmount::cMinOffset; k <= STAmount::cMaxOffset + 40; ++k)
+        {
+            v.push_back (power);
+            power *= 10;
+        }
+        return v;
+    }();
+    return powers;
+}
+
+TrustLineTotals::Sum&
+TrustLineTotals::Sum::operator+= (STAmount const& amount)
+{
+    assert (! amount.native ());
+    if (amount.mantissa () == 0)
+        return *this;
+
+    auto const units = amount.mantissa () *
+        powersOfTen ()[amount.exponent () - STAmount::cMinOffset];
+    if (amount.negative ())
+        units_ -= units;
+    else
+        units_ += units;
+    return *this;
+}
+
+TrustLineTotals::Sum&
+TrustLineTotals::Sum::operator-= (STAmount const& amount)
+{
+    return *this += -amount;
+}
+
+STAmount
+TrustLineTotals::Sum::value (Issue const& issue) const
+{
+    if (units_.is_zero ())
+        return STAmount (issue);
+
+    // Keep the leading digits an amount has room for
+    auto const magnitude = boost::multiprecision::abs (units_);
+    auto const& powers = powersOfTen ();
+    int const digits = std::upper_bound (
+        powers.begin (), powers.end (), magnitude) - powers.begin ();
+    int const dropped = std::max (0, digits - 16);
+    auto const mantissa =
+        boost::multiprecision::cpp_int (magnitude / powers[dropped]);
+
+    return STAmount (issue, mantissa.convert_to<std::uint64_t> (),
+        dropped + STAmount::cMinOffset, units_.sign () < 0);
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr<TrustLineTotals::Account const>
+TrustLineTotals::Snapshot::account (AccountID const& account) const
+{
+    auto const changed = changed_.find (account);
+    if (changed != changed_.end ())
+        return changed->second;
+
+    if (accounts_)
+    {
+        auto const iter = accounts_->find (account);
+        if (iter != accounts_->end ())
+            return iter->second;
+    }
+    return nullptr;
+}
+
+std::size_t
+TrustLineTotals::Snapshot::accounts () const
+{
+    std::size_t n = accounts_ ? accounts_->size () : 0;
+    for (auto const& changed : changed_)
+    {
+        bool const inAccounts = accounts_ && accounts_->count (changed.first);
+        if (inAccounts && ! changed.second)
+            --n;
+        else if (! inAccounts && changed.second)
+            ++n;
+    }
+    return n;
+}
+
+//------------------------------------------------------------------------------
+
+TrustLineTotals::TrustLineTotals (beast::Journal j, std::size_t maxChanged)
+    : j_ (j)
+    , maxChanged_ (maxChanged)
+{
+}
+
+std::shared_ptr<TrustLineTotals::Snapshot const>
+TrustLineTotals::current () const
+{
+    return std::atomic_load (&current_);
+}
+
+std::shared_ptr<TrustLineTotals::Snapshot const>
+TrustLineTotals::update (std::shared_ptr<ReadView const> const& ledger,
+    GetLedger const& getLedger)
+{
+    if (! ledger || ledger->open ())
+        return current ();
+
+    std::lock_guard<std::mutex> lock (updateMutex_);
+
+    auto const prev = current ();
+    if (prev && prev->hash () == ledger->info ().hash)
+        return prev;
+
+    auto next = prev;
+    if (next)
+    {
+        auto const chain = ledgerChainSince (prev->hash (), prev->seq (),
+            ledger, getLedger, maxGap);
+        if (chain.empty ())
+            next = nullptr;
+        for (auto iter = chain.begin (); next && iter != chain.end (); ++iter)
+            next = apply (*next, **iter);
+    }
+
+    if (! next)
+        next = build (*ledger);
+
+    std::atomic_store (&current_, next);
+    return next;
+}
+
+std::shared_ptr<TrustLineTotals::Snapshot const>
+TrustLineTotals::build (ReadView const& ledger) const
+{
+    auto const start = std::chrono::steady_clock::now ();
+
+    std::size_t lines = 0;
+    hash_map<AccountID, std::shared_ptr<Account>> accounts;
+    forEachStateLeaf (ledger, uint256 (),
+        [&](StateLeaf const& leaf)
+        {
+            if (leaf.type () != ltCASINOCOIN_STATE)
+                return true;
+
+            if (auto const sides = sidesOf (*leaf.sle ()))
+            {
+                ++lines;
+                for (auto const& side : *sides)
+                {
+                    auto& account = accounts[side.account];
+                    if (! account)
+                        account = std::make_shared<Account> ();
+                    addSide (*account, side, leaf.key (), 1);
+                }
+            }
+            return true;
+        });
+
+    auto all = std::make_shared<Snapshot::Accounts> ();
+    all->reserve (accounts.size ());
+    for (auto& account : accounts)
+        all->emplace (account.first, std::move (account.second));
+
+    auto snapshot = std::make_shared<Snapshot> ();
+    snapshot->seq_ = ledger.seq ();
+    snapshot->hash_ = ledger.info ().hash;
+    snapshot->accounts_ = std::move (all);
+
+    JLOG (j_.info ()) << "Built trust line totals of ledger " <<
+        ledger.seq () << ": " << lines << " lines, " <<
+        snapshot->accounts_->size () << " accounts in " <<
+        std::chrono::duration_cast<std::chrono::milliseconds> (
+            std::chrono::steady_clock::now () - start).count () << "ms";
+    return snapshot;
+}
+
+std::shared_ptr<TrustLineTotals::Snapshot const>
+TrustLineTotals::apply (Snapshot const& prev, ReadView const& ledger) const
+{
+    // Metadata in the order the transactions were applied
+    std::map<std::uint32_t, std::shared_ptr<STObject const>> metas;
+    for (auto const& item : ledger.txs)
+    {
+        if (! item.second)
+            return nullptr;
+        metas.emplace ((*item.second)[sfTransactionIndex], item.second);
+    }
+
+    // The lines the ledger changed, as they were before the first
+    // transaction which changed them; none if that transaction
+    // created them
+    std::map<uint256, boost::optional<std::array<LineSide, 2>>> before;
+
+    for (auto const& meta : metas)
+    {
+        for (auto const& node : meta.second->getFieldArray (sfAffectedNodes))
+        {
+            if (node.getFieldU16 (sfLedgerEntryType) != ltCASINOCOIN_STATE)
+                continue;
+
+            auto const key = node.getFieldH256 (sfLedgerIndex);
+            if (before.count (key))
+                continue;
+
+            if (node.getFName () == sfCreatedNode)
+            {
+                before.emplace (key, boost::none);
+                continue;
+            }
+
+            if (! node.isFieldPresent (sfFinalFields))
+                return nullptr;
+            auto const previous = node.isFieldPresent (sfPreviousFields) ?
+                &node.getFieldObject (sfPreviousFields) : nullptr;
+            auto sides = sidesOf (node.getFieldObject (sfFinalFields),
+                previous);
+            if (! sides)
+                return nullptr;
+            before.emplace (key, std::move (sides));
+        }
+    }
+
+    auto next = std::make_shared<Snapshot> ();
+    next->seq_ = ledger.seq ();
+    next->hash_ = ledger.info ().hash;
+    next->accounts_ = prev.accounts_;
+    next->changed_ = prev.changed_;
+
+    // The totals of an account, copied from the previous snapshot when
+    // first changed
+    hash_map<AccountID, std::shared_ptr<Account>> edited;
+    auto const edit = [&](AccountID const& id) -> Account&
+    {
+        auto& account = edited[id];
+        if (! account)
+        {
+            auto const old = prev.account (id);
+            account = old ? std::make_shared<Account> (*old) :
+                std::make_shared<Account> ();
+        }
+        return *account;
+    };
+
+    for (auto const& line : before)
+    {
+        boost::optional<std::array<LineSide, 2>> after;
+        if (auto const sle = ledger.read (keylet::line (line.first)))
+        {
+            after = sidesOf (*sle);
+            if (! after)
+                return nullptr;
+        }
+
+        for (int i = 0; i < 2; ++i)
+        {
+            auto const was = line.second ? &(*line.second)[i] : nullptr;
+            auto const is = after ? &(*after)[i] : nullptr;
+
+            if (was)
+                addSide (edit (was->account), *was, line.first, -1);
+            if (is)
+                addSide (edit (is->account), *is, line.first, 1);
+        }
+    }
+
+    for (auto& account : edited)
+    {
+        if (account.second->currencies.empty () &&
+                account.second->unusual.empty ())
+            next->changed_[account.first] = nullptr;
+        else
+            next->changed_[account.first] = std::move (account.second);
+    }
+
+    // Fold the changes in once there are enough of them
+    if (next->changed_.size () > maxChanged_)
+    {
+        auto all = next->accounts_ ?
+            std::make_shared<Snapshot::Accounts> (*next->accounts_) :
+            std::make_shared<Snapshot::Accounts> ();
+        for (auto& changed : next->changed_)
+        {
+            if (changed.second)
+                (*all)[changed.first] = std::move (changed.second);
+            else
+                all->erase (changed.first);
+        }
+
+        next->accounts_ = std::move (all);
+        next->changed_.clear ();
+
+        JLOG (j_.debug ()) << "Compacted trust line totals at ledger " <<
+            ledger.seq ();
+    }
+
+    JLOG (j_.debug ()) << "Applied ledger " << ledger.seq () <<
+        " to trust line totals: " << before.size () << " lines, " <<
+        edited.size () << " accounts changed";
+    return next;
+}
+
+} // casinocoin
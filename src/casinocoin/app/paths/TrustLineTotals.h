@@ -0,0 +1,204 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_PATHS_TRUSTLINETOTALS_H_INCLUDED
+#define CASINOCOIN_APP_PATHS_TRUSTLINETOTALS_H_INCLUDED
+
+#include <casinocoin/ledger/ReadView.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/beast/utility/Journal.h>
+#include <casinocoin/protocol/STAmount.h>
+#include <casinocoin/protocol/UintTypes.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace casinocoin {
+
+/** What the trust lines of each account add up to, kept across ledgers.
+
+    The currencies an account can send and receive, and what a gateway
+    owes in each currency, are found by walking every trust line of the
+    account. For an issuer with many lines that is slow. The totals
+    keep, for each account and currency, how many lines it has and
+    how many of them it can send or receive over, together with the
+    sum of its obligations, and are brought up to date with each new
+    closed ledger from the trust lines its metadata shows were changed.
+
+    The totals for a ledger are an immutable Snapshot, so any number of
+    threads can read them without locking while the next one is built.
+    Like the trust line graph, a snapshot holds the accounts as of some
+    earlier ledger, with the accounts whose lines changed since then on
+    the side, and folds the changes in once there are enough of them.
+
+    Obligations are summed exactly, so a total doesn't depend on the
+    order in which the lines were added and taken out again.
+*/
+class TrustLineTotals
+{
+public:
+    /** An exact sum of amounts of one currency.
+
+        The sum is kept as a whole number of the smallest unit an
+        amount can have, so adding and taking out amounts never loses
+        digits. It is rounded toward zero, as STAmount arithmetic does,
+        only when it is read.
+    */
+    class Sum
+    {
+    public:
+        Sum&
+        operator+= (STAmount const& amount);
+
+        Sum&
+        operator-= (STAmount const& amount);
+
+        /** The sum as an amount of the given issue. */
+        STAmount
+        value (Issue const& issue) const;
+
+        bool
+        operator== (Sum const& other) const
+        {
+            return units_ == other.units_;
+        }
+
+        bool
+        operator!= (Sum const& other) const
+        {
+            return units_ != other.units_;
+        }
+
+    private:
+        boost::multiprecision::cpp_int units_;
+    };
+
+    /** The trust lines of an account in one currency. */
+    struct Totals
+    {
+        // Lines in the currency
+        std::uint32_t lines = 0;
+        // Lines the account can send over: it holds some of the
+        // peer's IOUs, or the peer extends it credit
+        std::uint32_t sendable = 0;
+        // Lines the account can be paid more over
+        std::uint32_t receivable = 0;
+        // Lines on which the account owes its peer and has not frozen
+        std::uint32_t obligations = 0;
+        // What the account owes over those lines
+        Sum owed;
+    };
+
+    struct Account
+    {
+        std::map<Currency, Totals> currencies;
+        // The lines on which the account holds its peer's IOUs or which
+        // it froze while owing on them, in key order. gateway_balances
+        // lists these one by one.
+        std::vector<uint256> unusual;
+    };
+
+    class Snapshot
+    {
+    public:
+        /** The sequence of the ledger these are the totals of. */
+        LedgerIndex
+        seq () const
+        {
+            return seq_;
+        }
+
+        /** The hash of the ledger these are the totals of. */
+        uint256 const&
+        hash () const
+        {
+            return hash_;
+        }
+
+        /** The totals of an account, or nullptr if it has no lines. */
+        std::shared_ptr<Account const>
+        account (AccountID const& account) const;
+
+        /** The number of accounts with trust lines. */
+        std::size_t
+        accounts () const;
+
+    private:
+        friend class TrustLineTotals;
+
+        using Accounts = hash_map<AccountID, std::shared_ptr<Account const>>;
+
+        LedgerIndex seq_ = 0;
+        uint256 hash_;
+        std::shared_ptr<Accounts const> accounts_;
+        // Accounts whose totals differ from accounts_, nullptr if they
+        // no longer have lines
+        Accounts changed_;
+    };
+
+    /** Returns the ledger with a given hash, if it is available. */
+    using GetLedger = std::function<
+        std::shared_ptr<ReadView const> (uint256 const&)>;
+
+    explicit
+    TrustLineTotals (beast::Journal j, std::size_t maxChanged = 4096);
+
+    /** The totals of the last ledger they were updated to, if any. */
+    std::shared_ptr<Snapshot const>
+    current () const;
+
+    /** Bring the totals up to date with a closed ledger.
+
+        If the totals are of an earlier ledger, the ledgers between the
+        two are fetched with getLedger and their metadata applied in
+        turn. Otherwise the totals are built again from the state of
+        the ledger. Open ledgers are ignored.
+
+        @return The totals of the ledger, or nullptr if there are none.
+    */
+    std::shared_ptr<Snapshot const>
+    update (std::shared_ptr<ReadView const> const& ledger,
+        GetLedger const& getLedger);
+
+private:
+    std::shared_ptr<Snapshot const>
+    build (ReadView const& ledger) const;
+
+    std::shared_ptr<Snapshot const>
+    apply (Snapshot const& prev, ReadView const& ledger) const;
+
+    // How far back to look for the ledger the totals are of
+    static std::size_t const maxGap = 32;
+
+    beast::Journal j_;
+    std::size_t const maxChanged_;
+
+    // Serializes updates
+    std::mutex updateMutex_;
+    // Only accessed with the atomic shared_ptr functions
+    std::shared_ptr<Snapshot const> current_;
+};
+
+} // casinocoin
+
+#endif
@@ -462,6 +462,10 @@ flow (PaymentSandbox const& baseView,
     // successful
     boost::container::flat_set<uint256> ofrsToRmOnFail;
 
+    // Offers found unfunded in one pass. Cleared, not rebuilt, between
+    // passes so its storage is reused.
+    boost::container::flat_set<uint256> ofrsToRm;
+
     while (remainingOut > beast::zero &&
         (!remainingIn || *remainingIn > beast::zero))
     {
@@ -473,7 +477,7 @@ flow (PaymentSandbox const& baseView,
 
         activeStrands.activateNext();
 
-        boost::container::flat_set<uint256> ofrsToRm;
+        ofrsToRm.clear ();
         boost::optional<BestStrand> best;
         if (flowDebugInfo) flowDebugInfo->newLiquidityPass();
         for (auto strand : activeStrands)
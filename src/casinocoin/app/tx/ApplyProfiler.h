@@ -0,0 +1,202 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_APP_TX_APPLYPROFILER_H_INCLUDED
+#define CASINOCOIN_APP_TX_APPLYPROFILER_H_INCLUDED
+
+#include <casinocoin/basics/Histogram.h>
+#include <casinocoin/json/json_value.h>
+#include <casinocoin/ledger/detail/ApplyStateTable.h>
+#include <casinocoin/protocol/TER.h>
+#include <casinocoin/protocol/TxFormats.h>
+#include <casinocoin/beast/insight/Group.h>
+#include <casinocoin/beast/insight/Counter.h>
+#include <casinocoin/beast/insight/Event.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace casinocoin {
+
+class Application;
+
+/** Records the cost of applying transactions.
+
+    When enabled, each of preflight, preclaim and doApply is timed and
+    recorded by transaction type under the result that stage produced.
+    doApply also records the ledger entries read from the open ledger
+    and written back to it, broken down by entry type, and the node
+    store fetches made by preclaim and doApply on the applying thread.
+    Every attempt to apply is recorded, including retries. A speculative
+    apply is only recorded if its result is used; otherwise the apply
+    that replaces it is.
+
+    Values are kept in power of two histograms, reported by the
+    apply_profile RPC command, and stage times are also sent to the
+    insight collector.
+
+    When disabled, the cost is one relaxed atomic load per stage.
+*/
+class ApplyProfiler
+{
+public:
+    enum Stage
+    {
+        preflight,
+        preclaim,
+        apply,
+        stages
+    };
+
+    using clock_type = std::chrono::steady_clock;
+
+    /** Measures one stage of applying a transaction.
+
+        A sample does nothing unless the profiler was enabled when it
+        was constructed. Nothing is recorded until done() is called.
+    */
+    class Sample
+    {
+    private:
+        ApplyProfiler* profiler_ = nullptr;
+        Application& app_;
+        Stage const stage_;
+        clock_type::time_point start_;
+        std::uint32_t fetches_ = 0;
+
+    public:
+        /** Entries read from and written to the open ledger. */
+        EntryCounts reads;
+        EntryCounts writes;
+
+        Sample (Application& app, Stage stage);
+
+        Sample (Sample const&) = delete;
+        Sample& operator= (Sample const&) = delete;
+
+        explicit
+        operator bool () const
+        {
+            return profiler_ != nullptr;
+        }
+
+        void
+        done (TxType type, TER ter);
+    };
+
+    /** A sample held back by Defer. */
+    struct Record
+    {
+        ApplyProfiler* profiler;
+        TxType type;
+        TER ter;
+        Stage stage;
+        std::chrono::microseconds elapsed;
+        std::uint32_t fetches;
+        EntryCounts reads;
+        EntryCounts writes;
+    };
+
+    using Records = std::vector<Record>;
+
+    /** Holds back the samples taken on this thread while it lives.
+
+        The samples are added to `records` instead of being recorded,
+        so that a speculative apply can be recorded with commit() only
+        if its result is used.
+    */
+    class Defer
+    {
+    private:
+        Records* prev_;
+
+    public:
+        explicit
+        Defer (Records& records);
+
+        ~Defer ();
+
+        Defer (Defer const&) = delete;
+        Defer& operator= (Defer const&) = delete;
+    };
+
+    /** Record samples which were held back. */
+    static
+    void
+    commit (Records const& records);
+
+    explicit
+    ApplyProfiler (beast::insight::Group::ptr const& group);
+
+    bool
+    enabled () const
+    {
+        return enabled_.load (std::memory_order_relaxed);
+    }
+
+    void
+    enable (bool on);
+
+    /** Discard everything recorded so far. */
+    void
+    reset ();
+
+    void
+    record (TxType type, TER ter, Stage stage,
+        std::chrono::microseconds elapsed, std::uint32_t fetches,
+            EntryCounts const& reads, EntryCounts const& writes);
+
+    Json::Value
+    getJson () const;
+
+private:
+    struct Costs
+    {
+        std::array<Histogram, stages> time;
+        std::array<Histogram, stages> fetches;
+        Histogram reads;
+        Histogram writes;
+    };
+
+    struct Entries
+    {
+        std::uint64_t reads = 0;
+        std::uint64_t writes = 0;
+    };
+
+    std::atomic<bool> enabled_ {false};
+
+    beast::insight::Group::ptr group_;
+    beast::insight::Counter reads_;
+    beast::insight::Counter writes_;
+    beast::insight::Counter fetches_;
+
+    std::mutex mutable mutex_;
+    std::map<std::pair<TxType, TER>, Costs> costs_;
+    std::map<TxType, std::map<LedgerEntryType, Entries>> entries_;
+    std::map<std::pair<TxType, Stage>, beast::insight::Event> events_;
+};
+
+} // casinocoin
+
+#endif
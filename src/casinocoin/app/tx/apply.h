@@ -31,13 +31,16 @@
 #include <casinocoin/protocol/STTx.h>
 #include <casinocoin/protocol/TER.h>
 #include <casinocoin/beast/utility/Journal.h>
+#include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace casinocoin {
 
 class Application;
 class HashRouter;
+class WorkerPool;
 
 /** Describes the pre-processing validity of a transaction.
 
@@ -71,6 +74,16 @@ checkValidity(HashRouter& router,
     STTx const& tx, Rules const& rules,
         Config const& config, beast::Journal j);
 
+/** Checks transaction signature and local checks.
+
+    Like the other overload, but signature verdicts are also looked
+    up in and added to the application's SigCache, which keeps them
+    after the HashRouter entry for the transaction has expired.
+*/
+std::pair<Validity, std::string>
+checkValidity(Application& app,
+    STTx const& tx, Rules const& rules, beast::Journal j);
+
 
 /** Sets the validity of a given transaction in the cache.
 
@@ -132,6 +145,52 @@ apply (Application& app, OpenView& view,
         beast::Journal journal);
 
 
+/** Apply a batch of transactions to an open view using several threads.
+
+    Each transaction is first applied by `speculate` on a thread of
+    `workers`, to a view of its own over `view` as it was on entry,
+    recording the keys it reads and the entries it writes. The
+    results are then committed in order on the calling thread: a
+    transaction that touched no key written by an earlier one in the
+    batch, and for which `usable` returns true against the view as
+    it stands, has its recorded changes inserted. Any other
+    transaction is applied by `serial`.
+
+    The view ends up exactly as if `serial` had applied every
+    transaction in order, provided `speculate` is safe to call
+    concurrently and does what `serial` would do whenever `usable`
+    returns true. The functions are given the index of the
+    transaction in `txs`.
+
+    @param threads The number of threads to use, including the
+                   calling one. Zero picks a number from the
+                   hardware, one applies everything serially.
+
+    @return The result of each transaction, in order.
+*/
+std::vector<std::pair<TER, bool>>
+applyParallel (WorkerPool& workers, OpenView& view,
+    std::vector<std::shared_ptr<STTx const>> const& txs,
+        std::size_t threads,
+            std::function<std::pair<TER, bool> (
+                OpenView&, std::size_t)> const& speculate,
+            std::function<bool (
+                OpenView const&, std::size_t)> const& usable,
+            std::function<std::pair<TER, bool> (
+                OpenView&, std::size_t)> const& serial,
+                    beast::Journal j);
+
+/** Apply a batch of transactions with `apply`, using several threads
+    of the application's worker pool.
+
+    @see applyParallel
+*/
+std::vector<std::pair<TER, bool>>
+applyParallel (Application& app, OpenView& view,
+    std::vector<std::shared_ptr<STTx const>> const& txs,
+        ApplyFlags flags, std::size_t threads,
+            beast::Journal j);
+
 /** Enum class for return value from `applyTransaction`
 
     @see applyTransaction
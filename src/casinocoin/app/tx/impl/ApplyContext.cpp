@@ -54,14 +54,25 @@ void
 ApplyContext::discard()
 {
     view_.emplace(&base_, flags_);
+    view_->countReads(reads_);
 }
 
 void
 ApplyContext::apply(TER ter)
 {
+    if (writes_)
+        view_->countWrites(*writes_);
     view_->apply(base_, tx, ter, journal);
 }
 
+void
+ApplyContext::profile(EntryCounts* reads, EntryCounts* writes)
+{
+    reads_ = reads;
+    writes_ = writes;
+    view_->countReads(reads_);
+}
+
 std::size_t
 ApplyContext::size()
 {
@@ -116,6 +116,14 @@ public:
     TER
     checkInvariants(TER);
 
+    /** Count the entries read from and written to the base.
+
+        Reads are counted across discards. Writes are counted
+        when the result is applied.
+    */
+    void
+    profile (EntryCounts* reads, EntryCounts* writes);
+
 private:
     template<std::size_t... Is>
     TER checkInvariantsHelper(TER terResult, std::index_sequence<Is...>);
@@ -123,6 +131,8 @@ private:
     OpenView& base_;
     ApplyFlags flags_;
     boost::optional<ApplyViewImpl> view_;
+    EntryCounts* reads_ = nullptr;
+    EntryCounts* writes_ = nullptr;
 };
 
 } // casinocoin
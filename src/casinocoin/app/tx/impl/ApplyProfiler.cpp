@@ -0,0 +1,236 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/app/main/Application.h>
+#include <casinocoin/nodestore/Database.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <casinocoin/protocol/LedgerFormats.h>
+
+namespace casinocoin {
+
+static
+std::string
+stageName (ApplyProfiler::Stage stage)
+{
+    switch (stage)
+    {
+    case ApplyProfiler::preflight: return jss::preflight.c_str ();
+    case ApplyProfiler::preclaim:  return jss::preclaim.c_str ();
+    default:
+        break;
+    }
+    return jss::apply.c_str ();
+}
+
+static
+std::string
+typeName (TxType type)
+{
+    if (auto const item = TxFormats::getInstance ().findByType (type))
+        return item->getName ();
+    return std::to_string (type);
+}
+
+static
+std::string
+entryName (LedgerEntryType type)
+{
+    if (auto const item = LedgerFormats::getInstance ().findByType (type))
+        return item->getName ();
+    // Reads of missing entries by an unchecked keylet
+    return "unknown";
+}
+
+//------------------------------------------------------------------------------
+
+// Where samples taken on this thread are held back, if anywhere
+static thread_local ApplyProfiler::Records* deferred = nullptr;
+
+ApplyProfiler::Sample::Sample (Application& app, Stage stage)
+    : app_ (app)
+    , stage_ (stage)
+{
+    auto& profiler = app_.getApplyProfiler ();
+    if (! profiler.enabled ())
+        return;
+
+    profiler_ = &profiler;
+    start_ = clock_type::now ();
+    if (stage_ != preflight)
+        fetches_ = app_.getNodeStore ().getFetchThreadCount ();
+}
+
+void
+ApplyProfiler::Sample::done (TxType type, TER ter)
+{
+    if (! profiler_)
+        return;
+
+    using namespace std::chrono;
+    auto const elapsed = duration_cast<microseconds> (
+        clock_type::now () - start_);
+
+    std::uint32_t fetches = 0;
+    if (stage_ != preflight)
+        fetches = app_.getNodeStore ().getFetchThreadCount () - fetches_;
+
+    if (deferred)
+        deferred->push_back ({ profiler_, type, ter, stage_, elapsed,
+            fetches, reads, writes });
+    else
+        profiler_->record (type, ter, stage_, elapsed, fetches,
+            reads, writes);
+    profiler_ = nullptr;
+}
+
+ApplyProfiler::Defer::Defer (Records& records)
+    : prev_ (deferred)
+{
+    deferred = &records;
+}
+
+ApplyProfiler::Defer::~Defer ()
+{
+    deferred = prev_;
+}
+
+void
+ApplyProfiler::commit (Records const& records)
+{
+    for (auto const& r : records)
+        r.profiler->record (r.type, r.ter, r.stage, r.elapsed,
+            r.fetches, r.reads, r.writes);
+}
+
+//------------------------------------------------------------------------------
+
+ApplyProfiler::ApplyProfiler (beast::insight::Group::ptr const& group)
+    : group_ (group)
+    , reads_ (group_->make_counter ("reads"))
+    , writes_ (group_->make_counter ("writes"))
+    , fetches_ (group_->make_counter ("fetches"))
+{
+}
+
+void
+ApplyProfiler::enable (bool on)
+{
+    enabled_.store (on, std::memory_order_relaxed);
+}
+
+void
+ApplyProfiler::reset ()
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    costs_.clear ();
+    entries_.clear ();
+}
+
+void
+ApplyProfiler::record (TxType type, TER ter, Stage stage,
+    std::chrono::microseconds elapsed, std::uint32_t fetches,
+        EntryCounts const& reads, EntryCounts const& writes)
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    auto& costs = costs_[std::make_pair (type, ter)];
+    costs.time[stage].add (elapsed.count ());
+    if (stage != preflight)
+    {
+        costs.fetches[stage].add (fetches);
+        fetches_ += fetches;
+    }
+
+    if (stage == apply)
+    {
+        auto& entries = entries_[type];
+        std::uint64_t total = 0;
+        for (auto const& e : reads)
+        {
+            entries[e.first].reads += e.second;
+            total += e.second;
+        }
+        costs.reads.add (total);
+        reads_ += total;
+
+        total = 0;
+        for (auto const& e : writes)
+        {
+            entries[e.first].writes += e.second;
+            total += e.second;
+        }
+        costs.writes.add (total);
+        writes_ += total;
+    }
+
+    auto& event = events_[std::make_pair (type, stage)];
+    if (! event.impl ())
+        event = group_->make_event (typeName (type) + "_" + stageName (stage));
+    event.notify (elapsed);
+}
+
+Json::Value
+ApplyProfiler::getJson () const
+{
+    Json::Value ret (Json::objectValue);
+    ret[jss::enabled] = enabled ();
+
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    auto& txs = (ret[jss::transactions] = Json::objectValue);
+    for (auto const& c : costs_)
+    {
+        auto& result =
+            txs[typeName (c.first.first)][transToken (c.first.second)];
+        for (auto stage : {preflight, preclaim, apply})
+        {
+            auto const& time = c.second.time[stage];
+            if (time.count == 0)
+                continue;
+
+            auto& s = (result[stageName (stage)] = Json::objectValue);
+            s[jss::duration_us] = time.getJson ();
+            if (stage != preflight)
+                s[jss::fetches] = c.second.fetches[stage].getJson ();
+            if (stage == apply)
+            {
+                s[jss::reads] = c.second.reads.getJson ();
+                s[jss::writes] = c.second.writes.getJson ();
+            }
+        }
+    }
+
+    auto& entries = (ret[jss::entries] = Json::objectValue);
+    for (auto const& t : entries_)
+    {
+        auto& type = (entries[typeName (t.first)] = Json::objectValue);
+        for (auto const& e : t.second)
+        {
+            auto& entry = (type[entryName (e.first)] = Json::objectValue);
+            entry[jss::reads] = static_cast<Json::UInt> (e.second.reads);
+            entry[jss::writes] = static_cast<Json::UInt> (e.second.writes);
+        }
+    }
+
+    return ret;
+}
+
+} // casinocoin
@@ -66,6 +66,7 @@ BookTip::step (beast::Journal j)
         if (dirFirst (view_, *first_page, dir, di, m_index, j))
         {
             m_dir = dir->key();
+            m_page = dir;
             m_entry = view_.peek(keylet::offer(m_index));
             m_quality = Quality (getQuality (*first_page));
             m_valid = true;
@@ -49,6 +49,7 @@ private:
     uint256 m_end;
     uint256 m_dir;
     uint256 m_index;
+    std::shared_ptr<SLE> m_page;
     std::shared_ptr<SLE> m_entry;
     Quality m_quality;
 
@@ -80,6 +81,13 @@ public:
         return m_entry;
     }
 
+    /** The directory page holding the current offer. */
+    SLE::pointer const&
+    page() const noexcept
+    {
+        return m_page;
+    }
+
     /** Erases the current offer and advance to the next offer.
         Complexity: Constant
         @return `true` if there is a next offer
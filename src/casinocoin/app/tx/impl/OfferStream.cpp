@@ -83,6 +83,31 @@ TOfferStreamBase<TIn, TOut>::erase (ApplyView& view)
         " removed from directory " << tip_.dir();
 }
 
+// How many offers of a directory page to read ahead
+static std::size_t const readAheadOffers = 8;
+
+// Bring the next offers of the page at the tip into memory together,
+// so that stepping through them doesn't wait on the node store once per
+// offer. Only the page the tip already holds is looked at, nothing is
+// read through the view.
+template<class TIn, class TOut>
+void
+TOfferStreamBase<TIn, TOut>::readAhead ()
+{
+    readAhead_.clear();
+
+    auto const& page = tip_.page ();
+    if (! page)
+        return;
+    auto const& indexes = page->getFieldV256 (sfIndexes);
+    auto const count = std::min (indexes.size(), readAheadOffers);
+    readAhead_.assign (indexes.begin(), indexes.begin() + count);
+    if (count < 2)
+        return;
+
+    view_.prefetch (readAhead_);
+}
+
 static
 STAmount accountFundsHelper (ReadView const& view,
     AccountID const& id,
@@ -137,6 +162,12 @@ TOfferStreamBase<TIn, TOut>::step ()
         if (! tip_.step(j_))
             return false;
 
+        // Reading ahead only brings entries into memory, it doesn't
+        // change the order or outcome of the steps
+        if (std::find (readAhead_.begin(), readAhead_.end(),
+                tip_.index()) == readAhead_.end())
+            readAhead ();
+
         std::shared_ptr<SLE> entry = tip_.entry();
 
         // If we exceed the maximum number of allowed steps, we're done.
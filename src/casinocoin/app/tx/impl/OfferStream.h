@@ -84,10 +84,15 @@ protected:
     TOffer<TIn, TOut> offer_;
     boost::optional<TOut> ownerFunds_;
     StepCounter& counter_;
+    // The offers last read ahead
+    std::vector<uint256> readAhead_;
 
     void
     erase (ApplyView& view);
 
+    void
+    readAhead ();
+
     virtual
     void
     permRmOffer (uint256 const& offerIndex) = 0;
@@ -98,8 +98,8 @@ preflight2 (PreflightContext const& ctx)
 {
     if(!( ctx.flags & tapNO_CHECK_SIGN))
     {
-        auto const sigValid = checkValidity(ctx.app.getHashRouter(),
-            ctx.tx, ctx.rules, ctx.app.config(), ctx.j);
+        auto const sigValid = checkValidity(ctx.app,
+            ctx.tx, ctx.rules, ctx.j);
         if (sigValid.first == Validity::SigBad)
         {
             JLOG(ctx.j.debug()) <<
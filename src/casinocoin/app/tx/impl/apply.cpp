@@ -27,8 +27,15 @@
 #include <casinocoin/basics/Log.h>
 #include <casinocoin/app/tx/apply.h>
 #include <casinocoin/app/tx/applySteps.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/app/main/Application.h>
 #include <casinocoin/app/misc/HashRouter.h>
+#include <casinocoin/app/misc/SigVerifier.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <casinocoin/ledger/TxRecorder.h>
 #include <casinocoin/protocol/Feature.h>
+#include <algorithm>
+#include <thread>
 
 namespace casinocoin {
 
@@ -40,8 +47,9 @@ namespace casinocoin {
 
 //------------------------------------------------------------------------------
 
+static
 std::pair<Validity, std::string>
-checkValidity(HashRouter& router,
+checkValidity(HashRouter& router, SigCache* cache,
     STTx const& tx, Rules const& rules,
         Config const& config, beast::Journal j)
 {
@@ -60,12 +68,27 @@ checkValidity(HashRouter& router,
 
     if (!(flags & SF_SIGGOOD))
     {
-        // Don't know signature state. Check it.
-        auto const sigVerify = tx.checkSign(allowMultiSign);
-        if (! sigVerify.first)
+        // Don't know signature state. Check it, unless the
+        // signature cache remembers it. As in SigVerifier::check,
+        // only verdicts found with multi-signing enabled are cached.
+        boost::optional<bool> cached;
+        if (cache && allowMultiSign)
+            cached = cache->find(id);
+        if (cached && !*cached)
         {
             router.setFlags(id, SF_SIGBAD);
-            return {Validity::SigBad, sigVerify.second};
+            return {Validity::SigBad, "Invalid signature."};
+        }
+        if (!cached)
+        {
+            auto const sigVerify = tx.checkSign(allowMultiSign);
+            if (cache && allowMultiSign)
+                cache->insert(id, sigVerify.first);
+            if (! sigVerify.first)
+            {
+                router.setFlags(id, SF_SIGBAD);
+                return {Validity::SigBad, sigVerify.second};
+            }
         }
         router.setFlags(id, SF_SIGGOOD);
     }
@@ -92,6 +115,22 @@ checkValidity(HashRouter& router,
     return {Validity::Valid, ""};
 }
 
+std::pair<Validity, std::string>
+checkValidity(HashRouter& router,
+    STTx const& tx, Rules const& rules,
+        Config const& config, beast::Journal j)
+{
+    return checkValidity(router, nullptr, tx, rules, config, j);
+}
+
+std::pair<Validity, std::string>
+checkValidity(Application& app,
+    STTx const& tx, Rules const& rules, beast::Journal j)
+{
+    return checkValidity(app.getHashRouter(),
+        &app.getSigVerifier().cache(), tx, rules, app.config(), j);
+}
+
 void
 forceValidity(HashRouter& router, uint256 const& txid,
     Validity validity)
@@ -124,6 +163,138 @@ apply (Application& app, OpenView& view,
     return doApply(pcresult, app, view);
 }
 
+// Batches smaller than this are applied serially
+static std::size_t const minParallelBatch = 4;
+
+std::vector<std::pair<TER, bool>>
+applyParallel (WorkerPool& workers, OpenView& view,
+    std::vector<std::shared_ptr<STTx const>> const& txs,
+        std::size_t threads,
+            std::function<std::pair<TER, bool> (
+                OpenView&, std::size_t)> const& speculate,
+            std::function<bool (
+                OpenView const&, std::size_t)> const& usable,
+            std::function<std::pair<TER, bool> (
+                OpenView&, std::size_t)> const& serial,
+                    beast::Journal j)
+{
+    std::vector<std::pair<TER, bool>> results;
+    results.reserve (txs.size());
+
+    if (threads == 0)
+        threads = std::min (4u,
+            std::max (1u, std::thread::hardware_concurrency()));
+    threads = std::min (threads, txs.size());
+
+    // Closed views number their transactions in the metadata,
+    // so a result can't be moved to another position
+    if (threads < 2 || txs.size() < minParallelBatch || ! view.open())
+    {
+        for (std::size_t i = 0; i < txs.size(); ++i)
+            results.push_back (serial (view, i));
+        return results;
+    }
+
+    // Speculate. The view is shared by the workers, so it must
+    // neither change nor record until they are done.
+    std::vector<std::shared_ptr<TxFootprint const>> footprints (txs.size());
+    std::vector<std::pair<TER, bool>> speculated (txs.size());
+    // The cost of a speculative apply is only recorded if it's used
+    std::vector<ApplyProfiler::Records> profiles (txs.size());
+    auto const outer = view.recorder();
+    view.record (nullptr);
+    workers.forEach (txs.size(), [&](std::size_t i)
+        {
+            // Offers register their books with the
+            // application, which can't be undone
+            if (txs[i]->getTxnType() == ttOFFER_CREATE)
+                return;
+            try
+            {
+                OpenView sandbox (&view);
+                TxRecorder recorder;
+                sandbox.record (&recorder);
+                auto const result = [&]
+                {
+                    ApplyProfiler::Defer defer (profiles[i]);
+                    return speculate (sandbox, i);
+                }();
+                sandbox.record (nullptr);
+                recorder.finish();
+                if (result.second && recorder.complete() &&
+                    recorder.footprints().size() == 1)
+                {
+                    speculated[i] = result;
+                    footprints[i] = recorder.footprints().front();
+                }
+            }
+            catch (std::exception const& e)
+            {
+                JLOG (j.debug()) <<
+                    "Speculative apply threw: " << e.what();
+            }
+        }, threads);
+
+    // Commit in order. Keys written so far in the batch are the
+    // only ones whose state differs from what the workers saw.
+    TxRecorder recorder;
+    view.record (&recorder);
+    hash_set<uint256> written;
+    std::size_t committed = 0;
+    try
+    {
+        for (std::size_t i = 0; i < txs.size(); ++i)
+        {
+            auto const& fp = footprints[i];
+            // Changes that can't be attributed to a transaction
+            // leave the written keys unknown from then on
+            if (fp && recorder.complete() && ! fp->ranged &&
+                ! fp->touches (written) && ! view.txExists (fp->id) &&
+                    (! usable || usable (view, i)))
+            {
+                recorder.replay (view, fp);
+                ApplyProfiler::commit (profiles[i]);
+                fp->addWrites (written);
+                results.push_back (speculated[i]);
+                ++committed;
+                continue;
+            }
+
+            results.push_back (serial (view, i));
+            auto const last = recorder.last();
+            if (last && last->id == txs[i]->getTransactionID())
+                last->addWrites (written);
+        }
+    }
+    catch (...)
+    {
+        view.record (outer);
+        throw;
+    }
+    view.record (outer);
+    if (outer)
+        outer->append (std::move (recorder));
+
+    JLOG (j.debug()) <<
+        "Applied " << txs.size() << " transactions on " << threads <<
+            " threads, " << committed << " speculative results committed";
+    return results;
+}
+
+std::vector<std::pair<TER, bool>>
+applyParallel (Application& app, OpenView& view,
+    std::vector<std::shared_ptr<STTx const>> const& txs,
+        ApplyFlags flags, std::size_t threads,
+            beast::Journal j)
+{
+    auto const f = [&](OpenView& to, std::size_t i)
+    {
+        return apply (app, to, *txs[i], flags, j);
+    };
+    return applyParallel (app.getWorkerPool(),
+        view, txs, threads, f, nullptr, f, j);
+}
+
 ApplyResult
 applyTransaction (Application& app, OpenView& view,
     STTx const& txn,
@@ -26,6 +26,7 @@
 
 #include <BeastConfig.h>
 #include <casinocoin/app/tx/applySteps.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
 #include <casinocoin/app/tx/impl/ApplyContext.h>
 #include <casinocoin/app/tx/impl/CancelOffer.h>
 #include <casinocoin/app/tx/impl/CancelTicket.h>
@@ -286,16 +287,20 @@ preflight(Application& app, Rules const& rules,
 {
     PreflightContext const pfctx(app, tx,
         rules, flags, j);
+    ApplyProfiler::Sample sample(app, ApplyProfiler::preflight);
+    TER ter;
     try
     {
-        return{ pfctx, invoke_preflight(pfctx) };
+        ter = invoke_preflight(pfctx);
     }
     catch (std::exception const& e)
     {
         JLOG(j.fatal()) <<
             "apply: " << e.what();
-        return{ pfctx, tefEXCEPTION };
+        ter = tefEXCEPTION;
     }
+    sample.done(tx.getTxnType(), ter);
+    return{ pfctx, ter };
 }
 
 PreclaimResult
@@ -317,18 +322,22 @@ preclaim (PreflightResult const& preflightResult,
             app, view, preflightResult.ter, preflightResult.tx,
                 preflightResult.flags, preflightResult.j);
     }
+    if (ctx->preflightResult != tesSUCCESS)
+        return { *ctx, ctx->preflightResult, 0 };
+    ApplyProfiler::Sample sample(app, ApplyProfiler::preclaim);
+    std::pair<TER, std::uint64_t> result;
     try
     {
-        if (ctx->preflightResult != tesSUCCESS)
-            return { *ctx, ctx->preflightResult, 0 };
-        return{ *ctx, invoke_preclaim(*ctx) };
+        result = invoke_preclaim(*ctx);
     }
     catch (std::exception const& e)
     {
         JLOG(ctx->j.fatal()) <<
             "apply: " << e.what();
-        return{ *ctx, tefEXCEPTION, 0 };
+        result = { tefEXCEPTION, 0 };
     }
+    sample.done(ctx->tx.getTxnType(), result.first);
+    return{ *ctx, result };
 }
 
 std::uint64_t
@@ -367,11 +376,16 @@ doApply(PreclaimResult const& preclaimResult,
     {
         if (!preclaimResult.likelyToClaimFee)
             return{ preclaimResult.ter, false };
+        ApplyProfiler::Sample sample(app, ApplyProfiler::apply);
         ApplyContext ctx(app, view,
             preclaimResult.tx, preclaimResult.ter,
                 preclaimResult.baseFee, preclaimResult.flags,
                     preclaimResult.j);
-        return invoke_apply(ctx);
+        if (sample)
+            ctx.profile(&sample.reads, &sample.writes);
+        auto const result = invoke_apply(ctx);
+        sample.done(preclaimResult.tx.getTxnType(), result.first);
+        return result;
     }
     catch (std::exception const& e)
     {
@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_BASICS_HISTOGRAM_H_INCLUDED
+#define CASINOCOIN_BASICS_HISTOGRAM_H_INCLUDED
+
+#include <casinocoin/json/json_value.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace casinocoin {
+
+/** A histogram with power of two buckets.
+
+    Bucket 0 holds zero, bucket i holds values in [2^(i-1), 2^i)
+    and the last bucket holds everything larger.
+*/
+struct Histogram
+{
+    static std::size_t const size = 24;
+
+    std::uint64_t count = 0;
+    std::uint64_t total = 0;
+    std::array<std::uint64_t, size> buckets {};
+
+    void
+    add (std::uint64_t value);
+
+    /** Return the count, the total and the buckets in use. */
+    Json::Value
+    getJson () const;
+};
+
+} // casinocoin
+
+#endif
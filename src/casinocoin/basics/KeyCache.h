@@ -31,6 +31,7 @@
 #include <casinocoin/beast/clock/abstract_clock.h>
 #include <casinocoin/beast/insight/Insight.h>
 #include <mutex>
+#include <vector>
 
 namespace casinocoin {
 
@@ -243,6 +244,19 @@ public:
         return false;
     }
 
+    /** Returns a copy of the keys in the container. */
+    std::vector <key_type> getKeys () const
+    {
+        std::vector <key_type> v;
+        {
+            lock_guard lock (m_mutex);
+            v.reserve (m_map.size ());
+            for (auto const& e : m_map)
+                v.push_back (e.first);
+        }
+        return v;
+    }
+
     /** Remove stale entries from the cache. */
     void sweep ()
     {
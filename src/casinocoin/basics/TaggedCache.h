@@ -31,7 +31,10 @@
 #include <casinocoin/basics/UnorderedContainers.h>
 #include <casinocoin/beast/clock/abstract_clock.h>
 #include <casinocoin/beast/insight/Insight.h>
+#include <array>
+#include <atomic>
 #include <functional>
+#include <list>
 #include <mutex>
 #include <vector>
 
@@ -40,6 +43,18 @@ namespace casinocoin {
 // VFALCO NOTE Deprecated
 struct TaggedCacheLog;
 
+/** The number of bytes a cached object is charged for.
+
+    Used when a TaggedCache has a target in bytes. Overload this for
+    types which own variable sized data.
+*/
+template <class T>
+std::size_t
+cachedBytes (T const&)
+{
+    return sizeof (T);
+}
+
 /** Map/cache combination.
     This class implements a cache and a map. The cache keeps objects alive
     in the map. The map allows multiple code paths that reference objects
@@ -49,6 +64,14 @@ struct TaggedCacheLog;
     If it stays in memory even after it is ejected from the cache,
     the map will track it.
 
+    The map is split into shards by key, each with its own lock, so
+    threads working on different keys rarely contend. Objects leave the
+    cache when they have not been accessed for the target age. When a
+    shard holds more than its share of the target size or bytes, a
+    CLOCK hand passes over it: objects accessed since the hand last
+    passed get a second chance, the others are ejected. Sweeping locks
+    one shard at a time.
+
     @note Callers must not modify data objects that are stored in the cache
           unless they hold their own lock over all cache operations.
 */
@@ -75,6 +98,8 @@ public:
     using mapped_ptr = std::shared_ptr <mapped_type>;
     using clock_type = beast::abstract_clock <std::chrono::steady_clock>;
 
+    static std::size_t const shardCount = 16;
+
 public:
     // VFALCO TODO Change expiration_seconds to clock_type::duration
     TaggedCache (std::string const& name, int size,
@@ -87,10 +112,8 @@ public:
                 collector)
         , m_name (name)
         , m_target_size (size)
-        , m_target_age (std::chrono::seconds (expiration_seconds))
-        , m_cache_count (0)
-        , m_hits (0)
-        , m_misses (0)
+        , m_target_bytes (0)
+        , m_target_age (expiration_seconds)
     {
     }
 
@@ -103,171 +126,211 @@ public:
 
     int getTargetSize () const
     {
-        lock_guard lock (m_mutex);
         return m_target_size;
     }
 
     void setTargetSize (int s)
     {
-        lock_guard lock (m_mutex);
         m_target_size = s;
 
         if (s > 0)
-            m_cache.rehash (static_cast<std::size_t> ((s + (s >> 2)) / m_cache.max_load_factor () + 1));
+        {
+            auto const share = shareOf (s);
+            for (auto& shard : m_shards)
+            {
+                lock_guard lock (shard.mutex);
+                shard.map.rehash (static_cast<std::size_t> (
+                    (share + (share >> 2)) / shard.map.max_load_factor () + 1));
+            }
+        }
 
         JLOG(m_journal.debug()) <<
             m_name << " target size set to " << s;
     }
 
+    /** The desired number of bytes of cached objects (0 = ignore) */
+    std::size_t getTargetBytes () const
+    {
+        return m_target_bytes;
+    }
+
+    void setTargetBytes (std::size_t bytes)
+    {
+        m_target_bytes = bytes;
+        JLOG(m_journal.debug()) <<
+            m_name << " target bytes set to " << bytes;
+    }
+
     clock_type::rep getTargetAge () const
     {
-        lock_guard lock (m_mutex);
-        return m_target_age.count();
+        return m_target_age;
     }
 
     void setTargetAge (clock_type::rep s)
     {
-        lock_guard lock (m_mutex);
-        m_target_age = std::chrono::seconds (s);
+        m_target_age = s;
         JLOG(m_journal.debug()) <<
-            m_name << " target age set to " << m_target_age.count();
+            m_name << " target age set to " << s;
     }
 
     int getCacheSize () const
     {
-        lock_guard lock (m_mutex);
-        return m_cache_count;
+        int count = 0;
+        for (auto& shard : m_shards)
+        {
+            lock_guard lock (shard.mutex);
+            count += shard.count;
+        }
+        return count;
+    }
+
+    /** The bytes charged for the cached objects */
+    std::size_t getCacheBytes () const
+    {
+        std::size_t bytes = 0;
+        for (auto& shard : m_shards)
+        {
+            lock_guard lock (shard.mutex);
+            bytes += shard.bytes;
+        }
+        return bytes;
     }
 
     int getTrackSize () const
     {
-        lock_guard lock (m_mutex);
-        return m_cache.size ();
+        std::size_t size = 0;
+        for (auto& shard : m_shards)
+        {
+            lock_guard lock (shard.mutex);
+            size += shard.map.size ();
+        }
+        return size;
     }
 
     float getHitRate ()
     {
-        lock_guard lock (m_mutex);
-        auto const total = static_cast<float> (m_hits + m_misses);
-        return m_hits * (100.0f / std::max (1.0f, total));
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        totals (hits, misses);
+        auto const total = static_cast<float> (hits + misses);
+        return hits * (100.0f / std::max (1.0f, total));
     }
 
     void clearStats ()
     {
-        lock_guard lock (m_mutex);
-        m_hits = 0;
-        m_misses = 0;
+        for (auto& shard : m_shards)
+        {
+            lock_guard lock (shard.mutex);
+            shard.hits = 0;
+            shard.misses = 0;
+        }
     }
 
     void clear ()
     {
-        lock_guard lock (m_mutex);
-        m_cache.clear ();
-        m_cache_count = 0;
+        for (auto& shard : m_shards)
+        {
+            lock_guard lock (shard.mutex);
+            shard.map.clear ();
+            shard.ring.clear ();
+            shard.hand = shard.ring.end ();
+            shard.count = 0;
+            shard.bytes = 0;
+        }
     }
 
     void sweep ()
     {
         int cacheRemovals = 0;
         int mapRemovals = 0;
-        int cc = 0;
+        std::size_t tracked = 0;
 
-        // Keep references to all the stuff we sweep
-        // so that we can destroy them outside the lock.
-        //
-        std::vector <mapped_ptr> stuffToSweep;
+        clock_type::time_point const when_expire (m_clock.now() -
+            std::chrono::seconds (m_target_age.load ()));
 
+        for (auto& shard : m_shards)
         {
-            clock_type::time_point const now (m_clock.now());
-            clock_type::time_point when_expire;
-
-            lock_guard lock (m_mutex);
-
-            if (m_target_size == 0 ||
-                (static_cast<int> (m_cache.size ()) <= m_target_size))
-            {
-                when_expire = now - m_target_age;
-            }
-            else
-            {
-                when_expire = now - clock_type::duration (
-                    m_target_age.count() * m_target_size / m_cache.size ());
+            // Keep references to all the stuff we sweep
+            // so that we can destroy them outside the lock.
+            //
+            std::vector <mapped_ptr> stuffToSweep;
 
-                clock_type::duration const minimumAge (
-                    std::chrono::seconds (1));
-                if (when_expire > (now - minimumAge))
-                    when_expire = now - minimumAge;
+            lock_guard lock (shard.mutex);
 
-                JLOG(m_journal.trace()) <<
-                    m_name << " is growing fast " << m_cache.size () << " of " << m_target_size <<
-                        " aging at " << (now - when_expire).count() << " of " << m_target_age.count();
-            }
+            stuffToSweep.reserve (shard.count);
 
-            stuffToSweep.reserve (m_cache.size ());
+            cache_iterator cit = shard.map.begin ();
 
-            cache_iterator cit = m_cache.begin ();
-
-            while (cit != m_cache.end ())
+            while (cit != shard.map.end ())
             {
-                if (cit->second.isWeak ())
+                Entry& entry = cit->second;
+
+                if (entry.isWeak ())
                 {
                     // weak
-                    if (cit->second.isExpired ())
+                    if (entry.isExpired ())
                     {
                         ++mapRemovals;
-                        cit = m_cache.erase (cit);
+                        cit = shard.map.erase (cit);
                     }
                     else
                     {
                         ++cit;
                     }
+                    continue;
                 }
-                else if (cit->second.last_access <= when_expire)
+
+                if (entry.last_access > when_expire)
                 {
-                    // strong, expired
-                    --m_cache_count;
-                    ++cacheRemovals;
-                    if (cit->second.ptr.unique ())
-                    {
-                        stuffToSweep.push_back (cit->second.ptr);
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
-                    }
-                    else
-                    {
-                        // remains weakly cached
-                        cit->second.ptr.reset ();
-                        ++cit;
-                    }
+                    // strong, not expired
+                    ++cit;
+                    continue;
+                }
+
+                // strong, expired
+
+                ++cacheRemovals;
+                if (entry.ptr.unique ())
+                {
+                    stuffToSweep.push_back (uncache (shard, entry));
+                    ++mapRemovals;
+                    cit = shard.map.erase (cit);
                 }
                 else
                 {
-                    // strong, not expired
-                    ++cc;
+                    // remains weakly cached
+                    uncache (shard, entry);
                     ++cit;
                 }
             }
+
+            // Bring the shard back under its targets
+            cacheRemovals += makeRoom (shard, stuffToSweep);
+
+            tracked += shard.map.size ();
+
+            // The lock is released before stuffToSweep goes out of
+            // scope, so the strong pointers are dropped outside it.
         }
 
         if (mapRemovals || cacheRemovals)
         {
             JLOG(m_journal.trace()) <<
-                m_name << ": cache = " << m_cache.size () <<
+                m_name << ": cache = " << tracked <<
                 "-" << cacheRemovals << ", map-=" << mapRemovals;
         }
-
-        // At this point stuffToSweep will go out of scope outside the lock
-        // and decrement the reference count on each strong pointer.
     }
 
     bool del (const key_type& key, bool valid)
     {
         // Remove from cache, if !valid, remove from map too. Returns true if removed from cache
-        lock_guard lock (m_mutex);
+        mapped_ptr removed;
+        Shard& shard = shardFor (key);
+        lock_guard lock (shard.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = shard.map.find (key);
 
-        if (cit == m_cache.end ())
+        if (cit == shard.map.end ())
             return false;
 
         Entry& entry = cit->second;
@@ -276,13 +339,12 @@ public:
 
         if (entry.isCached ())
         {
-            --m_cache_count;
-            entry.ptr.reset ();
+            removed = uncache (shard, entry);
             ret = true;
         }
 
         if (!valid || entry.isExpired ())
-            m_cache.erase (cit);
+            shard.map.erase (cit);
 
         return ret;
     }
@@ -304,16 +366,22 @@ public:
     {
         // Return canonical value, store if needed, refresh in cache
         // Return values: true=we had the data already
-        lock_guard lock (m_mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        // Objects ejected to make room, released outside the lock
+        std::vector <mapped_ptr> ejected;
+
+        Shard& shard = shardFor (key);
+        lock_guard lock (shard.mutex);
+
+        cache_iterator cit = shard.map.find (key);
 
-        if (cit == m_cache.end ())
+        if (cit == shard.map.end ())
         {
-            m_cache.emplace (std::piecewise_construct,
+            auto const result = shard.map.emplace (std::piecewise_construct,
                 std::forward_as_tuple(key),
                 std::forward_as_tuple(m_clock.now(), data));
-            ++m_cache_count;
+            charge (shard, *result.first);
+            makeRoom (shard, ejected);
             return false;
         }
 
@@ -324,8 +392,11 @@ public:
         {
             if (replace)
             {
+                ejected.push_back (uncache (shard, entry));
                 entry.ptr = data;
                 entry.weak_ptr = data;
+                charge (shard, *cit);
+                makeRoom (shard, ejected);
             }
             else
             {
@@ -350,27 +421,33 @@ public:
                 data = cachedData;
             }
 
-            ++m_cache_count;
+            charge (shard, *cit);
+            makeRoom (shard, ejected);
             return true;
         }
 
         entry.ptr = data;
         entry.weak_ptr = data;
-        ++m_cache_count;
+        charge (shard, *cit);
+        makeRoom (shard, ejected);
 
         return false;
     }
 
     std::shared_ptr<T> fetch (const key_type& key)
     {
+        // Objects ejected to make room, released outside the lock
+        std::vector <mapped_ptr> ejected;
+
         // fetch us a shared pointer to the stored data object
-        lock_guard lock (m_mutex);
+        Shard& shard = shardFor (key);
+        lock_guard lock (shard.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = shard.map.find (key);
 
-        if (cit == m_cache.end ())
+        if (cit == shard.map.end ())
         {
-            ++m_misses;
+            ++shard.misses;
             return mapped_ptr ();
         }
 
@@ -379,7 +456,7 @@ public:
 
         if (entry.isCached ())
         {
-            ++m_hits;
+            ++shard.hits;
             return entry.ptr;
         }
 
@@ -388,12 +465,14 @@ public:
         if (entry.isCached ())
         {
             // independent of cache size, so not counted as a hit
-            ++m_cache_count;
-            return entry.ptr;
+            mapped_ptr result = entry.ptr;
+            charge (shard, *cit);
+            makeRoom (shard, ejected);
+            return result;
         }
 
-        m_cache.erase (cit);
-        ++m_misses;
+        shard.map.erase (cit);
+        ++shard.misses;
         return mapped_ptr ();
     }
 
@@ -434,12 +513,16 @@ public:
     {
         bool found = false;
 
+        // Objects ejected to make room, released outside the lock
+        std::vector <mapped_ptr> ejected;
+
         // If present, make current in cache
-        lock_guard lock (m_mutex);
+        Shard& shard = shardFor (key);
+        lock_guard lock (shard.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = shard.map.find (key);
 
-        if (cit != m_cache.end ())
+        if (cit != shard.map.end ())
         {
             Entry& entry = cit->second;
 
@@ -451,15 +534,18 @@ public:
                 if (entry.isCached ())
                 {
                     // We just put the object back in cache
-                    ++m_cache_count;
+                    // Held so making room can't forget the entry
+                    mapped_ptr const held = entry.ptr;
                     entry.touch (m_clock.now());
+                    charge (shard, *cit);
+                    makeRoom (shard, ejected);
                     found = true;
                 }
                 else
                 {
                     // Couldn't get strong pointer,
                     // object fell out of the cache so remove the entry.
-                    m_cache.erase (cit);
+                    shard.map.erase (cit);
                 }
             }
             else
@@ -477,6 +563,11 @@ public:
         return found;
     }
 
+    /** A mutex for callers which need to make several calls atomically.
+
+        The cache does not take this mutex itself; each call is atomic
+        on its own.
+    */
     mutex_type& peekMutex ()
     {
         return m_mutex;
@@ -486,10 +577,11 @@ public:
     {
         std::vector <key_type> v;
 
+        for (auto& shard : m_shards)
         {
-            lock_guard lock (m_mutex);
-            v.reserve (m_cache.size());
-            for (auto const& _ : m_cache)
+            lock_guard lock (shard.mutex);
+            v.reserve (v.size () + shard.map.size());
+            for (auto const& _ : shard.map)
                 v.push_back (_.first);
         }
 
@@ -504,10 +596,12 @@ private:
         {
             beast::insight::Gauge::value_type hit_rate (0);
             {
-                lock_guard lock (m_mutex);
-                auto const total (m_hits + m_misses);
+                std::uint64_t hits = 0;
+                std::uint64_t misses = 0;
+                totals (hits, misses);
+                auto const total (hits + misses);
                 if (total != 0)
-                    hit_rate = (m_hits * 100) / total;
+                    hit_rate = (hits * 100) / total;
             }
             m_stats.hit_rate.set (hit_rate);
         }
@@ -529,12 +623,21 @@ private:
         beast::insight::Gauge hit_rate;
     };
 
+    class Entry;
+    using value_type = std::pair <key_type const, Entry>;
+    using ring_type = std::list <value_type*>;
+    using ring_iterator = typename ring_type::iterator;
+
     class Entry
     {
     public:
         mapped_ptr ptr;
         weak_mapped_ptr weak_ptr;
         clock_type::time_point last_access;
+        // Position in the CLOCK ring while cached
+        ring_iterator slot;
+        std::size_t bytes = 0;
+        bool referenced = false;
 
         Entry (clock_type::time_point const& last_access_,
             mapped_ptr const& ptr_)
@@ -548,12 +651,119 @@ private:
         bool isCached () const { return ptr != nullptr; }
         bool isExpired () const { return weak_ptr.expired (); }
         mapped_ptr lock () { return weak_ptr.lock (); }
-        void touch (clock_type::time_point const& now) { last_access = now; }
+        void touch (clock_type::time_point const& now)
+        {
+            last_access = now;
+            referenced = true;
+        }
     };
 
     using cache_type = hardened_hash_map <key_type, Entry, Hash, KeyEqual>;
     using cache_iterator = typename cache_type::iterator;
 
+    struct Shard
+    {
+        mutex_type mutable mutex;
+        cache_type map;
+
+        // The cached entries in CLOCK order, and the hand
+        ring_type ring;
+        ring_iterator hand = ring.end ();
+
+        // Number of items cached and the bytes charged for them
+        int count = 0;
+        std::size_t bytes = 0;
+
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+    };
+
+    Shard& shardFor (key_type const& key)
+    {
+        return m_shards[m_hash (key) % shardCount];
+    }
+
+    static std::size_t shareOf (std::size_t target)
+    {
+        return (target + shardCount - 1) / shardCount;
+    }
+
+    bool overTarget (Shard const& shard) const
+    {
+        int const size = m_target_size;
+        std::size_t const bytes = m_target_bytes;
+        return (size > 0 && static_cast<std::size_t> (shard.count) >
+                shareOf (size)) ||
+            (bytes > 0 && shard.bytes > shareOf (bytes));
+    }
+
+    // Count a newly cached entry against the shard. It goes just
+    // behind the hand, so it is the last to be considered.
+    void charge (Shard& shard, value_type& item)
+    {
+        Entry& entry = item.second;
+        entry.bytes = cachedBytes (*entry.ptr);
+        entry.slot = shard.ring.insert (shard.hand, &item);
+        ++shard.count;
+        shard.bytes += entry.bytes;
+    }
+
+    // Eject an entry from the cache, returning the strong pointer
+    mapped_ptr uncache (Shard& shard, Entry& entry)
+    {
+        if (shard.hand == entry.slot)
+            ++shard.hand;
+        shard.ring.erase (entry.slot);
+        --shard.count;
+        shard.bytes -= entry.bytes;
+        entry.bytes = 0;
+        return std::move (entry.ptr);
+    }
+
+    // Move the CLOCK hand while the shard is over its targets. Entries
+    // used since the hand last passed are spared once; the others are
+    // ejected, and forgotten if nothing else holds them. Returns the
+    // number of entries ejected.
+    int makeRoom (Shard& shard, std::vector <mapped_ptr>& ejected)
+    {
+        int removals = 0;
+        // Two turns clear every bit and eject what is needed
+        auto steps = 2 * shard.ring.size ();
+        while (steps-- > 0 && overTarget (shard))
+        {
+            if (shard.hand == shard.ring.end ())
+                shard.hand = shard.ring.begin ();
+
+            value_type& item = **shard.hand;
+            Entry& entry = item.second;
+            if (entry.referenced)
+            {
+                entry.referenced = false;
+                ++shard.hand;
+                continue;
+            }
+
+            ++removals;
+            ejected.push_back (uncache (shard, entry));
+            if (ejected.back ().unique ())
+            {
+                auto const key = item.first;
+                shard.map.erase (key);
+            }
+        }
+        return removals;
+    }
+
+    void totals (std::uint64_t& hits, std::uint64_t& misses) const
+    {
+        for (auto& shard : m_shards)
+        {
+            lock_guard lock (shard.mutex);
+            hits += shard.hits;
+            misses += shard.misses;
+        }
+    }
+
     beast::Journal m_journal;
     clock_type& m_clock;
     Stats m_stats;
@@ -564,16 +774,16 @@ private:
     std::string m_name;
 
     // Desired number of cache entries (0 = ignore)
-    int m_target_size;
+    std::atomic<int> m_target_size;
+
+    // Desired bytes of cached objects (0 = ignore)
+    std::atomic<std::size_t> m_target_bytes;
 
-    // Desired maximum cache age
-    clock_type::duration m_target_age;
+    // Desired maximum cache age, in seconds
+    std::atomic<clock_type::rep> m_target_age;
 
-    // Number of items cached
-    int m_cache_count;
-    cache_type m_cache;  // Hold strong reference to recent objects
-    std::uint64_t m_hits;
-    std::uint64_t m_misses;
+    Hash m_hash;
+    std::array<Shard, shardCount> m_shards;
 };
 
 }
@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/basics/Histogram.h>
+#include <algorithm>
+#include <string>
+
+namespace casinocoin {
+
+void
+Histogram::add (std::uint64_t value)
+{
+    std::size_t bucket = 0;
+    for (auto v = value; v != 0 && bucket + 1 < size; v >>= 1)
+        ++bucket;
+
+    ++count;
+    total += value;
+    ++buckets[bucket];
+}
+
+Json::Value
+Histogram::getJson () const
+{
+    Json::Value ret (Json::objectValue);
+    ret["count"] = static_cast<Json::UInt> (count);
+    ret["total"] = std::to_string (total);
+
+    // Trailing empty buckets are left out
+    auto const used = std::find_if (buckets.rbegin (), buckets.rend (),
+        [](std::uint64_t n) { return n != 0; }).base ();
+    auto& b = (ret["buckets"] = Json::arrayValue);
+    for (auto iter = buckets.begin (); iter != used; ++iter)
+        b.append (static_cast<Json::UInt> (*iter));
+    return ret;
+}
+
+} // casinocoin
@@ -167,6 +167,8 @@ public:
     int                         PATH_SEARCH = 7;
     int                         PATH_SEARCH_FAST = 2;
     int                         PATH_SEARCH_MAX = 10;
+    int                         PATH_SEARCH_THREADS = 0;        // 0 to choose from the hardware
+    int                         PATH_SEARCH_DEADLINE = 3000;    // Milliseconds, 0 for no limit
 
     // Validation
     boost::optional<std::size_t> VALIDATION_QUORUM;     // Minimum validations to consider ledger authoritative
@@ -192,6 +194,9 @@ public:
     // Thread pool configuration
     std::size_t                 WORKERS = 0;
 
+    // Threads applying transactions to the open ledger, 0 for automatic
+    std::size_t                 APPLY_THREADS = 0;
+
     // Network the server connects to. production = 0, test = 1, development = 2
     // default is production if not specified in the config
     std::uint32_t               PEER_NETWORK = 0;
@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_CORE_WORKERPOOL_H_INCLUDED
+#define CASINOCOIN_CORE_WORKERPOOL_H_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace casinocoin {
+
+/** A fixed set of threads for splitting work that only reads shared state.
+
+    Path searches, signature checks, speculative applies and order book
+    scans hand out independent pieces of work with forEach. The threads
+    are started once and wait for work on a queue, so a call costs no
+    thread creation, and the number of threads busy across all callers
+    never exceeds the size of the pool.
+
+    The calling thread always works through the pieces itself as well,
+    and only waits for pieces that another thread has already started.
+    A queued request for help that no thread got to before the work ran
+    out is dropped when it's reached, so nested or concurrent calls,
+    including calls from the pool's own threads, can't wait on each
+    other.
+*/
+class WorkerPool
+{
+public:
+    /** Create the pool and start its threads.
+
+        @param threads The most threads to use at once, counting the
+                       calling thread. Zero chooses from the hardware.
+    */
+    explicit
+    WorkerPool (std::size_t threads);
+
+    WorkerPool (WorkerPool const&) = delete;
+    WorkerPool& operator= (WorkerPool const&) = delete;
+
+    /** Stop and join the threads. No call may be running. */
+    ~WorkerPool ();
+
+    std::size_t
+    threads () const
+    {
+        return threads_;
+    }
+
+    /** Call f(i) for each i in [0, n).
+
+        Calls may be concurrent and in any order, so f must only write
+        to state of its own index. Returns when all calls are done. If
+        any call throws, the first exception is rethrown.
+
+        @param most The most threads to use for this call, counting the
+                    calling thread. Zero allows the whole pool.
+    */
+    void
+    forEach (std::size_t n, std::function<void (std::size_t)> const& f,
+        std::size_t most = 0);
+
+private:
+    struct Batch;
+
+    void
+    run ();
+
+    std::size_t const threads_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    // Batches that asked for help, once per thread wanted
+    std::deque<std::shared_ptr<Batch>> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+} // casinocoin
+
+#endif
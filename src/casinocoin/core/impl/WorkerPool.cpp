@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace casinocoin {
+
+// The work of one forEach call, shared with the threads helping it.
+// A thread only calls f while it's counted in `helping`, and the caller
+// doesn't return until that's back to zero with no index left, so f is
+// never called after the caller has returned.
+struct WorkerPool::Batch
+{
+    Batch (std::size_t n_, std::function<void (std::size_t)> const& f_)
+        : n (n_)
+        , f (f_)
+    {
+    }
+
+    std::size_t const n;
+    std::function<void (std::size_t)> const& f;
+    std::atomic<std::size_t> next {0};
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t helping = 0;
+    std::exception_ptr error;
+
+    void
+    work ()
+    {
+        for (std::size_t i; (i = next++) < n;)
+        {
+            try
+            {
+                f (i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                if (! error)
+                    error = std::current_exception ();
+                // Let the other threads finish early
+                next = n;
+            }
+        }
+    }
+
+    void
+    help ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            if (next >= n)
+                return;
+            ++helping;
+        }
+        work ();
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            --helping;
+        }
+        done.notify_all ();
+    }
+};
+
+WorkerPool::WorkerPool (std::size_t threads)
+    : threads_ (threads != 0 ? threads :
+        std::max (1u, std::thread::hardware_concurrency ()))
+{
+    workers_.reserve (threads_ - 1);
+    for (std::size_t i = 1; i < threads_; ++i)
+        workers_.emplace_back (&WorkerPool::run, this);
+}
+
+WorkerPool::~WorkerPool ()
+{
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all ();
+    for (auto& t : workers_)
+        t.join ();
+}
+
+void
+WorkerPool::run ()
+{
+    for (;;)
+    {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock (mutex_);
+            wake_.wait (lock,
+                [this] { return stopping_ || ! queue_.empty (); });
+            if (queue_.empty ())
+                return;
+            batch = std::move (queue_.front ());
+            queue_.pop_front ();
+        }
+        batch->help ();
+    }
+}
+
+void
+WorkerPool::forEach (std::size_t n,
+    std::function<void (std::size_t)> const& f, std::size_t most)
+{
+    if (n == 0)
+        return;
+
+    auto const limit = most != 0 ? std::min (most, threads_) : threads_;
+    auto const extra = std::min (n, limit) - 1;
+
+    auto const batch = std::make_shared<Batch> (n, f);
+    if (extra > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            for (std::size_t i = 0; i < extra; ++i)
+                queue_.push_back (batch);
+        }
+        if (extra == 1)
+            wake_.notify_one ();
+        else
+            wake_.notify_all ();
+    }
+
+    batch->work ();
+
+    std::unique_lock<std::mutex> lock (batch->mutex);
+    batch->done.wait (lock, [&] { return batch->helping == 0; });
+    if (batch->error)
+        std::rethrow_exception (batch->error);
+}
+
+} // casinocoin
@@ -92,6 +92,23 @@ public:
             bool isDelete,
             std::shared_ptr <SLE const> const& before,
             std::shared_ptr <SLE const> const& after)> const& func);
+
+    /** Count the entries read from the base, by type
+    */
+    void
+    countReads (EntryCounts* reads)
+    {
+        items_.countReads (reads);
+    }
+
+    /** Count the modified entries, by type
+    */
+    void
+    countWrites (EntryCounts& writes) const
+    {
+        items_.countWrites (writes);
+    }
+
 private:
     boost::optional<STAmount> deliver_;
 };
@@ -71,6 +71,12 @@ public:
     std::shared_ptr<SLE const>
     read (Keylet const& k) const override;
 
+    std::size_t
+    prefetch (std::vector<key_type> const& keys) const override
+    {
+        return base_.prefetch(keys);
+    }
+
     bool
     open() const override
     {
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_LEDGER_METAWRITER_H_INCLUDED
+#define CASINOCOIN_LEDGER_METAWRITER_H_INCLUDED
+
+#include <casinocoin/protocol/STLedgerEntry.h>
+#include <casinocoin/protocol/STAmount.h>
+#include <casinocoin/protocol/Serializer.h>
+#include <casinocoin/protocol/TER.h>
+#include <boost/container/flat_map.hpp>
+#include <boost/optional.hpp>
+#include <vector>
+
+namespace casinocoin {
+
+/** Writes transaction metadata straight to its canonical binary form.
+
+    TxMeta holds the affected nodes as a tree of STObjects, each inner
+    object a copy of the fields of a ledger entry, which is only
+    serialized once every node is known. MetaWriter serializes the
+    fields of an inner object as soon as it is given them, from the
+    entries themselves, and keeps per node only what can still change:
+    its type and threading fields.
+
+    The calls mirror those of TxMeta, and the same calls produce the
+    same bytes as TxMeta::addRaw.
+*/
+class MetaWriter
+{
+public:
+    MetaWriter (uint256 const& txID, std::uint32_t ledger)
+        : txID_ (txID)
+        , ledger_ (ledger)
+    {
+    }
+
+    MetaWriter (MetaWriter const&) = delete;
+    MetaWriter& operator= (MetaWriter const&) = delete;
+
+    uint256 const&
+    getTxID () const
+    {
+        return txID_;
+    }
+
+    std::uint32_t
+    getLgrSeq () const
+    {
+        return ledger_;
+    }
+
+    void
+    setDeliveredAmount (STAmount const& delivered)
+    {
+        delivered_.emplace (delivered);
+    }
+
+    /** Add a node, or change the type of one already added. */
+    void
+    setAffectedNode (uint256 const& key, SField const& type,
+        std::uint16_t nodeType);
+
+    /** Set the previous transaction of the node for an entry.
+
+        The node is added as a ModifiedNode if it is not there yet.
+        As with TxMeta::thread, a node is only threaded once.
+    */
+    bool
+    thread (std::shared_ptr<SLE const> const& sle,
+        uint256 const& prevTxID, std::uint32_t prevLgrID);
+
+    /** Add an inner object to a node.
+
+        @param name sfPreviousFields, sfFinalFields or sfNewFields.
+        @param fields The fields TxMeta would copy into the object.
+                      Nothing is added if there are none.
+    */
+    void
+    addObject (uint256 const& key, SField const& name,
+        std::vector<STBase const*> const& fields);
+
+    /** Serialize the metadata, as TxMeta::addRaw does. */
+    void
+    addRaw (Serializer& s, TER result, std::uint32_t index) const;
+
+private:
+    struct Node
+    {
+        SField const* type;
+        std::uint16_t entryType;
+        bool threaded = false;
+        std::uint32_t prevLgrID = 0;
+        uint256 prevTxID;
+        // Serialized inner objects, in field order
+        Blob objects;
+    };
+
+    Node&
+    node (uint256 const& key, SField const& type, std::uint16_t nodeType);
+
+    uint256 const txID_;
+    std::uint32_t const ledger_;
+    boost::optional<STAmount> delivered_;
+    boost::container::flat_map<uint256, Node> nodes_;
+    Serializer scratch_;
+};
+
+} // casinocoin
+
+#endif
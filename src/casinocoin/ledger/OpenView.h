@@ -36,6 +36,8 @@
 
 namespace casinocoin {
 
+class TxRecorder;
+
 /** Open ledger construction tag.
 
     Views constructed with this tag will have the
@@ -73,6 +75,7 @@ private:
     detail::RawStateTable items_;
     std::shared_ptr<void const> hold_;
     bool open_ = true;
+    TxRecorder* recorder_ = nullptr;
 
 public:
     OpenView() = delete;
@@ -92,8 +95,11 @@ public:
         not duplicated but shared between instances.
         Since the SLEs are immutable, calls on the
         RawView interface cannot break invariants.
+
+        The copy does not report to the recorder of
+        `other`, if any.
     */
-    OpenView (OpenView const&) = default;
+    OpenView (OpenView const& other);
 
     /** Construct an open ledger view.
 
@@ -160,6 +166,23 @@ public:
     void
     apply (TxsRawView& to) const;
 
+    /** Report reads and changes to a recorder.
+
+        Only the thread building the view may use it while a
+        recorder is set. Pass nullptr to stop recording.
+    */
+    void
+    record (TxRecorder* recorder)
+    {
+        recorder_ = recorder;
+    }
+
+    TxRecorder*
+    recorder() const
+    {
+        return recorder_;
+    }
+
     // ReadView
 
     LedgerInfo const&
@@ -184,6 +207,9 @@ public:
     std::shared_ptr<SLE const>
     read (Keylet const& k) const override;
 
+    std::size_t
+    prefetch (std::vector<key_type> const& keys) const override;
+
     std::unique_ptr<sles_type::iter_base>
     slesBegin() const override;
 
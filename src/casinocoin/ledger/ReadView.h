@@ -42,6 +42,7 @@
 #include <cstdint>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 namespace casinocoin {
 
@@ -353,6 +354,18 @@ public:
         return count;
     }
 
+    // Brings the state entries with some keys into memory ahead of
+    // reading them, and returns how many needed a node store read. This
+    // is only a hint: views which are not backed by the node store
+    // ignore it, and the keys need not exist. Views over another view
+    // pass it on without treating it as a read.
+    virtual
+    std::size_t
+    prefetch (std::vector<key_type> const& keys) const
+    {
+        return 0;
+    }
+
     // used by the implementation
     virtual
     std::unique_ptr<sles_type::iter_base>
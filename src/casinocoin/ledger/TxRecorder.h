@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_LEDGER_TXRECORDER_H_INCLUDED
+#define CASINOCOIN_LEDGER_TXRECORDER_H_INCLUDED
+
+#include <casinocoin/protocol/CSCAmount.h>
+#include <casinocoin/protocol/STLedgerEntry.h>
+#include <casinocoin/protocol/Serializer.h>
+#include <casinocoin/basics/base_uint.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace casinocoin {
+
+class OpenView;
+
+/** The state one transaction read and wrote in an open view.
+
+    The writes are the entries the transaction left behind. Applying
+    them to another view is equivalent to applying the transaction
+    again, as long as none of the keys it read or wrote differ there.
+*/
+struct TxFootprint
+{
+    enum class Write
+    {
+        erase,
+        insert,
+        replace
+    };
+
+    uint256 id;
+    std::shared_ptr<Serializer const> txn;
+    std::shared_ptr<Serializer const> meta;
+
+    /** Keys read before the transaction was inserted, sorted. */
+    std::vector<uint256> reads;
+
+    /** Whether a range of keys was walked, which reads can't capture. */
+    bool ranged = false;
+
+    std::vector<std::pair<Write, std::shared_ptr<SLE>>> writes;
+    CSCAmount destroyed = 0;
+    CSCAmount redistributed = 0;
+
+    /** Insert the transaction and its writes into a view. */
+    void
+    apply (OpenView& to) const;
+
+    /** Returns true if any key read or written is in `keys`. */
+    bool
+    touches (hash_set<uint256> const& keys) const;
+
+    /** Add the keys written to `keys`. */
+    void
+    addWrites (hash_set<uint256>& keys) const;
+};
+
+/** Records the footprint of each transaction inserted in an open view.
+
+    An OpenView with a recorder reports the keys it is asked for and
+    the changes made to it. Reads are attributed to the next inserted
+    transaction and writes to the last one, which matches how a
+    transaction is applied: its reads come first, then the insert and
+    its writes. Reads made for transactions which were not applied
+    only make the next footprint larger.
+
+    Changes which don't follow that pattern, such as a whole view
+    applied at once, leave the record incomplete.
+*/
+class TxRecorder
+{
+private:
+    std::vector<std::shared_ptr<TxFootprint const>> footprints_;
+    std::shared_ptr<TxFootprint> open_;
+    std::vector<uint256> reads_;
+    std::vector<uint256> expected_;
+    hash_set<uint256> unexpected_;
+    bool ranged_ = false;
+    bool complete_ = true;
+    bool replaying_ = false;
+
+public:
+    TxRecorder() = default;
+    TxRecorder (TxRecorder&&) = default;
+    TxRecorder& operator= (TxRecorder&&) = default;
+
+    // Called by OpenView
+
+    void
+    read (uint256 const& key);
+
+    void
+    range ();
+
+    void
+    insert (uint256 const& id,
+        std::shared_ptr<Serializer const> const& txn,
+            std::shared_ptr<Serializer const> const& meta);
+
+    void
+    write (TxFootprint::Write action, std::shared_ptr<SLE> const& sle);
+
+    void
+    destroy (CSCAmount const& drops);
+
+    void
+    redistribute (CSCAmount const& drops);
+
+    // Called by the owner of the view
+
+    /** Apply a footprint to the view and record it as is. */
+    void
+    replay (OpenView& to, std::shared_ptr<TxFootprint const> const& fp);
+
+    /** The footprint of the last inserted transaction, if still open. */
+    std::shared_ptr<TxFootprint const>
+    last () const
+    {
+        return open_;
+    }
+
+    /** Close the last footprint and forget reads not followed by an insert. */
+    void
+    finish ();
+
+    /** Add the footprints of another recorder, in order. */
+    void
+    append (TxRecorder&& other);
+
+    /** The footprints in insertion order, once finished. */
+    std::vector<std::shared_ptr<TxFootprint const>> const&
+    footprints () const
+    {
+        return footprints_;
+    }
+
+    /** Count the keys read which are not in a sorted set.
+
+        Used to find the reads a batch made which were not read
+        ahead for it. Reads while replaying are not counted.
+    */
+    void
+    expect (std::vector<uint256> keys)
+    {
+        expected_ = std::move (keys);
+    }
+
+    /** The number of distinct keys read which were not expected. */
+    std::size_t
+    unexpected () const
+    {
+        return unexpected_.size ();
+    }
+
+    /** Returns true if every change belongs to a footprint. */
+    bool
+    complete () const
+    {
+        return complete_;
+    }
+
+private:
+    void
+    close ();
+
+    TxFootprint*
+    writing ();
+};
+
+} // casinocoin
+
+#endif
@@ -192,6 +192,25 @@ bool areCompatible (ReadView const& validLedger, ReadView const& testLedger,
 bool areCompatible (uint256 const& validHash, LedgerIndex validIndex,
     ReadView const& testLedger, beast::Journal::Stream& s, const char* reason);
 
+/** Return the ledgers which follow an earlier ledger up to a later one.
+
+    The chain is found by following parent hashes back from `ledger`
+    to the ledger with `prevHash` and `prevSeq`, fetching the ledgers
+    in between with `getLedger`. Used to bring something kept for one
+    ledger up to date from the metadata of the ledgers since.
+
+    @return The ledgers after the earlier one, oldest first and ending
+            with `ledger`. Empty if `ledger` isn't a closed descendant
+            at most `maxGap` ledgers later, or if a ledger in between
+            can't be fetched.
+*/
+std::vector<std::shared_ptr<ReadView const>>
+ledgerChainSince (uint256 const& prevHash, LedgerIndex prevSeq,
+    std::shared_ptr<ReadView const> const& ledger,
+        std::function<std::shared_ptr<ReadView const> (
+            uint256 const&)> const& getLedger,
+                std::uint32_t maxGap);
+
 //------------------------------------------------------------------------------
 //
 // Modifiers
@@ -26,16 +26,24 @@
 #ifndef CASINOCOIN_LEDGER_APPLYSTATETABLE_H_INCLUDED
 #define CASINOCOIN_LEDGER_APPLYSTATETABLE_H_INCLUDED
 
+#include <casinocoin/ledger/MetaWriter.h>
 #include <casinocoin/ledger/OpenView.h>
 #include <casinocoin/ledger/RawView.h>
 #include <casinocoin/ledger/ReadView.h>
 #include <casinocoin/ledger/TxMeta.h>
+#include <casinocoin/protocol/LedgerFormats.h>
 #include <casinocoin/protocol/TER.h>
 #include <casinocoin/protocol/CSCAmount.h>
 #include <casinocoin/beast/utility/Journal.h>
+#include <boost/container/flat_map.hpp>
 #include <memory>
 
 namespace casinocoin {
+
+/** Counts of ledger entries, by entry type. */
+using EntryCounts = boost::container::flat_map<
+    LedgerEntryType, std::uint32_t>;
+
 namespace detail {
 
 // Helper class that buffers modifications
@@ -59,6 +67,7 @@ private:
     items_t items_;
     CSCAmount dropsDestroyed_ = 0;
     CSCAmount dropsRedistributed_ = 0;
+    EntryCounts* reads_ = nullptr;
 
 public:
     ApplyStateTable() = default;
@@ -97,6 +106,21 @@ public:
     std::size_t
     size () const;
 
+    /** Count the entries read from the base into `reads`.
+
+        Only reads which are not satisfied by this table are
+        counted. Pass nullptr to stop counting.
+    */
+    void
+    countReads (EntryCounts* reads)
+    {
+        reads_ = reads;
+    }
+
+    /** Add the entries this table writes to `writes`. */
+    void
+    countWrites (EntryCounts& writes) const;
+
     void
     visit (ReadView const& base,
         std::function <void (
@@ -143,12 +167,16 @@ public:
     }
 
 private:
+    void
+    countRead (Keylet const& k,
+        std::shared_ptr<SLE const> const& sle) const;
+
     using Mods = hash_map<key_type,
         std::shared_ptr<SLE>>;
 
     static
     void
-    threadItem (TxMeta& meta,
+    threadItem (MetaWriter& meta,
         std::shared_ptr<SLE> const& to);
 
     std::shared_ptr<SLE>
@@ -157,13 +185,13 @@ private:
             beast::Journal j);
 
     void
-    threadTx (ReadView const& base, TxMeta& meta,
+    threadTx (ReadView const& base, MetaWriter& meta,
         AccountID const& to, Mods& mods,
             beast::Journal j);
 
     void
     threadOwners (ReadView const& base,
-        TxMeta& meta, std::shared_ptr<
+        MetaWriter& meta, std::shared_ptr<
             SLE const> const& sle, Mods& mods,
                 beast::Journal j);
 };
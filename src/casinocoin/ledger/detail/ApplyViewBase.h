@@ -78,6 +78,9 @@ public:
     std::shared_ptr<SLE const>
     read (Keylet const& k) const override;
 
+    std::size_t
+    prefetch (std::vector<key_type> const& keys) const override;
+
     std::unique_ptr<sles_type::iter_base>
     slesBegin() const override;
 
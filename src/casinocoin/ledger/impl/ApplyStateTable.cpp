@@ -79,6 +79,23 @@ ApplyStateTable::size () const
     return ret;
 }
 
+void
+ApplyStateTable::countWrites (EntryCounts& writes) const
+{
+    for (auto& item : items_)
+    {
+        switch (item.second.first)
+        {
+        case Action::erase:
+        case Action::insert:
+        case Action::modify:
+            ++writes[item.second.second->getType()];
+        default:
+            break;
+        }
+    }
+}
+
 void
 ApplyStateTable::visit (ReadView const& to,
     std::function <void (
@@ -125,12 +142,11 @@ ApplyStateTable::apply (OpenView& to,
     std::shared_ptr<Serializer> sMeta;
     if (!to.open())
     {
-        TxMeta meta(j);
-        // VFALCO Shouldn't TxMeta ctor do this?
-        meta.init (tx.getTransactionID(), to.seq());
+        MetaWriter meta (tx.getTransactionID(), to.seq());
         if (deliver)
             meta.setDeliveredAmount(*deliver);
         Mods newMod;
+        std::vector<STBase const*> fields;
         for (auto& item : items_)
         {
             SField const* type;
@@ -158,12 +174,15 @@ ApplyStateTable::apply (OpenView& to,
                 ? curNode->getFieldU16 (sfLedgerEntryType)
                 : origNode->getFieldU16 (sfLedgerEntryType);
             meta.setAffectedNode (item.first, *type, nodeType);
+
+            // The fields of each inner object are serialized straight
+            // from the entries, rather than copied into an STObject
             if (type == &sfDeletedNode)
             {
                 assert (origNode && curNode);
                 threadOwners (to, meta, origNode, newMod, j);
 
-                STObject prevs (sfPreviousFields);
+                fields.clear ();
                 for (auto const& obj : *origNode)
                 {
                     // go through the original node for
@@ -171,23 +190,19 @@ ApplyStateTable::apply (OpenView& to,
                     if (obj.getFName().shouldMeta(
                             SField::sMD_ChangeOrig) &&
                                 ! curNode->hasMatchingEntry (obj))
-                        prevs.emplace_back (obj);
+                        fields.push_back (&obj);
                 }
+                meta.addObject (item.first, sfPreviousFields, fields);
 
-                if (!prevs.empty ())
-                    meta.getAffectedNode(item.first).emplace_back(std::move(prevs));
-
-                STObject finals (sfFinalFields);
+                fields.clear ();
                 for (auto const& obj : *curNode)
                 {
                     // go through the final node for final fields
                     if (obj.getFName().shouldMeta(
                             SField::sMD_Always | SField::sMD_DeleteFinal))
-                        finals.emplace_back (obj);
+                        fields.push_back (&obj);
                 }
-
-                if (!finals.empty ())
-                    meta.getAffectedNode (item.first).emplace_back (std::move(finals));
+                meta.addObject (item.first, sfFinalFields, fields);
             }
             else if (type == &sfModifiedNode)
             {
@@ -196,27 +211,23 @@ ApplyStateTable::apply (OpenView& to,
                 if (curNode->isThreadedType ()) // thread transaction to node item modified
                     threadItem (meta, curNode);
 
-                STObject prevs (sfPreviousFields);
+                fields.clear ();
                 for (auto const& obj : *origNode)
                 {
                     // search the original node for values saved on modify
                     if (obj.getFName ().shouldMeta (SField::sMD_ChangeOrig) && !curNode->hasMatchingEntry (obj))
-                        prevs.emplace_back (obj);
+                        fields.push_back (&obj);
                 }
+                meta.addObject (item.first, sfPreviousFields, fields);
 
-                if (!prevs.empty ())
-                    meta.getAffectedNode (item.first).emplace_back (std::move(prevs));
-
-                STObject finals (sfFinalFields);
+                fields.clear ();
                 for (auto const& obj : *curNode)
                 {
                     // search the final node for values saved always
                     if (obj.getFName ().shouldMeta (SField::sMD_Always | SField::sMD_ChangeNew))
-                        finals.emplace_back (obj);
+                        fields.push_back (&obj);
                 }
-
-                if (!finals.empty ())
-                    meta.getAffectedNode (item.first).emplace_back (std::move(finals));
+                meta.addObject (item.first, sfFinalFields, fields);
             }
             else if (type == &sfCreatedNode) // if created, thread to owner(s)
             {
@@ -226,18 +237,16 @@ ApplyStateTable::apply (OpenView& to,
                 if (curNode->isThreadedType ()) // always thread to self
                     threadItem (meta, curNode);
 
-                STObject news (sfNewFields);
+                fields.clear ();
                 for (auto const& obj : *curNode)
                 {
                     // save non-default values
                     if (!obj.isDefault () &&
                             obj.getFName().shouldMeta(
                                 SField::sMD_Create | SField::sMD_Always))
-                        news.emplace_back (obj);
+                        fields.push_back (&obj);
                 }
-
-                if (!news.empty ())
-                    meta.getAffectedNode (item.first).emplace_back (std::move(news));
+                meta.addObject (item.first, sfNewFields, fields);
             }
             else
             {
@@ -254,8 +263,12 @@ ApplyStateTable::apply (OpenView& to,
 
         // VFALCO For diagnostics do we want to show
         //        metadata even when the base view is open?
-        JLOG(j.trace()) <<
-            "metadata " << meta.getJson (0);
+        if (auto stream = j.trace())
+        {
+            SerialIter sit (sMeta->slice());
+            stream << "metadata " <<
+                STObject (sit, sfMetadata).getJson (0);
+        }
     }
     to.rawTxInsert(
         tx.getTransactionID(),
@@ -271,7 +284,13 @@ ApplyStateTable::exists (ReadView const& base,
 {
     auto const iter = items_.find(k.key);
     if (iter == items_.end())
-        return base.exists(k);
+    {
+        if (! reads_)
+            return base.exists(k);
+        auto const sle = base.read(k);
+        countRead(k, sle);
+        return sle != nullptr;
+    }
     auto const& item = iter->second;
     auto const& sle = item.second;
     switch (item.first)
@@ -332,7 +351,11 @@ ApplyStateTable::read (ReadView const& base,
 {
     auto const iter = items_.find(k.key);
     if (iter == items_.end())
-        return base.read(k);
+    {
+        auto sle = base.read(k);
+        countRead(k, sle);
+        return sle;
+    }
     auto const& item = iter->second;
     auto const& sle = item.second;
     switch (item.first)
@@ -358,6 +381,7 @@ ApplyStateTable::peek (ReadView const& base,
         iter->first != k.key)
     {
         auto const sle = base.read(k);
+        countRead(k, sle);
         if (! sle)
             return nullptr;
         // Make our own copy
@@ -542,7 +566,7 @@ void ApplyStateTable::redistributeCSC(const CSCAmount &dropsRedistributed)
 
 // Insert this transaction to the SLE's threading list
 void
-ApplyStateTable::threadItem (TxMeta& meta,
+ApplyStateTable::threadItem (MetaWriter& meta,
     std::shared_ptr<SLE> const& sle)
 {
     key_type prevTxID;
@@ -552,8 +576,7 @@ ApplyStateTable::threadItem (TxMeta& meta,
         return;
     if (prevTxID.isZero())
         return;
-    TxMeta::thread(meta.getAffectedNode(
-        sle, sfModifiedNode), prevTxID, prevLgrID);
+    meta.thread(sle, prevTxID, prevLgrID);
 }
 
 std::shared_ptr<SLE>
@@ -589,6 +612,7 @@ ApplyStateTable::getForMod (ReadView const& base,
         }
     }
     auto c = base.read (keylet::unchecked (key));
+    countRead (keylet::unchecked (key), c);
     if (! c)
     {
         // VFALCO We need to think about throwing
@@ -602,9 +626,17 @@ ApplyStateTable::getForMod (ReadView const& base,
     return sle;
 }
 
+void
+ApplyStateTable::countRead (Keylet const& k,
+    std::shared_ptr<SLE const> const& sle) const
+{
+    if (reads_)
+        ++(*reads_)[sle ? sle->getType() : k.type];
+}
+
 void
 ApplyStateTable::threadTx (ReadView const& base,
-    TxMeta& meta, AccountID const& to,
+    MetaWriter& meta, AccountID const& to,
         Mods& mods, beast::Journal j)
 {
     auto const sle = getForMod(base,
@@ -624,7 +656,7 @@ ApplyStateTable::threadTx (ReadView const& base,
 
 void
 ApplyStateTable::threadOwners (ReadView const& base,
-    TxMeta& meta, std::shared_ptr<
+    MetaWriter& meta, std::shared_ptr<
         SLE const> const& sle, Mods& mods,
             beast::Journal j)
 {
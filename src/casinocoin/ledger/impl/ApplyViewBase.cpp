@@ -89,6 +89,12 @@ ApplyViewBase::read (Keylet const& k) const
     return items_.read(*base_, k);
 }
 
+std::size_t
+ApplyViewBase::prefetch (std::vector<key_type> const& keys) const
+{
+    return base_->prefetch(keys);
+}
+
 auto
 ApplyViewBase::slesBegin() const ->
     std::unique_ptr<sles_type::iter_base>
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/ledger/MetaWriter.h>
+#include <casinocoin/protocol/STArray.h>
+#include <algorithm>
+#include <cassert>
+
+namespace casinocoin {
+
+MetaWriter::Node&
+MetaWriter::node (uint256 const& key, SField const& type,
+    std::uint16_t nodeType)
+{
+    auto iter = nodes_.find (key);
+    if (iter == nodes_.end ())
+    {
+        iter = nodes_.emplace (key, Node ()).first;
+        iter->second.type = &type;
+        iter->second.entryType = nodeType;
+    }
+    return iter->second;
+}
+
+void
+MetaWriter::setAffectedNode (uint256 const& key, SField const& type,
+    std::uint16_t nodeType)
+{
+    auto& n = node (key, type, nodeType);
+    n.type = &type;
+    n.entryType = nodeType;
+}
+
+bool
+MetaWriter::thread (std::shared_ptr<SLE const> const& sle,
+    uint256 const& prevTxID, std::uint32_t prevLgrID)
+{
+    auto& n = node (sle->key (), sfModifiedNode,
+        sle->getFieldU16 (sfLedgerEntryType));
+    if (n.threaded)
+    {
+        assert (n.prevTxID == prevTxID);
+        assert (n.prevLgrID == prevLgrID);
+        return false;
+    }
+    n.threaded = true;
+    n.prevTxID = prevTxID;
+    n.prevLgrID = prevLgrID;
+    return true;
+}
+
+void
+MetaWriter::addObject (uint256 const& key, SField const& name,
+    std::vector<STBase const*> const& fields)
+{
+    if (fields.empty ())
+        return;
+
+    auto iter = nodes_.find (key);
+    assert (iter != nodes_.end ());
+    if (iter == nodes_.end ())
+        return;
+
+    // Fields are written in field code order, leaving out those which
+    // STObject::add would
+    std::vector<STBase const*> sorted;
+    sorted.reserve (fields.size ());
+    for (auto const field : fields)
+    {
+        if (field->getSType () != STI_NOTPRESENT &&
+                field->getFName ().shouldInclude (true))
+            sorted.push_back (field);
+    }
+    std::sort (sorted.begin (), sorted.end (),
+        [](STBase const* a, STBase const* b)
+        {
+            return a->getFName ().fieldCode < b->getFName ().fieldCode;
+        });
+
+    scratch_.erase ();
+    scratch_.addFieldID (name.fieldType, name.fieldValue);
+    for (auto const field : sorted)
+    {
+        field->addFieldID (scratch_);
+        field->add (scratch_);
+        if (dynamic_cast<STArray const*> (field) != nullptr)
+            scratch_.addFieldID (STI_ARRAY, 1);
+        else if (dynamic_cast<STObject const*> (field) != nullptr)
+            scratch_.addFieldID (STI_OBJECT, 1);
+    }
+    scratch_.addFieldID (STI_OBJECT, 1);
+
+    // Callers add at most one of each object to a node, in field order
+    auto& objects = iter->second.objects;
+    objects.insert (objects.end (), scratch_.begin (), scratch_.end ());
+}
+
+void
+MetaWriter::addRaw (Serializer& s, TER result, std::uint32_t index) const
+{
+    auto const code = static_cast<int> (result);
+    assert ((code == 0) || ((code > 100) && (code <= 255)));
+
+    // The fields of the metadata and of a node, in field code order
+    s.addFieldID (sfTransactionIndex.fieldType, sfTransactionIndex.fieldValue);
+    s.add32 (index);
+
+    if (delivered_)
+    {
+        s.addFieldID (sfDeliveredAmount.fieldType,
+            sfDeliveredAmount.fieldValue);
+        delivered_->add (s);
+    }
+
+    s.addFieldID (sfAffectedNodes.fieldType, sfAffectedNodes.fieldValue);
+    for (auto const& item : nodes_)
+    {
+        auto const& n = item.second;
+        s.addFieldID (n.type->fieldType, n.type->fieldValue);
+
+        s.addFieldID (sfLedgerEntryType.fieldType,
+            sfLedgerEntryType.fieldValue);
+        s.add16 (n.entryType);
+
+        if (n.threaded)
+        {
+            s.addFieldID (sfPreviousTxnLgrSeq.fieldType,
+                sfPreviousTxnLgrSeq.fieldValue);
+            s.add32 (n.prevLgrID);
+            s.addFieldID (sfPreviousTxnID.fieldType,
+                sfPreviousTxnID.fieldValue);
+            s.add256 (n.prevTxID);
+        }
+
+        s.addFieldID (sfLedgerIndex.fieldType, sfLedgerIndex.fieldValue);
+        s.add256 (item.first);
+
+        s.addRaw (n.objects);
+        s.addFieldID (STI_OBJECT, 1);
+    }
+    s.addFieldID (STI_ARRAY, 1);
+
+    s.addFieldID (sfTransactionResult.fieldType,
+        sfTransactionResult.fieldValue);
+    s.add8 (static_cast<unsigned char> (code));
+}
+
+} // casinocoin
@@ -25,6 +25,7 @@
 
 #include <BeastConfig.h>
 #include <casinocoin/ledger/OpenView.h>
+#include <casinocoin/ledger/TxRecorder.h>
 #include <casinocoin/basics/contract.h>
 
 namespace casinocoin {
@@ -92,6 +93,19 @@ public:
 
 //------------------------------------------------------------------------------
 
+OpenView::OpenView (OpenView const& other)
+    : ReadView (other)
+    , TxsRawView (other)
+    , rules_ (other.rules_)
+    , txs_ (other.txs_)
+    , info_ (other.info_)
+    , base_ (other.base_)
+    , items_ (other.items_)
+    , hold_ (other.hold_)
+    , open_ (other.open_)
+{
+}
+
 OpenView::OpenView (open_ledger_t,
     ReadView const* base, Rules const& rules,
         std::shared_ptr<void const> hold)
@@ -161,6 +175,8 @@ const LedgerConfig &OpenView::ledgerConfig() const
 bool
 OpenView::exists (Keylet const& k) const
 {
+    if (recorder_)
+        recorder_->read(k.key);
     return items_.exists(*base_, k);
 }
 
@@ -169,19 +185,31 @@ OpenView::succ (key_type const& key,
     boost::optional<key_type> const& last) const ->
         boost::optional<key_type>
 {
+    if (recorder_)
+        recorder_->range();
     return items_.succ(*base_, key, last);
 }
 
 std::shared_ptr<SLE const>
 OpenView::read (Keylet const& k) const
 {
+    if (recorder_)
+        recorder_->read(k.key);
     return items_.read(*base_, k);
 }
 
+std::size_t
+OpenView::prefetch (std::vector<key_type> const& keys) const
+{
+    return base_->prefetch(keys);
+}
+
 auto
 OpenView::slesBegin() const ->
     std::unique_ptr<sles_type::iter_base>
 {
+    if (recorder_)
+        recorder_->range();
     return items_.slesBegin(*base_);
 }
 
@@ -196,6 +224,8 @@ auto
 OpenView::slesUpperBound(uint256 const& key) const ->
     std::unique_ptr<sles_type::iter_base>
 {
+    if (recorder_)
+        recorder_->range();
     return items_.slesUpperBound(*base_, key);
 }
 
@@ -247,6 +277,8 @@ void
 OpenView::rawErase(
     std::shared_ptr<SLE> const& sle)
 {
+    if (recorder_)
+        recorder_->write(TxFootprint::Write::erase, sle);
     items_.erase(sle);
 }
 
@@ -254,6 +286,8 @@ void
 OpenView::rawInsert(
     std::shared_ptr<SLE> const& sle)
 {
+    if (recorder_)
+        recorder_->write(TxFootprint::Write::insert, sle);
     items_.insert(sle);
 }
 
@@ -261,6 +295,8 @@ void
 OpenView::rawReplace(
     std::shared_ptr<SLE> const& sle)
 {
+    if (recorder_)
+        recorder_->write(TxFootprint::Write::replace, sle);
     items_.replace(sle);
 }
 
@@ -268,6 +304,8 @@ void
 OpenView::rawDestroyCSC(
     CSCAmount const& fee)
 {
+    if (recorder_)
+        recorder_->destroy(fee);
     items_.destroyCSC(fee);
     // VFALCO Deduct from info_.totalDrops ?
     //        What about child views?
@@ -275,6 +313,8 @@ OpenView::rawDestroyCSC(
 
 void OpenView::rawRedistributeCSC(const CSCAmount &dropsRedistributed)
 {
+    if (recorder_)
+        recorder_->redistribute(dropsRedistributed);
     items_.redistributeCSC(dropsRedistributed);
     // jrojek. possibly above comment from VFALCO applies also here
 }
@@ -293,6 +333,8 @@ OpenView::rawTxInsert (key_type const& key,
     if (! result.second)
         LogicError("rawTxInsert: duplicate TX id" +
             to_string(key));
+    if (recorder_)
+        recorder_->insert(key, txn, metaData);
 }
 
 } // casinocoin
@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/ledger/TxRecorder.h>
+#include <casinocoin/ledger/OpenView.h>
+#include <algorithm>
+
+namespace casinocoin {
+
+void
+TxFootprint::apply (OpenView& to) const
+{
+    to.rawTxInsert (id, txn, meta);
+    to.rawDestroyCSC (destroyed);
+    to.rawRedistributeCSC (redistributed);
+    for (auto const& w : writes)
+    {
+        switch (w.first)
+        {
+        case Write::erase:
+            to.rawErase (w.second);
+            break;
+        case Write::insert:
+            to.rawInsert (w.second);
+            break;
+        case Write::replace:
+            to.rawReplace (w.second);
+            break;
+        }
+    }
+}
+
+bool
+TxFootprint::touches (hash_set<uint256> const& keys) const
+{
+    if (keys.empty ())
+        return false;
+    for (auto const& key : reads)
+        if (keys.count (key))
+            return true;
+    for (auto const& w : writes)
+        if (keys.count (w.second->key ()))
+            return true;
+    return false;
+}
+
+void
+TxFootprint::addWrites (hash_set<uint256>& keys) const
+{
+    for (auto const& w : writes)
+        keys.insert (w.second->key ());
+}
+
+//------------------------------------------------------------------------------
+
+void
+TxRecorder::read (uint256 const& key)
+{
+    if (replaying_)
+        return;
+    close ();
+    reads_.push_back (key);
+    if (! expected_.empty () &&
+            ! std::binary_search (expected_.begin (), expected_.end (), key))
+        unexpected_.insert (key);
+}
+
+void
+TxRecorder::range ()
+{
+    if (replaying_)
+        return;
+    close ();
+    ranged_ = true;
+}
+
+void
+TxRecorder::insert (uint256 const& id,
+    std::shared_ptr<Serializer const> const& txn,
+        std::shared_ptr<Serializer const> const& meta)
+{
+    if (replaying_)
+        return;
+    close ();
+    open_ = std::make_shared<TxFootprint> ();
+    open_->id = id;
+    open_->txn = txn;
+    open_->meta = meta;
+    std::sort (reads_.begin (), reads_.end ());
+    reads_.erase (std::unique (reads_.begin (), reads_.end ()), reads_.end ());
+    open_->reads = std::move (reads_);
+    open_->ranged = ranged_;
+    reads_.clear ();
+    ranged_ = false;
+}
+
+void
+TxRecorder::write (TxFootprint::Write action, std::shared_ptr<SLE> const& sle)
+{
+    if (auto const fp = writing ())
+        fp->writes.emplace_back (action, sle);
+}
+
+void
+TxRecorder::destroy (CSCAmount const& drops)
+{
+    if (auto const fp = writing ())
+        fp->destroyed += drops;
+}
+
+void
+TxRecorder::redistribute (CSCAmount const& drops)
+{
+    if (auto const fp = writing ())
+        fp->redistributed += drops;
+}
+
+void
+TxRecorder::replay (OpenView& to, std::shared_ptr<TxFootprint const> const& fp)
+{
+    close ();
+    replaying_ = true;
+    try
+    {
+        fp->apply (to);
+    }
+    catch (...)
+    {
+        replaying_ = false;
+        complete_ = false;
+        throw;
+    }
+    replaying_ = false;
+    footprints_.push_back (fp);
+}
+
+void
+TxRecorder::finish ()
+{
+    close ();
+    reads_.clear ();
+    ranged_ = false;
+}
+
+void
+TxRecorder::append (TxRecorder&& other)
+{
+    finish ();
+    other.finish ();
+    footprints_.insert (footprints_.end (),
+        std::make_move_iterator (other.footprints_.begin ()),
+            std::make_move_iterator (other.footprints_.end ()));
+    complete_ = complete_ && other.complete_;
+}
+
+void
+TxRecorder::close ()
+{
+    if (open_)
+        footprints_.push_back (std::move (open_));
+    open_.reset ();
+}
+
+TxFootprint*
+TxRecorder::writing ()
+{
+    if (replaying_)
+        return nullptr;
+    // A change that doesn't follow an insert can't be attributed
+    if (! open_)
+        complete_ = false;
+    return open_.get ();
+}
+
+} // casinocoin
@@ -552,6 +552,33 @@ bool areCompatible (uint256 const& validHash, LedgerIndex validIndex,
     return ret;
 }
 
+std::vector<std::shared_ptr<ReadView const>>
+ledgerChainSince (uint256 const& prevHash, LedgerIndex prevSeq,
+    std::shared_ptr<ReadView const> const& ledger,
+        std::function<std::shared_ptr<ReadView const> (
+            uint256 const&)> const& getLedger,
+                std::uint32_t maxGap)
+{
+    std::vector<std::shared_ptr<ReadView const>> chain;
+    if (! ledger || ledger->open () || ledger->info ().seq <= prevSeq ||
+            ledger->info ().seq - prevSeq > maxGap)
+        return chain;
+
+    // Newest first while walking back
+    chain.push_back (ledger);
+    while (chain.back ()->info ().parentHash != prevHash)
+    {
+        auto parent = (chain.back ()->info ().seq > prevSeq + 1 &&
+            getLedger) ? getLedger (chain.back ()->info ().parentHash) :
+                nullptr;
+        if (! parent || parent->info ().seq + 1 != chain.back ()->info ().seq)
+            return {};
+        chain.push_back (std::move (parent));
+    }
+    std::reverse (chain.begin (), chain.end ());
+    return chain;
+}
+
 bool
 dirIsEmpty (ReadView const& view,
     Keylet const& k)
@@ -171,6 +171,23 @@ private:
         return v;
     }
 
+    // apply_profile [enable|disable|reset]
+    Json::Value parseApplyProfile (Json::Value const& jvParams)
+    {
+        Json::Value     jvRequest (Json::objectValue);
+
+        if (jvParams.size () != 0)
+        {
+            auto const action = jvParams[0u].asString ();
+            if (action != jss::enable && action != jss::disable &&
+                    action != jss::reset)
+                return rpcError (rpcINVALID_PARAMS);
+            jvRequest[action] = true;
+        }
+
+        return jvRequest;
+    }
+
     // fetch_info [clear]
     Json::Value parseFetchInfo (Json::Value const& jvParams)
     {
@@ -1124,6 +1141,7 @@ public:
             {   "account_objects",      &RPCParser::parseAccountItems,          1,  5   },
             {   "account_offers",       &RPCParser::parseAccountItems,          1,  4   },
             {   "account_tx",           &RPCParser::parseAccountTransactions,   1,  8   },
+            {   "apply_profile",        &RPCParser::parseApplyProfile,          0,  1   },
             {   "book_offers",          &RPCParser::parseBookOffers,            2,  7   },
             {   "can_delete",           &RPCParser::parseCanDelete,             0,  1   },
             {   "channel_authorize",    &RPCParser::parseChannelAuthorize,      3,  3   },
@@ -157,6 +157,8 @@ public:
      */
     virtual std::uint32_t getStoreCount () const = 0;
     virtual std::uint32_t getFetchTotalCount () const = 0;
+    /** Return the reads from the backend made by the calling thread. */
+    virtual std::uint32_t getFetchThreadCount () const = 0;
     virtual std::uint32_t getFetchHitCount () const = 0;
     virtual std::uint32_t getStoreSize () const = 0;
     virtual std::uint32_t getFetchSize () const = 0;
@@ -111,6 +111,14 @@ private:
     Blob mData;
 };
 
+/** The bytes a NodeObject is charged for in a TaggedCache. */
+inline
+std::size_t
+cachedBytes (NodeObject const& object)
+{
+    return sizeof (object) + object.getData ().size ();
+}
+
 }
 
 #endif
@@ -66,6 +66,13 @@ private:
     std::atomic <std::uint32_t> m_storeSize;
     std::atomic <std::uint32_t> m_fetchSize;
 
+    // Backend reads made by this thread, shared by every database
+    static std::uint32_t& threadFetchCount ()
+    {
+        static thread_local std::uint32_t count = 0;
+        return count;
+    }
+
 public:
     DatabaseImp (std::string const& name,
                  Scheduler& scheduler,
@@ -202,6 +209,7 @@ public:
             //
             obj = fetchFrom (hash);
             ++m_fetchTotalCount;
+            ++threadFetchCount ();
         }
 
         if (obj == nullptr)
@@ -415,6 +423,11 @@ public:
         return m_fetchTotalCount;
     }
 
+    std::uint32_t getFetchThreadCount () const override
+    {
+        return threadFetchCount ();
+    }
+
     std::uint32_t getFetchHitCount () const override
     {
         return m_fetchHitCount;
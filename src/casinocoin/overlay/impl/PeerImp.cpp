@@ -32,6 +32,7 @@
 #include <casinocoin/app/misc/HashRouter.h>
 #include <casinocoin/app/misc/LoadFeeTrack.h>
 #include <casinocoin/app/misc/NetworkOPs.h>
+#include <casinocoin/app/misc/SigVerifier.h>
 #include <casinocoin/app/misc/Transaction.h>
 #include <casinocoin/app/misc/Validations.h>
 #include <casinocoin/app/misc/ValidatorList.h>
@@ -55,6 +56,7 @@
 #include <casinocoin/protocol/JsonFields.h>
 #include <casinocoin/protocol/tokens.h>
 #include <casinocoin/protocol/digest.h>
+#include <casinocoin/protocol/Feature.h>
 #include <casinocoin/protocol/PublicKey.h>
 #include <casinocoin/resource/Fees.h>
 #include <casinocoin/rpc/ServerHandler.h>
@@ -1138,6 +1140,46 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMTransaction> const& m)
         {
             JLOG(p_journal_.trace()) << "No new transactions until synchronized";
         }
+        else if (checkSignature &&
+            stx->getTxnType() != ttCRN_ROUND &&
+            stx->getTxnType() != ttCONFIG)
+        {
+            // Check the signature together with other incoming
+            // transactions, then hand off to the job queue. The
+            // verdict is left in the HashRouter for checkTransaction.
+            auto const rules = app_.getLedgerMaster().getValidatedRules();
+            app_.getSigVerifier().verify (stx,
+                rules.enabled(featureMultiSign),
+                [weak = std::weak_ptr<PeerImp>(shared_from_this()),
+                flags, stx, &app = app_] (bool valid,
+                    std::string const& reason)
+                {
+                    auto peer = weak.lock();
+                    if (! valid)
+                    {
+                        app.getHashRouter().setFlags(
+                            stx->getTransactionID(), SF_BAD);
+                        if (peer)
+                        {
+                            JLOG(peer->p_journal_.trace()) <<
+                                "Exception checking transaction: " <<
+                                    reason;
+                            peer->charge(Resource::feeInvalidSignature);
+                        }
+                        return;
+                    }
+                    forceValidity(app.getHashRouter(),
+                        stx->getTransactionID(), Validity::SigGoodOnly);
+                    if (! peer)
+                        return;
+                    app.getJobQueue ().addJob (
+                        jtTRANSACTION, "recvTransaction->checkTransaction",
+                        [weak, flags, stx] (Job&) {
+                            if (auto peer = weak.lock())
+                                peer->checkTransaction(flags, true, stx);
+                        });
+                });
+        }
         else
         {
             app_.getJobQueue ().addJob (
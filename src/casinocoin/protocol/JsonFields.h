@@ -85,6 +85,7 @@ JSS ( action );
 JSS ( activated );                  // in/out: ConfigObject, CRN_Settings
 JSS ( acquiring );                  // out: LedgerRequest
 JSS ( address );                    // out: PeerImp
+JSS ( admit_scale );                // out: GetCounts
 JSS ( affected );                   // out: AcceptedLedgerTx
 JSS ( age );                        // out: NetworkOPs, Peers
 JSS ( alternatives );               // out: PathRequest, CasinocoinPathFind
@@ -92,6 +93,11 @@ JSS ( amendment_blocked );          // out: NetworkOPs
 JSS ( amendments );                 // in: AccountObjects, out: NetworkOPs
 JSS ( amount );                     // out: AccountChannels
 JSS ( apiEndpoint );                // out: Configuration
+JSS ( apply );                      // out: ApplyProfile
+JSS ( apply_prefetch_keys );        // out: GetCounts
+JSS ( apply_prefetch_misses );      // out: GetCounts
+JSS ( apply_prefetch_reads );       // out: GetCounts
+JSS ( apply_us );                   // out: LedgerReplayer
 JSS ( asks );                       // out: Subscribe
 JSS ( assets );                     // out: GatewayBalances
 JSS ( authorized );                 // out: AccountLines
@@ -102,6 +108,8 @@ JSS ( balances );                   // out: GatewayBalances
 JSS ( base );                       // out: LogLevel
 JSS ( base_fee );                   // out: NetworkOPs
 JSS ( base_fee_csc );               // out: NetworkOPs
+JSS ( base_ledger_index );          // in: LedgerData
+JSS ( batch_size );                 // out: GetCounts
 JSS ( bids );                       // out: Subscribe
 JSS ( binary );                     // in: AccountTX, LedgerEntry,
                                     //     AccountTxOld, Tx LedgerData
@@ -111,6 +119,7 @@ JSS ( both_sides );                 // in: Subscribe, Unsubscribe
 JSS ( build_path );                 // in: TransactionSign
 JSS ( build_version );              // out: NetworkOPs
 JSS ( cancel_after );               // out: AccountChannels
+JSS ( cancelled );                  // out: GetCounts
 JSS ( can_delete );                 // out: CanDelete
 JSS ( channel_id );                 // out: AccountChannels
 JSS ( channels );                   // out: AccountChannels
@@ -123,6 +132,7 @@ JSS ( close_time_estimated );       // in: Application, out: LedgerToJson
 JSS ( close_time_human );           // out: LedgerToJson
 JSS ( close_time_offset );          // out: NetworkOPs
 JSS ( close_time_resolution );      // in: Application; out: LedgerToJson
+JSS ( close_us );                   // out: LedgerReplayer
 JSS ( closed );                     // out: NetworkOPs, LedgerToJson,
                                     //      handlers/Ledger
 JSS ( closed_ledger );              // out: NetworkOPs
@@ -131,6 +141,7 @@ JSS ( code );                       // out: errors
 JSS ( command );                    // in: RPCHandler
 JSS ( complete );                   // out: NetworkOPs, InboundLedger
 JSS ( complete_ledgers );           // out: NetworkOPs, PeerImp
+JSS ( completed );                  // out: GetCounts
 JSS ( configuration );              // out: RPCHandler
 JSS ( consensus );                  // out: NetworkOPs, LedgerConsensus
 JSS ( contactEmail );              // in/out: Configuration
@@ -172,7 +183,9 @@ JSS ( date );                       // out: tx/Transaction, NetworkOPs
 JSS ( dbKBLedger );                 // out: getCounts
 JSS ( dbKBTotal );                  // out: getCounts
 JSS ( dbKBTransaction );            // out: getCounts
+JSS ( deadline_ms );                // out: GetCounts
 JSS ( debug_signing );              // in: TransactionSign
+JSS ( deleted );                    // out: LedgerData
 JSS ( delivered_amount );           // out: addPaymentDeliveredAmount
 JSS ( deprecated );                 // out: WalletSeed
 JSS ( descending );                 // in: AccountTx*
@@ -183,18 +196,23 @@ JSS ( destination_currencies );     // in: PathRequest, CasinocoinPathFind
 JSS ( dest_public_key_hex );        // in: EncryptMsgHandler
 JSS ( destination_tag );            // in: PathRequest
                                     // out: AccountChannels
+JSS ( differences );                // out: LedgerReplayer
 JSS ( dir_entry );                  // out: DirectoryEntryIterator
 JSS ( dir_index );                  // out: DirectoryEntryIterator
 JSS ( dir_root );                   // out: DirectoryEntryIterator
 JSS ( directory );                  // in: LedgerEntry
+JSS ( disable );                    // in: ApplyProfile
+JSS ( dropped );                    // out: GetCounts
 JSS ( drops );                      // out: TxQ
 JSS ( duration_us );                // out: NetworkOPs
 JSS ( duration_sec );               // out: Peers
+JSS ( enable );                     // in: ApplyProfile
 JSS ( enabled );                    // out: AmendmentTable
 JSS ( encrypted_message );          // out: EncryptMsgHandler
 JSS ( engine_result );              // out: NetworkOPs, TransactionSign, Submit
 JSS ( engine_result_code );         // out: NetworkOPs, TransactionSign, Submit
 JSS ( engine_result_message );      // out: NetworkOPs, TransactionSign, Submit
+JSS ( entries );                    // out: ApplyProfile
 JSS ( error );                      // out: error
 JSS ( error_code );                 // out: error
 JSS ( error_exception );            // out: Submit
@@ -215,6 +233,7 @@ JSS ( fee_level );                  // out: AccountInfo
 JSS ( fee_mult_max );               // in: TransactionSign
 JSS ( fee_ref );                    // out: NetworkOPs
 JSS ( fetch_pack );                 // out: NetworkOPs
+JSS ( fetches );                    // out: ApplyProfile
 JSS ( first );                      // out: rpc/Version
 JSS ( fix_txns );                   // in: LedgerCleaner
 JSS ( flags );                      // out: paths/Node, AccountOffers,
@@ -228,7 +247,9 @@ JSS ( frozen_balances );            // out: GatewayBalances
 JSS ( full );                       // in: LedgerClearer, handlers/Ledger
 JSS ( fullName );                   // out: Configuration
 JSS ( full_reply );                 // out: PathFind
-JSS ( fullbelow_size );             // in: GetCounts
+JSS ( fullbelow_pending );          // out: GetCounts
+JSS ( fullbelow_restored );         // out: GetCounts
+JSS ( fullbelow_size );             // out: GetCounts
 JSS ( generator );                  // in: LedgerEntry
 JSS ( good );                       // out: RPCVersion
 JSS ( hash );                       // out: NetworkOPs, InboundLedger,
@@ -265,6 +286,7 @@ JSS ( last );                       // out: RPCVersion
 JSS ( last_close );                 // out: NetworkOPs
 JSS ( last_refresh_time );          // out: CRN Update Sites, Remote Update Sites
 JSS ( last_refresh_status );        // out: CRN Update Sites, Remote Update Sites
+JSS ( latency_us );                 // out: GetCounts
 JSS ( ledger );                     // in: NetworkOPs, LedgerCleaner,
                                     //     RPCHelpers
                                     // out: NetworkOPs, PeerImp
@@ -283,6 +305,7 @@ JSS ( ledger_index_min );           // in, out: AccountTx*
 JSS ( ledger_max );                 // in, out: AccountTx*
 JSS ( ledger_min );                 // in, out: AccountTx*
 JSS ( ledger_time );                // out: NetworkOPs
+JSS ( ledgers );                    // out: LedgerReplayer
 JSS ( levels );                     // LogLevels
 JSS ( limit );                      // in/out: AccountTx*, AccountOffers,
                                     //         AccountLines, AccountObjects
@@ -300,6 +323,7 @@ JSS ( load_factor_local );          // out: NetworkOPs
 JSS ( load_factor_net );            // out: NetworkOPs
 JSS ( load_factor_server );         // out: NetworkOPs
 JSS ( load_fee );                   // out: LoadFeeTrackImp, NetworkOPs
+JSS ( load_us );                    // out: LedgerReplayer
 JSS ( local );                      // out: resource/Logic.h
 JSS ( local_txs );                  // out: GetCounts
 JSS ( lowest_sequence );            // out: AccountInfo
@@ -312,6 +336,7 @@ JSS ( master_key );                 // out: WalletPropose
 JSS ( master_seed );                // out: WalletPropose
 JSS ( master_seed_hex );            // out: WalletPropose
 JSS ( master_signature );           // out: pubManifest
+JSS ( matched );                    // out: LedgerReplayer
 JSS ( max_ledger );                 // in/out: LedgerCleaner
 JSS ( max_queue_size );             // out: TxQ
 JSS ( max_spend_drops );            // out: AccountInfo
@@ -327,6 +352,7 @@ JSS ( min_count );                  // in: GetCounts
 JSS ( min_ledger );                 // in: LedgerCleaner
 JSS ( minimum_fee );                // out: TxQ
 JSS ( minimum_level );              // out: TxQ
+JSS ( mismatched );                 // out: LedgerReplayer
 JSS ( missingCommand );             // error or Message to encrypt
 JSS ( name );                       // out: AmendmentTableImpl, PeerImp
 JSS ( needed_state_hashes );        // out: InboundLedger
@@ -349,16 +375,22 @@ JSS ( offers );                     // out: NetworkOPs, AccountOffers, Subscribe
 JSS ( offline );                    // in: TransactionSign
 JSS ( offset );                     // in/out: AccountTxOld
 JSS ( open );                       // out: handlers/Ledger
+JSS ( open_carried );               // out: GetCounts
 JSS ( open_ledger_fee );            // out: TxQ
 JSS ( open_ledger_level );          // out: TxQ
+JSS ( open_reapplied );             // out: GetCounts
+JSS ( open_rebuild_time );          // out: GetCounts
 JSS ( owner );                      // in: LedgerEntry, out: NetworkOPs
 JSS ( owner_funds );                // in/out: Ledger, NetworkOPs, AcceptedLedgerTx
+JSS ( p99_us );                     // out: GetCounts
 JSS ( params );                     // RPC
 JSS ( parent_close_time );          // out: LedgerToJson
 JSS ( parent_hash );                // out: LedgerToJson
+JSS ( partial );                    // out: GetCounts
 JSS ( partition );                  // in: LogLevel
 JSS ( passphrase );                 // in: WalletPropose
 JSS ( password );                   // in: Subscribe
+JSS ( path_requests );              // out: GetCounts
 JSS ( paths );                      // in: CasinocoinPathFind
 JSS ( paths_canonical );            // out: CasinocoinPathFind
 JSS ( paths_computed );             // out: PathRequest, CasinocoinPathFind
@@ -368,7 +400,10 @@ JSS ( peer_authorized );            // out: AccountLines
 JSS ( peer_id );                    // out: CCLCxPeerPos
 JSS ( peers );                      // out: InboundLedger, handlers/Peers, Overlay
 JSS ( port );                       // in: Connect
+JSS ( preclaim );                   // out: ApplyProfile
+JSS ( preflight );                  // out: ApplyProfile
 JSS ( previous_ledger );            // out: LedgerPropose
+JSS ( profile );                    // out: LedgerReplayer
 JSS ( proof );                      // in: BookOffers
 JSS ( propose_seq );                // out: LedgerPropose
 JSS ( proposers );                  // out: NetworkOPs, LedgerConsensus
@@ -383,8 +418,10 @@ JSS ( quality_in );                 // out: AccountLines
 JSS ( quality_out );                // out: AccountLines
 JSS ( queue );                      // in: AccountInfo
 JSS ( queue_data );                 // out: AccountInfo
+JSS ( queued );                     // out: GetCounts
 JSS ( random );                     // out: Random
 JSS ( raw_meta );                   // out: AcceptedLedgerTx
+JSS ( reads );                      // out: ApplyProfile
 JSS ( receive_currencies );         // out: AccountCurrencies
 JSS ( reference_level );            // out: TxQ
 JSS ( refresh_interval_min );       // CRN Update Sites, Remote Update Sites
@@ -395,8 +432,10 @@ JSS ( reserve_base );               // out: NetworkOPs
 JSS ( reserve_base_csc );           // out: NetworkOPs
 JSS ( reserve_inc );                // out: NetworkOPs
 JSS ( reserve_inc_csc );            // out: NetworkOPs
+JSS ( reset );                      // in: ApplyProfile
 JSS ( response );                   // websocket
 JSS ( result );                     // RPC
+JSS ( running );                    // out: GetCounts
 JSS ( casinocoin_lines );               // out: NetworkOPs
 JSS ( casinocoin_state );               // in: LedgerEntr
 JSS ( casinocoinrpc );                  // casinocoin RPC version
@@ -452,6 +491,7 @@ JSS ( taker_gets );                 // in: Subscribe, Unsubscribe, BookOffers
 JSS ( taker_gets_funded );          // out: NetworkOPs
 JSS ( taker_pays );                 // in: Subscribe, Unsubscribe, BookOffers
 JSS ( taker_pays_funded );          // out: NetworkOPs
+JSS ( target_latency_ms );          // out: GetCounts
 JSS ( threshold );                  // in: Blacklist
 JSS ( ticket );                     // in: AccountObjects
 JSS ( timeouts );                   // out: InboundLedger
@@ -463,6 +503,7 @@ JSS ( totalSupply );                // out: Configuration
 JSS ( transTreeHash );              // out: ledger/Ledger.cpp
 JSS ( transaction );                // in: Tx
                                     // out: NetworkOPs, AcceptedLedgerTx,
+JSS ( transaction_batch );          // out: GetCounts
 JSS ( transaction_hash );           // out: CCLCxPeerPos, LedgerToJson
 JSS ( transactions );               // out: LedgerToJson,
                                     // in: AccountTx*, Unsubscribe
@@ -473,6 +514,7 @@ JSS ( trusted );                    // out: UnlList
 JSS ( tx );                         // out: STTx, AccountTx*
 JSS ( tx_blob );                    // in/out: Submit,
                                     // in: TransactionSign, AccountTx*
+JSS ( tx_cost_us );                 // out: GetCounts
 JSS ( tx_hash );                    // in: TransactionEntry
 JSS ( tx_json );                    // in/out: TransactionSign
                                     // out: TransactionEntry
@@ -507,9 +549,11 @@ JSS ( value );                      // out: STAmount
 JSS ( version );                    // out: RPCVersion
 JSS ( vetoed );                     // out: AmendmentTableImpl
 JSS ( vote );                       // in: Feature
+JSS ( wait_us );                    // out: GetCounts
 JSS ( warning );                    // rpc:
 JSS ( website );                    // out: Configuration
 JSS ( write_load );                 // out: GetCounts
+JSS ( writes );                     // out: ApplyProfile
 
 #undef JSS
 
@@ -37,6 +37,7 @@
 #include <cstring>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 namespace casinocoin {
 
@@ -247,6 +248,32 @@ verify (PublicKey const& publicKey,
     Slice const& sig,
     bool mustBeFullyCanonical = true);
 
+/** A signature to check with verifyBatch.
+
+    The message and signature are not owned, and must stay
+    valid until verifyBatch returns.
+*/
+struct SignedMessage
+{
+    PublicKey publicKey;
+    Slice message;
+    Slice signature;
+    bool mustBeFullyCanonical = true;
+};
+
+/** Verify several signatures on messages.
+
+    Each entry is checked with verify(), so it gets the same result
+    whatever else is in the batch. ed25519 batch verification is not
+    used: it decodes R instead of comparing its encoding, and its
+    random weights hide small order components, so it accepts some
+    signatures verify() rejects, depending on the batch they are in.
+
+    @return Whether each signature is valid, in the order given.
+*/
+std::vector<bool>
+verifyBatch (std::vector<SignedMessage> const& batch);
+
 /** Calculate the 160-bit node ID from a node public key. */
 NodeID
 calcNodeID (PublicKey const&);
@@ -174,6 +174,16 @@ bool passesLocalChecks (STObject const& st, std::string&,  const Config& config)
 std::shared_ptr<STTx const>
 sterilize (STTx const& stx);
 
+/** Check the signatures of several transactions.
+
+    Gives the same results as calling checkSign on each transaction.
+
+    @see verifyBatch
+*/
+std::vector<std::pair<bool, std::string>>
+checkSigns (std::vector<std::shared_ptr<STTx const>> const& txs,
+    bool allowMultiSign);
+
 /** Check whether a transaction is a pseudo-transaction */
 bool isPseudoTx(STObject const& tx);
 
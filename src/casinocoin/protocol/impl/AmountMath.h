@@ -0,0 +1,189 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef CASINOCOIN_PROTOCOL_AMOUNTMATH_H_INCLUDED
+#define CASINOCOIN_PROTOCOL_AMOUNTMATH_H_INCLUDED
+
+#include <cassert>
+#include <cstdint>
+
+#ifndef __SIZEOF_INT128__
+#include <boost/multiprecision/cpp_int.hpp>
+#include <limits>
+#endif
+
+namespace casinocoin {
+namespace detail {
+
+/*  Kernels for the decimal floating point used by STAmount and IOUAmount.
+
+    A normalized amount has a mantissa of exactly 16 digits, in the range
+    [10^15, 10^16), and an exponent. These compute in one step what the
+    amount code used to do a digit at a time, and give the same results.
+*/
+
+/** Returns 10^n, for n in [0, 19]. */
+inline
+std::uint64_t
+powerOfTen (int n)
+{
+    static std::uint64_t const table[] =
+    {
+        1ull,
+        10ull,
+        100ull,
+        1000ull,
+        10000ull,
+        100000ull,
+        1000000ull,
+        10000000ull,
+        100000000ull,
+        1000000000ull,
+        10000000000ull,
+        100000000000ull,
+        1000000000000ull,
+        10000000000000ull,
+        100000000000000ull,
+        1000000000000000ull,
+        10000000000000000ull,
+        100000000000000000ull,
+        1000000000000000000ull,
+        10000000000000000000ull
+    };
+
+    assert (n >= 0 && n < 20);
+    return table[n];
+}
+
+/** Returns the number of decimal digits in a non-zero value. */
+inline
+int
+decimalDigits (std::uint64_t value)
+{
+    assert (value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    // 1233 / 4096 approximates log10(2) closely enough that this
+    // is either the number of digits or one less.
+    int const bits = 64 - __builtin_clzll (value);
+    int const digits = (bits * 1233) >> 12;
+    return digits + (value >= powerOfTen (digits));
+#else
+    int digits = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+#endif
+}
+
+/** Scale a non-zero mantissa up to at least 10^15. */
+inline
+void
+normalizeUp (std::uint64_t& mantissa, int& exponent)
+{
+    if (mantissa >= 1000000000000000ull)
+        return;
+
+    int const n = 16 - decimalDigits (mantissa);
+    mantissa *= powerOfTen (n);
+    exponent -= n;
+}
+
+/** Scale a non-zero mantissa up to at least 10^15 without taking the
+    exponent below minExponent.
+*/
+inline
+void
+normalizeUp (std::uint64_t& mantissa, int& exponent, int minExponent)
+{
+    if (mantissa >= 1000000000000000ull || exponent <= minExponent)
+        return;
+
+    int n = 16 - decimalDigits (mantissa);
+    if (n > exponent - minExponent)
+        n = exponent - minExponent;
+    mantissa *= powerOfTen (n);
+    exponent -= n;
+}
+
+/** Scale a mantissa down to at most 10^16 - 1, truncating.
+
+    @return `false`, leaving the amount unchanged, if the exponent would
+            have to be raised past maxExponent.
+*/
+inline
+bool
+normalizeDown (std::uint64_t& mantissa, int& exponent, int maxExponent)
+{
+    if (mantissa <= 9999999999999999ull)
+        return true;
+
+    int const n = decimalDigits (mantissa) - 16;
+    if (exponent + n > maxExponent)
+        return false;
+    mantissa /= powerOfTen (n);
+    exponent += n;
+    return true;
+}
+
+/** Returns value / 10^places, truncating toward zero. */
+inline
+std::int64_t
+shiftDecimal (std::int64_t value, int places)
+{
+    assert (places >= 0);
+    if (places > 18)
+        return 0;
+    return value / static_cast<std::int64_t> (powerOfTen (places));
+}
+
+/** Computes (a * b + rounding) / divisor with a 128-bit intermediate.
+
+    @return `false` if the result does not fit in 64 bits.
+*/
+inline
+bool
+mulDivRound (std::uint64_t a, std::uint64_t b, std::uint64_t divisor,
+    std::uint64_t rounding, std::uint64_t& result)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = a;
+    r *= b;
+    r += rounding;
+    r /= divisor;
+    if (r >> 64)
+        return false;
+#else
+    boost::multiprecision::uint128_t r;
+    boost::multiprecision::multiply (r, a, b);
+    r += rounding;
+    r /= divisor;
+    if (r > std::numeric_limits<std::uint64_t>::max ())
+        return false;
+#endif
+    result = static_cast<std::uint64_t> (r);
+    return true;
+}
+
+} // detail
+} // casinocoin
+
+#endif
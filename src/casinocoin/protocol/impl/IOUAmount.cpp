@@ -26,6 +26,7 @@
 #include <BeastConfig.h>
 #include <casinocoin/basics/contract.h>
 #include <casinocoin/protocol/IOUAmount.h>
+#include <casinocoin/protocol/impl/AmountMath.h>
 #include <boost/multiprecision/cpp_int.hpp>
 #include <algorithm>
 #include <numeric>
@@ -55,20 +56,14 @@ IOUAmount::normalize ()
     if (negative)
         mantissa_ = -mantissa_;
 
-    while ((mantissa_ < minMantissa) && (exponent_ > minExponent))
-    {
-        mantissa_ *= 10;
-        --exponent_;
-    }
+    auto mantissa = static_cast<std::uint64_t> (mantissa_);
 
-    while (mantissa_ > maxMantissa)
-    {
-        if (exponent_ >= maxExponent)
-            Throw<std::overflow_error> ("IOUAmount::normalize");
+    detail::normalizeUp (mantissa, exponent_, minExponent);
 
-        mantissa_ /= 10;
-        ++exponent_;
-    }
+    if (! detail::normalizeDown (mantissa, exponent_, maxExponent))
+        Throw<std::overflow_error> ("IOUAmount::normalize");
+
+    mantissa_ = static_cast<std::int64_t> (mantissa);
 
     if ((exponent_ < minExponent) || (mantissa_ < minMantissa))
     {
@@ -98,16 +93,15 @@ IOUAmount::operator+= (IOUAmount const& other)
     auto m = other.mantissa_;
     auto e = other.exponent_;
 
-    while (exponent_ < e)
+    if (exponent_ < e)
     {
-        mantissa_ /= 10;
-        ++exponent_;
+        mantissa_ = detail::shiftDecimal (mantissa_, e - exponent_);
+        exponent_ = e;
     }
-
-    while (e < exponent_)
+    else if (e < exponent_)
     {
-        m /= 10;
-        ++e;
+        m = detail::shiftDecimal (m, exponent_ - e);
+        e = exponent_;
     }
 
     // This addition cannot overflow an std::int64_t but we may throw from
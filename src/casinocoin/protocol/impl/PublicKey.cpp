@@ -310,6 +310,17 @@ verify (PublicKey const& publicKey,
     return false;
 }
 
+std::vector<bool>
+verifyBatch (std::vector<SignedMessage> const& batch)
+{
+    std::vector<bool> result;
+    result.reserve(batch.size());
+    for (auto const& e : batch)
+        result.push_back(verify (e.publicKey, e.message,
+            e.signature, e.mustBeFullyCanonical));
+    return result;
+}
+
 NodeID
 calcNodeID (PublicKey const& pk)
 {
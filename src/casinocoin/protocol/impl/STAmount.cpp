@@ -31,10 +31,10 @@
 #include <casinocoin/protocol/SystemParameters.h>
 #include <casinocoin/protocol/STAmount.h>
 #include <casinocoin/protocol/UintTypes.h>
+#include <casinocoin/protocol/impl/AmountMath.h>
 #include <casinocoin/beast/core/LexicalCast.h>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
-#include <boost/multiprecision/cpp_int.hpp>
 #include <iterator>
 #include <memory>
 #include <iostream>
@@ -375,16 +375,15 @@ STAmount operator+ (STAmount const& v1, STAmount const& v2)
     if (v2.negative ())
         vv2 = -vv2;
 
-    while (ov1 < ov2)
+    if (ov1 < ov2)
     {
-        vv1 /= 10;
-        ++ov1;
+        vv1 = detail::shiftDecimal (vv1, ov2 - ov1);
+        ov1 = ov2;
     }
-
-    while (ov2 < ov1)
+    else if (ov2 < ov1)
     {
-        vv2 /= 10;
-        ++ov2;
+        vv2 = detail::shiftDecimal (vv2, ov1 - ov2);
+        ov2 = ov1;
     }
 
     // This addition cannot overflow an std::int64_t. It can overflow an
@@ -677,20 +676,10 @@ void STAmount::canonicalize ()
         return;
     }
 
-    while ((mValue < cMinValue) && (mOffset > cMinOffset))
-    {
-        mValue *= 10;
-        --mOffset;
-    }
-
-    while (mValue > cMaxValue)
-    {
-        if (mOffset >= cMaxOffset)
-            Throw<std::runtime_error> ("value overflow");
+    detail::normalizeUp (mValue, mOffset, cMinOffset);
 
-        mValue /= 10;
-        ++mOffset;
-    }
+    if (! detail::normalizeDown (mValue, mOffset, cMaxOffset))
+        Throw<std::runtime_error> ("value overflow");
 
     if ((mOffset < cMinOffset) || (mValue < cMinValue))
     {
@@ -987,12 +976,9 @@ muldiv(
     std::uint64_t multiplicand,
     std::uint64_t divisor)
 {
-    boost::multiprecision::uint128_t ret;
-
-    boost::multiprecision::multiply(ret, multiplier, multiplicand);
-    ret /= divisor;
+    std::uint64_t ret;
 
-    if (ret > std::numeric_limits<std::uint64_t>::max())
+    if (! detail::mulDivRound (multiplier, multiplicand, divisor, 0, ret))
     {
         Throw<std::overflow_error> ("overflow: (" +
             std::to_string (multiplier) + " * " +
@@ -1000,7 +986,7 @@ muldiv(
             std::to_string (divisor));
     }
 
-    return static_cast<uint64_t>(ret);
+    return ret;
 }
 
 static
@@ -1011,13 +997,10 @@ muldiv_round(
     std::uint64_t divisor,
     std::uint64_t rounding)
 {
-    boost::multiprecision::uint128_t ret;
-
-    boost::multiprecision::multiply(ret, multiplier, multiplicand);
-    ret += rounding;
-    ret /= divisor;
+    std::uint64_t ret;
 
-    if (ret > std::numeric_limits<std::uint64_t>::max())
+    if (! detail::mulDivRound (multiplier, multiplicand, divisor,
+        rounding, ret))
     {
         Throw<std::overflow_error> ("overflow: ((" +
             std::to_string (multiplier) + " * " +
@@ -1026,7 +1009,7 @@ muldiv_round(
             std::to_string (divisor));
     }
 
-    return static_cast<uint64_t>(ret);
+    return ret;
 }
 
 STAmount
@@ -1045,21 +1028,13 @@ divide (STAmount const& num, STAmount const& den, Issue const& issue)
 
     if (num.native())
     {
-        while (numVal < STAmount::cMinValue)
-        {
-            // Need to bring into range
-            numVal *= 10;
-            --numOffset;
-        }
+        // Need to bring into range
+        detail::normalizeUp (numVal, numOffset);
     }
 
     if (den.native())
     {
-        while (denVal < STAmount::cMinValue)
-        {
-            denVal *= 10;
-            --denOffset;
-        }
+        detail::normalizeUp (denVal, denOffset);
     }
 
     // We divide the two mantissas (each is between 10^15
@@ -1102,20 +1077,12 @@ multiply (STAmount const& v1, STAmount const& v2, Issue const& issue)
 
     if (v1.native())
     {
-        while (value1 < STAmount::cMinValue)
-        {
-            value1 *= 10;
-            --offset1;
-        }
+        detail::normalizeUp (value1, offset1);
     }
 
     if (v2.native())
     {
-        while (value2 < STAmount::cMinValue)
-        {
-            value2 *= 10;
-            --offset2;
-        }
+        detail::normalizeUp (value2, offset2);
     }
 
     // We multiply the two mantissas (each is between 10^15
@@ -1136,13 +1103,12 @@ canonicalizeRound (bool native, std::uint64_t& value, int& offset)
     {
         if (offset < 0)
         {
-            int loops = 0;
+            int const loops = -1 - offset;
 
-            while (offset < -1)
+            if (loops > 0)
             {
-                value /= 10;
-                ++offset;
-                ++loops;
+                value = (loops < 20) ? value / detail::powerOfTen (loops) : 0;
+                offset = -1;
             }
 
             value += (loops >= 2) ? 9 : 10; // add before last divide
@@ -1152,7 +1118,14 @@ canonicalizeRound (bool native, std::uint64_t& value, int& offset)
     }
     else if (value > STAmount::cMaxValue)
     {
-        while (value > (10 * STAmount::cMaxValue))
+        int const excess = detail::decimalDigits (value) - 17;
+        if (excess > 0)
+        {
+            value /= detail::powerOfTen (excess);
+            offset += excess;
+        }
+
+        if (value > (10 * STAmount::cMaxValue))
         {
             value /= 10;
             ++offset;
@@ -1194,20 +1167,12 @@ mulRound (STAmount const& v1, STAmount const& v2, Issue const& issue,
 
     if (v1.native())
     {
-        while (value1 < STAmount::cMinValue)
-        {
-            value1 *= 10;
-            --offset1;
-        }
+        detail::normalizeUp (value1, offset1);
     }
 
     if (v2.native())
     {
-        while (value2 < STAmount::cMinValue)
-        {
-            value2 *= 10;
-            --offset2;
-        }
+        detail::normalizeUp (value2, offset2);
     }
 
     bool const resultNegative = v1.negative() != v2.negative();
@@ -1264,20 +1229,12 @@ divRound (STAmount const& num, STAmount const& den,
 
     if (num.native())
     {
-        while (numVal < STAmount::cMinValue)
-        {
-            numVal *= 10;
-            --numOffset;
-        }
+        detail::normalizeUp (numVal, numOffset);
     }
 
     if (den.native())
     {
-        while (denVal < STAmount::cMinValue)
-        {
-            denVal *= 10;
-            --denOffset;
-        }
+        detail::normalizeUp (denVal, denOffset);
     }
 
     bool const resultNegative =
@@ -527,6 +527,61 @@ sterilize (STTx const& stx)
     return std::make_shared<STTx const>(std::ref(sit));
 }
 
+std::vector<std::pair<bool, std::string>>
+checkSigns (std::vector<std::shared_ptr<STTx const>> const& txs,
+    bool allowMultiSign)
+{
+    std::vector<std::pair<bool, std::string>> result (txs.size());
+
+    // The batch refers to the signing data and signatures held
+    // here, so these must not reallocate while it is being built
+    std::vector<std::size_t> index;
+    std::vector<Blob> data;
+    std::vector<Blob> sigs;
+    std::vector<SignedMessage> batch;
+    index.reserve (txs.size());
+    data.reserve (txs.size());
+    sigs.reserve (txs.size());
+    batch.reserve (txs.size());
+
+    for (std::size_t i = 0; i < txs.size(); ++i)
+    {
+        auto const& tx = *txs[i];
+        try
+        {
+            // Transactions with both a key and signers are rejected
+            // by checkSign, as is anything not signed with ed25519
+            auto const spk = tx.getSigningPubKey ();
+            if (tx.isFieldPresent (sfSigners) ||
+                publicKeyType (makeSlice (spk)) != KeyType::ed25519)
+            {
+                result[i] = tx.checkSign (allowMultiSign);
+                continue;
+            }
+
+            data.push_back (getSigningData (tx));
+            sigs.push_back (tx.getSignature ());
+            batch.push_back ({ PublicKey (makeSlice (spk)),
+                makeSlice (data.back ()), makeSlice (sigs.back ()) });
+            index.push_back (i);
+        }
+        catch (std::exception const&)
+        {
+            result[i] = {false, "Internal signature check failure."};
+        }
+    }
+
+    auto const valid = verifyBatch (batch);
+    for (std::size_t i = 0; i < index.size (); ++i)
+    {
+        if (valid[i])
+            result[index[i]] = {true, ""};
+        else
+            result[index[i]] = {false, "Invalid signature."};
+    }
+    return result;
+}
+
 bool
 isPseudoTx(STObject const& tx)
 {
@@ -26,6 +26,7 @@
 #include <BeastConfig.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/app/paths/CasinocoinState.h>
+#include <casinocoin/app/paths/PathRequests.h>
 #include <casinocoin/ledger/ReadView.h>
 #include <casinocoin/protocol/JsonFields.h>
 #include <casinocoin/rpc/Context.h>
@@ -64,16 +65,35 @@ Json::Value doAccountCurrencies (RPC::Context& context)
         return rpcError (rpcACT_NOT_FOUND);
 
     std::set<Currency> send, receive;
-    for (auto const& item : getCasinocoinStateItems (accountID, *ledger))
+    auto const totals = ledger->open () ? nullptr :
+        context.app.getPathRequests ().getLineTotals ();
+    if (totals && totals->seq () == ledger->seq () &&
+        totals->hash () == ledger->info ().hash)
     {
-        auto const rspEntry = item.get();
+        if (auto const lines = totals->account (accountID))
+        {
+            for (auto const& item : lines->currencies)
+            {
+                if (item.second.receivable != 0)
+                    receive.insert (item.first);
+                if (item.second.sendable != 0)
+                    send.insert (item.first);
+            }
+        }
+    }
+    else
+    {
+        for (auto const& item : getCasinocoinStateItems (accountID, *ledger))
+        {
+            auto const rspEntry = item.get();
 
-        STAmount const& saBalance = rspEntry->getBalance ();
+            STAmount const& saBalance = rspEntry->getBalance ();
 
-        if (saBalance < rspEntry->getLimit ())
-            receive.insert (saBalance.getCurrency ());
-        if ((-saBalance) < rspEntry->getLimitPeer ())
-            send.insert (saBalance.getCurrency ());
+            if (saBalance < rspEntry->getLimit ())
+                receive.insert (saBalance.getCurrency ());
+            if ((-saBalance) < rspEntry->getLimitPeer ())
+                send.insert (saBalance.getCurrency ());
+        }
     }
 
     send.erase (badCurrency());
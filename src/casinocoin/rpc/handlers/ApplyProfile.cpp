@@ -0,0 +1,56 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/main/Application.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/json/json_value.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <casinocoin/rpc/Context.h>
+
+namespace casinocoin {
+
+// {
+//   enable: <bool>     // optional, start recording
+//   disable: <bool>    // optional, stop recording
+//   reset: <bool>      // optional, discard what was recorded
+// }
+//
+// Durations are in microseconds. Each histogram bucket i > 0 counts
+// the values in [2^(i-1), 2^i).
+Json::Value doApplyProfile (RPC::Context& context)
+{
+    auto& profiler = context.app.getApplyProfiler ();
+
+    if (context.params.isMember (jss::reset) &&
+            context.params[jss::reset].asBool ())
+        profiler.reset ();
+
+    if (context.params.isMember (jss::enable) &&
+            context.params[jss::enable].asBool ())
+        profiler.enable (true);
+
+    if (context.params.isMember (jss::disable) &&
+            context.params[jss::disable].asBool ())
+        profiler.enable (false);
+
+    return profiler.getJson ();
+}
+
+} // casinocoin
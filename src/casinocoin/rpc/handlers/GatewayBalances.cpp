@@ -26,6 +26,8 @@
 #include <BeastConfig.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/app/paths/CasinocoinState.h>
+#include <casinocoin/app/paths/PathRequests.h>
+#include <casinocoin/app/paths/TrustLineTotals.h>
 #include <casinocoin/ledger/ReadView.h>
 #include <casinocoin/protocol/AccountID.h>
 #include <casinocoin/protocol/ErrorCodes.h>
@@ -34,6 +36,8 @@
 #include <casinocoin/resource/Fees.h>
 #include <casinocoin/rpc/Context.h>
 #include <casinocoin/rpc/impl/RPCHelpers.h>
+#include <map>
+#include <set>
 
 namespace casinocoin {
 
@@ -84,8 +88,6 @@ Json::Value doGatewayBalances (RPC::Context& context)
     if (jvAccepted)
         return jvAccepted;
 
-    context.loadType = Resource::feeHighBurdenRPC;
-
     result[jss::account] = context.app.accountIDCache().toBase58 (accountID);
 
     // Parse the specified hotwallet(s), if any
@@ -144,58 +146,107 @@ Json::Value doGatewayBalances (RPC::Context& context)
 
     }
 
-    std::map <Currency, STAmount> sums;
+    // Obligations are summed exactly, so the sums don't depend on the
+    // order of the lines
+    std::map <Currency, TrustLineTotals::Sum> sums;
     std::map <AccountID, std::vector <STAmount>> hotBalances;
     std::map <AccountID, std::vector <STAmount>> assets;
     std::map <AccountID, std::vector <STAmount>> frozenBalances;
 
-    // Traverse the cold wallet's trust lines
+    auto const visit = [&](std::shared_ptr<SLE const> const& sle)
     {
-        forEachItem(*ledger, accountID,
-            [&](std::shared_ptr<SLE const> const& sle)
-            {
-                auto rs = CasinocoinState::makeItem (accountID, sle);
+        auto rs = CasinocoinState::makeItem (accountID, sle);
 
-                if (!rs)
-                    return;
+        if (!rs)
+            return;
 
-                int balSign = rs->getBalance().signum();
-                if (balSign == 0)
-                    return;
+        int balSign = rs->getBalance().signum();
+        if (balSign == 0)
+            return;
 
-                auto const& peer = rs->getAccountIDPeer();
+        auto const& peer = rs->getAccountIDPeer();
 
-                // Here, a negative balance means the cold wallet owes (normal)
-                // A positive balance means the cold wallet has an asset (unusual)
+        // Here, a negative balance means the cold wallet owes (normal)
+        // A positive balance means the cold wallet has an asset (unusual)
 
-                if (hotWallets.count (peer) > 0)
-                {
-                    // This is a specified hot wallet
-                    hotBalances[peer].push_back (-rs->getBalance ());
-                }
-                else if (balSign > 0)
-                {
-                    // This is a gateway asset
-                    assets[peer].push_back (rs->getBalance ());
-                }
-                else if (rs->getFreeze())
+        if (hotWallets.count (peer) > 0)
+        {
+            // This is a specified hot wallet
+            hotBalances[peer].push_back (-rs->getBalance ());
+        }
+        else if (balSign > 0)
+        {
+            // This is a gateway asset
+            assets[peer].push_back (rs->getBalance ());
+        }
+        else if (rs->getFreeze())
+        {
+            // An obligation the gateway has frozen
+            frozenBalances[peer].push_back (-rs->getBalance ());
+        }
+        else
+        {
+            // normal negative balance, obligation to customer
+            sums[rs->getBalance().getCurrency()] -= rs->getBalance();
+        }
+    };
+
+    auto const totals = ledger->open () ? nullptr :
+        context.app.getPathRequests ().getLineTotals ();
+    if (totals && totals->seq () == ledger->seq () &&
+        totals->hash () == ledger->info ().hash)
+    {
+        // The totals of this ledger hold the obligations. Only the
+        // unusual lines and those of the hot wallets are read.
+        context.loadType = Resource::feeMediumBurdenRPC;
+
+        if (auto const lines = totals->account (accountID))
+        {
+            std::map <Currency, std::uint32_t> counts;
+            for (auto const& item : lines->currencies)
+            {
+                if (item.second.obligations != 0)
                 {
-                    // An obligation the gateway has frozen
-                    frozenBalances[peer].push_back (-rs->getBalance ());
+                    sums[item.first] = item.second.owed;
+                    counts[item.first] = item.second.obligations;
                 }
-                else
+            }
+
+            std::set <uint256> keys (
+                lines->unusual.begin (), lines->unusual.end ());
+            for (auto const& hotWallet : hotWallets)
+                for (auto const& item : lines->currencies)
+                    keys.insert (keylet::line (
+                        accountID, hotWallet, item.first).key);
+
+            for (auto const& key : keys)
+            {
+                auto const sle = ledger->read (keylet::line (key));
+                auto rs = CasinocoinState::makeItem (accountID, sle);
+                if (!rs)
+                    continue;
+
+                if (rs->getBalance().signum() < 0 && !rs->getFreeze())
                 {
-                    // normal negative balance, obligation to customer
-                    auto& bal = sums[rs->getBalance().getCurrency()];
-                    if (bal == zero)
-                    {
-                        // This is needed to set the currency code correctly
-                        bal = -rs->getBalance();
-                    }
+                    // Only a hot wallet's obligations get here, and the
+                    // totals count them with the others
+                    auto const currency = rs->getBalance().getCurrency();
+                    if (--counts[currency] == 0)
+                        sums.erase (currency);
                     else
-                        bal -= rs->getBalance();
+                        sums[currency] += rs->getBalance();
                 }
-            });
+
+                visit (sle);
+            }
+        }
+    }
+    else
+    {
+        context.loadType = Resource::feeHighBurdenRPC;
+
+        // Traverse the cold wallet's trust lines
+        forEachItem(*ledger, accountID, visit);
     }
 
     if (! sums.empty())
@@ -203,7 +254,8 @@ Json::Value doGatewayBalances (RPC::Context& context)
         Json::Value j;
         for (auto const& e : sums)
         {
-            j[to_string (e.first)] = e.second.getText ();
+            j[to_string (e.first)] =
+                e.second.value ({e.first, accountID}).getText ();
         }
         result [jss::obligations] = std::move (j);
     }
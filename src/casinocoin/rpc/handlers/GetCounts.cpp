@@ -27,8 +27,10 @@
 #include <casinocoin/app/ledger/AcceptedLedger.h>
 #include <casinocoin/app/ledger/InboundLedgers.h>
 #include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/OpenLedger.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/app/misc/NetworkOPs.h>
+#include <casinocoin/app/paths/PathRequests.h>
 #include <casinocoin/basics/UptimeTimer.h>
 #include <casinocoin/core/DatabaseCon.h>
 #include <casinocoin/json/json_value.h>
@@ -113,6 +115,8 @@ Json::Value doGetCounts (RPC::Context& context)
     ret[jss::AL_hit_rate] = context.app.getAcceptedLedgerCache ().getHitRate ();
 
     ret[jss::fullbelow_size] = static_cast<int>(context.app.family().fullbelow().size());
+    ret[jss::fullbelow_pending] = static_cast<int>(context.app.family().fullbelow().pendingSize());
+    ret[jss::fullbelow_restored] = static_cast<int>(context.app.family().fullbelow().restoredSize());
     ret[jss::treenode_cache_size] = context.app.family().treecache().getCacheSize();
     ret[jss::treenode_track_size] = context.app.family().treecache().getTrackSize();
 
@@ -125,6 +129,19 @@ Json::Value doGetCounts (RPC::Context& context)
     textTime (uptime, s, "second", 1);
     ret[jss::uptime] = uptime;
 
+    auto const prefetch = context.app.openLedger().prefetchStats();
+    ret[jss::apply_prefetch_keys] = prefetch.keys;
+    ret[jss::apply_prefetch_reads] = prefetch.reads;
+    ret[jss::apply_prefetch_misses] = prefetch.misses;
+
+    auto const rebuild = context.app.openLedger().rebuildStats();
+    ret[jss::open_rebuild_time] = rebuild.time;
+    ret[jss::open_carried] = rebuild.carried;
+    ret[jss::open_reapplied] = rebuild.reapplied;
+
+    ret[jss::transaction_batch] = context.app.getOPs().getTransactionBatchJson();
+    ret[jss::path_requests] = context.app.getPathRequests().getJson();
+
     ret[jss::node_writes] = context.app.getNodeStore().getStoreCount();
     ret[jss::node_reads_total] = context.app.getNodeStore().getFetchTotalCount();
     ret[jss::node_reads_hit] = context.app.getNodeStore().getFetchHitCount();
@@ -24,7 +24,11 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <casinocoin/app/ledger/Ledger.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
 #include <casinocoin/app/ledger/LedgerToJson.h>
+#include <casinocoin/app/main/Application.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
 #include <casinocoin/ledger/ReadView.h>
 #include <casinocoin/protocol/ErrorCodes.h>
 #include <casinocoin/protocol/JsonFields.h>
@@ -33,6 +37,7 @@
 #include <casinocoin/rpc/impl/Tuning.h>
 #include <casinocoin/rpc/Context.h>
 #include <casinocoin/rpc/Role.h>
+#include <casinocoin/core/WorkerPool.h>
 
 namespace casinocoin {
 
@@ -42,10 +47,13 @@ namespace casinocoin {
 //     marker:       opaque, resume point
 //     binary:       boolean, format
 //     type:         string // optional, defaults to all ledger node types
+//     base_ledger_index: integer // optional, only return the entries
+//                   which changed since this ledger
 //   Outputs:
 //     ledger_hash:  chosen ledger's hash
 //     ledger_index: chosen ledger's index
-//     state:        array of state nodes
+//     state:        array of state nodes, changed nodes which were
+//                   deleted have only index and deleted
 //     marker:       resume point, if any
 Json::Value doLedgerData (RPC::Context& context)
 {
@@ -101,33 +109,83 @@ Json::Value doLedgerData (RPC::Context& context)
     }
     Json::Value& nodes = jvResult[jss::state];
 
-    auto e = lpLedger->sles.end();
-    for (auto i = lpLedger->sles.upper_bound(key); i != e; ++i)
+    if (params.isMember (jss::base_ledger_index))
     {
-        auto sle = lpLedger->read(keylet::unchecked((*i)->key()));
-        if (limit-- <= 0)
-        {
-            // Stop processing before the current key.
-            auto k = sle->key();
-            jvResult[jss::marker] = to_string(--k);
-            break;
-        }
+        Json::Value const& jBase = params[jss::base_ledger_index];
+        if (! jBase.isIntegral ())
+            return RPC::expected_field_error (
+                jss::base_ledger_index, "integer");
+
+        // Both ledgers must be closed for their state maps to be compared
+        auto const ledger =
+            std::dynamic_pointer_cast<Ledger const> (lpLedger);
+        auto const base = context.ledgerMaster.getLedgerBySeq (
+            jBase.asUInt ());
+        if (! ledger || ! base)
+            return RPC::make_error (rpcLGR_NOT_FOUND, "ledgerNotFound");
+
+        // Compare only the branches which differ, in key order
+        ledger->stateMap ().visitDelta (base->stateMap (),
+            [&](uint256 const& k, SHAMap::DeltaItem const& item)
+            {
+                if (isMarker && k <= key)
+                    return true;
+
+                if (limit-- <= 0)
+                {
+                    auto m = k;
+                    jvResult[jss::marker] = to_string (--m);
+                    return false;
+                }
+
+                auto const& changed = item.first ? item.first : item.second;
+                SLE const sle (SerialIter (changed->slice ()), k);
+                if (type.second != ltINVALID && sle.getType () != type.second)
+                    return true;
+
+                Json::Value& entry = nodes.append (Json::objectValue);
+                if (! item.first)
+                    entry[jss::deleted] = true;
+                else if (isBinary)
+                    entry[jss::data] = strHex (item.first->slice ());
+                else
+                    entry = sle.getJson (0);
+                entry[jss::index] = to_string (k);
+                return true;
+            }, &context.app.getWorkerPool ());
 
-        if (type.second == ltINVALID || sle->getType () == type.second)
+        return jvResult;
+    }
+
+    // Walk the raw state entries, so only entries returned as JSON
+    // need to be deserialized
+    forEachStateLeaf (*lpLedger, key,
+        [&](StateLeaf const& leaf)
         {
-            if (isBinary)
+            if (limit-- <= 0)
             {
-                Json::Value& entry = nodes.append (Json::objectValue);
-                entry[jss::data] = serializeHex(*sle);
-                entry[jss::index] = to_string(sle->key());
+                // Stop processing before the current key.
+                auto k = leaf.key();
+                jvResult[jss::marker] = to_string(--k);
+                return false;
             }
-            else
+
+            if (type.second == ltINVALID || leaf.type () == type.second)
             {
-                Json::Value& entry = nodes.append (sle->getJson (0));
-                entry[jss::index] = to_string(sle->key());
+                if (isBinary)
+                {
+                    Json::Value& entry = nodes.append (Json::objectValue);
+                    entry[jss::data] = strHex(leaf.slice());
+                    entry[jss::index] = to_string(leaf.key());
+                }
+                else
+                {
+                    Json::Value& entry = nodes.append (leaf.sle()->getJson (0));
+                    entry[jss::index] = to_string(leaf.key());
+                }
             }
-        }
-    }
+            return true;
+        });
 
     return jvResult;
 }
@@ -113,6 +113,7 @@ Handler handlerArray[] {
     {   "account_objects",      byRef (&doAccountObjects),      Role::USER,  NO_CONDITION               },
     {   "account_offers",       byRef (&doAccountOffers),       Role::USER,  NO_CONDITION               },
     {   "account_tx",           byRef (&doAccountTxSwitch),     Role::USER,  NO_CONDITION               },
+    {   "apply_profile",        byRef (&doApplyProfile),        Role::ADMIN, NO_CONDITION               },
     {   "blacklist",            byRef (&doBlackList),           Role::ADMIN, NO_CONDITION               },
     {   "blacklisted_accounts", byRef (&doBlacklistedAccounts), Role::ADMIN, NO_CONDITION               },
     {   "book_offers",          byRef (&doBookOffers),          Role::USER,  NO_CONDITION               },
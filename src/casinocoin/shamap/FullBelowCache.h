@@ -29,8 +29,15 @@
 #include <casinocoin/basics/base_uint.h>
 #include <casinocoin/basics/KeyCache.h>
 #include <casinocoin/beast/insight/Collector.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/beast/utility/Journal.h>
+#include <casinocoin/nodestore/Database.h>
+#include <boost/filesystem/path.hpp>
 #include <atomic>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace casinocoin {
 
@@ -56,6 +63,9 @@ public:
     using size_type  = typename CacheType::size_type;
     using clock_type = typename CacheType::clock_type;
 
+    /** Checks that a key loaded from a previous run is still usable. */
+    using verifier_type = std::function <bool (key_type const&)>;
+
     /** Construct the cache.
 
         @param name A label for diagnostics and stats reporting.
@@ -129,19 +139,143 @@ public:
 
     void clear ()
     {
+        {
+            std::lock_guard <std::mutex> lock (m_pendingLock);
+            m_pending.clear ();
+            m_pendingCount = 0;
+        }
         m_cache.clear ();
         ++m_gen;
     }
 
+    /** Return a copy of the keys in the cache. */
+    std::vector <key_type> getKeys () const
+    {
+        return m_cache.getKeys ();
+    }
+
+    /** Seed the cache with keys that were full below in a previous run.
+        The keys are not trusted until verifyPending has checked them
+        with the verifier, and until then lookups don't find them.
+        Replaces any keys still pending.
+        Thread safety:
+            Safe to call from any thread.
+    */
+    void setPending (std::vector <key_type> const& keys,
+        verifier_type verifier)
+    {
+        std::lock_guard <std::mutex> lock (m_pendingLock);
+        m_pending.clear ();
+        m_pending.insert (keys.begin (), keys.end ());
+        m_verifier = std::move (verifier);
+        m_pendingCount = m_pending.size ();
+    }
+
+    /** Return the number of loaded keys not yet verified. */
+    size_type pendingSize () const
+    {
+        return m_pendingCount.load ();
+    }
+
+    /** Return the number of loaded keys that passed verification. */
+    size_type restoredSize () const
+    {
+        return m_restored.load ();
+    }
+
+    /** Check the pending keys, and move those the verifier accepts
+        into the cache. Meant to run in the background: lookups go on
+        meanwhile, and don't wait for it.
+        Thread safety:
+            Safe to call from any thread.
+        @param stopping Called between keys, stops early if it
+            returns `true`.
+        @return The number of keys moved into the cache.
+    */
+    size_type verifyPending (std::function <bool ()> const& stopping)
+    {
+        size_type restored = 0;
+        while (! stopping ())
+        {
+            key_type key;
+            verifier_type verifier;
+            {
+                std::lock_guard <std::mutex> lock (m_pendingLock);
+                if (m_pending.empty ())
+                    break;
+                auto const iter = m_pending.begin ();
+                key = *iter;
+                m_pending.erase (iter);
+                m_pendingCount = m_pending.size ();
+                verifier = m_verifier;
+            }
+
+            // Keys found complete since, or by checking another key,
+            // needn't be checked again. Don't hold the lock while the
+            // verifier touches the database.
+            if (! m_cache.touch_if_exists (key) &&
+                    (! verifier || ! verifier (key)))
+                continue;
+
+            m_cache.insert (key);
+            ++restored;
+            ++m_restored;
+        }
+        return restored;
+    }
+
 private:
     KeyCache <Key> m_cache;
     std::atomic <std::uint32_t> m_gen;
+
+    std::mutex mutable m_pendingLock;
+    hash_set <Key> m_pending;
+    verifier_type m_verifier;
+    std::atomic <std::size_t> m_pendingCount {0};
+    std::atomic <std::size_t> m_restored {0};
 };
 
 } // detail
 
 using FullBelowCache = detail::BasicFullBelowCache <uint256>;
 
+/** Write the keys in a full below cache to a file.
+
+    The keys are stored sorted, followed by a checksum, so that a
+    restarted server can skip re-verifying complete subtrees.
+
+    @return `true` if the file was written.
+*/
+bool
+saveFullBelow (FullBelowCache const& cache,
+    boost::filesystem::path const& file, beast::Journal j);
+
+/** Load keys written by saveFullBelow as pending cache entries.
+
+    A missing or corrupt file is ignored. The loaded keys are checked
+    with the verifier by FullBelowCache::verifyPending.
+
+    @return The number of keys loaded.
+*/
+std::size_t
+loadFullBelow (FullBelowCache& cache,
+    boost::filesystem::path const& file,
+        FullBelowCache::verifier_type verifier, beast::Journal j);
+
+/** Check that every node of a subtree is in the node store.
+
+    Walks down from the node with the given hash, fetching each node
+    beneath it. Subtrees the cache already holds as complete are not
+    walked again. If the subtree is complete, the inner nodes walked
+    are added to the cache, so checking a key beneath it later costs
+    nothing.
+
+    @return `true` if no node of the subtree is missing.
+*/
+bool
+subtreeInStore (FullBelowCache& cache, NodeStore::Database& db,
+    uint256 const& root, beast::Journal j);
+
 }
 
 #endif
@@ -48,6 +48,8 @@
 
 namespace casinocoin {
 
+class WorkerPool;
+
 enum class SHAMapState
 {
     Modifying = 0,       // Objects can be added and removed (like an open ledger)
@@ -134,6 +136,12 @@ public:
         return f_;
     }
 
+    Family const&
+    family() const
+    {
+        return f_;
+    }
+
     //--------------------------------------------------------------------------
 
     /** Iterator to a SHAMap's leaves
@@ -180,6 +188,17 @@ public:
     std::shared_ptr<SHAMapItem const> const&
         peekItem (uint256 const& id, SHAMapTreeNode::TNType & type) const;
 
+    /** Bring the nodes on the paths to some keys into memory
+
+        Nodes which are not cached are read from the node store
+        asynchronously, one level of the tree at a time, so the reads
+        for all of the keys are in flight together. Later lookups of
+        the keys then find every node they need without blocking.
+
+        @return The number of keys which needed a read.
+    */
+    std::size_t prefetch (std::vector<uint256> const& keys) const;
+
     // traverse functions
     const_iterator upper_bound(uint256 const& id) const;
 
@@ -228,6 +247,31 @@ public:
     bool compare (SHAMap const& otherMap,
                   Delta& differences, int maxCount) const;
 
+    using DeltaVisitor =
+        std::function<bool (uint256 const& key, DeltaItem const& item)>;
+
+    /** Visit the items that differ between this map and another
+
+        Differences are reported in ascending key order, without
+        building a Delta. The first item of each pair is from this
+        map and the second from otherMap; either is null if the key
+        is missing from that map. Branches with matching hashes are
+        skipped.
+
+        Given a pool, the branches of the root are compared on its
+        threads, as many at once as the pool has threads, and only
+        the differences of those branches are buffered. The visitor
+        is always invoked on the calling thread.
+
+        @param otherMap The map to compare to. It must be immutable.
+        @param func Called for each difference, returns false to stop.
+        @param pool The threads to compare branches on, if any.
+        @return false if the visitor stopped the walk.
+    */
+    bool visitDelta (SHAMap const& otherMap,
+                     DeltaVisitor const& func,
+                     WorkerPool* pool = nullptr) const;
+
     int flushDirty (NodeObjectType t, std::uint32_t seq);
     void walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing) const;
     bool deepCompare (SHAMap & other) const;  // Intended for debug/test only
@@ -250,8 +294,6 @@ public:
 private:
     using SharedPtrNodeStack =
         std::stack<std::pair<std::shared_ptr<SHAMapAbstractNode>, SHAMapNodeID>>;
-    using DeltaRef = std::pair<std::shared_ptr<SHAMapItem const> const&,
-                               std::shared_ptr<SHAMapItem const> const&>;
 
     void visitDifferences(SHAMap const* have, std::function<bool(SHAMapAbstractNode&)>) const;
 
@@ -327,9 +369,11 @@ private:
 
     SHAMapTreeNode const* peekFirstItem(SharedPtrNodeStack& stack) const;
     SHAMapTreeNode const* peekNextItem(uint256 const& id, SharedPtrNodeStack& stack) const;
-    bool walkBranch (SHAMapAbstractNode* node,
-                     std::shared_ptr<SHAMapItem const> const& otherMapItem,
-                     bool isFirstMap, Delta & differences, int & maxCount) const;
+    bool deltaBranch (SHAMapAbstractNode* node,
+                      std::shared_ptr<SHAMapItem const> otherMapItem,
+                      bool isFirstMap, DeltaVisitor const& func) const;
+    bool deltaNodes (SHAMapAbstractNode* ourNode, SHAMap const& otherMap,
+                     SHAMapAbstractNode* otherNode, DeltaVisitor const& func) const;
     int walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq);
     bool isInconsistentNode(std::shared_ptr<SHAMapAbstractNode> const& node) const;
 
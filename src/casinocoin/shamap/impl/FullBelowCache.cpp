@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/shamap/FullBelowCache.h>
+#include <casinocoin/shamap/SHAMapTreeNode.h>
+#include <casinocoin/basics/contract.h>
+#include <casinocoin/basics/Log.h>
+#include <casinocoin/protocol/digest.h>
+#include <casinocoin/protocol/Serializer.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace casinocoin {
+
+// File layout:
+//
+//   magic    4 bytes
+//   version  4 bytes
+//   count    8 bytes
+//   keys     count * 32 bytes, sorted
+//   checksum 32 bytes, sha512Half of the keys
+//
+static std::uint32_t const fullBelowMagic = 0x43464243;   // "CFBC"
+static std::uint32_t const fullBelowVersion = 1;
+
+bool
+saveFullBelow (FullBelowCache const& cache,
+    boost::filesystem::path const& file, beast::Journal j)
+{
+    auto keys = cache.getKeys ();
+    std::sort (keys.begin (), keys.end ());
+
+    Serializer s (16 + (keys.size () + 1) * uint256::size ());
+    s.add32 (fullBelowMagic);
+    s.add32 (fullBelowVersion);
+    s.add64 (keys.size ());
+
+    sha512_half_hasher h;
+    for (auto const& key : keys)
+    {
+        s.add256 (key);
+        h (key.data (), key.size ());
+    }
+    s.add256 (static_cast<sha512_half_hasher::result_type> (h));
+
+    // Write to a temporary file first, so a crash can't leave a
+    // truncated file behind
+    auto temp = file;
+    temp += ".tmp";
+
+    try
+    {
+        {
+            std::ofstream out (temp.string (),
+                std::ios::out | std::ios::binary | std::ios::trunc);
+            out.write (reinterpret_cast<char const*> (s.data ()), s.size ());
+            if (! out)
+                Throw<std::runtime_error> ("write failed");
+        }
+        boost::filesystem::rename (temp, file);
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j.warn()) <<
+            "Unable to save full below cache to " << file << ": " << e.what ();
+        boost::system::error_code ec;
+        boost::filesystem::remove (temp, ec);
+        return false;
+    }
+
+    JLOG (j.info()) <<
+        "Saved " << keys.size () << " full below keys to " << file;
+    return true;
+}
+
+std::size_t
+loadFullBelow (FullBelowCache& cache,
+    boost::filesystem::path const& file,
+        FullBelowCache::verifier_type verifier, beast::Journal j)
+{
+    boost::system::error_code ec;
+    if (! boost::filesystem::exists (file, ec))
+        return 0;
+
+    Blob data;
+    {
+        std::ifstream in (file.string (), std::ios::in | std::ios::binary);
+        data.assign (std::istreambuf_iterator<char> (in),
+            std::istreambuf_iterator<char> ());
+    }
+
+    // The file is only good for one restart, whatever happens next
+    boost::filesystem::remove (file, ec);
+
+    std::vector<uint256> keys;
+    try
+    {
+        SerialIter sit (makeSlice (data));
+
+        if (sit.get32 () != fullBelowMagic ||
+                sit.get32 () != fullBelowVersion)
+            Throw<std::runtime_error> ("unknown format");
+
+        auto const count = sit.get64 ();
+        if (count > sit.getBytesLeft () / uint256::size ())
+            Throw<std::runtime_error> ("truncated");
+
+        sha512_half_hasher h;
+        keys.reserve (count);
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            keys.push_back (sit.get256 ());
+            h (keys.back ().data (), keys.back ().size ());
+        }
+
+        if (sit.get256 () !=
+                static_cast<sha512_half_hasher::result_type> (h))
+            Throw<std::runtime_error> ("bad checksum");
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j.warn()) <<
+            "Ignoring full below cache " << file << ": " << e.what ();
+        return 0;
+    }
+
+    cache.setPending (keys, std::move (verifier));
+
+    JLOG (j.info()) <<
+        "Loaded " << keys.size () << " full below keys from " << file;
+    return keys.size ();
+}
+
+bool
+subtreeInStore (FullBelowCache& cache, NodeStore::Database& db,
+    uint256 const& root, beast::Journal j)
+{
+    std::vector<uint256> stack {root};
+    std::vector<uint256> inner;
+    while (! stack.empty ())
+    {
+        auto const hash = stack.back ();
+        stack.pop_back ();
+
+        // A subtree already known to be complete needn't be walked again
+        if (hash != root && cache.touch_if_exists (hash))
+            continue;
+
+        auto const obj = db.fetch (hash);
+        if (! obj)
+            return false;
+
+        std::shared_ptr<SHAMapAbstractNode> node;
+        try
+        {
+            node = SHAMapAbstractNode::make (makeSlice (obj->getData ()),
+                0, snfPREFIX, SHAMapHash{hash}, true, j);
+        }
+        catch (std::exception const&)
+        {
+        }
+        if (! node)
+            return false;
+
+        if (node->isInner ())
+        {
+            auto const in = std::static_pointer_cast<SHAMapInnerNode> (node);
+            for (int i = 0; i < 16; ++i)
+            {
+                if (! in->isEmptyBranch (i))
+                    stack.push_back (in->getChildHash (i).as_uint256 ());
+            }
+            inner.push_back (hash);
+        }
+    }
+
+    for (auto const& hash : inner)
+        cache.insert (hash);
+    return true;
+}
+
+} // casinocoin
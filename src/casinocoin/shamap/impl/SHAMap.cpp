@@ -246,6 +246,76 @@ SHAMap::findKey(uint256 const& id) const
     return leaf;
 }
 
+std::size_t
+SHAMap::prefetch (std::vector<uint256> const& keys) const
+{
+    if (! backed_ || ! root_)
+        return 0;
+
+    auto const isv2 = is_v2();
+
+    // Walk towards a key, stopping at the first node which is not in
+    // memory. Returns true if a read for that node was issued.
+    auto const walk = [&](uint256 const& key)
+    {
+        auto node = root_.get();
+        SHAMapNodeID nodeID;
+        while (node->isInner())
+        {
+            if (isv2 && ! static_cast<SHAMapInnerNodeV2*>(
+                    node)->has_common_prefix (key))
+                return false;
+
+            auto const inner = static_cast<SHAMapInnerNode*>(node);
+            auto const branch = nodeID.selectBranch (key);
+            if (inner->isEmptyBranch (branch))
+                return false;
+
+            bool pending;
+            node = descendAsync (inner, branch, nullptr, pending);
+            if (pending)
+                return true;
+            if (! node)
+                return false;
+
+            if (! isv2)
+                nodeID = nodeID.getChildNodeID (branch);
+            else if (node->isInner())
+            {
+                auto const n = static_cast<SHAMapInnerNodeV2*>(node);
+                nodeID = SHAMapNodeID{n->depth(), n->common()};
+            }
+        }
+        return false;
+    };
+
+    std::vector<uint256> waiting;
+    for (auto const& key : keys)
+    {
+        if (walk (key))
+            waiting.push_back (key);
+    }
+
+    auto const reads = waiting.size();
+
+    // Each pass descends at least one more level for every key
+    // still waiting, so the depth of the tree bounds the passes
+    for (int pass = 0; ! waiting.empty() && pass < 64; ++pass)
+    {
+        f_.db().waitReads();
+
+        std::vector<uint256> next;
+        for (auto const& key : waiting)
+        {
+            if (walk (key))
+                next.push_back (key);
+        }
+        waiting.swap (next);
+    }
+
+    return reads;
+}
+
 std::shared_ptr<SHAMapAbstractNode>
 SHAMap::fetchNodeFromDB (SHAMapHash const& hash) const
 {
@@ -26,27 +26,38 @@
 #include <BeastConfig.h>
 #include <casinocoin/basics/contract.h>
 #include <casinocoin/shamap/SHAMap.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <algorithm>
+#include <atomic>
 
 namespace casinocoin {
 
 // This code is used to compare another node's transaction tree
-// to our own. It returns a map containing all items that are different
-// between two SHA maps. It is optimized not to descend down tree
-// branches with the same branch hash. A limit can be passed so
-// that we will abort early if a node sends a map to us that
-// makes no sense at all. (And our sync algorithm will avoid
+// to our own. It reports all items that are different between two
+// SHA maps, in key order. It is optimized not to descend down tree
+// branches with the same branch hash. A limit can be passed to
+// compare so that we will abort early if a node sends a map to us
+// that makes no sense at all. (And our sync algorithm will avoid
 // synchronizing matching branches too.)
 
-bool SHAMap::walkBranch (SHAMapAbstractNode* node,
-                         std::shared_ptr<SHAMapItem const> const& otherMapItem,
-                         bool isFirstMap,Delta& differences, int& maxCount) const
+bool SHAMap::deltaBranch (SHAMapAbstractNode* node,
+                          std::shared_ptr<SHAMapItem const> otherMapItem,
+                          bool isFirstMap, DeltaVisitor const& func) const
 {
-    // Walk a branch of a SHAMap that's matched by an empty branch or single item in the other map
+    // Walk a branch of a SHAMap that's matched by an empty branch or
+    // single item in the other map, reporting its leaves in key order
+    auto report = [&](std::shared_ptr<SHAMapItem const> const& ours,
+        std::shared_ptr<SHAMapItem const> const& theirs)
+    {
+        auto const& key = ours ? ours->key() : theirs->key();
+        if (isFirstMap)
+            return func (key, DeltaItem (ours, theirs));
+        return func (key, DeltaItem (theirs, ours));
+    };
+
     std::stack <SHAMapAbstractNode*, std::vector<SHAMapAbstractNode*>> nodeStack;
     nodeStack.push (node);
 
-    bool emptyBranch = !otherMapItem;
-
     while (!nodeStack.empty ())
     {
         node = nodeStack.top ();
@@ -54,65 +65,116 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
 
         if (node->isInner ())
         {
-            // This is an inner node, add all non-empty branches
+            // This is an inner node, add all non-empty branches so
+            // that the lowest branch is visited first
             auto inner = static_cast<SHAMapInnerNode*>(node);
-            for (int i = 0; i < 16; ++i)
+            for (int i = 15; i >= 0; --i)
                 if (!inner->isEmptyBranch (i))
                     nodeStack.push ({descendThrow (inner, i)});
+            continue;
         }
-        else
+
+        // This is a leaf node, process its item
+        auto const& item = static_cast<SHAMapTreeNode*>(node)->peekItem();
+
+        if (otherMapItem && otherMapItem->key() < item->key())
         {
-            // This is a leaf node, process its item
-            auto item = static_cast<SHAMapTreeNode*>(node)->peekItem();
+            // otherMapItem sorts before this leaf, it is unmatched
+            if (!report (nullptr, otherMapItem))
+                return false;
+            otherMapItem.reset ();
+        }
 
-            if (emptyBranch || (item->key() != otherMapItem->key()))
-            {
-                // unmatched
-                if (isFirstMap)
-                    differences.insert (std::make_pair (item->key(),
-                        DeltaRef (item, std::shared_ptr<SHAMapItem const> ())));
-                else
-                    differences.insert (std::make_pair (item->key(),
-                        DeltaRef (std::shared_ptr<SHAMapItem const> (), item)));
+        if (otherMapItem && otherMapItem->key() == item->key())
+        {
+            // non-matching items with same tag
+            if (item->peekData () != otherMapItem->peekData () &&
+                    !report (item, otherMapItem))
+                return false;
+            otherMapItem.reset ();
+        }
+        else if (!report (item, nullptr))
+        {
+            // unmatched
+            return false;
+        }
+    }
 
-                if (--maxCount <= 0)
-                    return false;
-            }
-            else if (item->peekData () != otherMapItem->peekData ())
-            {
-                // non-matching items with same tag
-                if (isFirstMap)
-                    differences.insert (std::make_pair (item->key(),
-                                                DeltaRef (item, otherMapItem)));
-                else
-                    differences.insert (std::make_pair (item->key(),
-                                                DeltaRef (otherMapItem, item)));
+    // otherMapItem sorts after every leaf, it is unmatched
+    if (otherMapItem)
+        return report (nullptr, otherMapItem);
 
-                if (--maxCount <= 0)
-                    return false;
+    return true;
+}
 
-                emptyBranch = true;
-            }
-            else
-            {
-                // exact match
-                emptyBranch = true;
-            }
+bool
+SHAMap::deltaNodes (SHAMapAbstractNode* ourNode, SHAMap const& otherMap,
+    SHAMapAbstractNode* otherNode, DeltaVisitor const& func) const
+{
+    if (!ourNode && !otherNode)
+        return true;
+
+    if (!otherNode)
+    {
+        // We have a branch, the other tree does not
+        return deltaBranch (ourNode, nullptr, true, func);
+    }
+
+    if (!ourNode)
+    {
+        // The other tree has a branch, we do not
+        return otherMap.deltaBranch (otherNode, nullptr, false, func);
+    }
+
+    if (ourNode->isLeaf () && otherNode->isLeaf ())
+    {
+        // two leaves
+        auto const& ours = static_cast<SHAMapTreeNode*>(ourNode)->peekItem();
+        auto const& other = static_cast<SHAMapTreeNode*>(otherNode)->peekItem();
+
+        if (ours->key() == other->key())
+        {
+            if (ours->peekData () == other->peekData ())
+                return true;
+            return func (ours->key(), DeltaItem (ours, other));
         }
+
+        if (ours->key() < other->key())
+            return func (ours->key(), DeltaItem (ours, nullptr)) &&
+                func (other->key(), DeltaItem (nullptr, other));
+
+        return func (other->key(), DeltaItem (nullptr, other)) &&
+            func (ours->key(), DeltaItem (ours, nullptr));
+    }
+
+    if (ourNode->isInner () && otherNode->isLeaf ())
+    {
+        return deltaBranch (ourNode,
+            static_cast<SHAMapTreeNode*>(otherNode)->peekItem(),
+                true, func);
+    }
+
+    if (ourNode->isLeaf () && otherNode->isInner ())
+    {
+        return otherMap.deltaBranch (otherNode,
+            static_cast<SHAMapTreeNode*>(ourNode)->peekItem(),
+                false, func);
     }
 
-    if (!emptyBranch)
+    // The two trees have inner nodes here, descend into every branch
+    // whose hashes differ
+    auto ours = static_cast<SHAMapInnerNode*>(ourNode);
+    auto other = static_cast<SHAMapInnerNode*>(otherNode);
+    for (int i = 0; i < 16; ++i)
     {
-        // otherMapItem was unmatched, must add
-        if (isFirstMap) // this is first map, so other item is from second
-            differences.insert(std::make_pair(otherMapItem->key(),
-                                              DeltaRef(std::shared_ptr<SHAMapItem const>(),
-                                                       otherMapItem)));
-        else
-            differences.insert(std::make_pair(otherMapItem->key(),
-                DeltaRef(otherMapItem, std::shared_ptr<SHAMapItem const>())));
-
-        if (--maxCount <= 0)
+        if (ours->getChildHash (i) == other->getChildHash (i))
+            continue;
+
+        if (!deltaNodes (
+                ours->isEmptyBranch (i) ? nullptr : descendThrow (ours, i),
+                otherMap,
+                other->isEmptyBranch (i) ? nullptr : otherMap.descendThrow (other, i),
+                func))
             return false;
     }
 
@@ -120,119 +182,95 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
 }
 
 bool
-SHAMap::compare (SHAMap const& otherMap,
-                 Delta& differences, int maxCount) const
+SHAMap::visitDelta (SHAMap const& otherMap,
+    DeltaVisitor const& func, WorkerPool* pool) const
 {
-    // compare two hash trees, add up to maxCount differences to the difference table
-    // return value: true=complete table of differences given, false=too many differences
-    // throws on corrupt tables or missing nodes
     // CAUTION: otherMap is not locked and must be immutable
-
     assert (isValid () && otherMap.isValid ());
 
     if (getHash () == otherMap.getHash ())
         return true;
 
-    using StackEntry = std::pair <SHAMapAbstractNode*, SHAMapAbstractNode*>;
-    std::stack <StackEntry, std::vector<StackEntry>> nodeStack; // track nodes we've pushed
+    SHAMapAbstractNode* ourNode = root_.get();
+    SHAMapAbstractNode* otherNode = otherMap.root_.get();
 
-    nodeStack.push ({root_.get(), otherMap.root_.get()});
-    while (!nodeStack.empty ())
+    if (!ourNode || !otherNode)
     {
-        SHAMapAbstractNode* ourNode = nodeStack.top().first;
-        SHAMapAbstractNode* otherNode = nodeStack.top().second;
-        nodeStack.pop ();
+        assert (false);
+        Throw<SHAMapMissingNode> (type_, uint256 ());
+    }
 
-        if (!ourNode || !otherNode)
-        {
-            assert (false);
-            Throw<SHAMapMissingNode> (type_, uint256 ());
-        }
+    if (!pool || pool->threads () <= 1 ||
+            !ourNode->isInner () || !otherNode->isInner ())
+        return deltaNodes (ourNode, otherMap, otherNode, func);
 
-        if (ourNode->isLeaf () && otherNode->isLeaf ())
-        {
-            // two leaves
-            auto ours = static_cast<SHAMapTreeNode*>(ourNode);
-            auto other = static_cast<SHAMapTreeNode*>(otherNode);
-            if (ours->peekItem()->key() == other->peekItem()->key())
-            {
-                if (ours->peekItem()->peekData () != other->peekItem()->peekData ())
-                {
-                    differences.insert (std::make_pair (ours->peekItem()->key(),
-                                                 DeltaRef (ours->peekItem (),
-                                                 other->peekItem ())));
-                    if (--maxCount <= 0)
-                        return false;
-                }
-            }
-            else
+    // Split the work by the branches of the root. A window of differing
+    // branches is compared on the pool, each into its own buffer, and
+    // the buffers are handed to the caller in branch order so keys stay
+    // sorted.
+    auto ours = static_cast<SHAMapInnerNode*>(ourNode);
+    auto other = static_cast<SHAMapInnerNode*>(otherNode);
+
+    std::vector<int> branches;
+    for (int i = 0; i < 16; ++i)
+        if (ours->getChildHash (i) != other->getChildHash (i))
+            branches.push_back (i);
+
+    using Batch = std::vector<std::pair<uint256, DeltaItem>>;
+    auto const window = std::min (pool->threads (), branches.size ());
+    std::vector<Batch> batches (window);
+
+    for (std::size_t first = 0; first < branches.size (); first += window)
+    {
+        auto const count = std::min (window, branches.size () - first);
+        pool->forEach (count,
+            [&](std::size_t n)
             {
-                differences.insert (std::make_pair(ours->peekItem()->key(),
-                                                   DeltaRef(ours->peekItem(),
-                                                   std::shared_ptr<SHAMapItem const>())));
-                if (--maxCount <= 0)
-                    return false;
+                auto const i = branches[first + n];
+                auto& batch = batches[n];
+                batch.clear ();
+                deltaNodes (
+                    ours->isEmptyBranch (i) ? nullptr : descendThrow (ours, i),
+                    otherMap,
+                    other->isEmptyBranch (i) ? nullptr :
+                        otherMap.descendThrow (other, i),
+                    [&batch](uint256 const& key, DeltaItem const& item)
+                    {
+                        batch.emplace_back (key, item);
+                        return true;
+                    });
+            });
 
-                differences.insert(std::make_pair(other->peekItem()->key(),
-                    DeltaRef(std::shared_ptr<SHAMapItem const>(), other->peekItem ())));
-                if (--maxCount <= 0)
+        for (std::size_t n = 0; n < count; ++n)
+        {
+            for (auto const& d : batches[n])
+            {
+                if (!func (d.first, d.second))
                     return false;
             }
         }
-        else if (ourNode->isInner () && otherNode->isLeaf ())
-        {
-            auto ours = static_cast<SHAMapInnerNode*>(ourNode);
-            auto other = static_cast<SHAMapTreeNode*>(otherNode);
-            if (!walkBranch (ours, other->peekItem (),
-                    true, differences, maxCount))
-                return false;
-        }
-        else if (ourNode->isLeaf () && otherNode->isInner ())
-        {
-            auto ours = static_cast<SHAMapTreeNode*>(ourNode);
-            auto other = static_cast<SHAMapInnerNode*>(otherNode);
-            if (!otherMap.walkBranch (other, ours->peekItem (),
-                                       false, differences, maxCount))
-                return false;
-        }
-        else if (ourNode->isInner () && otherNode->isInner ())
-        {
-            auto ours = static_cast<SHAMapInnerNode*>(ourNode);
-            auto other = static_cast<SHAMapInnerNode*>(otherNode);
-            for (int i = 0; i < 16; ++i)
-                if (ours->getChildHash (i) != other->getChildHash (i))
-                {
-                    if (other->isEmptyBranch (i))
-                    {
-                        // We have a branch, the other tree does not
-                        SHAMapAbstractNode* iNode = descendThrow (ours, i);
-                        if (!walkBranch (iNode,
-                                         std::shared_ptr<SHAMapItem const> (), true,
-                                         differences, maxCount))
-                            return false;
-                    }
-                    else if (ours->isEmptyBranch (i))
-                    {
-                        // The other tree has a branch, we do not
-                        SHAMapAbstractNode* iNode =
-                            otherMap.descendThrow(other, i);
-                        if (!otherMap.walkBranch (iNode,
-                                                   std::shared_ptr<SHAMapItem const>(),
-                                                   false, differences, maxCount))
-                            return false;
-                    }
-                    else // The two trees have different non-empty branches
-                        nodeStack.push ({descendThrow (ours, i),
-                                        otherMap.descendThrow (other, i)});
-                }
-        }
-        else
-            assert (false);
     }
 
     return true;
 }
 
+bool
+SHAMap::compare (SHAMap const& otherMap,
+                 Delta& differences, int maxCount) const
+{
+    // compare two hash trees, add up to maxCount differences to the difference table
+    // return value: true=complete table of differences given, false=too many differences
+    // throws on corrupt tables or missing nodes
+    // CAUTION: otherMap is not locked and must be immutable
+    return visitDelta (otherMap,
+        [&](uint256 const& key, DeltaItem const& item)
+        {
+            differences.insert (differences.end (),
+                std::make_pair (key, item));
+            return --maxCount > 0;
+        });
+}
+
 void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing) const
 {
     if (!root_->isInner ())  // root_ is only node, and we have it
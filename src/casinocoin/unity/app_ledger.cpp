@@ -33,13 +33,16 @@
 #include <casinocoin/app/ledger/Ledger.cpp>
 #include <casinocoin/app/ledger/LedgerHistory.cpp>
 #include <casinocoin/app/ledger/OrderBookDB.cpp>
+#include <casinocoin/app/ledger/StateLeaf.cpp>
 #include <casinocoin/app/ledger/TransactionStateSF.cpp>
 
+#include <casinocoin/app/ledger/impl/BookIndex.cpp>
 #include <casinocoin/app/ledger/impl/InboundLedger.cpp>
 #include <casinocoin/app/ledger/impl/InboundLedgers.cpp>
 #include <casinocoin/app/ledger/impl/InboundTransactions.cpp>
 #include <casinocoin/app/ledger/impl/LedgerCleaner.cpp>
 #include <casinocoin/app/ledger/impl/LedgerMaster.cpp>
+#include <casinocoin/app/ledger/impl/LedgerReplayer.cpp>
 #include <casinocoin/app/ledger/impl/LocalTxs.cpp>
 #include <casinocoin/app/ledger/impl/OpenLedger.cpp>
 #include <casinocoin/app/ledger/impl/LedgerToJson.cpp>
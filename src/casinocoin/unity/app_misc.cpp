@@ -37,9 +37,11 @@
 
 #include <casinocoin/app/misc/impl/AccountTxPaging.cpp>
 #include <casinocoin/app/misc/impl/AmendmentTable.cpp>
+#include <casinocoin/app/misc/impl/BatchTuner.cpp>
 #include <casinocoin/app/misc/impl/configuration/VotableConfiguration.cpp>
 #include <casinocoin/app/misc/impl/LoadFeeTrack.cpp>
 #include <casinocoin/app/misc/impl/Manifest.cpp>
+#include <casinocoin/app/misc/impl/SigVerifier.cpp>
 #include <casinocoin/app/misc/impl/Transaction.cpp>
 #include <casinocoin/app/misc/impl/TxQ.cpp>
 #include <casinocoin/app/misc/impl/ValidatorList.cpp>
@@ -28,8 +28,12 @@
 #include <casinocoin/app/paths/CasinocoinState.cpp>
 #include <casinocoin/app/paths/AccountCurrencies.cpp>
 #include <casinocoin/app/paths/Credit.cpp>
+#include <casinocoin/app/paths/PathLiquidityCache.cpp>
+#include <casinocoin/app/paths/TrustLineGraph.cpp>
+#include <casinocoin/app/paths/TrustLineTotals.cpp>
 #include <casinocoin/app/paths/Pathfinder.cpp>
 #include <casinocoin/app/paths/Node.cpp>
+#include <casinocoin/app/paths/PathFindScheduler.cpp>
 #include <casinocoin/app/paths/PathRequest.cpp>
 #include <casinocoin/app/paths/PathRequests.cpp>
 #include <casinocoin/app/paths/PathState.cpp>
@@ -45,5 +45,6 @@
 #include <casinocoin/app/tx/impl/SignerEntries.cpp>
 #include <casinocoin/app/tx/impl/Taker.cpp>
 #include <casinocoin/app/tx/impl/ApplyContext.cpp>
+#include <casinocoin/app/tx/impl/ApplyProfiler.cpp>
 #include <casinocoin/app/tx/impl/Transactor.cpp>
 #include <casinocoin/app/tx/impl/SetKYC.cpp>
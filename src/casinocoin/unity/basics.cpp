@@ -29,6 +29,7 @@
 #include <casinocoin/basics/impl/CheckLibraryVersions.cpp>
 #include <casinocoin/basics/impl/contract.cpp>
 #include <casinocoin/basics/impl/CountedObject.cpp>
+#include <casinocoin/basics/impl/Histogram.cpp>
 #include <casinocoin/basics/impl/Log.cpp>
 #include <casinocoin/basics/impl/make_SSLContext.cpp>
 #include <casinocoin/basics/impl/mulDiv.cpp>
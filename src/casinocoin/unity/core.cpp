@@ -36,5 +36,6 @@
 #include <casinocoin/core/impl/Stoppable.cpp>
 #include <casinocoin/core/impl/TerminateHandler.cpp>
 #include <casinocoin/core/impl/TimeKeeper.cpp>
+#include <casinocoin/core/impl/WorkerPool.cpp>
 #include <casinocoin/core/impl/Workers.cpp>
 
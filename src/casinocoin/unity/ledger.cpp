@@ -33,9 +33,11 @@
 #include <casinocoin/ledger/impl/CachedView.cpp>
 #include <casinocoin/ledger/impl/CashDiff.cpp>
 #include <casinocoin/ledger/impl/Directory.cpp>
+#include <casinocoin/ledger/impl/MetaWriter.cpp>
 #include <casinocoin/ledger/impl/OpenView.cpp>
 #include <casinocoin/ledger/impl/PaymentSandbox.cpp>
 #include <casinocoin/ledger/impl/RawStateTable.cpp>
 #include <casinocoin/ledger/impl/ReadView.cpp>
 #include <casinocoin/ledger/impl/TxMeta.cpp>
+#include <casinocoin/ledger/impl/TxRecorder.cpp>
 #include <casinocoin/ledger/impl/View.cpp>
@@ -45,6 +45,7 @@
 #include <casinocoin/rpc/handlers/AccountTx.cpp>
 #include <casinocoin/rpc/handlers/AccountTxOld.cpp>
 #include <casinocoin/rpc/handlers/AccountTxSwitch.cpp>
+#include <casinocoin/rpc/handlers/ApplyProfile.cpp>
 #include <casinocoin/rpc/handlers/BlackList.cpp>
 #include <casinocoin/rpc/handlers/BookOffers.cpp>
 #include <casinocoin/rpc/handlers/CanDelete.cpp>
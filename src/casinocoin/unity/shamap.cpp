@@ -24,6 +24,7 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <casinocoin/shamap/impl/FullBelowCache.cpp>
 #include <casinocoin/shamap/impl/SHAMap.cpp>
 #include <casinocoin/shamap/impl/SHAMapDelta.cpp>
 #include <casinocoin/shamap/impl/SHAMapItem.cpp>
@@ -0,0 +1,221 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/misc/BatchTuner.h>
+#include <casinocoin/app/misc/NetworkOPs.h>
+#include <casinocoin/app/misc/Transaction.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <test/jtx.h>
+#include <atomic>
+#include <thread>
+
+namespace casinocoin {
+namespace test {
+
+class BatchTuner_test : public beast::unit_test::suite
+{
+    using clock_type = BatchTuner::clock_type;
+
+    // Record a batch of `size` transactions submitted `age` before
+    // it started, which waited `wait` to be applied and took `cost`
+    // per transaction to apply
+    static void
+    batch (BatchTuner& tuner, std::size_t size,
+        std::chrono::microseconds age, std::chrono::microseconds cost,
+            std::chrono::microseconds wait = {})
+    {
+        auto const start = clock_type::now ();
+        std::vector<clock_type::time_point> submitted (size, start - age);
+        tuner.record (submitted, start, start + wait,
+            start + wait + cost * size);
+    }
+
+    void
+    testBatchSize ()
+    {
+        testcase ("batch size");
+        using namespace std::chrono;
+
+        BatchTuner::Setup setup;
+        setup.targetLatency = milliseconds (100);
+        setup.minBatch = 4;
+        setup.maxBatch = 1000;
+        BatchTuner tuner (setup);
+
+        // Nothing measured yet, so everything up to the maximum
+        BEAST_EXPECT(tuner.batchSize (10) == 10);
+        BEAST_EXPECT(tuner.batchSize (5000) == 1000);
+
+        // 100us a transaction fits 500 in half the target
+        batch (tuner, 10, microseconds (0), microseconds (100));
+        BEAST_EXPECT(tuner.cost () == 100);
+        BEAST_EXPECT(tuner.batchSize (10) == 10);
+        BEAST_EXPECT(tuner.batchSize (5000) == 500);
+
+        // Slower transactions give smaller batches, but not below
+        // the minimum
+        for (int i = 0; i < 20; ++i)
+            batch (tuner, 10, microseconds (0), milliseconds (100));
+        BEAST_EXPECT(tuner.batchSize (5000) == 4);
+        BEAST_EXPECT(tuner.batchSize (2) == 2);
+    }
+
+    void
+    testCost ()
+    {
+        testcase ("cost");
+        using namespace std::chrono;
+
+        BatchTuner::Setup setup;
+        setup.targetLatency = milliseconds (100);
+        BatchTuner tuner (setup);
+
+        // Waiting to apply a batch isn't part of its cost, but does
+        // add to its latency
+        batch (tuner, 10, microseconds (0), microseconds (100),
+            milliseconds (50));
+        BEAST_EXPECT(tuner.cost () == 100);
+        BEAST_EXPECT(tuner.latency () >= milliseconds (51));
+    }
+
+    void
+    testAdmit ()
+    {
+        testcase ("admit");
+        using namespace std::chrono;
+
+        BatchTuner::Setup setup;
+        setup.targetLatency = milliseconds (100);
+        BatchTuner tuner (setup);
+
+        BEAST_EXPECT(tuner.admit (100000));
+
+        // 1ms a transaction lets 100 fit in the target
+        batch (tuner, 10, microseconds (0), milliseconds (1));
+        BEAST_EXPECT(tuner.admit (98));
+        BEAST_EXPECT(tuner.admit (99));
+        BEAST_EXPECT(! tuner.admit (100));
+
+        // Latency over the target shrinks the queue allowed
+        for (int i = 0; i < 10; ++i)
+            batch (tuner, 10, milliseconds (200), milliseconds (1));
+        BEAST_EXPECT(tuner.latency () >= milliseconds (200));
+        BEAST_EXPECT(! tuner.admit (50));
+        BEAST_EXPECT(tuner.admit (5));
+
+        // and latency well under the target grows it back
+        for (int i = 0; i < 200; ++i)
+            batch (tuner, 10, microseconds (0), milliseconds (1));
+        BEAST_EXPECT(tuner.latency () < milliseconds (50));
+        BEAST_EXPECT(tuner.admit (99));
+
+        auto const jv = tuner.getJson ();
+        BEAST_EXPECT(jv[jss::dropped] == "2");
+        BEAST_EXPECT(jv[jss::batch_size][jss::count] == 211);
+        BEAST_EXPECT(jv[jss::latency_us][jss::count] == 2110);
+    }
+
+public:
+    void
+    run ()
+    {
+        testBatchSize ();
+        testCost ();
+        testAdmit ();
+    }
+};
+
+// Relays payments into the server from several threads faster than
+// it can apply them, and reports the latency the batches achieve
+class BatchTunerOverload_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        using namespace std::chrono;
+
+        auto p = envconfig ();
+        p->section ("transaction_batch").set ("target_latency", "100");
+        Env env (*this, std::move (p));
+
+        int const clients = 8;
+        int const perClient = 500;
+
+        Account const gw ("gateway");
+        env.fund (CSC(1000000), gw);
+        std::vector<Account> senders;
+        for (int i = 0; i < clients; ++i)
+        {
+            senders.emplace_back ("s" + std::to_string (i));
+            env.fund (CSC(100000), senders.back ());
+        }
+        env.close ();
+
+        // Sign everything up front so the clients only submit
+        std::vector<std::vector<std::shared_ptr<STTx const>>> txs (clients);
+        for (int i = 0; i < clients; ++i)
+        {
+            auto seq = env.seq (senders[i]);
+            for (int j = 0; j < perClient; ++j)
+                txs[i].push_back (env.jt (pay (senders[i], gw, CSC(1)),
+                    jtx::seq (seq++), fee (10)).stx);
+        }
+
+        auto const start = steady_clock::now ();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < clients; ++i)
+        {
+            threads.emplace_back ([&, i]
+            {
+                for (auto const& stx : txs[i])
+                {
+                    std::string reason;
+                    auto tx = std::make_shared<Transaction> (
+                        stx, reason, env.app ());
+                    env.app ().getOPs ().processTransaction (
+                        tx, false, false, NetworkOPs::FailHard::no);
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join ();
+
+        // Wait for the queue to drain
+        auto& jq = env.app ().getJobQueue ();
+        while (jq.getJobCount (jtBATCH) > 0)
+            std::this_thread::sleep_for (milliseconds (10));
+
+        auto const jv = env.app ().getOPs ().getTransactionBatchJson ();
+        log << clients * perClient << " transactions in " <<
+            duration_cast<milliseconds> (steady_clock::now () - start).count () <<
+            "ms" << std::endl << jv.toStyledString () << std::endl;
+
+        // The latest latencies stay within reach of the target
+        BEAST_EXPECT(std::stoull (jv[jss::p99_us].asString ()) < 200000);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(BatchTuner,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(BatchTunerOverload,app,casinocoin);
+
+} // test
+} // casinocoin
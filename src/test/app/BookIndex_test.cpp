@@ -0,0 +1,445 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/BookIndex.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/misc/NetworkOPs.h>
+#include <casinocoin/ledger/OpenView.h>
+#include <casinocoin/ledger/View.h>
+#include <casinocoin/protocol/Indexes.h>
+#include <chrono>
+#include <thread>
+
+namespace casinocoin {
+namespace test {
+
+// The offers of a book in the order a walk of its directories visits them
+static
+std::vector<uint256>
+walkBook (ReadView const& view, Book const& book)
+{
+    std::vector<uint256> keys;
+    auto const end = getQualityNext (getBookBase (book));
+    auto tip = getBookBase (book);
+    while (auto const dir = view.succ (tip, end))
+    {
+        tip = *dir;
+        std::uint64_t page = 0;
+        while (auto const sle = view.read (keylet::page (*dir, page)))
+        {
+            for (auto const& key : sle->getFieldV256 (sfIndexes))
+                keys.push_back (key);
+            page = sle->getFieldU64 (sfIndexNext);
+            if (page == 0)
+                break;
+        }
+    }
+    return keys;
+}
+
+// Wait for the ledger to be published, which happens on a job
+static
+std::shared_ptr<BookIndex::Snapshot const>
+waitForIndex (jtx::Env& env, ReadView const& ledger)
+{
+    using namespace std::chrono_literals;
+    for (int i = 0; i < 500; ++i)
+    {
+        auto const index = env.app ().getOPs ().getBookIndex ();
+        if (index && index->hash () == ledger.info ().hash)
+            return index;
+        std::this_thread::sleep_for (10ms);
+    }
+    return nullptr;
+}
+
+class BookIndex_test : public beast::unit_test::suite
+{
+    // The closed ledgers of an Env, so an index can walk back through them
+    struct History
+    {
+        hash_map<uint256, std::shared_ptr<ReadView const>> ledgers;
+        int fetched = 0;
+
+        std::shared_ptr<ReadView const>
+        close (jtx::Env& env)
+        {
+            env.close ();
+            auto const ledger = env.closed ();
+            ledgers[ledger->info ().hash] = ledger;
+            return ledger;
+        }
+
+        BookIndex::GetLedger
+        getLedger ()
+        {
+            return [this](uint256 const& hash)
+                -> std::shared_ptr<ReadView const>
+            {
+                ++fetched;
+                auto const iter = ledgers.find (hash);
+                if (iter == ledgers.end ())
+                    return nullptr;
+                return iter->second;
+            };
+        }
+    };
+
+    // The index has the offers of the directories, with their funds
+    bool
+    sameBook (BookIndex::Snapshot const& index, ReadView const& ledger,
+        Book const& book)
+    {
+        std::vector<uint256> keys;
+        bool same = index.seq () == ledger.seq () &&
+            index.hash () == ledger.info ().hash;
+        if (auto const offers = index.offers (book))
+        {
+            same = same && ! offers->empty ();
+            for (auto const& offer : *offers)
+            {
+                keys.push_back (offer.sle->key ());
+                auto funds = accountHolds (ledger,
+                    offer.sle->getAccountID (sfAccount), book.out.currency,
+                        book.out.account, fhZERO_IF_FROZEN, beast::Journal ());
+                if (funds < zero)
+                    funds.clear ();
+                auto const sle = ledger.read (keylet::offer (keys.back ()));
+                same = same && sle &&
+                    offer.ownerFunds == funds &&
+                    offer.sle->getFieldAmount (sfTakerGets) ==
+                        sle->getFieldAmount (sfTakerGets) &&
+                    offer.sle->getFieldAmount (sfTakerPays) ==
+                        sle->getFieldAmount (sfTakerPays);
+            }
+        }
+        return same && keys == walkBook (ledger, book);
+    }
+
+    void
+    testIncremental ()
+    {
+        testcase ("incremental");
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        BookIndex index {beast::Journal ()};
+
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        Account const bob ("bob");
+        Account const carol ("carol");
+        Account const dan ("dan");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        Book const cscToUSD (cscIssue (), USD.issue ());
+        Book const usdToCSC (USD.issue (), cscIssue ());
+        Book const cscToEUR (cscIssue (), EUR.issue ());
+        std::vector<Book> const books {cscToUSD, usdToCSC, cscToEUR};
+
+        auto const check = [&](std::shared_ptr<ReadView const> const& ledger)
+        {
+            auto const snapshot = index.update (ledger, history.getLedger ());
+            for (auto const& book : books)
+                BEAST_EXPECT(sameBook (*snapshot, *ledger, book));
+            return snapshot;
+        };
+
+        env.fund (CSC(100000), gw, alice, bob, carol, dan);
+        env.close ();
+        env (trust (alice, USD(10000)));
+        env (trust (bob, USD(10000)));
+        env (trust (carol, USD(10000)));
+        env (trust (dan, EUR(10000)));
+        env (pay (gw, alice, USD(1000)));
+        env (pay (gw, bob, USD(1000)));
+        env (pay (gw, dan, EUR(1000)));
+        auto ledger = history.close (env);
+
+        BEAST_EXPECT(! index.current ());
+        auto snapshot = check (ledger);
+        BEAST_EXPECT(snapshot->books () == 0);
+
+        // More offers at one quality than fit in a directory page
+        std::vector<std::uint32_t> seqs;
+        for (int i = 0; i < 40; ++i)
+        {
+            seqs.push_back (env.seq (alice));
+            env (offer (alice, CSC(100), USD(10)));
+        }
+        env (offer (bob, CSC(90), USD(10)));
+        env (offer (alice, USD(10), CSC(100)));
+        env (offer (dan, CSC(50), EUR(5)));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(history.fetched == 0);
+        BEAST_EXPECT(snapshot->books () == 3);
+        BEAST_EXPECT(snapshot->offers (cscToUSD)->size () == 41);
+
+        // Updating to the same ledger again does nothing, and open
+        // ledgers are ignored
+        BEAST_EXPECT(index.update (ledger, history.getLedger ()) == snapshot);
+        BEAST_EXPECT(index.update (env.current (),
+            history.getLedger ()) == snapshot);
+
+        // Crossing consumes the best offers and part of the next one,
+        // leaving the books nobody touched as they were
+        auto const eurOffers = snapshot->offers (cscToEUR);
+        env (offer (carol, USD(25), CSC(260)));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(snapshot->offers (cscToUSD)->size () == 39);
+        BEAST_EXPECT(snapshot->offers (cscToEUR) == eurOffers);
+
+        // Cancel offers on both pages, then add more which go on the end
+        for (auto const i : {3, 20, 35})
+            env (offer_cancel (alice, seqs[i]));
+        for (int i = 0; i < 5; ++i)
+            env (offer (alice, CSC(100), USD(10)));
+        env (offer (bob, CSC(95), USD(10)));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(snapshot->offers (cscToUSD)->size () == 42);
+
+        // Paying away funds leaves the offers underfunded
+        env (pay (alice, bob, USD(800)));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(snapshot->offers (cscToEUR) == eurOffers);
+
+        // A global freeze changes what every holder of the issuer's
+        // currencies can offer
+        env (fset (gw, asfGlobalFreeze));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(snapshot->offers (cscToEUR)->front ().ownerFunds == zero);
+        env (fclear (gw, asfGlobalFreeze));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(snapshot->offers (cscToEUR)->front ().ownerFunds ==
+            EUR(1000).value ());
+
+        // Skipped ledgers are fetched and applied in turn
+        env (offer (carol, USD(10), CSC(100)));
+        history.close (env);
+        env (offer_cancel (alice, seqs[10]));
+        history.close (env);
+        env (offer (bob, CSC(80), USD(10)));
+        ledger = history.close (env);
+        history.fetched = 0;
+        snapshot = check (ledger);
+        BEAST_EXPECT(history.fetched == 2);
+
+        // Without the ledgers in between, the index is built again
+        env (offer (bob, CSC(85), USD(10)));
+        history.close (env);
+        ledger = history.close (env);
+        history.ledgers.clear ();
+        snapshot = check (ledger);
+
+        // Cancelling the last offer of a book removes it
+        env (offer_cancel (dan, env.seq (dan) - 1));
+        ledger = history.close (env);
+        snapshot = check (ledger);
+        BEAST_EXPECT(! snapshot->offers (cscToEUR));
+        BEAST_EXPECT(snapshot->books () == 2);
+    }
+
+    void
+    testBookPage ()
+    {
+        testcase ("book page");
+        using namespace jtx;
+
+        Env env (*this);
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        Account const bob ("bob");
+        auto const USD = gw["USD"];
+
+        env.fund (CSC(100000), gw, alice, bob);
+        env.close ();
+        env (rate (gw, 1.002));
+        env (trust (alice, USD(10000)));
+        env (trust (bob, USD(10000)));
+        env (pay (gw, alice, USD(100)));
+        env (pay (gw, bob, USD(1000)));
+        env.close ();
+
+        for (int i = 0; i < 20; ++i)
+        {
+            env (offer (alice, CSC(100 + i), USD(10)));
+            env (offer (bob, CSC(100 + i), USD(20)));
+        }
+        env (offer (gw, CSC(150), USD(50)));
+        env (offer (bob, USD(10), CSC(100)));
+        env.close ();
+
+        auto ledger = env.closed ();
+        auto const index = waitForIndex (env, *ledger);
+        if (! BEAST_EXPECT(index))
+            return;
+        BEAST_EXPECT(index->books () == 2);
+
+        // The same ledger, read through a view the index doesn't serve
+        std::shared_ptr<ReadView const> walked =
+            std::make_shared<OpenView> (open_ledger, ledger->rules (), ledger);
+
+        auto const page = [&](std::shared_ptr<ReadView const> view,
+            Book const& book, AccountID const& taker, unsigned int limit)
+        {
+            Json::Value result;
+            env.app ().getOPs ().getBookPage (view, book, taker,
+                false, limit, Json::nullValue, result);
+            return result[jss::offers];
+        };
+
+        for (auto const& book : {Book (cscIssue (), USD.issue ()),
+            Book (USD.issue (), cscIssue ()), Book (cscIssue (), gw["EUR"].issue ())})
+        {
+            for (auto const& taker : {alice.id (), gw.id (), noAccount ()})
+            {
+                for (unsigned int limit : {1u, 7u, 100u})
+                {
+                    auto const indexed = page (ledger, book, taker, limit);
+                    BEAST_EXPECT(indexed == page (walked, book, taker, limit));
+                    BEAST_EXPECT(indexed.size () <= limit);
+                }
+            }
+        }
+
+        // A book page for the next ledger comes from the next index
+        env (offer (alice, USD(30), CSC(400)));
+        env.close ();
+        ledger = env.closed ();
+        BEAST_EXPECT(waitForIndex (env, *ledger));
+        walked = std::make_shared<OpenView> (
+            open_ledger, ledger->rules (), ledger);
+        Book const book (cscIssue (), USD.issue ());
+        BEAST_EXPECT(page (ledger, book, noAccount (), 100) ==
+            page (walked, book, noAccount (), 100));
+    }
+
+public:
+    void
+    run ()
+    {
+        testIncremental ();
+        testBookPage ();
+    }
+};
+
+// Compares book queries served from the index with directory walks, and
+// reports the throughput of crossing a deep book
+class BookIndexTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        Env env (*this);
+        Account const gw ("gateway");
+        auto const USD = gw["USD"];
+        env.fund (CSC(10000000), gw);
+        env.close ();
+
+        std::vector<Account> makers;
+        for (int i = 0; i < 200; ++i)
+        {
+            makers.emplace_back ("m" + std::to_string (i));
+            auto const& m = makers.back ();
+            env.fund (CSC(100000), m);
+            env.close ();
+            env (trust (m, USD(100000)));
+            env (pay (gw, m, USD(10000)));
+            for (int j = 0; j < 20; ++j)
+                env (offer (m, CSC(100 + j % 10), USD(1)));
+            if (i % 20 == 19)
+                env.close ();
+        }
+        env.close ();
+
+        auto const ledger = env.closed ();
+        auto const start = clock_type::now ();
+        BookIndex index {beast::Journal ()};
+        auto const snapshot = index.update (ledger, nullptr);
+        log << "built index of " << snapshot->books () << " books in " <<
+            elapsed (start) << "us" << std::endl;
+
+        if (! BEAST_EXPECT(waitForIndex (env, *ledger)))
+            return;
+
+        std::shared_ptr<ReadView const> const walked =
+            std::make_shared<OpenView> (open_ledger, ledger->rules (), ledger);
+        Book const book (cscIssue (), USD.issue ());
+        for (unsigned int limit : {10u, 100u, 1000u})
+        {
+            for (auto view : {walked, ledger})
+            {
+                auto const start = clock_type::now ();
+                for (int i = 0; i < 20; ++i)
+                {
+                    Json::Value result;
+                    env.app ().getOPs ().getBookPage (view, book,
+                        noAccount (), false, limit, Json::nullValue, result);
+                }
+                log << "book page of " << limit <<
+                    (view == ledger ? " from index: " : " from walk: ") <<
+                    elapsed (start) / 20 << "us" << std::endl;
+            }
+        }
+
+        // Each taker crosses a few of the best offers
+        Account const taker ("taker");
+        env.fund (CSC(1000000), taker);
+        env (trust (taker, USD(100000)));
+        env.close ();
+
+        std::size_t const crossings = 500;
+        auto const crossStart = clock_type::now ();
+        for (std::size_t i = 0; i < crossings; ++i)
+        {
+            env (offer (taker, USD(3), CSC(330)));
+            if (i % 50 == 49)
+                env.close ();
+        }
+        auto const us = elapsed (crossStart);
+        log << crossings << " crossing offers in " << us << "us, " <<
+            crossings * 1000000 / std::max<std::int64_t> (us, 1) <<
+                " tx/s" << std::endl;
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(BookIndex,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(BookIndexTiming,app,casinocoin);
+
+} // test
+} // casinocoin
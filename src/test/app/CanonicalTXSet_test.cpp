@@ -0,0 +1,306 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/misc/CanonicalTXSet.h>
+#include <casinocoin/beast/unit_test.h>
+#include <casinocoin/protocol/digest.h>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace casinocoin {
+namespace test {
+
+// An account which looks like a real one
+static
+AccountID
+account (int i)
+{
+    auto const hash = sha512Half (std::uint32_t (i));
+    AccountID ret;
+    std::memcpy (ret.data (), hash.data (), ret.size ());
+    return ret;
+}
+
+// Unsigned transactions, `perAccount` from each account with
+// sequences in decreasing order
+static
+std::vector<std::shared_ptr<STTx const>>
+makeTxns (int accounts, int perAccount)
+{
+    std::vector<std::shared_ptr<STTx const>> txns;
+    txns.reserve (accounts * perAccount);
+    for (int seq = perAccount; seq > 0; --seq)
+    {
+        for (int i = 0; i < accounts; ++i)
+        {
+            txns.push_back (std::make_shared<STTx const> (ttACCOUNT_SET,
+                [&](auto& obj)
+                {
+                    obj.setAccountID (sfAccount, account (i));
+                    obj.setFieldU32 (sfSequence, seq);
+                }));
+        }
+    }
+    return txns;
+}
+
+static
+std::vector<uint256>
+ids (CanonicalTXSet const& set)
+{
+    std::vector<uint256> ret;
+    for (auto const& item : set)
+        ret.push_back (item.second->getTransactionID ());
+    return ret;
+}
+
+class CanonicalTXSet_test : public beast::unit_test::suite
+{
+    void
+    testOrder ()
+    {
+        testcase ("order");
+
+        auto const txns = makeTxns (20, 5);
+        auto const salt = sha512Half (std::uint32_t (1));
+
+        CanonicalTXSet single (salt);
+        for (auto const& txn : txns)
+            single.insert (txn);
+        BEAST_EXPECT(single.size () == txns.size ());
+
+        // Transactions from an account are grouped in sequence order
+        {
+            std::set<AccountID> seen;
+            AccountID current;
+            std::uint32_t seq = 0;
+            bool ordered = true;
+            for (auto const& item : single)
+            {
+                auto const& txn = *item.second;
+                if (txn.getAccountID (sfAccount) != current)
+                {
+                    current = txn.getAccountID (sfAccount);
+                    ordered = ordered && seen.insert (current).second;
+                    seq = 0;
+                }
+                ordered = ordered && txn.getSequence () > seq;
+                seq = txn.getSequence ();
+            }
+            BEAST_EXPECT(ordered);
+            BEAST_EXPECT(seen.size () == 20);
+        }
+
+        // A bulk insert gives the same order, and drops duplicates
+        CanonicalTXSet bulk (salt);
+        bulk.insert (std::vector<std::shared_ptr<STTx const>> (
+            txns.begin (), txns.begin () + 50));
+        bulk.insert (txns);
+        BEAST_EXPECT(bulk.size () == txns.size ());
+        BEAST_EXPECT(ids (bulk) == ids (single));
+
+        // So does a single insert into a bulk built set
+        CanonicalTXSet mixed (salt);
+        mixed.insert (std::vector<std::shared_ptr<STTx const>> (
+            txns.begin () + 1, txns.end ()));
+        mixed.insert (txns.front ());
+        mixed.insert (txns.front ());
+        BEAST_EXPECT(ids (mixed) == ids (single));
+
+        // A different salt gives a different order of accounts
+        CanonicalTXSet other (sha512Half (std::uint32_t (2)));
+        other.insert (txns);
+        BEAST_EXPECT(ids (other) != ids (single));
+    }
+
+    void
+    testErase ()
+    {
+        testcase ("erase");
+
+        auto const txns = makeTxns (10, 3);
+        CanonicalTXSet set (uint256 {});
+        set.insert (txns);
+        auto const all = ids (set);
+
+        // Erase every other entry
+        std::vector<uint256> kept;
+        bool erase = true;
+        for (auto it = set.begin (); it != set.end ();)
+        {
+            if (erase)
+            {
+                it = set.erase (it);
+            }
+            else
+            {
+                kept.push_back (it->second->getTransactionID ());
+                ++it;
+            }
+            erase = ! erase;
+        }
+        BEAST_EXPECT(set.size () == kept.size ());
+        BEAST_EXPECT(ids (set) == kept);
+        BEAST_EXPECT(! set.empty ());
+
+        // Erased entries can be inserted again
+        for (auto const& txn : txns)
+            set.insert (txn);
+        BEAST_EXPECT(set.size () == txns.size ());
+        BEAST_EXPECT(ids (set) == all);
+
+        for (auto it = set.begin (); it != set.end ();)
+            it = set.erase (it);
+        BEAST_EXPECT(set.empty ());
+        BEAST_EXPECT(set.begin () == set.end ());
+
+        set.insert (txns);
+        BEAST_EXPECT(ids (set) == all);
+
+        set.reset (uint256 {});
+        BEAST_EXPECT(set.empty ());
+    }
+
+    void
+    testPrune ()
+    {
+        testcase ("prune");
+
+        auto const txns = makeTxns (5, 4);
+        CanonicalTXSet set (uint256 {});
+        set.insert (txns);
+
+        auto const pruned = set.prune (account (3), 2);
+        BEAST_EXPECT(pruned.size () == 1);
+        BEAST_EXPECT(pruned[0]->getAccountID (sfAccount) == account (3));
+        BEAST_EXPECT(pruned[0]->getSequence () == 2);
+        BEAST_EXPECT(set.size () == txns.size () - 1);
+        for (auto const& item : set)
+            BEAST_EXPECT(item.second != pruned[0]);
+
+        BEAST_EXPECT(set.prune (account (3), 2).empty ());
+        BEAST_EXPECT(set.prune (account (9), 1).empty ());
+        BEAST_EXPECT(set.size () == txns.size () - 1);
+    }
+
+public:
+    void
+    run ()
+    {
+        testOrder ();
+        testErase ();
+        testPrune ();
+    }
+};
+
+// Times building a canonical set for a consensus close and walking it
+// over the retry passes, against the node based map it replaced
+class CanonicalTXSetTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        auto const salt = sha512Half (std::uint32_t (1));
+        auto const txns = makeTxns (2500, 4);
+
+        // Most transactions apply in the first pass, a few need one
+        // more pass and a few fail
+        auto const outcome = [](std::size_t i, int pass)
+        {
+            if (i % 50 == 0)
+                return pass == 0 ? 0 : 1;
+            if (i % 97 == 0)
+                return 0;
+            return 1;
+        };
+
+        for (int round = 0; round < 3; ++round)
+        {
+            std::size_t mapLeft = 0;
+            auto start = clock_type::now ();
+            {
+                using Key = std::tuple<uint256, std::uint32_t, uint256>;
+                std::map<Key, std::shared_ptr<STTx const>> map;
+                for (auto const& txn : txns)
+                {
+                    uint256 account;
+                    auto const id = txn->getAccountID (sfAccount);
+                    memcpy (account.begin (), id.begin (), id.size ());
+                    map.emplace (Key (account ^ salt, txn->getSequence (),
+                        txn->getTransactionID ()), txn);
+                }
+                for (int pass = 0; pass < 3; ++pass)
+                {
+                    std::size_t i = 0;
+                    for (auto it = map.begin (); it != map.end (); ++i)
+                    {
+                        if (outcome (i, pass))
+                            it = map.erase (it);
+                        else
+                            ++it;
+                    }
+                }
+                mapLeft = map.size ();
+            }
+            auto const mapTime = elapsed (start);
+
+            std::size_t setLeft = 0;
+            start = clock_type::now ();
+            {
+                CanonicalTXSet set (salt);
+                set.insert (txns);
+                for (int pass = 0; pass < 3; ++pass)
+                {
+                    std::size_t i = 0;
+                    for (auto it = set.begin (); it != set.end (); ++i)
+                    {
+                        if (outcome (i, pass))
+                            it = set.erase (it);
+                        else
+                            ++it;
+                    }
+                }
+                setLeft = set.size ();
+            }
+            auto const setTime = elapsed (start);
+
+            BEAST_EXPECT(mapLeft == setLeft);
+            log << txns.size () << " transactions: map " << mapTime <<
+                "us, flat " << setTime << "us" << std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(CanonicalTXSet,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(CanonicalTXSetTiming,app,casinocoin);
+
+} // test
+} // casinocoin
@@ -27,6 +27,7 @@
 #include <test/jtx/PathSet.h>
 #include <casinocoin/protocol/Feature.h>
 #include <casinocoin/protocol/JsonFields.h>
+#include <chrono>
 
 namespace casinocoin {
 namespace test {
@@ -1289,7 +1290,100 @@ struct Flow_test : public beast::unit_test::suite
     }
 };
 
+// Measures payments through direct and book steps
+class FlowTiming_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    static
+    std::int64_t
+    elapsed (clock_type::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds> (
+            clock_type::now () - start).count ();
+    }
+
+    void
+    report (std::string const& name, int count, std::int64_t us)
+    {
+        log << name << ": " << count << " in " << us << "us (" <<
+            (us ? count * 1000000ll / us : 0) << "/s)" << std::endl;
+    }
+
+    // Runs the same flow repeatedly against one view
+    void
+    measureFlow (jtx::Env& env, std::string const& name,
+        STAmount const& deliver, jtx::Account const& src,
+        jtx::Account const& dst, STPathSet const& paths,
+        boost::optional<STAmount> const& sendMax)
+    {
+        int const iterations = 5000;
+        auto const j = env.app ().logs ().journal ("Flow");
+        auto const view = env.current ();
+
+        int failed = 0;
+        auto const start = clock_type::now ();
+        for (int i = 0; i < iterations; ++i)
+        {
+            PaymentSandbox sb (view.get (), tapNONE);
+            auto const r = flow (sb, deliver, src, dst, paths, paths.empty (),
+                false, false, false, boost::none, sendMax, j);
+            if (r.result () != tesSUCCESS)
+                ++failed;
+        }
+        auto const us = elapsed (start);
+        BEAST_EXPECT(failed == 0);
+        report (name + " flows", iterations, us);
+    }
+
+public:
+    void
+    run () override
+    {
+        using namespace jtx;
+
+        Env env (*this, features (featureFlow, fix1373));
+        auto const gw = Account ("gateway");
+        auto const USD = gw["USD"];
+        auto const BTC = gw["BTC"];
+        Account const alice ("alice");
+        Account const bob ("bob");
+        Account const carol ("carol");
+
+        env.fund (CSC (10000000), alice, bob, carol, gw);
+        env.trust (USD (10000000), alice, bob, carol);
+        env.trust (BTC (10000000), alice, bob, carol);
+        env (pay (gw, alice, USD (1000000)));
+        env (pay (gw, alice, BTC (1000000)));
+        env (pay (gw, bob, USD (1000000)));
+        env (offer (bob, BTC (1000000), USD (1000000)));
+        env (offer (bob, BTC (1000000), CSC (1000000)));
+        env (offer (bob, CSC (1000000), USD (1000000)));
+        env.close ();
+
+        STPathSet const none;
+        measureFlow (env, "direct", USD (10), alice, carol, none, boost::none);
+        measureFlow (env, "one book", USD (10), alice, carol,
+            PathSet (Path (USD.issue ())).paths, STAmount (BTC (10)));
+        measureFlow (env, "two books", USD (10), alice, carol,
+            PathSet (Path (cscIssue (), USD.issue ())).paths, STAmount (BTC (10)));
+
+        // Whole payment transactions, applied to the open ledger
+        int const payments = 1000;
+        auto const start = clock_type::now ();
+        for (int i = 0; i < payments; ++i)
+        {
+            env (pay (alice, carol, USD (1)), path (~USD), sendmax (BTC (1)));
+            if (i % 200 == 199)
+                env.close ();
+        }
+        report ("book payments", payments, elapsed (start));
+        env.require (balance (carol, USD (payments)));
+    }
+};
+
 BEAST_DEFINE_TESTSUITE(Flow,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(FlowTiming,app,casinocoin);
 
 } // test
 } // casinocoin
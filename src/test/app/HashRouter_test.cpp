@@ -186,6 +186,31 @@ class HashRouter_test : public beast::unit_test::suite
         BEAST_EXPECT(router.setFlags(key1, 20));
     }
 
+    void
+    testErase()
+    {
+        using namespace std::chrono_literals;
+        TestStopwatch stopwatch;
+        HashRouter router(stopwatch, 2s);
+
+        uint256 const key1(1);
+        uint256 const key2(2);
+
+        BEAST_EXPECT(router.addSuppressionPeer(key1, 1));
+        BEAST_EXPECT(router.setFlags(key1, 10));
+        BEAST_EXPECT(router.addSuppressionPeer(key2, 1));
+
+        // An erased hash is new again, and keeps no flags
+        router.erase(key1);
+        BEAST_EXPECT(router.addSuppressionPeer(key1, 2));
+        BEAST_EXPECT(router.getFlags(key1) == 0);
+        BEAST_EXPECT(!router.addSuppressionPeer(key2, 2));
+
+        // Erasing an unknown hash does nothing
+        router.erase(uint256(3));
+        BEAST_EXPECT(!router.addSuppressionPeer(key1, 3));
+    }
+
     void
     testRelay()
     {
@@ -238,6 +263,7 @@ public:
         testExpiration();
         testSuppression();
         testSetFlags();
+        testErase();
         testRelay();
     }
 };
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/LedgerReplayer.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/beast/utility/temp_dir.h>
+#include <casinocoin/protocol/JsonFields.h>
+
+namespace casinocoin {
+namespace test {
+
+class LedgerReplayer_test : public beast::unit_test::suite
+{
+    // Close ledgers holding payments, trust lines and crossing offers
+    static void
+    populate (jtx::Env& env, int ledgers)
+    {
+        using namespace jtx;
+        Account const gw ("gateway");
+        auto const USD = gw["USD"];
+        env.fund (CSC(100000), gw);
+        env.close ();
+
+        for (int i = 0; i < ledgers; ++i)
+        {
+            Account const a ("a" + std::to_string (i));
+            env.fund (CSC(10000), a);
+            env (trust (a, USD(1000)));
+            env (pay (gw, a, USD(100)));
+            env (offer (a, CSC(10 + i), USD(10)));
+            if (i > 0)
+                env (offer (Account ("a" + std::to_string (i - 1)),
+                    USD(5), CSC(5 + i)));
+            env.close ();
+        }
+    }
+
+    void
+    testLedger ()
+    {
+        testcase ("replay a ledger");
+        using namespace jtx;
+
+        Env env (*this);
+        populate (env, 10);
+
+        auto& lm = env.app ().getLedgerMaster ();
+        LedgerReplayer replayer (env.app (), env.journal);
+
+        auto const last = lm.getClosedLedger ()->info ().seq;
+        for (auto seq = last - 10; seq <= last; ++seq)
+        {
+            auto const ledger = lm.getLedgerBySeq (seq);
+            auto const result = replayer.replay (
+                lm.getLedgerBySeq (seq - 1), ledger);
+            if (! BEAST_EXPECT(result))
+                continue;
+
+            std::size_t count = 0;
+            for (auto const& tx : ledger->txs)
+                (void)tx, ++count;
+
+            BEAST_EXPECT(result->seq == seq);
+            BEAST_EXPECT(result->transactions == count);
+            BEAST_EXPECT(result->mismatched == 0);
+            BEAST_EXPECT(result->matched);
+            BEAST_EXPECT(result->hash == ledger->info ().hash);
+        }
+
+        // A ledger can only be replayed on its parent
+        BEAST_EXPECT(! replayer.replay (
+            lm.getLedgerBySeq (last - 2), lm.getLedgerBySeq (last)));
+        BEAST_EXPECT(! replayer.replay (nullptr, lm.getLedgerBySeq (last)));
+    }
+
+    void
+    testRange ()
+    {
+        testcase ("replay a range");
+        using namespace jtx;
+
+        beast::temp_dir td;
+        auto const withDatabase = [&](std::unique_ptr<Config> cfg,
+            Config::StartUpType type)
+        {
+            cfg->legacy ("database_path", td.path ());
+            cfg->START_LEDGER = "latest";
+            cfg->START_UP = type;
+            return cfg;
+        };
+
+        std::uint32_t last;
+        {
+            Env env (*this, envconfig (withDatabase, Config::NORMAL));
+            populate (env, 5);
+            last = env.closed ()->info ().seq;
+        }
+
+        // Load the stored ledgers in a new application
+        Env env (*this, envconfig (withDatabase, Config::LOAD));
+
+        auto const& profiler = env.app ().getApplyProfiler ();
+        BEAST_EXPECT(! profiler.enabled ());
+
+        LedgerReplayer replayer (env.app (), env.journal);
+        auto const jv = replayer.replay (3, last);
+        BEAST_EXPECT(jv[jss::ledgers].size () == last - 2);
+        BEAST_EXPECT(jv[jss::failed] == 0);
+        BEAST_EXPECT(jv[jss::transactions].asUInt () > 20);
+        for (auto const& ledger : jv[jss::ledgers])
+            BEAST_EXPECT(ledger[jss::matched].asBool ());
+        BEAST_EXPECT(jv[jss::profile].isObject ());
+        BEAST_EXPECT(! profiler.enabled ());
+
+        // Ledgers which are not stored can't be replayed
+        auto const missing = replayer.replay (last + 1, last + 2);
+        BEAST_EXPECT(missing[jss::failed] == 2);
+    }
+
+public:
+    void
+    run ()
+    {
+        testLedger ();
+        testRange ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerReplayer,app,casinocoin);
+
+} // test
+} // casinocoin
@@ -0,0 +1,220 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/app/tx/apply.h>
+#include <casinocoin/json/to_string.h>
+#include <casinocoin/protocol/Feature.h>
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace casinocoin {
+namespace test {
+
+/** Measures offer crossing with the Taker and the FlowCross engines.
+
+    Each round fills a USD/CSC book with `depth` offers spread over
+    `owners` accounts, then has `takers` accounts each cross an equal
+    share of it. The crossing offers are applied directly to the open
+    ledger on this thread, timed as a whole and through the apply
+    profiler, which also counts the ledger entries they read.
+
+    The parameters are given as the suite argument, for example
+    "depth=500,owners=50,takers=25,rounds=5". Each engine's results are
+    logged as one line of JSON.
+*/
+class OfferCrossing_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct Params
+    {
+        int depth = 200;
+        int owners = 10;
+        int takers = 20;
+        int rounds = 3;
+    };
+
+    Params
+    parseArgs (std::string const& s)
+    {
+        Params p;
+        std::map<std::string, int*> const names {
+            {"depth", &p.depth},
+            {"owners", &p.owners},
+            {"takers", &p.takers},
+            {"rounds", &p.rounds}};
+
+        std::vector<std::string> args;
+        boost::split (args, s, boost::algorithm::is_any_of (","));
+        for (auto const& arg : args)
+        {
+            if (arg.empty ())
+                continue;
+            auto const eq = arg.find ('=');
+            auto const name = names.find (
+                boost::trim_copy (arg.substr (0, eq)));
+            if (eq == std::string::npos || name == names.end ())
+            {
+                log << "Ignoring argument " << arg << std::endl;
+                continue;
+            }
+            *name->second = std::max (1, std::stoi (arg.substr (eq + 1)));
+        }
+        return p;
+    }
+
+    void
+    bench (std::string const& engine, std::initializer_list<uint256> fs,
+        Params const& p)
+    {
+        using namespace jtx;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        Env env {*this, features (fs)};
+        Account const gw ("gateway");
+        auto const USD = gw["USD"];
+        env.fund (CSC(1000000), gw);
+        env.close ();
+
+        std::vector<Account> makers;
+        for (int i = 0; i < p.owners; ++i)
+        {
+            makers.emplace_back ("m" + std::to_string (i));
+            env.fund (CSC(1000000), makers.back ());
+            env (trust (makers.back (), USD(100000000)));
+            env (pay (gw, makers.back (), USD(1000000)));
+            if (i % 100 == 99)
+                env.close ();
+        }
+
+        std::vector<Account> takers;
+        for (int i = 0; i < p.takers; ++i)
+        {
+            takers.emplace_back ("t" + std::to_string (i));
+            env.fund (CSC(1000000), takers.back ());
+            env (trust (takers.back (), USD(100000000)));
+            if (i % 100 == 99)
+                env.close ();
+        }
+        env.close ();
+
+        // Every taker crosses the same number of offers, each of USD(1),
+        // at a price above that of the worst offer in the book
+        int const share = std::max (1, p.depth / p.takers);
+        int const price = 200 + p.depth;
+
+        auto& profiler = env.app ().getApplyProfiler ();
+        profiler.enable (true);
+
+        std::uint64_t crossings = 0;
+        std::uint64_t transactions = 0;
+        std::uint64_t wallUs = 0;
+        std::uint64_t applyUs = 0;
+        std::uint64_t reads = 0;
+
+        for (int round = 0; round < p.rounds; ++round)
+        {
+            // A few offers of different owners at each quality
+            for (int i = 0; i < p.depth; ++i)
+                env (offer (makers[i % p.owners],
+                    CSC(100 + i / p.owners), USD(1)));
+            env.close ();
+
+            std::vector<std::shared_ptr<STTx const>> txs;
+            for (auto const& taker : takers)
+                txs.push_back (env.jt (offer (taker,
+                    USD(share), CSC(share * price))).stx);
+
+            profiler.reset ();
+            auto const start = clock_type::now ();
+            env.app ().openLedger ().modify (
+                [&](OpenView& view, beast::Journal j)
+                {
+                    for (auto const& tx : txs)
+                        casinocoin::apply (env.app (), view, *tx, tapNONE, j);
+                    return true;
+                });
+            wallUs += elapsed (start);
+
+            auto const jv = profiler.getJson ()[jss::transactions]
+                ["OfferCreate"]["tesSUCCESS"][jss::apply];
+            BEAST_EXPECT(jv[jss::duration_us][jss::count].asUInt () ==
+                txs.size ());
+            applyUs += std::stoull (
+                jv[jss::duration_us][jss::total].asString ());
+            reads += std::stoull (jv[jss::reads][jss::total].asString ());
+
+            crossings += share * txs.size ();
+            transactions += txs.size ();
+            env.close ();
+        }
+        profiler.enable (false);
+
+        // Every taker got what it asked for
+        for (auto const& taker : takers)
+            BEAST_EXPECT(env.balance (taker, USD) ==
+                USD(share * p.rounds));
+
+        auto const perCrossing = [crossings](std::uint64_t n)
+        {
+            return crossings ? static_cast<double> (n) / crossings : 0.0;
+        };
+
+        Json::Value result (Json::objectValue);
+        result["engine"] = engine;
+        result["depth"] = p.depth;
+        result["owners"] = p.owners;
+        result["takers"] = p.takers;
+        result["rounds"] = p.rounds;
+        result["transactions"] = static_cast<Json::UInt> (transactions);
+        result["crossings"] = static_cast<Json::UInt> (crossings);
+        result["wall_us"] = static_cast<Json::UInt> (wallUs);
+        result["apply_us"] = static_cast<Json::UInt> (applyUs);
+        result["crossings_per_sec"] = applyUs ?
+            crossings * 1000000.0 / applyUs : 0.0;
+        result["us_per_crossing"] = perCrossing (applyUs);
+        result["reads_per_crossing"] = perCrossing (reads);
+        log << to_string (result) << std::endl;
+    }
+
+public:
+    void
+    run ()
+    {
+        auto const p = parseArgs (arg ());
+        bench ("taker", {featureFlow, fix1373}, p);
+        bench ("flow_cross", {featureFlow, fix1373, featureFlowCross}, p);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(OfferCrossing,tx,casinocoin);
+
+} // test
+} // casinocoin
@@ -20,22 +20,208 @@
 #include <BeastConfig.h>
 #include <casinocoin/app/tx/impl/OfferStream.h>
 #include <casinocoin/beast/unit_test.h>
+#include <casinocoin/ledger/Sandbox.h>
+#include <test/jtx.h>
+#include <algorithm>
 
 namespace casinocoin {
 
 class OfferStream_test : public beast::unit_test::suite
 {
+    // Passes everything through to a ledger, noting the keys
+    // read ahead
+    class PrefetchView : public ReadView
+    {
+    private:
+        ReadView const& base_;
+
+    public:
+        std::vector<std::vector<uint256>> mutable prefetched;
+
+        explicit
+        PrefetchView(ReadView const& base)
+            : base_(base)
+        {
+        }
+
+        std::size_t
+        prefetch(std::vector<key_type> const& keys) const override
+        {
+            prefetched.push_back(keys);
+            return keys.size();
+        }
+
+        LedgerInfo const&
+        info() const override
+        {
+            return base_.info();
+        }
+
+        bool
+        open() const override
+        {
+            return base_.open();
+        }
+
+        Fees const&
+        fees() const override
+        {
+            return base_.fees();
+        }
+
+        Rules const&
+        rules() const override
+        {
+            return base_.rules();
+        }
+
+        LedgerConfig const&
+        ledgerConfig() const override
+        {
+            return base_.ledgerConfig();
+        }
+
+        bool
+        exists(Keylet const& k) const override
+        {
+            return base_.exists(k);
+        }
+
+        boost::optional<key_type>
+        succ(key_type const& key, boost::optional<
+            key_type> const& last = boost::none) const override
+        {
+            return base_.succ(key, last);
+        }
+
+        std::shared_ptr<SLE const>
+        read(Keylet const& k) const override
+        {
+            return base_.read(k);
+        }
+
+        std::unique_ptr<sles_type::iter_base>
+        slesBegin() const override
+        {
+            return base_.slesBegin();
+        }
+
+        std::unique_ptr<sles_type::iter_base>
+        slesEnd() const override
+        {
+            return base_.slesEnd();
+        }
+
+        std::unique_ptr<sles_type::iter_base>
+        slesUpperBound(key_type const& key) const override
+        {
+            return base_.slesUpperBound(key);
+        }
+
+        std::unique_ptr<txs_type::iter_base>
+        txsBegin() const override
+        {
+            return base_.txsBegin();
+        }
+
+        std::unique_ptr<txs_type::iter_base>
+        txsEnd() const override
+        {
+            return base_.txsEnd();
+        }
+
+        bool
+        txExists(key_type const& key) const override
+        {
+            return base_.txExists(key);
+        }
+
+        tx_type
+        txRead(key_type const& key) const override
+        {
+            return base_.txRead(key);
+        }
+    };
+
 public:
     void
-    test()
+    testReadAhead()
     {
-        pass();
+        testcase("read ahead");
+        using namespace test::jtx;
+
+        Env env(*this);
+        Account const gw("gateway");
+        Account const alice("alice");
+        Account const bob("bob");
+        auto const USD = gw["USD"];
+
+        env.fund(CSC(100000), gw, alice, bob);
+        env.close();
+        env(trust(alice, USD(10000)));
+        env(trust(bob, USD(10000)));
+        env(pay(gw, alice, USD(1000)));
+        env(pay(gw, bob, USD(1000)));
+        env.close();
+
+        // Twelve offers at one quality share a directory page
+        for (int i = 0; i < 6; ++i)
+        {
+            env(offer(alice, CSC(100), USD(10)));
+            env(offer(bob, CSC(100), USD(10)));
+        }
+        env.close();
+
+        auto const ledger = env.closed();
+        Book const book(cscIssue(), USD.issue());
+        auto const page = ledger->read(keylet::page(
+            *ledger->succ(getBookBase(book), getQualityNext(
+                getBookBase(book)))));
+        if (! BEAST_EXPECT(page))
+            return;
+        auto const& indexes = page->getFieldV256(sfIndexes);
+        BEAST_EXPECT(indexes.size() == 12);
+
+        auto const stepAll = [&](PrefetchView const& view)
+        {
+            Sandbox sb(&view, tapNONE);
+            Sandbox cancel(&view, tapNONE);
+            OfferStream::StepCounter counter(1000, env.journal);
+            OfferStream stream(sb, cancel, book,
+                ledger->parentCloseTime(), counter, env.journal);
+            std::vector<uint256> offers;
+            // Each step removes the offer before it
+            while (stream.step())
+                offers.push_back(stream.tip().key());
+            return offers;
+        };
+
+        PrefetchView view(*ledger);
+        auto const offers = stepAll(view);
+        BEAST_EXPECT(offers.size() == 12);
+
+        // The first eight offers were read ahead together, then the
+        // remaining ones
+        if (BEAST_EXPECT(view.prefetched.size() == 2))
+        {
+            BEAST_EXPECT(view.prefetched[0] == std::vector<uint256>(
+                indexes.begin(), indexes.begin() + 8));
+            BEAST_EXPECT(view.prefetched[1] == std::vector<uint256>(
+                indexes.begin() + 8, indexes.end()));
+        }
+
+        // Reading ahead doesn't change what the stream sees
+        std::vector<uint256> expected;
+        expected.reserve(indexes.size());
+        for (auto const& index : indexes)
+            expected.push_back(index);
+        BEAST_EXPECT(offers == expected);
     }
 
     void
     run()
     {
-        test();
+        testReadAhead();
     }
 };
 
@@ -0,0 +1,236 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/OpenLedger.h>
+#include <casinocoin/app/tx/apply.h>
+#include <casinocoin/ledger/TxRecorder.h>
+
+namespace casinocoin {
+namespace test {
+
+class OpenLedger_test : public beast::unit_test::suite
+{
+    using Txs = std::vector<std::shared_ptr<STTx const>>;
+
+    // A closed ledger following prev with the given transactions
+    static
+    std::shared_ptr<Ledger const>
+    close (jtx::Env& env, Ledger const& prev, Txs const& txs)
+    {
+        auto next = std::make_shared<Ledger>(
+            prev, env.app().timeKeeper().closeTime());
+        {
+            OpenView accum(&*next);
+            for (auto const& tx : txs)
+                casinocoin::apply(env.app(), accum, *tx,
+                    tapNONE, env.journal);
+            accum.apply(*next);
+        }
+        next->updateSkipList();
+        next->setImmutable(env.app().config());
+        return next;
+    }
+
+    static
+    void
+    add (jtx::Env& env, OpenLedger& ol, Txs const& txs)
+    {
+        ol.modify(
+            [&](OpenView& view, beast::Journal j)
+            {
+                for (auto const& tx : txs)
+                    casinocoin::apply(env.app(), view, *tx, tapNONE, j);
+                return true;
+            });
+    }
+
+    // Whether the open ledger holds what applying txs to ledger gives
+    bool
+    matches (jtx::Env& env, OpenLedger const& ol,
+        std::shared_ptr<Ledger const> const& ledger, Txs const& txs)
+    {
+        OpenView expected(open_ledger, ledger->rules(), ledger);
+        for (auto const& tx : txs)
+            if (! ledger->txExists(tx->getTransactionID()))
+                casinocoin::apply(env.app(), expected, *tx,
+                    tapNONE, env.journal);
+
+        auto const view = ol.current();
+        if (view->txCount() != expected.txCount() ||
+                view->info().drops != expected.info().drops)
+            return false;
+
+        std::size_t count = 0;
+        for (auto const& sle : expected.sles)
+        {
+            auto const other = view->read(keylet::unchecked(sle->key()));
+            if (! other || ! (*other == *sle))
+                return false;
+            ++count;
+        }
+        for (auto iter = view->sles.begin();
+                iter != view->sles.end(); ++iter)
+            --count;
+        return count == 0;
+    }
+
+    void
+    testCarry()
+    {
+        testcase("carry");
+        using namespace jtx;
+
+        Env env(*this);
+        Account const alice ("alice");
+        Account const bob ("bob");
+        Account const carol ("carol");
+        Account const dave ("dave");
+        Account const erin ("erin");
+        env.fund(CSC(10000), alice, bob, carol, dave, erin);
+        env.close();
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        OpenLedger ol(closed, env.app().cachedSLEs(), env.journal);
+
+        Txs const open {
+            env.jt(pay(alice, bob, CSC(10))).stx,
+            env.jt(pay(carol, dave, CSC(10))).stx,
+            env.jt(pay(alice, erin, CSC(20)), seq(env.seq(alice) + 1)).stx };
+        add(env, ol, open);
+        BEAST_EXPECT(ol.current()->txCount() == 3);
+
+        // The closed ledger touches carol only
+        auto const next = close(env, *closed,
+            { env.jt(pay(erin, carol, CSC(5))).stx });
+
+        auto const before = ol.rebuildStats();
+        OrderedTxs retries (uint256{});
+        // The open transactions are read ahead before accepting
+        auto prefetched = ol.prefetch(*next,
+            OrderedTxs (uint256{}), retries);
+        BEAST_EXPECT(! prefetched.empty());
+        ol.accept(env.app(), next->rules(), next,
+            OrderedTxs (uint256{}), false, retries, tapNONE,
+                "", {}, std::move(prefetched));
+        auto const after = ol.rebuildStats();
+
+        // carol's payment is applied again and so is alice's second
+        // payment, which reads erin's account
+        BEAST_EXPECT(after.carried - before.carried == 1);
+        BEAST_EXPECT(after.reapplied - before.reapplied == 2);
+        BEAST_EXPECT(retries.empty());
+        BEAST_EXPECT(matches(env, ol, next, open));
+
+        // Transactions in the closed ledger are dropped, the rest
+        // carry over
+        auto const last = close(env, *next, { open[1] });
+        ol.accept(env.app(), last->rules(), last,
+            OrderedTxs (uint256{}), false, retries, tapNONE);
+        auto const final = ol.rebuildStats();
+        BEAST_EXPECT(final.carried - after.carried == 2);
+        BEAST_EXPECT(final.reapplied == after.reapplied);
+        BEAST_EXPECT(matches(env, ol, last, open));
+    }
+
+    void
+    testIncomplete()
+    {
+        testcase("incomplete footprints");
+        using namespace jtx;
+
+        Env env(*this);
+        Account const alice ("alice");
+        Account const bob ("bob");
+        env.fund(CSC(10000), alice, bob);
+        env.close();
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        OpenLedger ol(closed, env.app().cachedSLEs(), env.journal);
+
+        // Changes applied as a whole can't be split by transaction
+        auto const tx = env.jt(pay(alice, bob, CSC(10))).stx;
+        ol.modify(
+            [&](OpenView& view, beast::Journal j)
+            {
+                OpenView sandbox(open_ledger, &view, view.rules());
+                casinocoin::apply(env.app(), sandbox, *tx, tapNONE, j);
+                sandbox.apply(view);
+                return true;
+            });
+
+        auto const next = close(env, *closed, {});
+        auto const before = ol.rebuildStats();
+        OrderedTxs retries (uint256{});
+        ol.accept(env.app(), next->rules(), next,
+            OrderedTxs (uint256{}), false, retries, tapNONE);
+        auto const after = ol.rebuildStats();
+        BEAST_EXPECT(after.carried == before.carried);
+        BEAST_EXPECT(after.reapplied == before.reapplied);
+        BEAST_EXPECT(matches(env, ol, next, { tx }));
+    }
+
+    void
+    testCopy()
+    {
+        testcase("copies don't record");
+        using namespace jtx;
+
+        Env env(*this);
+        Account const alice ("alice");
+        Account const bob ("bob");
+        env.fund(CSC(10000), alice, bob);
+        env.close();
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        OpenView view(open_ledger, closed->rules(), closed);
+        TxRecorder recorder;
+        view.record(&recorder);
+
+        // Changes made to a copy are not the recorded view's
+        OpenView copy(view);
+        BEAST_EXPECT(copy.recorder() == nullptr);
+        casinocoin::apply(env.app(), copy,
+            *env.jt(pay(alice, bob, CSC(10))).stx, tapNONE, env.journal);
+        BEAST_EXPECT(copy.txCount() == 1);
+
+        casinocoin::apply(env.app(), view,
+            *env.jt(pay(bob, alice, CSC(10))).stx, tapNONE, env.journal);
+        view.record(nullptr);
+        recorder.finish();
+        BEAST_EXPECT(recorder.complete());
+        BEAST_EXPECT(recorder.footprints().size() == 1);
+    }
+
+public:
+    void
+    run()
+    {
+        testCarry();
+        testIncomplete();
+        testCopy();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(OpenLedger,app,casinocoin);
+
+} // test
+} // casinocoin
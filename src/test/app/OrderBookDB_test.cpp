@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/OrderBookDB.h>
+#include <casinocoin/core/Stoppable.h>
+#include <chrono>
+#include <set>
+#include <thread>
+
+namespace casinocoin {
+namespace test {
+
+class OrderBookDB_test : public beast::unit_test::suite
+{
+    // The books taking an issue, as a set
+    static
+    std::set<Book>
+    booksFrom (OrderBookDB& db, Issue const& issue)
+    {
+        std::set<Book> books;
+        for (auto const& ob : db.getBooksByTakerPays (issue))
+            books.insert (ob->book ());
+        return books;
+    }
+
+    // Wait for the books to follow the last closed ledger, which is
+    // published on a job
+    static
+    bool
+    caughtUp (jtx::Env& env)
+    {
+        using namespace std::chrono_literals;
+        auto const seq = env.closed ()->info ().seq;
+        for (int i = 0; i < 500; ++i)
+        {
+            if (env.app ().getOrderBookDB ().getLedgerSeq () == seq)
+                return true;
+            std::this_thread::sleep_for (10ms);
+        }
+        return false;
+    }
+
+    void
+    testIncremental ()
+    {
+        testcase ("incremental");
+        using namespace jtx;
+
+        Env env (*this);
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        env.fund (CSC(100000), gw, alice);
+        env (trust (alice, USD(1000)));
+        env (trust (alice, EUR(1000)));
+        env (pay (gw, alice, USD(500)));
+        env (pay (gw, alice, EUR(500)));
+        env.close ();
+        BEAST_EXPECT(caughtUp (env));
+
+        auto& db = env.app ().getOrderBookDB ();
+        Book const usdToCSC (USD.issue (), cscIssue ());
+        Book const usdToEUR (USD.issue (), EUR.issue ());
+
+        // A book added from the open ledger whose offer never made it
+        // into a validated ledger
+        Book const unlisted (EUR.issue (), USD.issue ());
+        db.addOrderBook (unlisted);
+        BEAST_EXPECT(booksFrom (db, EUR.issue ()).count (unlisted));
+
+        // Offers of two qualities in each book
+        env (offer (alice, USD(10), CSC(100)));
+        env (offer (alice, USD(10), CSC(110)));
+        env (offer (alice, USD(10), EUR(10)));
+        env (offer (alice, USD(10), EUR(11)));
+        env.close ();
+        BEAST_EXPECT(caughtUp (env));
+        BEAST_EXPECT(booksFrom (db, USD.issue ()) ==
+            std::set<Book> ({usdToCSC, usdToEUR}));
+        BEAST_EXPECT(db.isBookToCSC (USD.issue ()));
+        // It's given a few ledgers to show up
+        BEAST_EXPECT(booksFrom (db, EUR.issue ()).count (unlisted));
+
+        // A book stays while any of its qualities has offers
+        auto const seq = env.seq (alice);
+        env (offer_cancel (alice, seq - 4));
+        env (offer_cancel (alice, seq - 2));
+        env.close ();
+        BEAST_EXPECT(caughtUp (env));
+        BEAST_EXPECT(booksFrom (db, USD.issue ()).size () == 2);
+
+        // And goes once the last one is gone
+        env (offer_cancel (alice, seq - 3));
+        env.close ();
+        BEAST_EXPECT(caughtUp (env));
+        BEAST_EXPECT(booksFrom (db, USD.issue ()) ==
+            std::set<Book> ({usdToEUR}));
+        BEAST_EXPECT(! db.isBookToCSC (USD.issue ()));
+        BEAST_EXPECT(db.getBookSize (USD.issue ()) == 1);
+
+        env (offer_cancel (alice, seq - 1));
+        env (offer (alice, EUR(10), CSC(100)));
+        env.close ();
+        BEAST_EXPECT(caughtUp (env));
+        BEAST_EXPECT(booksFrom (db, USD.issue ()).empty ());
+        BEAST_EXPECT(db.isBookToCSC (EUR.issue ()));
+
+        // And is dropped when it doesn't
+        BEAST_EXPECT(! booksFrom (db, EUR.issue ()).count (unlisted));
+
+        // A full scan of the ledger finds the same books
+        RootStoppable parent ("TestRootStoppable");
+        OrderBookDB scanned (env.app (), parent);
+        scanned.update (env.closed ());
+        BEAST_EXPECT(scanned.getLedgerSeq () == env.closed ()->info ().seq);
+        for (auto const& issue : {USD.issue (), EUR.issue (), cscIssue ()})
+            BEAST_EXPECT(booksFrom (scanned, issue) == booksFrom (db, issue));
+    }
+
+public:
+    void
+    run ()
+    {
+        testIncremental ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(OrderBookDB,app,casinocoin);
+
+} // test
+} // casinocoin
@@ -0,0 +1,302 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/OpenLedger.h>
+#include <casinocoin/app/tx/apply.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <casinocoin/ledger/TxRecorder.h>
+#include <algorithm>
+#include <chrono>
+
+namespace casinocoin {
+namespace test {
+
+class ParallelApply_test : public beast::unit_test::suite
+{
+    using Txs = std::vector<std::shared_ptr<STTx const>>;
+
+    // Whether two views hold the same state and transactions
+    static
+    bool
+    same (OpenView const& a, OpenView const& b)
+    {
+        if (a.txCount() != b.txCount() ||
+                a.info().drops != b.info().drops)
+            return false;
+
+        auto ta = a.txs.begin();
+        auto tb = b.txs.begin();
+        for (; ta != a.txs.end() && tb != b.txs.end(); ++ta, ++tb)
+        {
+            if (ta->first->getTransactionID() !=
+                    tb->first->getTransactionID())
+                return false;
+        }
+
+        auto sa = a.sles.begin();
+        auto sb = b.sles.begin();
+        for (; sa != a.sles.end() && sb != b.sles.end(); ++sa, ++sb)
+        {
+            if ((*sa)->key() != (*sb)->key() || ! (**sa == **sb))
+                return false;
+        }
+        return sa == a.sles.end() && sb == b.sles.end();
+    }
+
+    void
+    testSerialEquivalence()
+    {
+        testcase("same as serial");
+        using namespace jtx;
+
+        Env env(*this);
+        Account const gw ("gateway");
+        auto const USD = gw["USD"];
+        std::vector<Account> accounts;
+        for (int i = 0; i < 20; ++i)
+            accounts.emplace_back ("a" + std::to_string (i));
+        env.fund(CSC(100000), gw);
+        for (auto const& a : accounts)
+        {
+            env.fund(CSC(10000), a);
+            env(trust(a, USD(1000)));
+            env(pay(gw, a, USD(100)));
+        }
+        env.close();
+
+        // Disjoint payments mixed with ones that conflict through
+        // a shared account, a gateway, or a sequence
+        Txs txs;
+        for (int i = 0; i < 10; ++i)
+            txs.push_back(env.jt(pay(accounts[i],
+                accounts[i + 10], CSC(10))).stx);
+        for (int i = 0; i < 5; ++i)
+            txs.push_back(env.jt(pay(accounts[i],
+                accounts[0], USD(1)), seq(env.seq(accounts[i]) + 1)).stx);
+        txs.push_back(env.jt(offer(accounts[15], USD(5), CSC(5))).stx);
+        txs.push_back(env.jt(pay(accounts[16], accounts[17],
+            CSC(1000000))).stx);
+        txs.push_back(env.jt(pay(accounts[18], accounts[19], CSC(10)),
+            seq(env.seq(accounts[18]) + 5)).stx);
+        txs.push_back(txs[3]);
+        txs.push_back(env.jt(noop(accounts[19])).stx);
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        for (std::size_t threads : {1, 2, 4, 8})
+        {
+            OpenView serial(open_ledger, closed->rules(), closed);
+            std::vector<std::pair<TER, bool>> expected;
+            for (auto const& tx : txs)
+                expected.push_back(casinocoin::apply(env.app(), serial,
+                    *tx, tapNONE, env.journal));
+
+            OpenView parallel(open_ledger, closed->rules(), closed);
+            TxRecorder recorder;
+            parallel.record(&recorder);
+            auto const results = applyParallel(env.app(), parallel, txs,
+                tapNONE, threads, env.journal);
+            parallel.record(nullptr);
+            recorder.finish();
+
+            BEAST_EXPECT(results == expected);
+            BEAST_EXPECT(same(serial, parallel));
+            BEAST_EXPECT(recorder.complete());
+            BEAST_EXPECT(recorder.footprints().size() ==
+                parallel.txCount());
+        }
+    }
+
+    void
+    testPrefetchMisses()
+    {
+        testcase("prefetch misses");
+        using namespace jtx;
+
+        Env env(*this);
+        std::vector<Account> accounts;
+        for (int i = 0; i < 10; ++i)
+        {
+            accounts.emplace_back ("a" + std::to_string (i));
+            env.fund(CSC(10000), accounts.back());
+        }
+        env.close();
+
+        Txs txs;
+        for (int i = 0; i < 5; ++i)
+            txs.push_back(env.jt(pay(accounts[i],
+                accounts[i + 5], CSC(10))).stx);
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        auto const misses = [&](std::vector<uint256> expected)
+        {
+            OpenView view(open_ledger, closed->rules(), closed);
+            TxRecorder recorder;
+            recorder.expect(std::move(expected));
+            view.record(&recorder);
+            for (auto const& tx : txs)
+                casinocoin::apply(env.app(), view, *tx, tapNONE,
+                    env.journal);
+            view.record(nullptr);
+            return recorder.unexpected();
+        };
+
+        // Every key read misses a prefetch of something else
+        auto const all = misses({uint256{}});
+        BEAST_EXPECT(all > 0);
+
+        // The keys read ahead for the batch are not misses
+        auto const prefetched = env.app().openLedger().prefetch(
+            *closed, txs);
+        BEAST_EXPECT(! prefetched.empty());
+        BEAST_EXPECT(std::is_sorted(prefetched.begin(), prefetched.end()));
+        BEAST_EXPECT(misses(prefetched) < all);
+    }
+
+    void
+    testProfile()
+    {
+        testcase("profiled once");
+        using namespace jtx;
+
+        Env env(*this);
+        std::vector<Account> accounts;
+        for (int i = 0; i < 20; ++i)
+        {
+            accounts.emplace_back ("a" + std::to_string (i));
+            env.fund(CSC(10000), accounts.back());
+        }
+        env.close();
+
+        // Half the payments go to one account, so most of those
+        // speculative results can't be used and are applied again
+        Txs txs;
+        for (int i = 0; i < 10; ++i)
+            txs.push_back(env.jt(pay(accounts[i],
+                accounts[i + 10], CSC(10))).stx);
+        for (int i = 0; i < 10; ++i)
+            txs.push_back(env.jt(pay(accounts[i + 10],
+                accounts[0], CSC(10))).stx);
+
+        auto& profiler = env.app().getApplyProfiler();
+        profiler.reset();
+        profiler.enable(true);
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        OpenView view(open_ledger, closed->rules(), closed);
+        auto const results = applyParallel(env.app(), view, txs,
+            tapNONE, 4, env.journal);
+        profiler.enable(false);
+
+        std::size_t const applied = std::count_if(
+            results.begin(), results.end(),
+            [](std::pair<TER, bool> const& r) { return r.second; });
+        BEAST_EXPECT(applied == txs.size());
+
+        auto const json = profiler.getJson();
+        auto const& apply = json[jss::transactions]["Payment"]
+            ["tesSUCCESS"][jss::apply][jss::duration_us];
+        BEAST_EXPECT(apply[jss::count].asUInt() == applied);
+        profiler.reset();
+    }
+
+public:
+    void
+    run()
+    {
+        testSerialEquivalence();
+        testPrefetchMisses();
+        testProfile();
+    }
+};
+
+// Compares serial and parallel apply of payment batches
+class ParallelApplyTiming_test : public beast::unit_test::suite
+{
+    using Txs = std::vector<std::shared_ptr<STTx const>>;
+
+public:
+    void
+    run()
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+
+        Env env(*this);
+        Account const gw ("gateway");
+        auto const USD = gw["USD"];
+        int const count = 2000;
+        std::vector<Account> accounts;
+        accounts.reserve(count);
+        env.fund(CSC(1000000), gw);
+        for (int i = 0; i < count; ++i)
+        {
+            accounts.emplace_back("a" + std::to_string(i));
+            env.fund(CSC(10000), accounts.back());
+            env(trust(accounts.back(), USD(1000000)));
+            env(pay(gw, accounts.back(), USD(1000)));
+            if (i % 100 == 99)
+                env.close();
+        }
+        env.close();
+
+        std::vector<std::pair<char const*, Txs>> batches(2);
+        batches[0].first = "CSC";
+        batches[1].first = "IOU";
+        for (int i = 0; i < count; ++i)
+        {
+            auto const& to = accounts[(i + 1) % count];
+            batches[0].second.push_back(
+                env.jt(pay(accounts[i], to, CSC(10))).stx);
+            batches[1].second.push_back(
+                env.jt(pay(accounts[i], to, USD(1))).stx);
+        }
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        for (auto const& batch : batches)
+        {
+            for (int pass = 0; pass < 3; ++pass)
+            {
+                for (std::size_t threads : {1, 2, 4})
+                {
+                    OpenView view(open_ledger, closed->rules(), closed);
+                    auto const start = clock_type::now();
+                    applyParallel(env.app(), view, batch.second,
+                        tapNONE, threads, env.journal);
+                    auto const us = std::chrono::duration_cast<
+                        std::chrono::microseconds>(
+                            clock_type::now() - start).count();
+                    BEAST_EXPECT(view.txCount() == batch.second.size());
+                    log << batch.first << " " << threads << " threads: " <<
+                        batch.second.size() * 1000000 / std::max<
+                            std::int64_t>(us, 1) << " tx/s" << std::endl;
+                }
+            }
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ParallelApply,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(ParallelApplyTiming,app,casinocoin);
+
+} // test
+} // casinocoin
@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/paths/PathFindScheduler.h>
+#include <casinocoin/basics/UnorderedContainers.h>
+#include <casinocoin/beast/unit_test.h>
+#include <casinocoin/protocol/JsonFields.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace casinocoin {
+namespace test {
+
+class PathFindScheduler_test : public beast::unit_test::suite
+{
+    using Priority = PathFindScheduler::Priority;
+
+    // The clients of a pass in the order they are served, with each
+    // request numbered within its client; a client's own requests keep
+    // their order, so "a:1" is always the second request "a" made
+    static std::vector<std::string>
+    served (std::vector<std::pair<Priority, std::string>> const& pass)
+    {
+        std::vector<PathFindScheduler::Entry> entries;
+        for (auto const& p : pass)
+            entries.push_back ({nullptr, p.first, p.second});
+
+        PathFindScheduler::order (entries);
+
+        std::vector<std::string> result;
+        hash_map<std::string, int> seen;
+        for (auto const& e : entries)
+            result.push_back (e.client + ":" +
+                std::to_string (seen[e.client]++));
+        return result;
+    }
+
+    void
+    testOrder ()
+    {
+        testcase ("order");
+
+        auto const admin = Priority::admin;
+        auto const user = Priority::user;
+
+        // Nothing to do
+        BEAST_EXPECT(served ({}).empty ());
+
+        // Admin requests go first, whatever order they arrived in
+        {
+            auto const r = served ({
+                {user, "a"}, {admin, "x"}, {user, "b"}, {admin, "y"}});
+            BEAST_EXPECT(r == std::vector<std::string> (
+                {"x:0", "y:0", "a:0", "b:0"}));
+        }
+
+        // A client with many requests takes turns with the others
+        {
+            auto const r = served ({
+                {user, "a"}, {user, "a"}, {user, "a"},
+                {user, "b"}, {user, "c"}, {user, "c"}});
+            BEAST_EXPECT(r == std::vector<std::string> (
+                {"a:0", "b:0", "c:0", "a:1", "c:1", "a:2"}));
+        }
+
+        // Turns are kept separately for each class
+        {
+            auto const r = served ({
+                {user, "a"}, {user, "a"}, {admin, "a"}, {admin, "a"},
+                {user, "b"}, {admin, "x"}});
+            BEAST_EXPECT(r == std::vector<std::string> (
+                {"a:0", "x:0", "a:1", "a:2", "b:0", "a:3"}));
+        }
+    }
+
+    void
+    testAccounting ()
+    {
+        testcase ("accounting");
+        using namespace std::chrono;
+        using clock_type = PathFindScheduler::clock_type;
+
+        PathFindScheduler scheduler (milliseconds (50));
+
+        auto const before = clock_type::now ();
+        auto const deadline = scheduler.deadline ();
+        BEAST_EXPECT(deadline >= before + milliseconds (50));
+        BEAST_EXPECT(deadline <= clock_type::now () + milliseconds (50));
+        BEAST_EXPECT(PathFindScheduler (milliseconds (0)).deadline () ==
+            clock_type::time_point::max ());
+        {
+            PathFindScheduler changed (milliseconds (50));
+            changed.setDeadline (milliseconds (0));
+            BEAST_EXPECT(changed.deadline () == clock_type::time_point::max ());
+        }
+
+        scheduler.queued (4);
+        auto jv = scheduler.getJson ();
+        BEAST_EXPECT(jv[jss::deadline_ms].asUInt () == 50);
+        BEAST_EXPECT(jv[jss::queued].asUInt () == 4);
+        BEAST_EXPECT(jv[jss::running].asUInt () == 0);
+
+        auto const start = clock_type::now ();
+        scheduler.started (before);
+        scheduler.started (before);
+        jv = scheduler.getJson ();
+        BEAST_EXPECT(jv[jss::queued].asUInt () == 2);
+        BEAST_EXPECT(jv[jss::running].asUInt () == 2);
+
+        scheduler.finished (start, false);
+        scheduler.finished (start, true);
+        scheduler.skipped ();
+        scheduler.cancelled ();
+        jv = scheduler.getJson ();
+        BEAST_EXPECT(jv[jss::queued].asUInt () == 0);
+        BEAST_EXPECT(jv[jss::running].asUInt () == 0);
+        BEAST_EXPECT(jv[jss::completed].asString () == "2");
+        BEAST_EXPECT(jv[jss::partial].asString () == "1");
+        BEAST_EXPECT(jv[jss::cancelled].asString () == "1");
+        BEAST_EXPECT(jv.isMember (jss::wait_us));
+        BEAST_EXPECT(jv.isMember (jss::latency_us));
+    }
+
+public:
+    void
+    run ()
+    {
+        testOrder ();
+        testAccounting ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(PathFindScheduler,app,casinocoin);
+
+} // test
+} // casinocoin
@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/paths/CasinocoinLineCache.h>
+#include <casinocoin/app/paths/PathLiquidityCache.h>
+#include <casinocoin/app/paths/Pathfinder.h>
+#include <casinocoin/json/to_string.h>
+
+namespace casinocoin {
+namespace test {
+
+class PathLiquidityCache_test : public beast::unit_test::suite
+{
+    // The best paths from A1 to A2, as JSON text
+    static std::string
+    bestPaths (jtx::Env& env, std::shared_ptr<ReadView const> const& ledger,
+        PathLiquidityCache* liquidity)
+    {
+        using namespace jtx;
+        auto const cache = std::make_shared<CasinocoinLineCache> (ledger);
+        if (liquidity)
+            liquidity->setLedger (cache->getBaseLedger ());
+
+        Pathfinder pf (cache, Account ("A1").id (), Account ("A2").id (),
+            to_currency ("HKD"), boost::none, Account ("G2")["HKD"](10),
+                boost::none, env.app ());
+        pf.setLiquidityCache (liquidity);
+        if (! pf.findPaths (7))
+            return {};
+        pf.computePathRanks (4);
+
+        STPath fullLiquidityPath;
+        auto const paths = pf.getBestPaths (4, fullLiquidityPath,
+            STPathSet (), Account ("G1").id ());
+        return to_string (paths.getJson (0)) +
+            to_string (fullLiquidityPath.getJson (0));
+    }
+
+    void
+    testReuse ()
+    {
+        testcase ("reuse");
+        using namespace jtx;
+
+        Env env (*this);
+        Account const A1 {"A1"};
+        Account const A2 {"A2"};
+        Account const G1 {"G1"};
+        Account const G2 {"G2"};
+        Account const M1 {"M1"};
+        Account const M2 {"M2"};
+
+        env.fund (CSC(10000), A1, A2, G1, G2);
+        env.fund (CSC(11000), M1, M2);
+        env.close ();
+
+        env.trust (G1["HKD"](2000), A1);
+        env.trust (G2["HKD"](2000), A2);
+        env.trust (G1["HKD"](100000), M1, M2);
+        env.trust (G2["HKD"](100000), M1, M2);
+        env.close ();
+
+        env (pay (G1, A1, G1["HKD"](1000)));
+        env (pay (G1, M1, G1["HKD"](1200)));
+        env (pay (G2, M1, G2["HKD"](5000)));
+        env (pay (G1, M2, G1["HKD"](1200)));
+        env (pay (G2, M2, G2["HKD"](5000)));
+        env.close ();
+
+        auto const expiration = env.closed ()->info ().closeTime +
+            std::chrono::seconds (60);
+        env (offer (M1, G1["HKD"](1000), G2["HKD"](1000)));
+        env (offer (M2, G1["HKD"](1000), G2["HKD"](900)),
+            json (sfExpiration.fieldName, static_cast<std::uint32_t> (
+                expiration.time_since_epoch ().count ())));
+        env.close ();
+
+        PathLiquidityCache liquidity;
+        auto ledger = env.closed ();
+        auto const first = bestPaths (env, ledger, &liquidity);
+        BEAST_EXPECT(! first.empty ());
+        BEAST_EXPECT(first == bestPaths (env, ledger, nullptr));
+        auto misses = liquidity.misses ();
+        BEAST_EXPECT(misses > 0);
+        BEAST_EXPECT(liquidity.size () > 0);
+        BEAST_EXPECT(liquidity.size () <= misses);
+
+        // The same ledger again
+        auto hits = liquidity.hits ();
+        BEAST_EXPECT(bestPaths (env, ledger, &liquidity) == first);
+        BEAST_EXPECT(liquidity.hits () >= hits + liquidity.size ());
+        BEAST_EXPECT(liquidity.misses () == misses);
+
+        // A ledger that changes nothing on the paths
+        env.fund (CSC(10000), "carol");
+        env.close ();
+        ledger = env.closed ();
+        hits = liquidity.hits ();
+        BEAST_EXPECT(bestPaths (env, ledger, &liquidity) == first);
+        BEAST_EXPECT(liquidity.hits () > hits);
+        BEAST_EXPECT(liquidity.misses () == misses);
+
+        // Changing an offer on the paths means checking again
+        env (offer (M1, G1["HKD"](1000), G2["HKD"](500)));
+        env.close ();
+        ledger = env.closed ();
+        auto const changed = bestPaths (env, ledger, &liquidity);
+        BEAST_EXPECT(changed == bestPaths (env, ledger, nullptr));
+        BEAST_EXPECT(liquidity.misses () > misses);
+        misses = liquidity.misses ();
+
+        // So does the expiry of an offer that was read, which happens
+        // once the parent of the ledger closed after it
+        env.close (expiration + std::chrono::seconds (10));
+        env.close ();
+        ledger = env.closed ();
+        auto const expired = bestPaths (env, ledger, &liquidity);
+        BEAST_EXPECT(expired == bestPaths (env, ledger, nullptr));
+        BEAST_EXPECT(liquidity.misses () > misses);
+        misses = liquidity.misses ();
+
+        // Open ledgers are not cached
+        hits = liquidity.hits ();
+        auto const entries = liquidity.size ();
+        BEAST_EXPECT(bestPaths (env, env.current (), &liquidity) ==
+            bestPaths (env, env.current (), nullptr));
+        BEAST_EXPECT(liquidity.hits () == hits);
+        BEAST_EXPECT(liquidity.misses () == misses);
+        BEAST_EXPECT(liquidity.size () == entries);
+
+        // Entries not used with a ledger are dropped after it
+        env.close ();
+        liquidity.setLedger (env.closed ());
+        env.close ();
+        liquidity.setLedger (env.closed ());
+        BEAST_EXPECT(liquidity.size () == 0);
+    }
+
+public:
+    void
+    run ()
+    {
+        testReuse ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(PathLiquidityCache,app,casinocoin);
+
+} // test
+} // casinocoin
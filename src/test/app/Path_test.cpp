@@ -18,7 +18,9 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <casinocoin/app/misc/NetworkOPs.h>
 #include <casinocoin/app/paths/AccountCurrencies.h>
+#include <casinocoin/app/paths/PathRequests.h>
 #include <casinocoin/basics/contract.h>
 #include <casinocoin/core/JobQueue.h>
 #include <casinocoin/json/json_reader.h>
@@ -26,16 +28,20 @@
 #include <casinocoin/protocol/JsonFields.h>
 #include <casinocoin/protocol/STParsedJSON.h>
 #include <casinocoin/protocol/TxFlags.h>
+#include <casinocoin/resource/ResourceManager.h>
 #include <casinocoin/resource/Fees.h>
 #include <casinocoin/rpc/Context.h>
 #include <casinocoin/rpc/impl/Tuning.h>
 #include <casinocoin/rpc/RPCHandler.h>
 #include <test/jtx.h>
 #include <casinocoin/beast/unit_test.h>
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 
 namespace casinocoin {
 namespace test {
@@ -1382,6 +1388,174 @@ public:
             stpath(IPE(G2["HKD"]), G2)));
     }
 
+    // A1 holds several currencies issued by G1, and market makers offer
+    // each of them, and CSC, for the USD that A2 wants.
+    static void
+    multi_currency_market(jtx::Env& env, int makers)
+    {
+        using namespace jtx;
+        Account const G1 {"G1"};
+        Account const A1 {"A1"};
+        Account const A2 {"A2"};
+        std::vector<std::string> const currencies {"HKD", "EUR", "JPY", "GBP"};
+
+        env.fund(CSC(100000), G1, A1, A2);
+        env.close();
+
+        env.trust(G1["USD"](100000), A2);
+        for (auto const& c : currencies)
+        {
+            env.trust(G1[c](100000), A1);
+            env(pay(G1, A1, G1[c](10000)));
+        }
+        env.close();
+
+        for (int i = 0; i < makers; ++i)
+        {
+            Account const M {"M" + std::to_string(i)};
+            env.fund(CSC(100000), M);
+            env.close();
+            env.trust(G1["USD"](100000), M);
+            env(pay(G1, M, G1["USD"](10000)));
+            for (auto const& c : currencies)
+            {
+                env.trust(G1[c](100000), M);
+                env(offer(M, G1[c](100 + i), G1["USD"](100)));
+            }
+            env(offer(M, CSC(1000 + 10 * i), G1["USD"](100)));
+            env.close();
+        }
+    }
+
+    void
+    parallel_search_deterministic()
+    {
+        testcase("parallel search is deterministic");
+        using namespace jtx;
+
+        auto const alternatives = [&](int threads)
+        {
+            Env env(*this, envconfig([threads](std::unique_ptr<Config> cfg)
+                {
+                    cfg->PATH_SEARCH_THREADS = threads;
+                    return cfg;
+                }));
+            BEAST_EXPECT(env.app().getPathRequests().threads() ==
+                static_cast<std::size_t>(threads));
+            multi_currency_market(env, 3);
+            return find_paths_request(env, "A1", "A2",
+                Account("G1")["USD"](150))[jss::alternatives];
+        };
+
+        auto const serial = alternatives(1);
+        BEAST_EXPECT(serial.size() > 1);
+        for (int threads : {2, 4})
+            BEAST_EXPECT(alternatives(threads) == serial);
+    }
+
+    // Keeps the path_find updates pushed to it
+    class PathSubscriber : public InfoSub
+    {
+    public:
+        PathSubscriber (Source& source, Consumer consumer)
+            : InfoSub (source, consumer)
+        {
+        }
+
+        void
+        send (Json::Value const& jv, bool) override
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            updates_.push_back (jv);
+        }
+
+        std::vector<Json::Value>
+        updates ()
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            return std::move (updates_);
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<Json::Value> updates_;
+    };
+
+    void
+    partial_then_full_update()
+    {
+        testcase("partial update, then full update");
+        using namespace jtx;
+        using namespace std::chrono_literals;
+        Env env(*this, envconfig([](std::unique_ptr<Config> cfg)
+            {
+                cfg->PATH_SEARCH_THREADS = 1;
+                return cfg;
+            }));
+        multi_currency_market(env, 2);
+
+        auto& app = env.app();
+        auto& requests = app.getPathRequests();
+        auto const sub = std::make_shared<PathSubscriber>(app.getOPs(),
+            app.getResourceManager().newUnlimitedEndpoint("path_find"));
+
+        // Each update has time for only the first currency it searches
+        requests.setDeadline(1ns);
+
+        Json::Value params = Json::objectValue;
+        params[jss::source_account] = toBase58(Account("A1"));
+        params[jss::destination_account] = toBase58(Account("A2"));
+        params[jss::destination_amount] =
+            Account("G1")["USD"](100).value().getJson(0);
+        requests.makePathRequest(sub, env.current(), params);
+
+        auto update = [&]
+        {
+            env.close();
+            app.getJobQueue().rendezvous();
+            requests.updateAll(env.closed(), []{ return false; });
+            app.getJobQueue().rendezvous();
+            return sub->updates();
+        };
+
+        auto sourceCurrency = [](Json::Value const& alternative)
+        {
+            return amountFromJson(sfGeneric,
+                alternative[jss::source_amount]).getCurrency();
+        };
+
+        // A1 can pay in CSC and four other currencies. Each partial update
+        // searches the currency the last ones left longest.
+        std::set<Currency> searched;
+        for (int i = 0; i < 5; ++i)
+        {
+            for (auto const& jv : update())
+            {
+                BEAST_EXPECT(jv[jss::type] == "path_find");
+                BEAST_EXPECT(! jv[jss::full_reply].asBool());
+                auto const& alternatives = jv[jss::alternatives];
+                BEAST_EXPECT(alternatives.size() <= 1);
+                if (alternatives.size() == 1)
+                    searched.insert(sourceCurrency(alternatives[0u]));
+            }
+        }
+        BEAST_EXPECT(searched.size() == 5);
+
+        // Without a deadline the update searches every currency
+        requests.setDeadline(0ns);
+        auto const updates = update();
+        if (BEAST_EXPECT(! updates.empty()))
+        {
+            auto const& jv = updates.back();
+            BEAST_EXPECT(jv[jss::full_reply].asBool());
+            BEAST_EXPECT(jv[jss::alternatives].size() == 5);
+            std::set<Currency> all;
+            for (auto const& alternative : jv[jss::alternatives])
+                all.insert(sourceCurrency(alternative));
+            BEAST_EXPECT(all == searched);
+        }
+    }
+
     void
     run()
     {
@@ -1417,10 +1591,51 @@ public:
         path_find_04();
         path_find_05();
         path_find_06();
+        parallel_search_deterministic();
+        partial_then_full_update();
+    }
+};
+
+// Measures path_find latency with and without parallel search
+class PathFindTiming_test : public Path_test
+{
+public:
+    void
+    run() override
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+
+        for (int threads : {1, 4})
+        {
+            Env env(*this, envconfig([threads](std::unique_ptr<Config> cfg)
+                {
+                    cfg->PATH_SEARCH_THREADS = threads;
+                    return cfg;
+                }));
+            multi_currency_market(env, 20);
+
+            std::vector<std::int64_t> latencies;
+            for (int i = 0; i < 50; ++i)
+            {
+                auto const start = clock_type::now();
+                find_paths_request(env, "A1", "A2",
+                    Account("G1")["USD"](100 + 10 * i));
+                latencies.push_back(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        clock_type::now() - start).count());
+            }
+            std::sort(latencies.begin(), latencies.end());
+
+            log << threads << " thread(s): p50 " <<
+                latencies[latencies.size() / 2] << "us, p99 " <<
+                latencies[latencies.size() * 99 / 100] << "us" << std::endl;
+        }
     }
 };
 
 BEAST_DEFINE_TESTSUITE(Path,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(PathFindTiming,app,casinocoin);
 
 } // test
 } // casinocoin
@@ -0,0 +1,251 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/app/misc/SigVerifier.h>
+#include <casinocoin/protocol/digest.h>
+#include <casinocoin/protocol/SecretKey.h>
+#include <casinocoin/protocol/STTx.h>
+#include <test/jtx.h>
+#include <chrono>
+#include <future>
+
+namespace casinocoin {
+namespace test {
+
+// A signed AccountSet, with a bad signature if `good` is false
+static
+std::shared_ptr<STTx const>
+makeTx (std::pair<PublicKey, SecretKey> const& keys,
+    std::uint32_t seq, bool good = true)
+{
+    auto tx = std::make_shared<STTx> (ttACCOUNT_SET,
+        [&](auto& obj)
+        {
+            obj.setAccountID (sfAccount, calcAccountID (keys.first));
+            obj.setFieldU32 (sfSequence, seq);
+            obj.setFieldVL (sfSigningPubKey, keys.first.slice ());
+        });
+    if (good)
+        tx->sign (keys.first, keys.second);
+    else
+        tx->sign (keys.first, randomKeyPair (
+            *publicKeyType (keys.first)).second);
+    return tx;
+}
+
+static
+std::vector<std::shared_ptr<STTx const>>
+makeTxs (KeyType type, std::size_t count, std::size_t badEvery = 0)
+{
+    auto const keys = randomKeyPair (type);
+    std::vector<std::shared_ptr<STTx const>> txs;
+    for (std::size_t i = 0; i < count; ++i)
+        txs.push_back (makeTx (keys, i + 1,
+            badEvery == 0 || i % badEvery != 0));
+    return txs;
+}
+
+class SigVerifier_test : public beast::unit_test::suite
+{
+    void
+    testCache ()
+    {
+        testcase ("cache");
+
+        // 16 shards of 2 entries
+        SigCache cache (32);
+        for (std::uint32_t i = 0; i < 1000; ++i)
+            cache.insert (sha512Half (i), i % 2 == 0);
+        BEAST_EXPECT(cache.size () <= 32);
+        BEAST_EXPECT(cache.size () > 0);
+
+        // The newest entries are kept
+        BEAST_EXPECT(cache.find (sha512Half (std::uint32_t (998))) == true);
+        BEAST_EXPECT(cache.find (sha512Half (std::uint32_t (999))) == false);
+        BEAST_EXPECT(! cache.find (sha512Half (std::uint32_t (0))));
+
+        cache.insert (sha512Half (std::uint32_t (999)), true);
+        BEAST_EXPECT(cache.find (sha512Half (std::uint32_t (999))) == true);
+
+        cache.clear ();
+        BEAST_EXPECT(cache.size () == 0);
+    }
+
+    void
+    testCheck ()
+    {
+        testcase ("check");
+
+        jtx::Env env (*this);
+        auto& verifier = env.app ().getSigVerifier ();
+        verifier.cache ().clear ();
+
+        // Interleave key types and bad signatures, with enough
+        // ed25519 signatures for several batches
+        auto txs = makeTxs (KeyType::ed25519, 200, 7);
+        auto const secp = makeTxs (KeyType::secp256k1, 50, 5);
+        for (std::size_t i = 0; i < secp.size (); ++i)
+            txs.insert (txs.begin () + i * 4, secp[i]);
+
+        std::vector<bool> expected;
+        for (auto const& tx : txs)
+            expected.push_back (tx->checkSign (true).first);
+        BEAST_EXPECT(std::count (expected.begin (),
+            expected.end (), false) == 29 + 10);
+
+        auto const batched = checkSigns (txs, true);
+        auto const checked = verifier.check (txs, true);
+        bool same = true;
+        for (std::size_t i = 0; i < txs.size (); ++i)
+        {
+            same = same &&
+                batched[i].first == expected[i] &&
+                checked[i].first == expected[i] &&
+                checked[i].second.empty () == expected[i];
+        }
+        BEAST_EXPECT(same);
+        BEAST_EXPECT(verifier.checked () == txs.size ());
+
+        // Verdicts now come from the cache
+        auto const cached = verifier.check (txs, true);
+        for (std::size_t i = 0; i < txs.size (); ++i)
+            same = same && cached[i].first == expected[i];
+        BEAST_EXPECT(same);
+        BEAST_EXPECT(verifier.checked () == txs.size ());
+
+        // An entry with a single bad signature in an otherwise
+        // good batch doesn't spoil the others
+        auto one = makeTxs (KeyType::ed25519, 64);
+        one[17] = makeTx (randomKeyPair (KeyType::ed25519), 1, false);
+        auto const results = checkSigns (one, true);
+        for (std::size_t i = 0; i < one.size (); ++i)
+            same = same && results[i].first == (i != 17);
+        BEAST_EXPECT(same);
+    }
+
+    void
+    testVerify ()
+    {
+        testcase ("verify");
+
+        jtx::Env env (*this);
+        auto& verifier = env.app ().getSigVerifier ();
+
+        auto txs = makeTxs (KeyType::ed25519, 40, 3);
+        auto const secp = makeTxs (KeyType::secp256k1, 10, 3);
+        txs.insert (txs.end (), secp.begin (), secp.end ());
+
+        std::vector<std::promise<bool>> verdicts (txs.size ());
+        for (std::size_t i = 0; i < txs.size (); ++i)
+        {
+            verifier.verify (txs[i], true,
+                [&verdicts, i](bool valid, std::string const&)
+                {
+                    verdicts[i].set_value (valid);
+                });
+        }
+
+        bool same = true;
+        for (std::size_t i = 0; i < txs.size (); ++i)
+        {
+            auto future = verdicts[i].get_future ();
+            same = same &&
+                future.wait_for (std::chrono::seconds (10)) ==
+                    std::future_status::ready &&
+                future.get () == txs[i]->checkSign (true).first;
+        }
+        BEAST_EXPECT(same);
+
+        // A known verdict is given straight away
+        bool called = false;
+        verifier.verify (txs[1], true,
+            [&](bool valid, std::string const&)
+            {
+                called = valid;
+            });
+        BEAST_EXPECT(called);
+    }
+
+public:
+    void
+    run ()
+    {
+        testCache ();
+        testCheck ();
+        testVerify ();
+    }
+};
+
+// Reports signature verifications per second one at a time,
+// batched on one thread and through the SigVerifier
+class SigVerifierTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using clock_type = std::chrono::steady_clock;
+        std::size_t const count = 4096;
+
+        jtx::Env env (*this);
+        auto& verifier = env.app ().getSigVerifier ();
+
+        auto const rate = [&](clock_type::time_point start)
+        {
+            auto const us = std::chrono::duration_cast<
+                std::chrono::microseconds> (clock_type::now () - start);
+            return count * 1000000 / std::max<std::int64_t> (1, us.count ());
+        };
+
+        for (auto const type : {KeyType::ed25519, KeyType::secp256k1})
+        {
+            auto const txs = makeTxs (type, count);
+            log << (type == KeyType::ed25519 ? "ed25519" : "secp256k1") <<
+                std::endl;
+
+            auto start = clock_type::now ();
+            std::size_t good = 0;
+            for (auto const& tx : txs)
+                good += tx->checkSign (true).first;
+            BEAST_EXPECT(good == count);
+            log << "  checkSign: " << rate (start) << "/s" << std::endl;
+
+            start = clock_type::now ();
+            auto const batched = checkSigns (txs, true);
+            log << "  checkSigns: " << rate (start) << "/s" << std::endl;
+
+            verifier.cache ().clear ();
+            start = clock_type::now ();
+            auto const checked = verifier.check (txs, true);
+            log << "  SigVerifier: " << rate (start) << "/s" << std::endl;
+
+            good = 0;
+            for (std::size_t i = 0; i < count; ++i)
+                good += batched[i].first && checked[i].first;
+            BEAST_EXPECT(good == count);
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SigVerifier,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(SigVerifierTiming,app,casinocoin);
+
+} // test
+} // casinocoin
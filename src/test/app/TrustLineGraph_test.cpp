@@ -0,0 +1,375 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/paths/CasinocoinLineCache.h>
+#include <casinocoin/app/paths/Pathfinder.h>
+#include <casinocoin/app/paths/TrustLineGraph.h>
+#include <algorithm>
+#include <chrono>
+
+namespace casinocoin {
+namespace test {
+
+class TrustLineGraph_test : public beast::unit_test::suite
+{
+    // The closed ledgers of an Env, so a graph can walk back through them
+    struct History
+    {
+        hash_map<uint256, std::shared_ptr<ReadView const>> ledgers;
+        int fetched = 0;
+
+        std::shared_ptr<ReadView const>
+        close (jtx::Env& env)
+        {
+            env.close ();
+            auto const ledger = env.closed ();
+            ledgers[ledger->info ().hash] = ledger;
+            return ledger;
+        }
+
+        TrustLineGraph::GetLedger
+        getLedger ()
+        {
+            return [this](uint256 const& hash)
+                -> std::shared_ptr<ReadView const>
+            {
+                ++fetched;
+                auto const iter = ledgers.find (hash);
+                if (iter == ledgers.end ())
+                    return nullptr;
+                return iter->second;
+            };
+        }
+    };
+
+    // The graph has the same lines as the owner directories
+    bool
+    sameLines (TrustLineGraph::Snapshot const& graph,
+        ReadView const& ledger, std::vector<jtx::Account> const& accounts)
+    {
+        bool same = graph.seq () == ledger.seq () &&
+            graph.hash () == ledger.info ().hash;
+        for (auto const& account : accounts)
+        {
+            std::vector<uint256> expected;
+            for (auto const& item :
+                    getCasinocoinStateItems (account.id (), ledger))
+                expected.push_back (item->key ());
+            std::sort (expected.begin (), expected.end ());
+
+            auto const lines = graph.lines (account.id ());
+            same = same && std::vector<uint256> (
+                lines.begin (), lines.end ()) == expected;
+        }
+        return same;
+    }
+
+    void
+    testIncremental (std::size_t maxChanged)
+    {
+        testcase ("incremental, compact after " +
+            std::to_string (maxChanged));
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        TrustLineGraph graph (beast::Journal (), maxChanged);
+
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        Account const bob ("bob");
+        Account const carol ("carol");
+        std::vector<Account> const accounts {gw, alice, bob, carol};
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        env.fund (CSC(10000), gw, alice, bob, carol);
+        auto ledger = history.close (env);
+
+        BEAST_EXPECT(! graph.current ());
+        auto first = graph.update (ledger, history.getLedger ());
+        BEAST_EXPECT(first && graph.current () == first);
+        BEAST_EXPECT(first->accounts () == 0);
+        BEAST_EXPECT(sameLines (*first, *ledger, accounts));
+
+        // Updating to the same ledger again does nothing
+        BEAST_EXPECT(graph.update (ledger, history.getLedger ()) == first);
+
+        // Open ledgers are ignored
+        BEAST_EXPECT(graph.update (env.current (),
+            history.getLedger ()) == first);
+
+        env (trust (alice, USD(1000)));
+        env (trust (bob, USD(1000)));
+        env (trust (alice, EUR(1000)));
+        ledger = history.close (env);
+        auto const second = graph.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 0);
+        BEAST_EXPECT(second->accounts () == 3);
+        BEAST_EXPECT(second->lines (alice.id ()).size () == 2);
+        BEAST_EXPECT(second->lines (gw.id ()).size () == 3);
+        BEAST_EXPECT(sameLines (*second, *ledger, accounts));
+
+        // Payments change balances, not lines
+        env (pay (gw, alice, USD(100)));
+        env (trust (carol, alice["USD"](50)));
+        ledger = history.close (env);
+        BEAST_EXPECT(sameLines (*graph.update (ledger,
+            history.getLedger ()), *ledger, accounts));
+
+        // A line goes away once it is back to its default state
+        env (trust (bob, USD(0)));
+        env (pay (alice, gw, USD(100)));
+        ledger = history.close (env);
+        auto const third = graph.update (ledger, history.getLedger ());
+        BEAST_EXPECT(third->lines (bob.id ()).empty ());
+        BEAST_EXPECT(sameLines (*third, *ledger, accounts));
+
+        // Skipped ledgers are fetched and applied in order
+        env (trust (bob, EUR(500)));
+        history.close (env);
+        env (trust (carol, USD(10)));
+        history.close (env);
+        env (trust (bob, EUR(0)));
+        ledger = history.close (env);
+        auto const fourth = graph.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 2);
+        BEAST_EXPECT(sameLines (*fourth, *ledger, accounts));
+
+        // Older snapshots are unchanged
+        BEAST_EXPECT(first->accounts () == 0);
+        BEAST_EXPECT(first->lines (alice.id ()).empty ());
+        BEAST_EXPECT(second->lines (bob.id ()).size () == 1);
+    }
+
+    void
+    testRebuild ()
+    {
+        testcase ("rebuild");
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        TrustLineGraph graph {beast::Journal ()};
+
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        std::vector<Account> const accounts {gw, alice};
+
+        env.fund (CSC(10000), gw, alice);
+        auto ledger = history.close (env);
+        graph.update (ledger, history.getLedger ());
+
+        // A missing ledger in between means starting over
+        env (trust (alice, gw["USD"](100)));
+        auto const missing = history.close (env);
+        history.ledgers.erase (missing->info ().hash);
+        env (trust (alice, gw["EUR"](100)));
+        ledger = history.close (env);
+        auto snapshot = graph.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 1);
+        BEAST_EXPECT(snapshot->lines (alice.id ()).size () == 2);
+        BEAST_EXPECT(sameLines (*snapshot, *ledger, accounts));
+
+        // So does a ledger too far ahead, without fetching anything
+        for (int i = 0; i < 40; ++i)
+            ledger = history.close (env);
+        history.fetched = 0;
+        snapshot = graph.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 0);
+        BEAST_EXPECT(sameLines (*snapshot, *ledger, accounts));
+
+        // Or an earlier ledger
+        snapshot = graph.update (missing, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 0);
+        BEAST_EXPECT(snapshot->lines (alice.id ()).size () == 1);
+        BEAST_EXPECT(sameLines (*snapshot, *missing, accounts));
+    }
+
+    void
+    testLineCache ()
+    {
+        testcase ("line cache");
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        TrustLineGraph graph {beast::Journal ()};
+
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        Account const bob ("bob");
+        auto const USD = gw["USD"];
+
+        env.fund (CSC(10000), gw, alice, bob);
+        env (trust (alice, USD(1000)));
+        env (trust (bob, USD(1000)));
+        env (pay (gw, alice, USD(10)));
+        env (offer (alice, CSC(10), USD(1)));
+        auto const ledger = history.close (env);
+        auto const snapshot = graph.update (ledger, history.getLedger ());
+
+        auto const keys = [](std::vector<CasinocoinState::pointer> const& v)
+        {
+            std::vector<uint256> keys;
+            for (auto const& item : v)
+                keys.push_back (item->key ());
+            std::sort (keys.begin (), keys.end ());
+            return keys;
+        };
+
+        CasinocoinLineCache withGraph (ledger, snapshot);
+        CasinocoinLineCache without (ledger);
+        for (auto const& account : {gw, alice, bob})
+        {
+            auto const& lines = withGraph.getCasinocoinLines (account.id ());
+            BEAST_EXPECT(! lines.empty ());
+            BEAST_EXPECT(keys (lines) ==
+                keys (without.getCasinocoinLines (account.id ())));
+        }
+
+        // Items are seen from the account that asked for them
+        auto const& lines = withGraph.getCasinocoinLines (alice.id ());
+        BEAST_EXPECT(lines.size () == 1 &&
+            lines[0]->getAccountIDPeer () == gw.id () &&
+            lines[0]->getBalance () == USD(10));
+
+        // A graph of another ledger is not used
+        env (trust (alice, gw["EUR"](1000)));
+        auto const next = history.close (env);
+        CasinocoinLineCache stale (next, snapshot);
+        BEAST_EXPECT(stale.getCasinocoinLines (alice.id ()).size () == 2);
+    }
+
+public:
+    void
+    run ()
+    {
+        testIncremental (4096);
+        testIncremental (1);
+        testRebuild ();
+        testLineCache ();
+    }
+};
+
+// Compares finding trust lines with and without the graph, on accounts
+// whose owner directories are mostly offers
+class TrustLineGraphTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        Env env (*this);
+        std::vector<Account> gateways;
+        for (int i = 0; i < 5; ++i)
+        {
+            gateways.emplace_back ("gateway" + std::to_string (i));
+            env.fund (CSC(1000000), gateways.back ());
+        }
+        env.close ();
+
+        std::vector<Account> accounts;
+        for (int i = 0; i < 500; ++i)
+        {
+            accounts.emplace_back ("a" + std::to_string (i));
+            auto const& a = accounts.back ();
+            env.fund (CSC(100000), a);
+            env.close ();
+            for (auto const& gw : gateways)
+            {
+                env (trust (a, gw["USD"](1000)));
+                env (pay (gw, a, gw["USD"](100)));
+            }
+            for (int j = 0; j < 10; ++j)
+                env (offer (a, CSC(10 + j), gateways[j % 5]["USD"](1)));
+            if (i % 50 == 49)
+                env.close ();
+        }
+        env.close ();
+
+        auto const ledger = env.closed ();
+        auto const getLedger = [&env](uint256 const& hash)
+            -> std::shared_ptr<ReadView const>
+        {
+            return env.app ().getLedgerMaster ().getLedgerByHash (hash);
+        };
+
+        TrustLineGraph graph {beast::Journal ()};
+        auto start = clock_type::now ();
+        auto const snapshot = graph.update (ledger, getLedger);
+        log << "built graph of " << snapshot->accounts () << " accounts in " <<
+            elapsed (start) << "us" << std::endl;
+
+        Pathfinder::initPathTable ();
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            for (bool useGraph : {false, true})
+            {
+                auto const cache = std::make_shared<CasinocoinLineCache> (
+                    ledger, useGraph ? snapshot : nullptr);
+
+                std::size_t lines = 0;
+                start = clock_type::now ();
+                for (auto const& a : accounts)
+                    lines += cache->getCasinocoinLines (a.id ()).size ();
+                for (auto const& gw : gateways)
+                    lines += cache->getCasinocoinLines (gw.id ()).size ();
+                auto const linesTime = elapsed (start);
+
+                // A fresh cache for pathfinding, so no lines are cached
+                auto const pathCache = std::make_shared<CasinocoinLineCache> (
+                    ledger, useGraph ? snapshot : nullptr);
+                start = clock_type::now ();
+                for (int i = 0; i < 20; ++i)
+                {
+                    auto const& src = accounts[i];
+                    auto const& dst = accounts[accounts.size () - 1 - i];
+                    Pathfinder pf (pathCache, src.id (), dst.id (),
+                        to_currency ("USD"), boost::none,
+                            gateways[0]["USD"](5), boost::none, env.app ());
+                    if (pf.findPaths (4))
+                        pf.computePathRanks (4);
+                }
+                auto const pathTime = elapsed (start);
+
+                log << (useGraph ? "graph:      " : "directory:  ") <<
+                    lines << " lines in " << linesTime << "us, " <<
+                    "20 path searches in " << pathTime << "us" << std::endl;
+            }
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TrustLineGraph,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(TrustLineGraphTiming,app,casinocoin);
+
+} // test
+} // casinocoin
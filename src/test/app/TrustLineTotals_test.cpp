@@ -0,0 +1,508 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/paths/AccountCurrencies.h>
+#include <casinocoin/app/paths/CasinocoinState.h>
+#include <casinocoin/app/paths/CasinocoinLineCache.h>
+#include <casinocoin/app/paths/PathRequests.h>
+#include <casinocoin/app/paths/TrustLineTotals.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+namespace casinocoin {
+namespace test {
+
+class TrustLineTotals_test : public beast::unit_test::suite
+{
+    // The closed ledgers of an Env, so the totals can walk back
+    // through them
+    struct History
+    {
+        hash_map<uint256, std::shared_ptr<ReadView const>> ledgers;
+        int fetched = 0;
+
+        std::shared_ptr<ReadView const>
+        close (jtx::Env& env)
+        {
+            env.close ();
+            auto const ledger = env.closed ();
+            ledgers[ledger->info ().hash] = ledger;
+            return ledger;
+        }
+
+        TrustLineTotals::GetLedger
+        getLedger ()
+        {
+            return [this](uint256 const& hash)
+                -> std::shared_ptr<ReadView const>
+            {
+                ++fetched;
+                auto const iter = ledgers.find (hash);
+                if (iter == ledgers.end ())
+                    return nullptr;
+                return iter->second;
+            };
+        }
+    };
+
+    using SnapshotPtr = std::shared_ptr<TrustLineTotals::Snapshot const>;
+
+    // The totals agree with a walk of the lines of each account
+    bool
+    sameTotals (SnapshotPtr const& snapshot,
+        std::shared_ptr<ReadView const> const& ledger,
+            std::vector<jtx::Account> const& accounts)
+    {
+        bool same = snapshot->seq () == ledger->seq () &&
+            snapshot->hash () == ledger->info ().hash;
+
+        auto const plain = std::make_shared<CasinocoinLineCache> (ledger);
+        auto const withTotals = std::make_shared<CasinocoinLineCache> (
+            ledger, nullptr, snapshot);
+        same = same && withTotals->getTotals ();
+
+        for (auto const& account : accounts)
+        {
+            auto const id = account.id ();
+            std::map<Currency, std::uint32_t> lines;
+            std::map<Currency, std::uint32_t> obligations;
+            std::map<Currency, TrustLineTotals::Sum> owed;
+            std::vector<uint256> unusual;
+            for (auto const& item : getCasinocoinStateItems (id, *ledger))
+            {
+                auto const& balance = item->getBalance ();
+                auto const currency = balance.getCurrency ();
+                ++lines[currency];
+                if (balance > zero || (balance < zero && item->getFreeze ()))
+                {
+                    unusual.push_back (item->key ());
+                }
+                else if (balance < zero)
+                {
+                    ++obligations[currency];
+                    owed[currency] -= balance;
+                }
+            }
+            std::sort (unusual.begin (), unusual.end ());
+
+            auto const totals = snapshot->account (id);
+            if (! totals)
+            {
+                same = same && lines.empty () && unusual.empty ();
+                continue;
+            }
+
+            same = same && totals->unusual == unusual &&
+                totals->currencies.size () == lines.size ();
+            for (auto const& item : totals->currencies)
+            {
+                auto const& c = item.first;
+                same = same && item.second.lines == lines[c] &&
+                    item.second.obligations == obligations[c] &&
+                    item.second.owed == owed[c];
+            }
+
+            for (bool includeCSC : {false, true})
+            {
+                same = same &&
+                    accountSourceCurrencies (id, plain, includeCSC) ==
+                        accountSourceCurrencies (id, withTotals, includeCSC) &&
+                    accountDestCurrencies (id, plain, includeCSC) ==
+                        accountDestCurrencies (id, withTotals, includeCSC);
+            }
+        }
+        return same;
+    }
+
+    void
+    testIncremental (std::size_t maxChanged)
+    {
+        testcase ("incremental, compact after " +
+            std::to_string (maxChanged));
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        TrustLineTotals totals (beast::Journal (), maxChanged);
+
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        Account const bob ("bob");
+        Account const carol ("carol");
+        std::vector<Account> const accounts {gw, alice, bob, carol};
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        env.fund (CSC(10000), gw, alice, bob, carol);
+        auto ledger = history.close (env);
+
+        BEAST_EXPECT(! totals.current ());
+        auto const first = totals.update (ledger, history.getLedger ());
+        BEAST_EXPECT(first && totals.current () == first);
+        BEAST_EXPECT(first->accounts () == 0);
+        BEAST_EXPECT(sameTotals (first, ledger, accounts));
+
+        // Updating to the same ledger again does nothing
+        BEAST_EXPECT(totals.update (ledger, history.getLedger ()) == first);
+
+        // Open ledgers are ignored
+        BEAST_EXPECT(totals.update (env.current (),
+            history.getLedger ()) == first);
+
+        env (trust (alice, USD(1000)));
+        env (trust (bob, USD(1000)));
+        env (trust (alice, EUR(1000)));
+        env (pay (gw, alice, USD(100)));
+        env (pay (gw, bob, USD(20)));
+        ledger = history.close (env);
+        auto const second = totals.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 0);
+        BEAST_EXPECT(second->accounts () == 3);
+        BEAST_EXPECT(sameTotals (second, ledger, accounts));
+        {
+            auto const g = second->account (gw.id ());
+            auto const& usd = g->currencies.at (USD.currency);
+            BEAST_EXPECT(usd.lines == 2 && usd.obligations == 2);
+            BEAST_EXPECT(usd.owed.value (USD.issue ()) == USD(120));
+            BEAST_EXPECT(g->currencies.at (EUR.currency).obligations == 0);
+        }
+
+        // Several changes to a line in one ledger, and lines rippling
+        // through an account that isn't the issuer
+        env (pay (alice, bob, USD(30)));
+        env (pay (bob, alice, USD(5)));
+        env (trust (carol, alice["USD"](50)));
+        env (pay (alice, carol, alice["USD"](10)));
+        ledger = history.close (env);
+        BEAST_EXPECT(sameTotals (totals.update (ledger,
+            history.getLedger ()), ledger, accounts));
+
+        // Frozen obligations and assets are listed, not summed
+        env (trust (gw, bob["USD"](0), tfSetFreeze));
+        env (trust (gw, alice["AUD"](100)));
+        env (pay (alice, gw, alice["AUD"](10)));
+        ledger = history.close (env);
+        auto const third = totals.update (ledger, history.getLedger ());
+        BEAST_EXPECT(sameTotals (third, ledger, accounts));
+        {
+            auto const g = third->account (gw.id ());
+            BEAST_EXPECT(g->unusual.size () == 2);
+            BEAST_EXPECT(g->currencies.at (USD.currency).obligations == 1);
+        }
+
+        // Lines going away take their totals with them
+        env (trust (gw, bob["USD"](0), tfClearFreeze));
+        env (pay (bob, gw, USD(45)));
+        env (trust (bob, USD(0)));
+        env (pay (gw, alice, alice["AUD"](10)));
+        env (trust (gw, alice["AUD"](0)));
+        ledger = history.close (env);
+        auto const fourth = totals.update (ledger, history.getLedger ());
+        BEAST_EXPECT(fourth->account (gw.id ())->unusual.empty ());
+        BEAST_EXPECT(sameTotals (fourth, ledger, accounts));
+
+        // Skipped ledgers are fetched and applied in order
+        env (trust (bob, EUR(500)));
+        env (pay (gw, bob, EUR(50)));
+        history.close (env);
+        env (trust (carol, USD(10)));
+        history.close (env);
+        env (pay (bob, gw, EUR(50)));
+        env (trust (bob, EUR(0)));
+        ledger = history.close (env);
+        auto const fifth = totals.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 2);
+        BEAST_EXPECT(sameTotals (fifth, ledger, accounts));
+
+        // Older snapshots are unchanged
+        BEAST_EXPECT(first->accounts () == 0);
+        BEAST_EXPECT(second->account (carol.id ()) == nullptr);
+        BEAST_EXPECT(second->account (gw.id ())->currencies.at (
+            USD.currency).owed.value (USD.issue ()) == USD(120));
+    }
+
+    void
+    testRebuild ()
+    {
+        testcase ("rebuild");
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        TrustLineTotals totals {beast::Journal ()};
+
+        Account const gw ("gateway");
+        Account const alice ("alice");
+        std::vector<Account> const accounts {gw, alice};
+
+        env.fund (CSC(10000), gw, alice);
+        auto ledger = history.close (env);
+        totals.update (ledger, history.getLedger ());
+
+        // A missing ledger in between means starting over
+        env (trust (alice, gw["USD"](100)));
+        env (pay (gw, alice, gw["USD"](10)));
+        auto const missing = history.close (env);
+        history.ledgers.erase (missing->info ().hash);
+        env (trust (alice, gw["EUR"](100)));
+        ledger = history.close (env);
+        auto snapshot = totals.update (ledger, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 1);
+        BEAST_EXPECT(snapshot->account (alice.id ())->
+            currencies.size () == 2);
+        BEAST_EXPECT(sameTotals (snapshot, ledger, accounts));
+
+        // Or an earlier ledger
+        history.fetched = 0;
+        snapshot = totals.update (missing, history.getLedger ());
+        BEAST_EXPECT(history.fetched == 0);
+        BEAST_EXPECT(sameTotals (snapshot, missing, accounts));
+    }
+
+    void
+    testExactSums ()
+    {
+        testcase ("exact sums");
+        using namespace jtx;
+
+        Env env (*this);
+        History history;
+        TrustLineTotals totals {beast::Journal ()};
+
+        Account const gw ("gateway");
+        Account const whale ("whale");
+        Account const alice ("alice");
+        auto const USD = gw["USD"];
+
+        env.fund (CSC(100000), gw, whale, alice);
+        env.close ();
+        env (trust (whale, USD(1000000000)));
+        env (trust (alice, USD(1000)));
+        env (pay (gw, whale, USD(100000000)));
+        totals.update (history.close (env), history.getLedger ());
+
+        // Each payment is far below the last digit the total has room
+        // for, so a running total in an STAmount would lose them
+        STAmount const small (USD.issue (), 1234567, -15);
+        auto const payments = [&](Account const& from, Account const& to,
+            int ledgers)
+        {
+            for (int i = 0; i < ledgers; ++i)
+            {
+                for (int j = 0; j < 10; ++j)
+                    env (pay (from, to, small));
+                totals.update (history.close (env), history.getLedger ());
+            }
+        };
+        payments (gw, alice, 20);
+        payments (alice, gw, 10);
+
+        auto const ledger = env.closed ();
+        auto const snapshot = totals.current ();
+        BEAST_EXPECT(snapshot->hash () == ledger->info ().hash);
+
+        TrustLineTotals::Sum walked;
+        forEachItem (*ledger, gw.id (),
+            [&](std::shared_ptr<SLE const> const& sle)
+            {
+                auto const line = CasinocoinState::makeItem (gw.id (), sle);
+                if (line && line->getBalance () < zero &&
+                        ! line->getFreeze ())
+                    walked -= line->getBalance ();
+            });
+
+        auto const& owed = snapshot->account (gw.id ())->
+            currencies.at (USD.currency).owed;
+        BEAST_EXPECT(owed == walked);
+        BEAST_EXPECT(owed.value (USD.issue ()).getText () ==
+            "100000000.0000001");
+        BEAST_EXPECT(sameTotals (snapshot, ledger, {gw, whale, alice}));
+    }
+
+    void
+    testRPC ()
+    {
+        testcase ("rpc");
+        using namespace jtx;
+
+        Env env (*this);
+        Account const gw ("gateway");
+        Account const hot ("hot");
+        Account const alice ("alice");
+        Account const bob ("bob");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        env.fund (CSC(10000), gw, hot, alice, bob);
+        env.close ();
+        for (auto const& a : {hot, alice, bob})
+        {
+            env (trust (a, USD(1000)));
+            env (trust (a, EUR(1000)));
+        }
+        env.close ();
+        env (pay (gw, hot, USD(500)));
+        env (pay (gw, alice, USD(70)));
+        env (pay (gw, alice, EUR(20)));
+        env (pay (gw, bob, USD(9)));
+        env (trust (gw, bob["USD"](0), tfSetFreeze));
+        env (trust (gw, alice["AUD"](100)));
+        env (pay (alice, gw, alice["AUD"](10)));
+        env.close ();
+
+        auto const ledger = env.closed ();
+        auto const query = [&]()
+        {
+            Json::Value params;
+            params[jss::account] = gw.human ();
+            params[jss::ledger_index] = ledger->seq ();
+            params[jss::hotwallet] = hot.human ();
+            auto balances = env.rpc ("json", "gateway_balances",
+                to_string (params))[jss::result];
+
+            params.removeMember (jss::hotwallet);
+            Json::Value currencies (Json::objectValue);
+            for (auto const& a : {gw, hot, alice, bob})
+            {
+                params[jss::account] = a.human ();
+                currencies[a.human ()] = env.rpc ("json",
+                    "account_currencies", to_string (params))[jss::result];
+            }
+            return std::make_pair (balances, currencies);
+        };
+
+        // Walk the lines, then answer from the totals of the ledger
+        auto& pathRequests = env.app ().getPathRequests ();
+        auto const before = pathRequests.getLineTotals ();
+        auto const walked = (before && before->hash () ==
+            ledger->info ().hash) ? decltype (query ()) () : query ();
+
+        pathRequests.getLineCache (ledger, true);
+        auto const snapshot = pathRequests.getLineTotals ();
+        BEAST_EXPECT(snapshot && snapshot->hash () == ledger->info ().hash);
+        auto const indexed = query ();
+
+        auto const& b = indexed.first;
+        BEAST_EXPECT(b[jss::obligations][to_string (USD.currency)] == "70");
+        BEAST_EXPECT(b[jss::obligations][to_string (EUR.currency)] == "20");
+        BEAST_EXPECT(b[jss::balances][hot.human ()].size () == 1);
+        BEAST_EXPECT(b[jss::balances][hot.human ()][0u][jss::value] == "500");
+        BEAST_EXPECT(b[jss::frozen_balances][bob.human ()][0u][jss::value] ==
+            "9");
+        BEAST_EXPECT(b[jss::assets][alice.human ()][0u][jss::value] == "10");
+
+        auto const& c = indexed.second[alice.human ()];
+        BEAST_EXPECT(c[jss::send_currencies].size () == 3);
+        BEAST_EXPECT(c[jss::receive_currencies].size () == 3);
+
+        if (! walked.first.isNull ())
+        {
+            BEAST_EXPECT(walked.first == indexed.first);
+            BEAST_EXPECT(walked.second == indexed.second);
+        }
+    }
+
+public:
+    void
+    run ()
+    {
+        testIncremental (4096);
+        testIncremental (1);
+        testRebuild ();
+        testExactSums ();
+        testRPC ();
+    }
+};
+
+// Compares gateway_balances with and without the totals, for a gateway
+// with many trust lines
+class TrustLineTotalsTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        Env env (*this);
+        Account const gw ("gateway");
+        env.fund (CSC(10000000), gw);
+        env.close ();
+
+        char const* names[] = {"USD", "EUR", "JPY", "GBP"};
+        for (int i = 0; i < 2000; ++i)
+        {
+            Account const a ("a" + std::to_string (i));
+            env.fund (CSC(10000), a);
+            for (auto const name : names)
+            {
+                env (trust (a, gw[name](1000)));
+                env (pay (gw, a, gw[name](1 + i % 100)));
+            }
+            if (i % 100 == 99)
+                env.close ();
+        }
+        env.close ();
+
+        auto const ledger = env.closed ();
+        auto const query = [&]()
+        {
+            Json::Value params;
+            params[jss::account] = gw.human ();
+            params[jss::ledger_index] = ledger->seq ();
+            auto const start = clock_type::now ();
+            auto const jv = env.rpc ("json", "gateway_balances",
+                to_string (params))[jss::result];
+            return std::make_pair (jv, elapsed (start));
+        };
+
+        auto const walked = query ();
+
+        auto& pathRequests = env.app ().getPathRequests ();
+        auto const start = clock_type::now ();
+        pathRequests.getLineCache (ledger, true);
+        log << "built totals of " <<
+            pathRequests.getLineTotals ()->accounts () << " accounts in " <<
+            elapsed (start) << "us" << std::endl;
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            auto const indexed = query ();
+            BEAST_EXPECT(indexed.first[jss::obligations] ==
+                walked.first[jss::obligations]);
+            log << "gateway_balances: walk " << walked.second <<
+                "us, totals " << indexed.second << "us" << std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TrustLineTotals,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(TrustLineTotalsTiming,app,casinocoin);
+
+} // test
+} // casinocoin
@@ -17,6 +17,7 @@
 */
 //==============================================================================
 
+#include <casinocoin/app/ledger/OpenLedger.h>
 #include <casinocoin/app/main/Application.h>
 #include <casinocoin/app/misc/LoadFeeTrack.h>
 #include <casinocoin/app/misc/TxQ.h>
@@ -32,6 +33,7 @@
 #include <test/jtx.h>
 #include <test/jtx/ticket.h>
 #include <boost/optional.hpp>
+#include <chrono>
 #include <test/jtx/WSClient.h>
 
 namespace casinocoin {
@@ -2790,6 +2792,70 @@ public:
         }
     }
 
+    void testAcceptResume()
+    {
+        using namespace jtx;
+
+        Env env(*this,
+            makeConfig({ { "minimum_txn_in_ledger_standalone", "3" },
+                { "maximum_accept_time", "1" } }),
+            features(featureFeeEscalation));
+        auto& txq = env.app().getTxQ();
+
+        auto alice = Account("alice");
+        auto bob = Account("bob");
+        auto USD = bob["USD"];
+        auto queued = ter(terQUEUED);
+
+        // What alice keeps once her offer is taken: the reserve
+        // for the trust line she gets
+        auto const fees = env.current()->fees();
+        std::uint64_t const reserve = fees.reserve + fees.increment;
+        std::uint64_t const sold = 4 * reserve;
+
+        env.fund(drops(reserve + sold), noCasinocoin(alice));
+        env.fund(CSC(100000), noCasinocoin(bob));
+        env(offer(alice, USD(sold), drops(sold)));
+        env.close();
+
+        // Queue a few transactions, and one which will be unable to
+        // pay its fee once alice's offer is taken
+        fillQueue(env, alice);
+        auto aliceSeq = env.seq(alice);
+        env(noop(alice), seq(aliceSeq++), queued);
+        env(noop(alice), seq(aliceSeq++), queued);
+        env(noop(alice), seq(aliceSeq++), queued);
+        env(noop(alice), fee(drops(2 * reserve)), seq(aliceSeq), queued);
+        env(offer(bob, drops(sold), USD(sold)), openLedgerFee(env));
+        env.require(balance(alice, drops(reserve)));
+
+        auto const retries = [&]
+        {
+            auto const txs = txq.getTxs(*env.current());
+            if (!BEAST_EXPECT(txs.size() == 1))
+                return -1;
+            return txs.front().retriesRemaining;
+        };
+
+        // The last transaction is tried once and stays in the queue
+        env.close();
+        auto const tried = retries();
+        BEAST_EXPECT(tried >= 0);
+
+        // Accepting again on the same open ledger, as a resumed
+        // accept does, doesn't try it again
+        env.app().openLedger().modify(
+            [&](OpenView& view, beast::Journal)
+            {
+                return txq.accept(env.app(), view);
+            });
+        BEAST_EXPECT(retries() == tried);
+
+        // The next open ledger does
+        env.close();
+        BEAST_EXPECT(retries() == tried - 1);
+    }
+
     void run()
     {
 //        testQueue();
@@ -2814,11 +2880,106 @@ public:
 //        testServerInfo();
 //        testServerSubscribe();
 //        testClearQueuedAccountTxs();
-        pass();
+        testAcceptResume();
+    }
+};
+
+// Fills the queue with a large number of transactions and reports how
+// long closing ledgers takes while it drains, with and without a limit
+// on the time spent in TxQ::accept. The number of transactions can be
+// given as the suite argument.
+class TxQStress_test : public beast::unit_test::suite
+{
+    void
+    stress(int count, std::string const& acceptTime)
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                clock_type::now() - start).count();
+        };
+
+        int const perAccount = 100;
+        int const accounts = (count + perAccount - 1) / perAccount;
+
+        auto p = envconfig();
+        auto& section = p->section("transaction_queue");
+        section.set("minimum_txn_in_ledger_standalone", "1000");
+        section.set("ledgers_in_queue", std::to_string(
+            count / 1000 + 20));
+        section.set("maximum_txn_per_account", std::to_string(perAccount));
+        section.set("maximum_accept_time", acceptTime);
+
+        Env env(*this, std::move(p), features(featureFeeEscalation));
+        auto& txq = env.app().getTxQ();
+
+        Account const gw("gateway");
+        env.fund(CSC(1000000), gw);
+        env.close();
+
+        std::vector<Account> senders;
+        senders.reserve(accounts);
+        for (int i = 0; i < accounts; ++i)
+        {
+            senders.emplace_back("s" + std::to_string(i));
+            env.fund(CSC(100000), senders.back());
+            if (i % 200 == 199)
+                env.close();
+        }
+        env.close();
+
+        auto start = clock_type::now();
+        env.close();
+        log << "close with an empty queue: " << elapsed(start) << "ms" <<
+            std::endl;
+
+        start = clock_type::now();
+        std::vector<std::uint32_t> seqs;
+        seqs.reserve(accounts);
+        for (auto const& a : senders)
+            seqs.push_back(env.seq(a));
+        for (int i = 0; i < count; ++i)
+        {
+            auto const n = i % accounts;
+            env(pay(senders[n], gw, CSC(1)), seq(seqs[n]++),
+                ter(std::ignore));
+        }
+        auto metrics = txq.getMetrics(*env.current());
+        BEAST_EXPECT(metrics);
+        log << "submitted " << count << " transactions in " <<
+            elapsed(start) << "ms, " << metrics->txCount << " queued" <<
+            std::endl;
+
+        std::size_t queued = metrics->txCount;
+        for (int closes = 0; queued > 0 && closes < 50; ++closes)
+        {
+            start = clock_type::now();
+            env.close();
+            auto const closeTime = elapsed(start);
+            metrics = txq.getMetrics(*env.current());
+            log << "close " << closes << ": " << closeTime << "ms, " <<
+                metrics->txInLedger << " in the open ledger, " <<
+                metrics->txCount << " queued" << std::endl;
+            queued = metrics->txCount;
+        }
+    }
+
+public:
+    void run()
+    {
+        int const count = arg().empty() ? 100000 : std::stoi(arg());
+
+        log << "maximum_accept_time = 0" << std::endl;
+        stress(count, "0");
+        log << "maximum_accept_time = 50" << std::endl;
+        stress(count, "50");
     }
 };
 
 BEAST_DEFINE_TESTSUITE(TxQ,app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(TxQStress,app,casinocoin);
 
 }
 }
@@ -22,6 +22,12 @@
 #include <casinocoin/basics/TaggedCache.h>
 #include <casinocoin/beast/unit_test.h>
 #include <casinocoin/beast/clock/manual_clock.h>
+#include <casinocoin/beast/xor_shift_engine.h>
+#include <casinocoin/basics/random.h>
+#include <casinocoin/protocol/digest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace casinocoin {
 
@@ -37,18 +43,147 @@ original object.
 
 class TaggedCache_test : public beast::unit_test::suite
 {
+    using Key = int;
+    using Value = std::string;
+    using Cache = TaggedCache <Key, Value>;
+
+    void testClock ()
+    {
+        testcase ("clock");
+
+        beast::Journal const j;
+        TestStopwatch clock;
+        clock.set (0);
+
+        Cache c ("test", 64, 3600, clock, j);
+
+        // An object used between inserts survives while the rest of
+        // the cache turns over
+        BEAST_EXPECT(! c.insert (0, "hot"));
+        int maxSize = 0;
+        for (int i = 1; i < 10000; ++i)
+        {
+            c.insert (i, std::to_string (i));
+            BEAST_EXPECT(c.fetch (0) != nullptr);
+            maxSize = std::max (maxSize, c.getCacheSize ());
+        }
+        BEAST_EXPECT(maxSize <= 2 * 64);
+
+        // Objects held elsewhere are still tracked after ejection
+        {
+            Cache::mapped_ptr p (std::make_shared <Value> ("held"));
+            c.canonicalize (20000, p);
+            for (int i = 20001; i < 21000; ++i)
+                c.insert (i, std::to_string (i));
+            Cache::mapped_ptr p2 (std::make_shared <Value> ("other"));
+            BEAST_EXPECT(c.canonicalize (20000, p2));
+            BEAST_EXPECT(p.get () == p2.get ());
+        }
+
+        // Objects revived by a fetch make room as inserts do
+        {
+            std::vector<Cache::mapped_ptr> held;
+            for (int i = 30000; i < 31000; ++i)
+            {
+                held.push_back (std::make_shared <Value> (std::to_string (i)));
+                c.canonicalize (i, held.back ());
+            }
+            for (int i = 30000; i < 31000; ++i)
+                BEAST_EXPECT(c.fetch (i) == held[i - 30000]);
+            BEAST_EXPECT(c.getCacheSize () <= 2 * 64);
+        }
+
+        // Sweeping drops the entries of destroyed objects
+        c.sweep ();
+        BEAST_EXPECT(c.getTrackSize () == c.getCacheSize ());
+        BEAST_EXPECT(c.getCacheSize () <= 64 + 16);
+
+        clock.set (7200);
+        c.sweep ();
+        BEAST_EXPECT(c.getCacheSize () == 0);
+        BEAST_EXPECT(c.getTrackSize () == 0);
+    }
+
+    void testBytes ()
+    {
+        testcase ("bytes");
+
+        beast::Journal const j;
+        TestStopwatch clock;
+        clock.set (0);
+
+        Cache c ("test", 0, 3600, clock, j);
+        auto const target = 1000 * sizeof (Value);
+        c.setTargetBytes (target);
+        BEAST_EXPECT(c.getTargetBytes () == target);
+
+        for (int i = 0; i < 10000; ++i)
+            c.insert (i, std::to_string (i));
+
+        BEAST_EXPECT(c.getCacheBytes () ==
+            c.getCacheSize () * sizeof (Value));
+        BEAST_EXPECT(c.getCacheBytes () <= 2 * target);
+
+        c.sweep ();
+        BEAST_EXPECT(c.getCacheBytes () <= target + 16 * sizeof (Value));
+
+        c.clear ();
+        BEAST_EXPECT(c.getCacheBytes () == 0);
+    }
+
+    void testConcurrent ()
+    {
+        testcase ("concurrent");
+
+        beast::Journal const j;
+        TestStopwatch clock;
+        clock.set (0);
+
+        Cache c ("test", 256, 3600, clock, j);
+
+        // Threads racing to canonicalize the same keys agree on
+        // the object for each key
+        int const keys = 1000;
+        std::vector<std::vector<Cache::mapped_ptr>> seen (4);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back ([&c, &seen, t, keys]
+            {
+                for (int i = 0; i < keys; ++i)
+                {
+                    Cache::mapped_ptr p (std::make_shared <Value> (
+                        std::to_string (i)));
+                    c.canonicalize (i, p);
+                    seen[t].push_back (p);
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join ();
+
+        bool same = true;
+        for (int i = 0; i < keys; ++i)
+            for (int t = 1; t < 4; ++t)
+                same = same && seen[t][i] == seen[0][i];
+        BEAST_EXPECT(same);
+        BEAST_EXPECT(c.getTrackSize () == keys);
+    }
+
 public:
     void run ()
     {
+        testClock ();
+        testBytes ();
+        testConcurrent ();
+
+        testcase ("basics");
+
         beast::Journal const j;
 
         TestStopwatch clock;
         clock.set (0);
 
-        using Key = int;
-        using Value = std::string;
-        using Cache = TaggedCache <Key, Value>;
-
         Cache c ("test", 1, 1, clock, j);
 
         // Insert an item, retrieve it, and age it so it gets purged.
@@ -147,6 +282,73 @@ public:
     }
 };
 
+// Measures throughput with many threads sharing a cache
+class TaggedCacheTiming_test : public beast::unit_test::suite
+{
+public:
+    void run ()
+    {
+        using Cache = TaggedCache <uint256, std::string>;
+        using clock_type = std::chrono::steady_clock;
+
+        beast::Journal const j;
+        int const keys = 100000;
+        int const ops = 1000000;
+
+        std::vector<uint256> hashes;
+        for (int i = 0; i < keys; ++i)
+            hashes.push_back (sha512Half (i));
+
+        for (bool serialized : {true, false})
+        {
+            for (int threads : {1, 2, 4, 8})
+            {
+                Cache c ("test", keys / 2, 60, stopwatch (), j);
+                std::mutex m;
+
+                auto const work = [&](int seed)
+                {
+                    beast::xor_shift_engine gen (seed);
+                    for (int i = 0; i < ops / threads; ++i)
+                    {
+                        // Most reads go to a small set of hot keys
+                        auto const r = rand_int (gen, keys - 1);
+                        auto const& key = hashes[(i % 4) ? r % 1000 : r];
+
+                        std::unique_lock<std::mutex> lock (m, std::defer_lock);
+                        if (serialized)
+                            lock.lock ();
+
+                        if (i % 10 == 0 || ! c.fetch (key))
+                        {
+                            auto p = std::make_shared<std::string> ("value");
+                            c.canonicalize (key, p);
+                        }
+                        if (i % 100000 == 0)
+                            c.sweep ();
+                    }
+                };
+
+                auto const start = clock_type::now ();
+                std::vector<std::thread> pool;
+                for (int t = 0; t < threads; ++t)
+                    pool.emplace_back (work, t + 1);
+                for (auto& t : pool)
+                    t.join ();
+                auto const elapsed = std::chrono::duration_cast<
+                    std::chrono::milliseconds> (clock_type::now () - start);
+
+                log << (serialized ? "one lock, " : "sharded,  ") <<
+                    threads << " threads: " << ops << " ops in " <<
+                    elapsed.count () << "ms, hit rate " <<
+                    c.getHitRate () << "%" << std::endl;
+            }
+        }
+        pass ();
+    }
+};
+
 BEAST_DEFINE_TESTSUITE(TaggedCache,common,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(TaggedCacheTiming,common,casinocoin);
 
 }
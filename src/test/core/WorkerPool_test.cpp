@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <casinocoin/beast/unit_test.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace casinocoin {
+namespace test {
+
+class WorkerPool_test : public beast::unit_test::suite
+{
+    void
+    testForEach ()
+    {
+        testcase ("for each");
+
+        for (std::size_t threads : {1, 2, 4})
+        {
+            WorkerPool pool (threads);
+            BEAST_EXPECT(pool.threads () == threads);
+
+            for (std::size_t n : {0, 1, 3, 100})
+            {
+                std::vector<int> calls (n, 0);
+                pool.forEach (n, [&](std::size_t i) { ++calls[i]; });
+                BEAST_EXPECT(std::all_of (calls.begin (), calls.end (),
+                    [](int c) { return c == 1; }));
+            }
+        }
+
+        BEAST_EXPECT(WorkerPool (0).threads () >= 1);
+    }
+
+    void
+    testBounded ()
+    {
+        testcase ("bounded");
+
+        WorkerPool pool (3);
+        std::atomic<int> running {0};
+        std::atomic<int> most {0};
+        auto const task = [&](std::size_t)
+        {
+            auto const now = ++running;
+            int seen = most;
+            while (now > seen && ! most.compare_exchange_weak (seen, now))
+                ;
+            std::this_thread::sleep_for (std::chrono::milliseconds (2));
+            --running;
+        };
+
+        // Nested calls share the limit and still finish
+        std::atomic<int> inner {0};
+        pool.forEach (6, [&](std::size_t i)
+            {
+                task (i);
+                pool.forEach (4, [&](std::size_t j)
+                    {
+                        task (j);
+                        ++inner;
+                    });
+            });
+        BEAST_EXPECT(inner == 24);
+        BEAST_EXPECT(most <= 3);
+
+        // Concurrent callers too
+        most = 0;
+        std::vector<std::thread> callers;
+        for (int i = 0; i < 3; ++i)
+            callers.emplace_back ([&] { pool.forEach (8, task); });
+        for (auto& t : callers)
+            t.join ();
+        // Each caller works on its own thread as well
+        BEAST_EXPECT(most <= 3 + 2);
+    }
+
+    void
+    testReuse ()
+    {
+        testcase ("reuse");
+
+        // The same threads do the work of every call
+        WorkerPool pool (3);
+        std::mutex mutex;
+        std::set<std::thread::id> ids;
+        for (int call = 0; call < 50; ++call)
+        {
+            pool.forEach (6, [&](std::size_t)
+                {
+                    std::this_thread::sleep_for (
+                        std::chrono::microseconds (100));
+                    std::lock_guard<std::mutex> lock (mutex);
+                    ids.insert (std::this_thread::get_id ());
+                });
+        }
+        BEAST_EXPECT(ids.size () <= 3);
+        BEAST_EXPECT(ids.count (std::this_thread::get_id ()) == 1);
+
+        // A call can ask for fewer threads than the pool has
+        std::atomic<int> running {0};
+        std::atomic<int> most {0};
+        for (int call = 0; call < 20; ++call)
+        {
+            pool.forEach (6, [&](std::size_t)
+                {
+                    auto const now = ++running;
+                    int seen = most;
+                    while (now > seen &&
+                            ! most.compare_exchange_weak (seen, now))
+                        ;
+                    std::this_thread::sleep_for (
+                        std::chrono::microseconds (100));
+                    --running;
+                }, 2);
+        }
+        BEAST_EXPECT(most <= 2);
+    }
+
+    void
+    testException ()
+    {
+        testcase ("exception");
+
+        WorkerPool pool (4);
+        std::atomic<int> calls {0};
+        try
+        {
+            pool.forEach (50, [&](std::size_t i)
+                {
+                    ++calls;
+                    if (i == 10)
+                        throw std::runtime_error ("path");
+                });
+            fail ();
+        }
+        catch (std::runtime_error const& e)
+        {
+            BEAST_EXPECT(std::string (e.what ()) == "path");
+        }
+        BEAST_EXPECT(calls >= 11);
+
+        // The pool is still usable
+        std::atomic<int> after {0};
+        pool.forEach (20, [&](std::size_t) { ++after; });
+        BEAST_EXPECT(after == 20);
+    }
+
+public:
+    void
+    run ()
+    {
+        testForEach ();
+        testBounded ();
+        testReuse ();
+        testException ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(WorkerPool,core,casinocoin);
+
+} // test
+} // casinocoin
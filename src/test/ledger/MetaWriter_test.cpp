@@ -0,0 +1,339 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/ledger/MetaWriter.h>
+#include <casinocoin/ledger/TxMeta.h>
+#include <chrono>
+
+namespace casinocoin {
+namespace test {
+
+namespace {
+
+// A change to a ledger entry, as ApplyStateTable sees it
+struct Change
+{
+    uint256 key;
+    SField const* type;
+    std::shared_ptr<SLE const> before;
+    std::shared_ptr<SLE> after;
+};
+
+// The changes which turn one ledger into another, in key order
+std::vector<Change>
+diff (ReadView const& from, ReadView const& to)
+{
+    std::vector<Change> changes;
+    for (auto const& sle : to.sles)
+    {
+        auto const before = from.read (keylet::unchecked (sle->key ()));
+        auto after = std::make_shared<SLE> (*sle);
+        if (! before)
+            changes.push_back ({sle->key (), &sfCreatedNode, nullptr, after});
+        else if (! (*before == *sle))
+            changes.push_back ({sle->key (), &sfModifiedNode, before, after});
+    }
+    for (auto const& sle : from.sles)
+    {
+        if (! to.exists (keylet::unchecked (sle->key ())))
+            changes.push_back ({sle->key (), &sfDeletedNode, sle,
+                std::make_shared<SLE> (*sle)});
+    }
+    std::sort (changes.begin (), changes.end (),
+        [](Change const& a, Change const& b)
+        {
+            return a.key < b.key;
+        });
+    return changes;
+}
+
+// The fields ApplyStateTable puts in the inner objects of a node
+std::vector<std::pair<SField const*, std::vector<STBase const*>>>
+objects (Change const& c)
+{
+    std::vector<std::pair<SField const*, std::vector<STBase const*>>> ret;
+    if (c.type == &sfCreatedNode)
+    {
+        ret.emplace_back (&sfNewFields, std::vector<STBase const*> ());
+        for (auto const& obj : *c.after)
+            if (! obj.isDefault () && obj.getFName ().shouldMeta (
+                    SField::sMD_Create | SField::sMD_Always))
+                ret.back ().second.push_back (&obj);
+        return ret;
+    }
+
+    ret.emplace_back (&sfPreviousFields, std::vector<STBase const*> ());
+    for (auto const& obj : *c.before)
+        if (obj.getFName ().shouldMeta (SField::sMD_ChangeOrig) &&
+                ! c.after->hasMatchingEntry (obj))
+            ret.back ().second.push_back (&obj);
+
+    auto const finals = (c.type == &sfDeletedNode) ?
+        SField::sMD_DeleteFinal : SField::sMD_ChangeNew;
+    ret.emplace_back (&sfFinalFields, std::vector<STBase const*> ());
+    for (auto const& obj : *c.after)
+        if (obj.getFName ().shouldMeta (SField::sMD_Always | finals))
+            ret.back ().second.push_back (&obj);
+    return ret;
+}
+
+// Build metadata for a set of changes the way TxMeta does
+void
+build (TxMeta& meta, std::vector<Change> const& changes,
+    bool threaded, Serializer& s)
+{
+    if (threaded)
+    {
+        for (auto const& c : changes)
+        {
+            auto const& sle = c.after;
+            if (sle->isFieldPresent (sfPreviousTxnID))
+                TxMeta::thread (meta.getAffectedNode (sle, sfModifiedNode),
+                    (*sle)[sfPreviousTxnID], (*sle)[sfPreviousTxnLgrSeq]);
+        }
+    }
+
+    for (auto const& c : changes)
+    {
+        meta.setAffectedNode (c.key, *c.type,
+            c.after->getFieldU16 (sfLedgerEntryType));
+        for (auto const& o : objects (c))
+        {
+            STObject obj (*o.first);
+            for (auto const field : o.second)
+                obj.emplace_back (*field);
+            if (! obj.empty ())
+                meta.getAffectedNode (c.key).emplace_back (std::move (obj));
+        }
+    }
+    meta.addRaw (s, tesSUCCESS, 3);
+}
+
+// Build metadata for a set of changes with a MetaWriter
+void
+build (MetaWriter& meta, std::vector<Change> const& changes,
+    bool threaded, Serializer& s)
+{
+    if (threaded)
+    {
+        for (auto const& c : changes)
+        {
+            if (c.after->isFieldPresent (sfPreviousTxnID))
+                meta.thread (c.after, (*c.after)[sfPreviousTxnID],
+                    (*c.after)[sfPreviousTxnLgrSeq]);
+        }
+    }
+
+    for (auto const& c : changes)
+    {
+        meta.setAffectedNode (c.key, *c.type,
+            c.after->getFieldU16 (sfLedgerEntryType));
+        for (auto const& o : objects (c))
+            meta.addObject (c.key, *o.first, o.second);
+    }
+    meta.addRaw (s, tesSUCCESS, 3);
+}
+
+// Offers from `makers` accounts, all crossed by one offer
+void
+crossOffers (jtx::Env& env, int makers)
+{
+    using namespace jtx;
+    Account const gw ("gateway");
+    Account const taker ("taker");
+    auto const USD = gw["USD"];
+
+    env.fund (CSC(1000000), gw, taker);
+    env (trust (taker, USD(1000000)));
+    env.close ();
+
+    for (int i = 0; i < makers; ++i)
+    {
+        Account const a ("m" + std::to_string (i));
+        env.fund (CSC(10000), a);
+        env (trust (a, USD(1000)));
+        env (pay (gw, a, USD(100)));
+        env (offer (a, CSC(10 + i % 7), USD(10)));
+        if (i % 50 == 49)
+            env.close ();
+    }
+    env.close ();
+
+    env (offer (taker, USD(10 * makers), CSC(20 * makers)));
+}
+
+} // namespace
+
+class MetaWriter_test : public beast::unit_test::suite
+{
+    void
+    testSameBytes ()
+    {
+        testcase ("same bytes as TxMeta");
+        using namespace jtx;
+
+        beast::Journal const j;
+        Env env (*this);
+        auto const genesis = env.closed ();
+        crossOffers (env, 30);
+        auto const before = env.closed ();
+        env.close ();
+        auto const after = env.closed ();
+
+        for (auto const& from : {genesis, before})
+        {
+            auto const changes = diff (*from, *after);
+            BEAST_EXPECT(changes.size () > 30);
+
+            for (bool threaded : {false, true})
+            {
+                uint256 const txID (1);
+                Serializer expected;
+                {
+                    TxMeta meta (j);
+                    meta.init (txID, after->seq ());
+                    meta.setDeliveredAmount (CSC(1).value ());
+                    build (meta, changes, threaded, expected);
+                }
+
+                Serializer actual;
+                {
+                    MetaWriter meta (txID, after->seq ());
+                    meta.setDeliveredAmount (CSC(1).value ());
+                    build (meta, changes, threaded, actual);
+                }
+
+                BEAST_EXPECT(actual.slice () == expected.slice ());
+            }
+        }
+    }
+
+    void
+    testLedger ()
+    {
+        testcase ("ledger metadata");
+        using namespace jtx;
+
+        Env env (*this);
+        crossOffers (env, 30);
+        Account const gw ("gateway");
+        for (int i = 0; i < 5; ++i)
+            env (offer (Account ("m" + std::to_string (i)), CSC(1),
+                gw["USD"](1)));
+        env.close ();
+
+        // The metadata written to the ledger is in canonical form
+        auto const ledger = env.app ().getLedgerMaster ().getClosedLedger ();
+        int count = 0;
+        for (auto const& item : ledger->txMap ())
+        {
+            SerialIter sit (item.slice ());
+            auto const tx = sit.getSlice (sit.getVLDataLength ());
+            auto const data = sit.getSlice (sit.getVLDataLength ());
+            BEAST_EXPECT(! tx.empty ());
+
+            TxMeta meta (item.key (), ledger->seq (),
+                Blob (data.data (), data.data () + data.size ()),
+                beast::Journal ());
+            Serializer s;
+            meta.addRaw (s, meta.getResultTER (), meta.getIndex ());
+            BEAST_EXPECT(s.slice () == data);
+            ++count;
+        }
+        BEAST_EXPECT(count == 6);
+    }
+
+public:
+    void
+    run ()
+    {
+        testSameBytes ();
+        testLedger ();
+    }
+};
+
+// Compares building the metadata of an offer crossing transaction
+// with TxMeta and with MetaWriter
+class MetaWriterTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        int const makers = arg ().empty () ? 200 : std::stoi (arg ());
+        beast::Journal const j;
+
+        Env env (*this);
+        crossOffers (env, makers);
+        auto const before = env.closed ();
+        auto start = clock_type::now ();
+        env.close ();
+        log << "close: " << elapsed (start) << "us" << std::endl;
+
+        auto const changes = diff (*before, *env.closed ());
+        int const iterations = 200;
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            std::size_t bytes = 0;
+            start = clock_type::now ();
+            for (int i = 0; i < iterations; ++i)
+            {
+                Serializer s;
+                TxMeta meta (j);
+                meta.init (uint256 (1), 2);
+                build (meta, changes, true, s);
+                bytes = s.size ();
+            }
+            auto const txMetaTime = elapsed (start);
+
+            start = clock_type::now ();
+            for (int i = 0; i < iterations; ++i)
+            {
+                Serializer s;
+                MetaWriter meta (uint256 (1), 2);
+                build (meta, changes, true, s);
+                BEAST_EXPECT(s.size () == bytes);
+            }
+            auto const writerTime = elapsed (start);
+
+            log << changes.size () << " nodes, " << bytes << " bytes: " <<
+                "TxMeta " << txMetaTime / iterations << "us, " <<
+                "MetaWriter " << writerTime / iterations << "us" <<
+                std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(MetaWriter,ledger,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(MetaWriterTiming,ledger,casinocoin);
+
+} // test
+} // casinocoin
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace casinocoin {
+namespace test {
+
+// Measures open ledger apply throughput for bursts of payments
+class PaymentStorm_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    void
+    storm (char const* name, int accounts, int rounds,
+        std::function<void (jtx::Env&, jtx::Account const&,
+            jtx::Account const&)> const& pay)
+    {
+        using namespace jtx;
+
+        Env env (*this);
+        Account const gw ("gateway");
+        env.fund (CSC(1000000), gw);
+
+        std::vector<Account> senders;
+        senders.reserve (accounts);
+        for (int i = 0; i < accounts; ++i)
+        {
+            senders.emplace_back ("s" + std::to_string (i));
+            env.fund (CSC(100000), senders.back ());
+            env (trust (senders.back (), gw["USD"](1000000)));
+            if (i % 100 == 99)
+                env.close ();
+        }
+        env.close ();
+        for (auto const& a : senders)
+            env (jtx::pay (gw, a, gw["USD"](10000)));
+        env.close ();
+
+        std::size_t count = 0;
+        auto const start = clock_type::now ();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (int i = 0; i < accounts; ++i)
+            {
+                pay (env, senders[i], senders[(i + 1 + r) % accounts]);
+                ++count;
+            }
+            env.close ();
+        }
+        auto const us = std::chrono::duration_cast<
+            std::chrono::microseconds> (clock_type::now () - start).count ();
+
+        log << name << ": " << count << " payments in " << us << "us, " <<
+            (us ? count * 1000000 / us : 0) << " tx/s" << std::endl;
+    }
+
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        int const accounts = 500;
+        int const rounds = 5;
+
+        storm ("CSC", accounts, rounds,
+            [](Env& env, Account const& from, Account const& to)
+            {
+                env (pay (from, to, CSC(10)));
+            });
+
+        auto const USD = Account ("gateway")["USD"];
+        storm ("IOU", accounts, rounds,
+            [&USD](Env& env, Account const& from, Account const& to)
+            {
+                env (pay (from, to, USD(1)));
+            });
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(PaymentStorm,ledger,casinocoin);
+
+} // test
+} // casinocoin
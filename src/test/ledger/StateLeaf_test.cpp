@@ -0,0 +1,250 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/ledger/LedgerMaster.h>
+#include <casinocoin/app/ledger/LedgerToJson.h>
+#include <casinocoin/app/ledger/StateLeaf.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <chrono>
+#include <mutex>
+
+namespace casinocoin {
+namespace test {
+
+class StateLeaf_test : public beast::unit_test::suite
+{
+    // Populate a ledger with a few kinds of entries
+    static void
+    populate (jtx::Env& env, int accounts)
+    {
+        using namespace jtx;
+        Account const gw ("gateway");
+        env.fund (CSC(100000), gw);
+        for (int i = 0; i < accounts; ++i)
+        {
+            Account const a ("a" + std::to_string (i));
+            env.fund (CSC(10000), a);
+            env.close ();
+            env (trust (a, gw["USD"](1000)));
+            env (pay (gw, a, gw["USD"](100)));
+            env (offer (a, gw["USD"](10), CSC(1 + i)));
+            env.close ();
+        }
+    }
+
+    void
+    testScan ()
+    {
+        testcase ("scan");
+        using namespace jtx;
+
+        Env env (*this);
+        populate (env, 10);
+
+        auto const ledger = env.app ().getLedgerMaster ().getClosedLedger ();
+
+        // The raw scan matches the deserializing one
+        std::vector<uint256> keys;
+        for (auto const& sle : ledger->sles)
+            keys.push_back (sle->key ());
+
+        std::size_t i = 0;
+        bool matched = true;
+        BEAST_EXPECT(forEachStateLeaf (*ledger, uint256 (),
+            [&](StateLeaf const& leaf)
+            {
+                auto const sle = ledger->read (keylet::unchecked (leaf.key ()));
+                matched = matched && i < keys.size () &&
+                    leaf.key () == keys[i] &&
+                    leaf.type () == sle->getType () &&
+                    strHex (leaf.slice ()) == serializeHex (*sle) &&
+                    leaf.sle ()->getType () == sle->getType ();
+                ++i;
+                return true;
+            }));
+        BEAST_EXPECT(matched);
+        BEAST_EXPECT(i == keys.size ());
+
+        // A scan can stop and resume after the last key it saw
+        {
+            std::vector<uint256> seen;
+            uint256 marker;
+            for (;;)
+            {
+                int n = 0;
+                if (forEachStateLeaf (*ledger, marker,
+                    [&](StateLeaf const& leaf)
+                    {
+                        seen.push_back (leaf.key ());
+                        marker = leaf.key ();
+                        return ++n < 7;
+                    }))
+                    break;
+            }
+            BEAST_EXPECT(seen == keys);
+        }
+
+        // Views which are not closed ledgers give the same entries
+        {
+            std::vector<uint256> seen;
+            auto const view = env.current ();
+            forEachStateLeaf (*view, uint256 (),
+                [&](StateLeaf const& leaf)
+                {
+                    seen.push_back (leaf.key ());
+                    BEAST_EXPECT(leaf.type () == leaf.sle ()->getType ());
+                    return true;
+                });
+
+            std::vector<uint256> expected;
+            for (auto const& sle : view->sles)
+                expected.push_back (sle->key ());
+            BEAST_EXPECT(seen == expected);
+        }
+
+        // A partitioned scan covers every key exactly once
+        for (int partitions : {1, 3, 16, 256})
+        {
+            std::vector<std::vector<uint256>> parts (partitions);
+            std::mutex m;
+            forEachStateLeaf (*ledger, env.app ().getWorkerPool (),
+                partitions,
+                [&](int p, StateLeaf const& leaf)
+                {
+                    std::lock_guard<std::mutex> lock (m);
+                    parts[p].push_back (leaf.key ());
+                });
+
+            std::vector<uint256> seen;
+            for (auto const& p : parts)
+                seen.insert (seen.end (), p.begin (), p.end ());
+            BEAST_EXPECT(seen == keys);
+        }
+    }
+
+public:
+    void
+    run ()
+    {
+        testScan ();
+    }
+};
+
+// Compares the cost of full state scans with and without deserializing
+class StateLeafTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using namespace jtx;
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        Env env (*this);
+        Account const gw ("gateway");
+        env.fund (CSC(100000), gw);
+        for (int i = 0; i < 2000; ++i)
+        {
+            Account const a ("a" + std::to_string (i));
+            env.fund (CSC(10000), a);
+            env (trust (a, gw["USD"](1000)));
+            env (offer (gw, CSC(1 + i), gw["USD"](10)));
+            if (i % 100 == 99)
+                env.close ();
+        }
+        env.close ();
+
+        auto const ledger = env.app ().getLedgerMaster ().getClosedLedger ();
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            std::size_t offers = 0;
+            auto start = clock_type::now ();
+            for (auto const& sle : ledger->sles)
+                if (sle->getType () == ltOFFER)
+                    ++offers;
+            auto const slesTime = elapsed (start);
+
+            std::size_t leafOffers = 0;
+            start = clock_type::now ();
+            forEachStateLeaf (*ledger, uint256 (),
+                [&](StateLeaf const& leaf)
+                {
+                    if (leaf.type () == ltOFFER)
+                        ++leafOffers;
+                    return true;
+                });
+            auto const leafTime = elapsed (start);
+
+            std::atomic<std::size_t> parallelOffers {0};
+            start = clock_type::now ();
+            forEachStateLeaf (*ledger, env.app ().getWorkerPool (), 4,
+                [&](int, StateLeaf const& leaf)
+                {
+                    if (leaf.type () == ltOFFER)
+                        ++parallelOffers;
+                });
+            auto const parallelTime = elapsed (start);
+
+            BEAST_EXPECT(offers == leafOffers);
+            BEAST_EXPECT(offers == parallelOffers);
+
+            log << offers << " offers: sles " << slesTime << "us, leaves " <<
+                leafTime << "us, 4 partitions " << parallelTime << "us" <<
+                std::endl;
+        }
+
+        // ledger_data, as used by a client walking the whole state
+        for (bool binary : {false, true})
+        {
+            auto const start = clock_type::now ();
+            int pages = 0;
+            Json::Value marker;
+            do
+            {
+                Json::Value params;
+                params[jss::ledger_index] = "validated";
+                params[jss::binary] = binary;
+                if (marker.isString ())
+                    params[jss::marker] = marker;
+                auto const jv = env.rpc ("json", "ledger_data",
+                    to_string (params))[jss::result];
+                marker = jv[jss::marker];
+                ++pages;
+            }
+            while (marker.isString ());
+
+            log << "ledger_data" << (binary ? " binary: " : ": ") <<
+                pages << " pages in " << elapsed (start) << "us" << std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(StateLeaf,ledger,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(StateLeafTiming,ledger,casinocoin);
+
+} // test
+} // casinocoin
@@ -0,0 +1,700 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/basics/random.h>
+#include <casinocoin/protocol/IOUAmount.h>
+#include <casinocoin/protocol/STAmount.h>
+#include <casinocoin/protocol/impl/AmountMath.h>
+#include <casinocoin/beast/unit_test.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace casinocoin {
+
+// The amount arithmetic as it was written before the kernels in
+// AmountMath.h, a digit at a time. The kernels must match it exactly.
+namespace amount_reference {
+
+struct Amount
+{
+    std::uint64_t mantissa;
+    int exponent;
+    bool negative;
+};
+
+bool
+operator== (Amount const& a, STAmount const& b)
+{
+    return a.mantissa == b.mantissa () &&
+        a.exponent == b.exponent () &&
+        a.negative == b.negative ();
+}
+
+int
+decimalDigits (std::uint64_t value)
+{
+    int digits = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+bool
+mulDivRound (std::uint64_t a, std::uint64_t b, std::uint64_t divisor,
+    std::uint64_t rounding, std::uint64_t& result)
+{
+    boost::multiprecision::uint128_t r;
+    boost::multiprecision::multiply (r, a, b);
+    r += rounding;
+    r /= divisor;
+    if (r > std::numeric_limits<std::uint64_t>::max ())
+        return false;
+    result = static_cast<std::uint64_t> (r);
+    return true;
+}
+
+void
+normalizeUp (std::uint64_t& value, int& exponent)
+{
+    while (value < STAmount::cMinValue)
+    {
+        value *= 10;
+        --exponent;
+    }
+}
+
+void
+normalizeUp (std::uint64_t& value, int& exponent, int minExponent)
+{
+    while ((value < STAmount::cMinValue) && (exponent > minExponent))
+    {
+        value *= 10;
+        --exponent;
+    }
+}
+
+bool
+normalizeDown (std::uint64_t& value, int& exponent, int maxExponent)
+{
+    while (value > STAmount::cMaxValue)
+    {
+        if (exponent >= maxExponent)
+            return false;
+
+        value /= 10;
+        ++exponent;
+    }
+    return true;
+}
+
+std::int64_t
+shiftDecimal (std::int64_t value, int places)
+{
+    while (places-- > 0)
+        value /= 10;
+    return value;
+}
+
+// Returns false where STAmount::canonicalize throws
+bool
+canonicalize (bool native, Amount& a)
+{
+    if (native)
+    {
+        if (a.mantissa == 0)
+        {
+            a.exponent = 0;
+            a.negative = false;
+            return true;
+        }
+
+        while (a.exponent < 0)
+        {
+            a.mantissa /= 10;
+            ++a.exponent;
+        }
+
+        while (a.exponent > 0)
+        {
+            a.mantissa *= 10;
+            --a.exponent;
+        }
+
+        return a.mantissa <= STAmount::cMaxNativeN;
+    }
+
+    if (a.mantissa == 0)
+    {
+        a.exponent = -100;
+        a.negative = false;
+        return true;
+    }
+
+    normalizeUp (a.mantissa, a.exponent, STAmount::cMinOffset);
+
+    if (! normalizeDown (a.mantissa, a.exponent, STAmount::cMaxOffset))
+        return false;
+
+    if ((a.exponent < STAmount::cMinOffset) ||
+        (a.mantissa < STAmount::cMinValue))
+    {
+        a.mantissa = 0;
+        a.negative = false;
+        a.exponent = -100;
+        return true;
+    }
+
+    return a.exponent <= STAmount::cMaxOffset;
+}
+
+void
+canonicalizeRound (bool native, std::uint64_t& value, int& offset)
+{
+    if (native)
+    {
+        if (offset < 0)
+        {
+            int loops = 0;
+
+            while (offset < -1)
+            {
+                value /= 10;
+                ++offset;
+                ++loops;
+            }
+
+            value += (loops >= 2) ? 9 : 10;
+            value /= 10;
+            ++offset;
+        }
+    }
+    else if (value > STAmount::cMaxValue)
+    {
+        while (value > (10 * STAmount::cMaxValue))
+        {
+            value /= 10;
+            ++offset;
+        }
+
+        value += 9;
+        value /= 10;
+        ++offset;
+    }
+}
+
+// The scaled mantissas and exponents of the operands of a multiply
+// or divide of two non-zero amounts
+void
+operands (STAmount const& v1, STAmount const& v2,
+    std::uint64_t& value1, int& offset1,
+        std::uint64_t& value2, int& offset2)
+{
+    value1 = v1.mantissa ();
+    value2 = v2.mantissa ();
+    offset1 = v1.exponent ();
+    offset2 = v2.exponent ();
+
+    if (v1.native ())
+        normalizeUp (value1, offset1);
+    if (v2.native ())
+        normalizeUp (value2, offset2);
+}
+
+// The rounded operations, for operands which are neither zero nor
+// both native with a native result. Returns false where they throw.
+bool
+round (STAmount const& v1, STAmount const& v2, Issue const& issue,
+    bool multiply, bool roundUp, Amount& result)
+{
+    std::uint64_t value1, value2;
+    int offset1, offset2;
+    operands (v1, v2, value1, offset1, value2, offset2);
+
+    bool const native = isCSC (issue);
+    bool const negative = v1.negative () != v2.negative ();
+    bool const away = negative != roundUp;
+
+    std::uint64_t const tenTo14 = 100000000000000ull;
+    std::uint64_t amount;
+    int offset;
+    if (multiply)
+    {
+        if (! mulDivRound (value1, value2, tenTo14,
+                away ? tenTo14 - 1 : 0, amount))
+            return false;
+        offset = offset1 + offset2 + 14;
+    }
+    else
+    {
+        if (! mulDivRound (value1, tenTo14 * 1000, value2,
+                away ? value2 - 1 : 0, amount))
+            return false;
+        offset = offset1 - offset2 - 17;
+    }
+
+    if (away)
+        canonicalizeRound (native, amount, offset);
+
+    result = {amount, offset, negative};
+    if (! canonicalize (native, result))
+        return false;
+
+    if (roundUp && ! negative && result.mantissa == 0 &&
+        *stAmountCalcSwitchover)
+    {
+        if (native && *stAmountCalcSwitchover2)
+            result = {1, 0, false};
+        else
+            result = {STAmount::cMinValue, STAmount::cMinOffset, false};
+        return canonicalize (native, result);
+    }
+    return true;
+}
+
+// The unrounded operations, with the same restrictions as round
+bool
+exact (STAmount const& v1, STAmount const& v2, Issue const& issue,
+    bool multiply, Amount& result)
+{
+    std::uint64_t value1, value2;
+    int offset1, offset2;
+    operands (v1, v2, value1, offset1, value2, offset2);
+
+    std::uint64_t const tenTo14 = 100000000000000ull;
+    std::uint64_t amount;
+    int offset;
+    if (multiply)
+    {
+        if (! mulDivRound (value1, value2, tenTo14, 0, amount))
+            return false;
+        amount += 7;
+        offset = offset1 + offset2 + 14;
+    }
+    else
+    {
+        if (! mulDivRound (value1, tenTo14 * 1000, value2, 0, amount))
+            return false;
+        amount += 5;
+        offset = offset1 - offset2 - 17;
+    }
+
+    result = {amount, offset, v1.negative () != v2.negative ()};
+    return canonicalize (isCSC (issue), result);
+}
+
+// Returns false where IOUAmount::normalize throws
+bool
+normalize (std::int64_t& mantissa, int& exponent)
+{
+    if (mantissa == 0)
+    {
+        exponent = -100;
+        return true;
+    }
+
+    bool const negative = mantissa < 0;
+    auto value = static_cast<std::uint64_t> (negative ? -mantissa : mantissa);
+
+    normalizeUp (value, exponent, -96);
+    if (! normalizeDown (value, exponent, 80))
+        return false;
+
+    if (exponent < -96 || value < STAmount::cMinValue)
+    {
+        mantissa = 0;
+        exponent = -100;
+        return true;
+    }
+
+    if (exponent > 80)
+        return false;
+
+    mantissa = negative ? -static_cast<std::int64_t> (value) :
+        static_cast<std::int64_t> (value);
+    return true;
+}
+
+} // amount_reference
+
+//------------------------------------------------------------------------------
+
+class AmountMath_test : public beast::unit_test::suite
+{
+    std::mt19937_64 engine_ {0x5ca1ab1e};
+
+    Issue const iou_ {Currency (0x5553440000000000), AccountID (0x4985601)};
+
+    // A value with a random number of digits
+    std::uint64_t
+    randomValue (int maxDigits = 20)
+    {
+        int const digits = rand_int (engine_, 1, maxDigits);
+        if (digits == 20)
+            return rand_int (engine_, detail::powerOfTen (19),
+                std::numeric_limits<std::uint64_t>::max ());
+        return rand_int (engine_, detail::powerOfTen (digits - 1),
+            detail::powerOfTen (digits) - 1);
+    }
+
+    // A non-zero amount, either native or of an issued currency
+    STAmount
+    randomAmount (bool native)
+    {
+        bool const negative = rand_int (engine_, 1) == 1;
+        if (native)
+            return STAmount (randomValue (17), negative);
+        return STAmount (iou_, rand_int (engine_, STAmount::cMinValue,
+            STAmount::cMaxValue), rand_int (engine_, -96, 80), negative);
+    }
+
+    template <class F>
+    static
+    bool
+    throws (F&& f)
+    {
+        try
+        {
+            f ();
+        }
+        catch (std::exception const&)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void
+    testKernels ()
+    {
+        testcase ("kernels");
+
+        namespace ref = amount_reference;
+
+        // Every digit boundary and power of two
+        std::vector<std::uint64_t> values;
+        for (int i = 0; i < 20; ++i)
+        {
+            values.push_back (detail::powerOfTen (i));
+            values.push_back (detail::powerOfTen (i) - 1);
+            values.push_back (detail::powerOfTen (i) + 1);
+        }
+        for (int i = 0; i < 64; ++i)
+        {
+            values.push_back (std::uint64_t (1) << i);
+            values.push_back ((std::uint64_t (1) << i) - 1);
+        }
+        values.push_back (std::numeric_limits<std::uint64_t>::max ());
+        for (int i = 0; i < 100000; ++i)
+            values.push_back (randomValue ());
+
+        std::size_t mismatches = 0;
+        for (auto const v : values)
+        {
+            if (v == 0)
+                continue;
+
+            if (detail::decimalDigits (v) != ref::decimalDigits (v))
+                ++mismatches;
+
+            int const e = rand_int (engine_, -120, 100);
+
+            if (v < detail::powerOfTen (16))
+            {
+                std::uint64_t v1 = v, v2 = v;
+                int e1 = e, e2 = e;
+                detail::normalizeUp (v1, e1);
+                ref::normalizeUp (v2, e2);
+                if (v1 != v2 || e1 != e2)
+                    ++mismatches;
+            }
+
+            {
+                std::uint64_t v1 = v, v2 = v;
+                int e1 = e, e2 = e;
+                detail::normalizeUp (v1, e1, STAmount::cMinOffset);
+                ref::normalizeUp (v2, e2, STAmount::cMinOffset);
+                if (v1 != v2 || e1 != e2)
+                    ++mismatches;
+            }
+
+            {
+                std::uint64_t v1 = v, v2 = v;
+                int e1 = e, e2 = e;
+                bool const ok1 = detail::normalizeDown (
+                    v1, e1, STAmount::cMaxOffset);
+                bool const ok2 = ref::normalizeDown (
+                    v2, e2, STAmount::cMaxOffset);
+                if (ok1 != ok2 || (ok1 && (v1 != v2 || e1 != e2)))
+                    ++mismatches;
+            }
+
+            {
+                auto const s = static_cast<std::int64_t> (v >> 1) *
+                    (rand_int (engine_, 1) ? 1 : -1);
+                int const places = rand_int (engine_, 0, 40);
+                if (detail::shiftDecimal (s, places) !=
+                        ref::shiftDecimal (s, places))
+                    ++mismatches;
+            }
+
+            {
+                auto const b = randomValue ();
+                auto const d = randomValue ();
+                auto const r = rand_int (engine_, d);
+                std::uint64_t q1 = 0, q2 = 0;
+                bool const ok1 = detail::mulDivRound (v, b, d, r, q1);
+                bool const ok2 = ref::mulDivRound (v, b, d, r, q2);
+                if (ok1 != ok2 || q1 != q2)
+                    ++mismatches;
+            }
+        }
+        BEAST_EXPECT(mismatches == 0);
+    }
+
+    void
+    testCanonicalize ()
+    {
+        testcase ("canonicalize");
+
+        namespace ref = amount_reference;
+
+        std::size_t mismatches = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            bool const native = (i % 4) == 0;
+            ref::Amount expected {randomValue (), native ?
+                rand_int (engine_, -25, 5) : rand_int (engine_, -130, 100),
+                    rand_int (engine_, 1) == 1};
+            auto const m = expected.mantissa;
+            auto const e = expected.exponent;
+            auto const n = expected.negative;
+
+            bool const ok = ref::canonicalize (native, expected);
+            boost::optional<STAmount> actual;
+            bool const threw = throws ([&]
+            {
+                actual.emplace (native ? cscIssue () : iou_, m, e, n);
+            });
+            if (ok == threw || (ok && ! (expected == *actual)))
+                ++mismatches;
+
+            // IOUAmount keeps its own normalization
+            if (! native)
+            {
+                auto mantissa = static_cast<std::int64_t> (m >> 1);
+                if (n)
+                    mantissa = -mantissa;
+                auto exponent = e;
+                bool const ok = ref::normalize (mantissa, exponent);
+                boost::optional<IOUAmount> actual;
+                bool const threw = throws ([&]
+                {
+                    actual.emplace (static_cast<std::int64_t> (m >> 1) *
+                        (n ? -1 : 1), e);
+                });
+                if (ok == threw || (ok && (actual->mantissa () != mantissa ||
+                        actual->exponent () != exponent)))
+                    ++mismatches;
+            }
+        }
+        BEAST_EXPECT(mismatches == 0);
+    }
+
+    void
+    testArithmetic ()
+    {
+        testcase ("arithmetic");
+
+        namespace ref = amount_reference;
+
+        bool const saved = *stAmountCalcSwitchover;
+        bool const saved2 = *stAmountCalcSwitchover2;
+
+        std::size_t mismatches = 0;
+        std::size_t checked = 0;
+        for (bool switchover : {false, true})
+        {
+            *stAmountCalcSwitchover = switchover;
+            *stAmountCalcSwitchover2 = switchover;
+            for (int i = 0; i < 100000; ++i)
+            {
+                int const kind = i % 4;
+                bool const cscResult = kind == 3;
+                auto const v1 = randomAmount (kind == 1 || kind == 3);
+                auto const v2 = randomAmount (kind == 2);
+                auto const& issue = cscResult ? cscIssue () : iou_;
+
+                for (bool multiply : {true, false})
+                {
+                    ref::Amount expected;
+                    bool const ok = ref::exact (
+                        v1, v2, issue, multiply, expected);
+                    STAmount actual;
+                    bool const threw = throws ([&]
+                    {
+                        actual = multiply ? casinocoin::multiply (v1, v2, issue) :
+                            divide (v1, v2, issue);
+                    });
+                    if (ok == threw || (ok && ! (expected == actual)))
+                        ++mismatches;
+                    ++checked;
+
+                    for (bool roundUp : {true, false})
+                    {
+                        ref::Amount expected;
+                        bool const ok = ref::round (
+                            v1, v2, issue, multiply, roundUp, expected);
+                        STAmount actual;
+                        bool const threw = throws ([&]
+                        {
+                            actual = multiply ?
+                                mulRound (v1, v2, issue, roundUp) :
+                                    divRound (v1, v2, issue, roundUp);
+                        });
+                        if (ok == threw || (ok && ! (expected == actual)))
+                            ++mismatches;
+                        ++checked;
+                    }
+                }
+
+                // Sums of issued amounts
+                if (kind == 0)
+                {
+                    auto const a = v1.iou ();
+                    auto const b = v2.iou ();
+                    auto const shift = a.exponent () - b.exponent ();
+                    auto m1 = a.mantissa ();
+                    auto m2 = b.mantissa ();
+                    auto e = std::max (a.exponent (), b.exponent ());
+                    if (shift < 0)
+                        m1 = ref::shiftDecimal (m1, -shift);
+                    else
+                        m2 = ref::shiftDecimal (m2, shift);
+                    auto sum = m1 + m2;
+                    bool const ok = (sum < -10 || sum > 10) ?
+                        ref::normalize (sum, e) : (sum = 0, e = -100, true);
+
+                    boost::optional<IOUAmount> actual;
+                    bool const threw = throws ([&] { actual.emplace (a + b); });
+                    if (ok == threw || (ok && (actual->mantissa () != sum ||
+                            actual->exponent () != e)))
+                        ++mismatches;
+                    ++checked;
+                }
+            }
+        }
+        *stAmountCalcSwitchover = saved;
+        *stAmountCalcSwitchover2 = saved2;
+
+        log << checked << " operations checked" << std::endl;
+        BEAST_EXPECT(mismatches == 0);
+    }
+
+public:
+    void
+    run () override
+    {
+        testKernels ();
+        testCanonicalize ();
+        testArithmetic ();
+    }
+};
+
+// Compares the amount arithmetic with the digit at a time reference
+class AmountMathTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run () override
+    {
+        namespace ref = amount_reference;
+        using clock_type = std::chrono::steady_clock;
+
+        std::mt19937_64 engine (0x5ca1ab1e);
+        Issue const iou (Currency (0x5553440000000000), AccountID (0x4985601));
+
+        // Offer crossing mostly works on issued amounts with
+        // similar exponents, and on whole drops
+        std::vector<std::pair<STAmount, STAmount>> operands;
+        for (int i = 0; i < 100000; ++i)
+        {
+            auto const iouAmount = [&]
+            {
+                return STAmount (iou, rand_int (engine, STAmount::cMinValue,
+                    STAmount::cMaxValue), rand_int (engine, -20, 0));
+            };
+            if (i % 2)
+                operands.emplace_back (iouAmount (), iouAmount ());
+            else
+                operands.emplace_back (iouAmount (),
+                    STAmount (rand_int (engine, 1ull, 100000000000ull)));
+        }
+
+        auto const time = [&](std::string const& name, auto&& f)
+        {
+            std::uint64_t sink = 0;
+            auto const start = clock_type::now ();
+            for (auto const& o : operands)
+                sink += f (o.first, o.second);
+            auto const us = std::chrono::duration_cast<
+                std::chrono::microseconds> (clock_type::now () - start).count ();
+            BEAST_EXPECT(sink != 0);
+            log << name << ": " << operands.size () << " in " << us <<
+                "us" << std::endl;
+        };
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            time ("mulRound", [&](STAmount const& a, STAmount const& b)
+            {
+                return mulRound (a, b, iou, true).mantissa ();
+            });
+            time ("mulRound reference",
+                [&](STAmount const& a, STAmount const& b)
+            {
+                ref::Amount r;
+                ref::round (a, b, iou, true, true, r);
+                return r.mantissa;
+            });
+            time ("divRound", [&](STAmount const& a, STAmount const& b)
+            {
+                return divRound (a, b, iou, false).mantissa ();
+            });
+            time ("divRound reference",
+                [&](STAmount const& a, STAmount const& b)
+            {
+                ref::Amount r;
+                ref::round (a, b, iou, false, false, r);
+                return r.mantissa;
+            });
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(AmountMath,protocol,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(AmountMathTiming,protocol,casinocoin);
+
+} // casinocoin
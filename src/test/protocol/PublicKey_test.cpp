@@ -21,6 +21,8 @@
 #include <casinocoin/protocol/PublicKey.h>
 #include <casinocoin/protocol/SecretKey.h>
 #include <casinocoin/beast/unit_test.h>
+#include <algorithm>
+#include <string>
 #include <vector>
 
 namespace casinocoin {
@@ -382,11 +384,61 @@ public:
         BEAST_EXPECT(pk1 == pk3);
     }
 
+    void testVerifyBatch ()
+    {
+        testcase ("Batch verification");
+
+        // Good signatures of both key types, and one on the wrong message
+        std::vector<PublicKey> keys;
+        std::vector<Buffer> sigs;
+        std::vector<std::string> messages;
+        for (int i = 0; i < 8; ++i)
+        {
+            auto const type = (i % 4 == 3) ?
+                KeyType::secp256k1 : KeyType::ed25519;
+            auto const kp = randomKeyPair (type);
+            messages.push_back ("message " + std::to_string (i));
+            keys.push_back (kp.first);
+            sigs.push_back (sign (kp.first, kp.second,
+                makeSlice (messages.back ())));
+        }
+        messages[5] = "forged";
+
+        // The identity point as the key, and the identity again as R
+        // but encoded as y = p + 1, with S = 0. ed25519 batch
+        // verification decodes R and accepts this; verify() compares
+        // the encoding of R and doesn't.
+        blob identity (33, 0);
+        identity[0] = 0xED;
+        identity[1] = 0x01;
+        keys.push_back (PublicKey (makeSlice (identity)));
+        blob crafted (64, 0);
+        crafted[0] = 0xEE;
+        std::fill (crafted.begin () + 1, crafted.begin () + 31, 0xFF);
+        crafted[31] = 0x7F;
+        sigs.push_back (Buffer (crafted.data (), crafted.size ()));
+        messages.push_back ("crafted");
+
+        std::vector<SignedMessage> batch;
+        for (std::size_t i = 0; i < keys.size (); ++i)
+            batch.push_back ({keys[i], makeSlice (messages[i]), sigs[i]});
+
+        auto const valid = verifyBatch (batch);
+        BEAST_EXPECT(valid.size () == batch.size ());
+        for (std::size_t i = 0; i < batch.size (); ++i)
+        {
+            BEAST_EXPECT(valid[i] == verify (
+                keys[i], makeSlice (messages[i]), sigs[i]));
+            BEAST_EXPECT(valid[i] == (i != 5 && i != 8));
+        }
+    }
+
     void run() override
     {
         testBase58();
         testCanonical();
         testMiscOperations();
+        testVerifyBatch();
     }
 };
 
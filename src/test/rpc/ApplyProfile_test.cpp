@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <casinocoin/app/tx/ApplyProfiler.h>
+#include <casinocoin/protocol/JsonFields.h>
+
+namespace casinocoin {
+namespace test {
+
+class ApplyProfile_test : public beast::unit_test::suite
+{
+    void
+    testProfile ()
+    {
+        testcase ("profile");
+        using namespace jtx;
+
+        Env env (*this);
+        Account const alice ("alice");
+        Account const bob ("bob");
+
+        // Nothing is recorded until the profiler is enabled
+        env.fund (CSC(10000), alice, bob);
+        env.close ();
+        {
+            auto const result = env.rpc ("apply_profile")[jss::result];
+            BEAST_EXPECT(! result[jss::enabled].asBool ());
+            BEAST_EXPECT(result[jss::transactions].size () == 0);
+        }
+
+        BEAST_EXPECT(env.rpc ("apply_profile", "enable")
+            [jss::result][jss::enabled].asBool ());
+        BEAST_EXPECT(env.app ().getApplyProfiler ().enabled ());
+
+        for (int i = 0; i < 5; ++i)
+            env (pay (alice, bob, CSC(10)));
+        env (pay (alice, bob, CSC(100000)), ter (tecUNFUNDED_PAYMENT));
+        env (pay (alice, alice, CSC(10)), ter (temREDUNDANT));
+        env.close ();
+
+        auto const result = env.rpc ("apply_profile", "disable")[jss::result];
+        BEAST_EXPECT(! result[jss::enabled].asBool ());
+
+        auto const& payment = result[jss::transactions]["Payment"];
+        auto const& success = payment["tesSUCCESS"];
+        for (auto const stage : {jss::preflight, jss::preclaim, jss::apply})
+        {
+            auto const& time = success[stage][jss::duration_us];
+            BEAST_EXPECTS(time[jss::count].asUInt () >= 5, stage);
+        }
+
+        // Reads and writes are reported for doApply only
+        auto const& apply = success[jss::apply];
+        auto const& applied = apply[jss::duration_us][jss::count];
+        BEAST_EXPECT(apply[jss::reads][jss::count] == applied);
+        BEAST_EXPECT(apply[jss::writes][jss::count] == applied);
+        BEAST_EXPECT(apply[jss::fetches][jss::count] == applied);
+        BEAST_EXPECT(apply[jss::reads][jss::total].asString () != "0");
+        BEAST_EXPECT(apply[jss::writes][jss::total].asString () != "0");
+        BEAST_EXPECT(! success[jss::preflight].isMember (jss::reads));
+
+        // A claimed fee is applied and recorded under its own result
+        auto const& unfunded = payment["tecUNFUNDED_PAYMENT"];
+        BEAST_EXPECT(unfunded[jss::apply][jss::writes]
+            [jss::count].asUInt () >= 1);
+        BEAST_EXPECT(! unfunded.isMember (jss::preflight));
+
+        // A malformed transaction stops in preflight
+        auto const& malformed = payment["temREDUNDANT"];
+        BEAST_EXPECT(malformed.isMember (jss::preflight));
+        BEAST_EXPECT(! malformed.isMember (jss::preclaim));
+
+        // A payment reads and writes both account roots
+        auto const& roots =
+            result[jss::entries]["Payment"]["AccountRoot"];
+        BEAST_EXPECT(roots[jss::reads].asUInt () >= 2 * 5);
+        BEAST_EXPECT(roots[jss::writes].asUInt () >= 2 * 5);
+
+        // Nothing more is recorded once disabled
+        env (pay (alice, bob, CSC(10)));
+        env.close ();
+        auto const after = env.rpc ("apply_profile")[jss::result];
+        BEAST_EXPECT(after[jss::transactions] == result[jss::transactions]);
+
+        BEAST_EXPECT(env.rpc ("apply_profile", "reset")
+            [jss::result][jss::transactions].size () == 0);
+
+        BEAST_EXPECT(env.rpc ("apply_profile", "bogus")
+            ["client_error"][jss::error] == "invalidParams");
+    }
+
+public:
+    void
+    run ()
+    {
+        testProfile ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ApplyProfile,rpc,casinocoin);
+
+} // test
+} // casinocoin
@@ -21,6 +21,7 @@
 #include <casinocoin/protocol/Feature.h>
 #include <casinocoin/protocol/JsonFields.h>
 #include <test/jtx.h>
+#include <set>
 
 namespace casinocoin {
 
@@ -262,6 +263,64 @@ public:
         }
     }
 
+    void testBaseLedger()
+    {
+        using namespace test::jtx;
+        Env env { *this };
+        Account const gw { "gateway" };
+        env.fund(CSC(100000), gw);
+        env.close();
+        auto const base = env.closed()->info().seq;
+
+        int const num_accounts = 5;
+        std::set<std::string> funded;
+        for (auto i = 0; i < num_accounts; i++)
+        {
+            Account const bob { std::string("bob") + std::to_string(i) };
+            env.fund(CSC(1000), bob);
+            funded.insert(to_string(keylet::account(bob).key));
+        }
+        env.close();
+
+        // Only the entries changed since the base ledger are returned
+        Json::Value jvParams;
+        jvParams[jss::ledger_index] = "closed";
+        jvParams[jss::base_ledger_index] = base;
+        auto jrr = env.rpc ( "json", "ledger_data",
+            boost::lexical_cast<std::string>(jvParams)) [jss::result];
+        BEAST_EXPECT( ! jrr.isMember(jss::marker) );
+        auto const& state = jrr[jss::state];
+        BEAST_EXPECT( state.isArray() && state.size() > num_accounts );
+        for (auto const& entry : state)
+        {
+            BEAST_EXPECT( ! entry.isMember(jss::deleted) );
+            funded.erase(entry[jss::index].asString());
+        }
+        BEAST_EXPECT( funded.empty() );
+        auto const total_count = state.size();
+
+        // Follow the marker through the changes
+        jvParams[jss::limit] = 2;
+        jrr = env.rpc ( "json", "ledger_data",
+            boost::lexical_cast<std::string>(jvParams)) [jss::result];
+        BEAST_EXPECT( checkMarker(jrr) );
+        auto running_total = jrr[jss::state].size();
+        while ( jrr.isMember(jss::marker) )
+        {
+            jvParams[jss::marker] = jrr[jss::marker];
+            jrr = env.rpc ( "json", "ledger_data",
+                boost::lexical_cast<std::string>(jvParams)) [jss::result];
+            running_total += jrr[jss::state].size();
+        }
+        BEAST_EXPECT( running_total == total_count );
+
+        // The base ledger must exist
+        jvParams[jss::base_ledger_index] = 1000;
+        jrr = env.rpc ( "json", "ledger_data",
+            boost::lexical_cast<std::string>(jvParams)) [jss::result];
+        BEAST_EXPECT( jrr[jss::error_message] == "ledgerNotFound" );
+    }
+
     void testLedgerType()
     {
         // Put a bunch of different LedgerEntryTypes into a ledger
@@ -434,6 +493,7 @@ public:
         testBadInput();
         testMarkerFollow();
         testLedgerHeader();
+        testBaseLedger();
         testLedgerType();
     }
 };
@@ -0,0 +1,208 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/shamap/FullBelowCache.h>
+#include <casinocoin/shamap/SHAMap.h>
+#include <test/shamap/common.h>
+#include <casinocoin/basics/chrono.h>
+#include <casinocoin/beast/unit_test.h>
+#include <casinocoin/beast/utility/temp_dir.h>
+#include <casinocoin/protocol/digest.h>
+#include <fstream>
+
+namespace casinocoin {
+namespace tests {
+
+class FullBelowCache_test : public beast::unit_test::suite
+{
+    void
+    testSaveLoad ()
+    {
+        testcase ("save and load");
+
+        TestStopwatch clock;
+        beast::Journal const j;
+        beast::temp_dir td;
+        auto const file = td.file ("full_below.bin");
+
+        std::vector<uint256> keys;
+        for (std::uint32_t i = 0; i < 100; ++i)
+            keys.push_back (sha512Half (i));
+
+        {
+            FullBelowCache cache ("test", clock);
+            for (auto const& key : keys)
+                cache.insert (key);
+            BEAST_EXPECT(saveFullBelow (cache, file, j));
+        }
+
+        // Loaded keys are pending until they are verified
+        FullBelowCache cache ("test", clock);
+        std::size_t verified = 0;
+        BEAST_EXPECT(loadFullBelow (cache, file,
+            [&](uint256 const& key)
+            {
+                ++verified;
+                return key != keys[1];
+            }, j) == keys.size ());
+        BEAST_EXPECT(cache.size () == 0);
+        BEAST_EXPECT(cache.pendingSize () == keys.size ());
+
+        // The file is consumed by loading it
+        BEAST_EXPECT(! boost::filesystem::exists (file));
+
+        // Lookups don't find pending keys, nor verify them
+        BEAST_EXPECT(! cache.touch_if_exists (keys[0]));
+        BEAST_EXPECT(verified == 0);
+
+        // Verification can be stopped early
+        BEAST_EXPECT(cache.verifyPending ([]{ return true; }) == 0);
+        BEAST_EXPECT(cache.pendingSize () == keys.size ());
+
+        // A key already in the cache isn't verified again
+        cache.insert (keys[0]);
+
+        // A key that fails verification is dropped
+        BEAST_EXPECT(cache.verifyPending ([]{ return false; }) ==
+            keys.size () - 1);
+        BEAST_EXPECT(verified == keys.size () - 1);
+        BEAST_EXPECT(cache.pendingSize () == 0);
+        BEAST_EXPECT(cache.restoredSize () == keys.size () - 1);
+        BEAST_EXPECT(cache.size () == keys.size () - 1);
+        BEAST_EXPECT(cache.touch_if_exists (keys[2]));
+        BEAST_EXPECT(! cache.touch_if_exists (keys[1]));
+
+        // Clearing the cache discards pending keys too
+        BEAST_EXPECT(loadFullBelow (cache, file,
+            [](uint256 const&) { return true; }, j) == 0);
+        BEAST_EXPECT(saveFullBelow (cache, file, j));
+        BEAST_EXPECT(loadFullBelow (cache, file,
+            [](uint256 const&) { return true; }, j) == keys.size () - 1);
+        cache.clear ();
+        BEAST_EXPECT(cache.pendingSize () == 0);
+        BEAST_EXPECT(cache.verifyPending ([]{ return false; }) == 0);
+        BEAST_EXPECT(! cache.touch_if_exists (keys[2]));
+    }
+
+    void
+    testCorrupt ()
+    {
+        testcase ("corrupt file");
+
+        TestStopwatch clock;
+        beast::Journal const j;
+        beast::temp_dir td;
+        auto const file = td.file ("full_below.bin");
+        auto const accept = [](uint256 const&) { return true; };
+
+        FullBelowCache cache ("test", clock);
+
+        // A missing file loads nothing
+        BEAST_EXPECT(loadFullBelow (cache, file, accept, j) == 0);
+
+        cache.insert (sha512Half (1));
+        cache.insert (sha512Half (2));
+        BEAST_EXPECT(saveFullBelow (cache, file, j));
+
+        // Flip one bit of a key
+        {
+            std::fstream f (file, std::ios::in | std::ios::out |
+                std::ios::binary);
+            f.seekp (20);
+            f.put ('\xff');
+        }
+
+        FullBelowCache other ("test", clock);
+        BEAST_EXPECT(loadFullBelow (other, file, accept, j) == 0);
+        BEAST_EXPECT(other.pendingSize () == 0);
+    }
+
+    void
+    testSubtree ()
+    {
+        testcase ("subtree in store");
+
+        beast::Journal const j;
+        TestFamily f (j);
+        SHAMap map (SHAMapType::STATE, f, SHAMap::version{1});
+        for (std::uint32_t i = 0; i < 500; ++i)
+        {
+            Serializer s;
+            s.add256 (sha512Half (i));
+            map.addItem (SHAMapItem{sha512Half (i), std::move (s)},
+                false, false);
+        }
+        map.flushDirty (hotACCOUNT_NODE, 1);
+        auto const root = map.getHash ().as_uint256 ();
+
+        TestStopwatch clock;
+        {
+            // A complete subtree marks the inner nodes beneath it
+            FullBelowCache cache ("test", clock);
+            BEAST_EXPECT(subtreeInStore (cache, f.db (), root, j));
+            BEAST_EXPECT(cache.touch_if_exists (root));
+            BEAST_EXPECT(cache.size () > 1);
+        }
+
+        FullBelowCache cache ("test", clock);
+
+        // A store holding the root, but not what is below it
+        NodeStore::DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+        Section section;
+        section.set ("type", "memory");
+        section.set ("Path", "FullBelowCache_test");
+        auto partial = NodeStore::Manager::instance ().make_Database (
+            "test", scheduler, 1, parent, section, j);
+        auto const obj = f.db ().fetch (root);
+        BEAST_EXPECT(obj);
+        Blob data (obj->getData ());
+        partial->store (obj->getType (), std::move (data), root);
+
+        BEAST_EXPECT(partial->fetch (root));
+        BEAST_EXPECT(! subtreeInStore (cache, *partial, root, j));
+        BEAST_EXPECT(cache.size () == 0);
+
+        // Unless the cache already knows the children are complete
+        auto const node = std::static_pointer_cast<SHAMapInnerNode> (
+            SHAMapAbstractNode::make (makeSlice (obj->getData ()), 0,
+                snfPREFIX, SHAMapHash{root}, true, j));
+        for (int i = 0; i < 16; ++i)
+        {
+            if (! node->isEmptyBranch (i))
+                cache.insert (node->getChildHash (i).as_uint256 ());
+        }
+        BEAST_EXPECT(subtreeInStore (cache, *partial, root, j));
+    }
+
+public:
+    void
+    run ()
+    {
+        testSaveLoad ();
+        testCorrupt ();
+        testSubtree ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(FullBelowCache,shamap,casinocoin);
+
+} // tests
+} // casinocoin
@@ -0,0 +1,320 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/shamap/SHAMap.h>
+#include <test/shamap/common.h>
+#include <casinocoin/basics/random.h>
+#include <casinocoin/core/WorkerPool.h>
+#include <casinocoin/beast/unit_test.h>
+#include <casinocoin/beast/xor_shift_engine.h>
+#include <casinocoin/protocol/digest.h>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+namespace casinocoin {
+namespace tests {
+
+namespace {
+
+// Builds maps which evolve the way a state map does from one
+// ledger close to the next.
+class DeltaMaps
+{
+    beast::xor_shift_engine gen_;
+    std::vector<uint256> keys_;
+    std::uint32_t next_ = 0;
+
+    uint256
+    makeKey ()
+    {
+        return sha512Half (next_++);
+    }
+
+    Blob
+    makeData ()
+    {
+        Blob data (48);
+        for (auto& b : data)
+            b = static_cast<std::uint8_t> (
+                rand_int (gen_, 255));
+        return data;
+    }
+
+public:
+    explicit DeltaMaps (std::uint64_t seed)
+        : gen_ (seed)
+    {
+    }
+
+    void
+    populate (SHAMap& map, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            keys_.push_back (makeKey ());
+            map.addItem (SHAMapItem{keys_.back (), makeData ()},
+                false, false);
+        }
+    }
+
+    // Modify, insert and delete a few items, like a ledger close
+    void
+    close (SHAMap& map, int modified, int created, int deleted)
+    {
+        for (int i = 0; i < modified && !keys_.empty (); ++i)
+        {
+            auto const& key = keys_[rand_int (
+                gen_, keys_.size () - 1)];
+            map.updateGiveItem (std::make_shared<SHAMapItem const> (
+                key, makeData ()), false, false);
+        }
+
+        for (int i = 0; i < created; ++i)
+        {
+            keys_.push_back (makeKey ());
+            map.addItem (SHAMapItem{keys_.back (), makeData ()},
+                false, false);
+        }
+
+        for (int i = 0; i < deleted && !keys_.empty (); ++i)
+        {
+            auto const index = rand_int (
+                gen_, keys_.size () - 1);
+            map.delItem (keys_[index]);
+            keys_[index] = keys_.back ();
+            keys_.pop_back ();
+        }
+    }
+};
+
+} // namespace
+
+class SHAMapDelta_test : public beast::unit_test::suite
+{
+    // Collect a delta with visitDelta, checking the keys come in order
+    bool
+    collect (SHAMap const& map, SHAMap const& other,
+        SHAMap::Delta& delta, std::size_t threads)
+    {
+        WorkerPool pool (threads);
+        bool ordered = true;
+        map.visitDelta (other,
+            [&](uint256 const& key, SHAMap::DeltaItem const& item)
+            {
+                if (!delta.empty () && !(delta.rbegin ()->first < key))
+                    ordered = false;
+                delta.emplace (key, item);
+                return true;
+            }, &pool);
+        return ordered;
+    }
+
+    // Build the delta by walking both maps in full
+    SHAMap::Delta
+    fullDelta (SHAMap const& map, SHAMap const& other)
+    {
+        SHAMap::Delta delta;
+        for (auto const& item : map)
+            delta.emplace (item.key (), SHAMap::DeltaItem (
+                std::make_shared<SHAMapItem const> (item), nullptr));
+        for (auto const& item : other)
+        {
+            auto const iter = delta.find (item.key ());
+            if (iter == delta.end ())
+                delta.emplace (item.key (), SHAMap::DeltaItem (
+                    nullptr, std::make_shared<SHAMapItem const> (item)));
+            else if (iter->second.first->peekData () == item.peekData ())
+                delta.erase (iter);
+            else
+                iter->second.second = std::make_shared<SHAMapItem const> (item);
+        }
+        return delta;
+    }
+
+    bool
+    same (SHAMap::Delta const& a, SHAMap::Delta const& b)
+    {
+        if (a.size () != b.size ())
+            return false;
+
+        auto const sameItem = [](
+            std::shared_ptr<SHAMapItem const> const& x,
+            std::shared_ptr<SHAMapItem const> const& y)
+        {
+            if (!x || !y)
+                return !x && !y;
+            return x->key () == y->key () &&
+                x->peekData () == y->peekData ();
+        };
+
+        for (auto ai = a.begin (), bi = b.begin (); ai != a.end (); ++ai, ++bi)
+        {
+            if (ai->first != bi->first ||
+                    !sameItem (ai->second.first, bi->second.first) ||
+                    !sameItem (ai->second.second, bi->second.second))
+                return false;
+        }
+        return true;
+    }
+
+    void
+    testVisitDelta (bool backed)
+    {
+        testcase (std::string ("visitDelta ") +
+            (backed ? "backed" : "unbacked"));
+
+        TestFamily f (beast::Journal{});
+        SHAMap map (SHAMapType::FREE, f, SHAMap::version{1});
+        if (!backed)
+            map.setUnbacked ();
+
+        DeltaMaps maps (backed ? 11 : 13);
+        maps.populate (map, 2000);
+        auto const before = map.snapShot (false);
+
+        // Identical maps have no differences
+        {
+            SHAMap::Delta delta;
+            BEAST_EXPECT(collect (map, *before, delta, 1));
+            BEAST_EXPECT(delta.empty ());
+        }
+
+        for (int i = 0; i < 10; ++i)
+            maps.close (map, 20, 5, 3);
+        auto const after = map.snapShot (false);
+
+        auto const expected = fullDelta (*before, *after);
+        BEAST_EXPECT(!expected.empty ());
+
+        {
+            SHAMap::Delta delta;
+            BEAST_EXPECT(before->compare (*after, delta, 100000));
+            BEAST_EXPECT(same (delta, expected));
+        }
+
+        for (std::size_t threads : {1, 2, 4, 16})
+        {
+            SHAMap::Delta delta;
+            BEAST_EXPECT(collect (*before, *after, delta, threads));
+            BEAST_EXPECT(same (delta, expected));
+        }
+
+        // The reverse comparison swaps both sides of every item
+        {
+            SHAMap::Delta delta;
+            BEAST_EXPECT(collect (*after, *before, delta, 4));
+            BEAST_EXPECT(delta.size () == expected.size ());
+            for (auto& d : delta)
+                std::swap (d.second.first, d.second.second);
+            BEAST_EXPECT(same (delta, expected));
+        }
+
+        // Stopping early is reported, with or without threads
+        for (std::size_t threads : {1, 4})
+        {
+            WorkerPool pool (threads);
+            int count = 0;
+            BEAST_EXPECT(! before->visitDelta (*after,
+                [&](uint256 const&, SHAMap::DeltaItem const&)
+                {
+                    return ++count < 5;
+                }, &pool));
+            BEAST_EXPECT(count == 5);
+        }
+
+        // compare still honors its limit
+        {
+            SHAMap::Delta delta;
+            BEAST_EXPECT(! before->compare (*after, delta, 5));
+            BEAST_EXPECT(delta.size () == 5);
+        }
+    }
+
+public:
+    void
+    run ()
+    {
+        testVisitDelta (true);
+        testVisitDelta (false);
+    }
+};
+
+// Times the comparison of two state maps 1,000 closes apart
+class SHAMapDeltaTiming_test : public beast::unit_test::suite
+{
+public:
+    void
+    run ()
+    {
+        using clock_type = std::chrono::steady_clock;
+        auto const elapsed = [](clock_type::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds> (
+                clock_type::now () - start).count ();
+        };
+
+        int const items = 250000;
+        int const closes = 1000;
+
+        TestFamily f (beast::Journal{});
+        SHAMap map (SHAMapType::FREE, f, SHAMap::version{1});
+        map.setUnbacked ();
+
+        DeltaMaps maps (7);
+        maps.populate (map, items);
+        auto const before = map.snapShot (false);
+        for (int i = 0; i < closes; ++i)
+            maps.close (map, 40, 10, 8);
+        auto const after = map.snapShot (false);
+
+        log << items << " items, " << closes << " closes apart" << std::endl;
+
+        {
+            auto const start = clock_type::now ();
+            SHAMap::Delta delta;
+            BEAST_EXPECT(before->compare (*after, delta,
+                std::numeric_limits<int>::max ()));
+            log << "compare: " << delta.size () << " differences in " <<
+                elapsed (start) << "ms" << std::endl;
+        }
+
+        for (std::size_t threads : {1, 2, 4, 8, 16})
+        {
+            WorkerPool pool (threads);
+            auto const start = clock_type::now ();
+            std::size_t count = 0;
+            BEAST_EXPECT(before->visitDelta (*after,
+                [&](uint256 const&, SHAMap::DeltaItem const&)
+                {
+                    ++count;
+                    return true;
+                }, &pool));
+            log << "visitDelta, " << threads << " threads: " << count <<
+                " differences in " << elapsed (start) << "ms" << std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHAMapDelta,casinocoin_app,casinocoin);
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapDeltaTiming,casinocoin_app,casinocoin);
+
+} // tests
+} // casinocoin
@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of casinocoind: https://github.com/casinocoin/casinocoind
+    Copyright (c) 2019 CasinoCoin Foundation
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <casinocoin/shamap/SHAMap.h>
+#include <test/shamap/common.h>
+#include <casinocoin/beast/unit_test.h>
+#include <casinocoin/protocol/digest.h>
+#include <thread>
+#include <vector>
+
+namespace casinocoin {
+namespace tests {
+
+class SHAMapPrefetch_test : public beast::unit_test::suite
+{
+    static Blob
+    makeData (std::uint32_t i)
+    {
+        auto const h = sha512Half (i);
+        return Blob (h.begin (), h.end ());
+    }
+
+    void
+    testPrefetch ()
+    {
+        testcase ("prefetch");
+
+        beast::Journal const j;
+        std::vector<uint256> keys;
+        SHAMapHash hash;
+
+        // Build and store a map through one family
+        {
+            TestFamily f (j);
+            SHAMap map (SHAMapType::STATE, f, SHAMap::version{1});
+            for (std::uint32_t i = 0; i < 2000; ++i)
+            {
+                keys.push_back (sha512Half (i));
+                map.addItem (SHAMapItem{keys.back (), makeData (i)},
+                    false, false);
+            }
+            map.flushDirty (hotACCOUNT_NODE, 1);
+            hash = map.getHash ();
+        }
+
+        // Some keys which are in the map and some which are not
+        std::vector<uint256> wanted;
+        for (std::uint32_t i = 0; i < 2000; i += 7)
+            wanted.push_back (keys[i]);
+        for (std::uint32_t i = 5000; i < 5050; ++i)
+            wanted.push_back (sha512Half (i));
+
+        // Without a prefetch, lookups read from the node store
+        {
+            TestFamily f (j);
+            SHAMap map (SHAMapType::STATE, hash.as_uint256 (), f,
+                SHAMap::version{1});
+            BEAST_EXPECT(map.fetchRoot (hash, nullptr));
+
+            auto const before = f.db ().getFetchTotalCount ();
+            auto const mine = f.db ().getFetchThreadCount ();
+            for (std::uint32_t i = 0; i < 2000; i += 7)
+                BEAST_EXPECT(map.hasItem (keys[i]));
+            BEAST_EXPECT(f.db ().getFetchTotalCount () > before);
+            BEAST_EXPECT(f.db ().getFetchThreadCount () - mine ==
+                f.db ().getFetchTotalCount () - before);
+
+            // Reads made by another thread are not counted for this one
+            auto const total = f.db ().getFetchTotalCount ();
+            auto const ours = f.db ().getFetchThreadCount ();
+            std::thread ([&]
+                {
+                    for (std::uint32_t i = 1; i < 2000; i += 7)
+                        map.hasItem (keys[i]);
+                }).join ();
+            BEAST_EXPECT(f.db ().getFetchTotalCount () > total);
+            BEAST_EXPECT(f.db ().getFetchThreadCount () == ours);
+        }
+
+        // After a prefetch, they don't
+        {
+            TestFamily f (j);
+            SHAMap map (SHAMapType::STATE, hash.as_uint256 (), f,
+                SHAMap::version{1});
+            BEAST_EXPECT(map.fetchRoot (hash, nullptr));
+
+            BEAST_EXPECT(map.prefetch (wanted) > 0);
+
+            auto const before = f.db ().getFetchTotalCount ();
+            for (std::uint32_t i = 0; i < 2000; i += 7)
+            {
+                BEAST_EXPECT(map.hasItem (keys[i]));
+                BEAST_EXPECT(map.peekItem (keys[i])->peekData () ==
+                    makeData (i));
+            }
+            for (std::uint32_t i = 5000; i < 5050; ++i)
+                BEAST_EXPECT(! map.hasItem (sha512Half (i)));
+            BEAST_EXPECT(f.db ().getFetchTotalCount () == before);
+
+            // Everything is in memory now
+            BEAST_EXPECT(map.prefetch (wanted) == 0);
+        }
+
+        // A map which is not backed has nothing to read
+        {
+            TestFamily f (j);
+            SHAMap map (SHAMapType::FREE, f, SHAMap::version{1});
+            map.setUnbacked ();
+            map.addItem (SHAMapItem{keys[0], makeData (0)}, false, false);
+            BEAST_EXPECT(map.prefetch (wanted) == 0);
+        }
+    }
+
+public:
+    void
+    run ()
+    {
+        testPrefetch ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHAMapPrefetch,shamap,casinocoin);
+
+} // tests
+} // casinocoin
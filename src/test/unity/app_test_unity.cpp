@@ -20,6 +20,9 @@
 
 #include <test/app/AccountTxPaging_test.cpp>
 #include <test/app/AmendmentTable_test.cpp>
+#include <test/app/BatchTuner_test.cpp>
+#include <test/app/BookIndex_test.cpp>
+#include <test/app/CanonicalTXSet_test.cpp>
 #include <test/app/CrossingLimits_test.cpp>
 #include <test/app/DeliverMin_test.cpp>
 #include <test/app/Discrepancy_test.cpp>
@@ -27,23 +30,33 @@
 #include <test/app/Freeze_test.cpp>
 #include <test/app/HashRouter_test.cpp>
 #include <test/app/LedgerLoad_test.cpp>
+#include <test/app/LedgerReplayer_test.cpp>
 #include <test/app/LoadFeeTrack_test.cpp>
 #include <test/app/Manifest_test.cpp>
 #include <test/app/MultiSign_test.cpp>
+#include <test/app/OfferCrossing_test.cpp>
 #include <test/app/OfferStream_test.cpp>
 #include <test/app/Offer_test.cpp>
+#include <test/app/OpenLedger_test.cpp>
+#include <test/app/OrderBookDB_test.cpp>
 #include <test/app/OversizeMeta_test.cpp>
+#include <test/app/ParallelApply_test.cpp>
 #include <test/app/Path_test.cpp>
+#include <test/app/PathFindScheduler_test.cpp>
+#include <test/app/PathLiquidityCache_test.cpp>
 #include <test/app/PayChan_test.cpp>
 #include <test/app/PayStrand_test.cpp>
 #include <test/app/Regression_test.cpp>
 #include <test/app/SetAuth_test.cpp>
 #include <test/app/SetRegularKey_test.cpp>
 #include <test/app/SHAMapStore_test.cpp>
+#include <test/app/SigVerifier_test.cpp>
 #include <test/app/Escrow_test.cpp>
 #include <test/app/Taker_test.cpp>
 #include <test/app/Transaction_ordering_test.cpp>
 #include <test/app/TrustAndBalance_test.cpp>
+#include <test/app/TrustLineGraph_test.cpp>
+#include <test/app/TrustLineTotals_test.cpp>
 #include <test/app/TxQ_test.cpp>
 #include <test/app/ValidatorList_test.cpp>
 #include <test/app/ValidatorSite_test.cpp>
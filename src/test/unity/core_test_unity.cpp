@@ -26,4 +26,5 @@
 #include <test/core/SociDB_test.cpp>
 #include <test/core/Stoppable_test.cpp>
 #include <test/core/TerminateHandler_test.cpp>
+#include <test/core/WorkerPool_test.cpp>
 #include <test/core/Workers_test.cpp>
@@ -22,8 +22,11 @@
 #include <test/ledger/CashDiff_test.cpp>
 #include <test/ledger/Directory_test.cpp>
 #include <test/ledger/Invariants_test.cpp>
+#include <test/ledger/MetaWriter_test.cpp>
 #include <test/ledger/PaymentSandbox_test.cpp>
+#include <test/ledger/PaymentStorm_test.cpp>
 #include <test/ledger/PendingSaves_test.cpp>
 #include <test/ledger/SHAMapV2_test.cpp>
 #include <test/ledger/SkipList_test.cpp>
+#include <test/ledger/StateLeaf_test.cpp>
 #include <test/ledger/View_test.cpp>
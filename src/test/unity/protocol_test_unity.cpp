@@ -18,6 +18,7 @@
 */
 //==============================================================================
 
+#include <test/protocol/AmountMath_test.cpp>
 #include <test/protocol/BuildInfo_test.cpp>
 #include <test/protocol/digest_test.cpp>
 #include <test/protocol/InnerObjectFormats_test.cpp>
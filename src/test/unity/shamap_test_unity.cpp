@@ -19,5 +19,8 @@
 //==============================================================================
 
 #include <test/shamap/FetchPack_test.cpp>
+#include <test/shamap/FullBelowCache_test.cpp>
+#include <test/shamap/SHAMapDelta_test.cpp>
+#include <test/shamap/SHAMapPrefetch_test.cpp>
 #include <test/shamap/SHAMapSync_test.cpp>
 #include <test/shamap/SHAMap_test.cpp>
\ No newline at end of file